@@ -69,6 +69,11 @@ void SystemClock_Config(void);
 //#define PA_PSU_EN_GPIO_Port GPIOA
 
 /* USER CODE BEGIN Private defines */
+/* Unused NVIC line on which SUBGHZ Radio IRQ processing is deferred, below critical sections
+ * ceiling (cf SUBGHZ_Radio_IRQHandler)
+ */
+#define RADIO_DEFERRED_IRQn COMP_IRQn
+#define RADIO_DEFERRED_IRQ_PRIO 2
 
 /* USER CODE END Private defines */
 
@@ -35,12 +35,20 @@ extern "C" {
 extern RTC_HandleTypeDef hrtc;
 
 /* USER CODE BEGIN Private defines */
+/** RTC runs in binary mode: RTC_SSR is a 32-bit down-counter clocked by ck_apre = LSE / 32 */
+#define RTC_BIN_TICK_HZ 1024
 
 /* USER CODE END Private defines */
 
 void MX_RTC_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+/**
+ * @brief Get RTC binary tick counter
+ *
+ * @return ticks of RTC_BIN_TICK_HZ, incrementing, wrapping around every 2^32 ticks (~48 days)
+ */
+uint32_t RTC_getBinTick(void);
 
 /* USER CODE END Prototypes */
 
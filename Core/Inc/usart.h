@@ -35,6 +35,8 @@ extern "C" {
 extern UART_HandleTypeDef hlpuart1;
 
 /* USER CODE BEGIN Private defines */
+extern DMA_HandleTypeDef hdma_lpuart1_rx;
+extern DMA_HandleTypeDef hdma_lpuart1_tx;
 
 /* USER CODE END Private defines */
 
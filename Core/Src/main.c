@@ -74,6 +74,7 @@
 #include "kns_q.h"
 #include "kns_os.h"
 #include "mcu_tim.h"
+#include "mcu_tim_srv.h"
 #include "kns_mac.h"
 #include "kns_app.h"
 #ifdef USE_GUI_APP
@@ -86,6 +87,9 @@
 #endif
 #include "lpm.h"
 #include "mgr_log.h"
+#ifdef USE_USERDATA_JOURNAL
+#include "user_data_journal.h"
+#endif
 
 /** Assembly function used to initialize SRAM2 .bss and .data sections. It is based on the same
  * model as the Reset_Handler (cf startup_*.s file) regarding the whole RAM memory
@@ -177,7 +181,7 @@ static void IDLE_task(void)
     while(HAL_GPIO_ReadPin(EXT_WKUP_BUTTON_GPIO_Port, EXT_WKUP_BUTTON_Pin) == GPIO_PIN_SET) {
 
 	  //MGR_LOG_DEBUG("==== WAKEUP BUTTON SET ====\r\n");
-      if (KNS_Q_isEvtInSomeQ() || MGR_AT_CMD_isPendingAt())
+      if (KNS_OS_isSomeTaskReady() || MGR_AT_CMD_isPendingAt())
         return;
     }
     /** Do the last check on event out of for loop. */
@@ -188,7 +192,7 @@ static void IDLE_task(void)
   prim = __get_PRIMASK();
   __disable_irq();
   __disable_fault_irq();
-  if (KNS_Q_isEvtInSomeQ() || MGR_AT_CMD_isPendingAt()) {
+  if (KNS_OS_isSomeTaskReady() || MGR_AT_CMD_isPendingAt()) {
     if (!prim){
       __enable_fault_irq();
       __enable_irq();
@@ -220,7 +224,7 @@ static void IDLE_task(void)
   prim = __get_PRIMASK();
   __disable_irq();
   __disable_fault_irq();
-  if (KNS_Q_isEvtInSomeQ()) {
+  if (KNS_OS_isSomeTaskReady()) {
     if (!prim){
       __enable_fault_irq();
       __enable_irq();
@@ -250,6 +254,7 @@ int main(void)
 {
   /* USER CODE BEGIN 1 */
   bool bIsWakeUpFromReset = false;
+  bool bIsRam2Lost = false;
 
   /** Check if reset was triggered by nRST external pin
    *
@@ -318,8 +323,9 @@ int main(void)
   /* USER CODE BEGIN 2 */
 
 #ifdef DEBUG
-  /** When core enters debug mode (core halted), freeze RTC */
+  /** When core enters debug mode (core halted), freeze RTC and software timers time base */
   __HAL_DBGMCU_FREEZE_RTC();
+  __HAL_DBGMCU_FREEZE_LPTIM1();
 #endif
 
   /** As we just woke up, most of GPIOs are useless so far. Limit their current drain */
@@ -335,6 +341,7 @@ int main(void)
   case LOW_POWER_MODE_SHUTDOWN:
     /** Initialize retention RAM2 as not done by default in the Reset_Handler */
     Sram2_Init();
+    bIsRam2Lost = true;
     break;
   case LOW_POWER_MODE_STANDBY:
     __HAL_PWR_CLEAR_FLAG(PWR_FLAG_SB);
@@ -351,9 +358,12 @@ int main(void)
     __HAL_PWR_CLEAR_FLAG(PWR_FLAG_STOP2);
     /** Initialize retention RAM2 as not done by default in the Reset_Handler */
     Sram2_Init();
+    bIsRam2Lost = true;
     /** Deinit all unused timers including RTC timer to save current drain (was automatically
-     * enabled by STM32Cube generated code earlier
+     * enabled by STM32Cube generated code earlier). TIM16 is not used anymore, TX timeout runs
+     * on LPTIM1 (mcu_tim_srv).
      */
+    HAL_TIM_Base_DeInit(&htim16);
     MCU_TIM_deinit(MCU_TIM_HDLR_TX_TIMEOUT);
     MCU_TIM_deinit(MCU_TIM_HDLR_TX_PERIOD);
     break;
@@ -386,6 +396,19 @@ int main(void)
     break;
   }
 
+  /** Software timers service, runs from LSE started by RTC init */
+  MCU_TIM_SRV_init();
+
+#ifdef USE_USERDATA_JOURNAL
+  /** USERDATA TX fifo was lost along with RAM2, rebuild it from flash journal. Recovered messages
+   * are submitted to Kineis stack once it is initialized (cf MGR_AT_CMD)
+   */
+  if (bIsRam2Lost)
+    USERDATA_journalRecover();
+#else
+  (void)bIsRam2Lost;
+#endif
+
   /** LPM managment: Initialize and register Kineis stack client */
   LPM_init();
 
@@ -423,13 +446,13 @@ int main(void)
   case LOW_POWER_MODE_SHUTDOWN:
   case LOW_POWER_MODE_STANDBY:
     /** Simulate potential RTC interrupts, as we can exit shutdown/standby mode from:
-     * - RTC alarm
+     * - RTC alarm A, end of a TX period step (cf mcu_tim.c, context kept in RTC backup registers)
      * - RTC wakeuptimer
      * The handlers check RTC registers in a way to identify RTC interrupt if any.
      * In case shutdown exit is due to the wakeup pin (not RTC), no functional processing will be
      * by those RTC handlers
      */
-//    RTC_Alarm_IRQHandler();
+    RTC_Alarm_IRQHandler();
     RTC_WKUP_IRQHandler();
     break;
   case LOW_POWER_MODE_STOP:
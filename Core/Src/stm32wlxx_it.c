@@ -22,6 +22,9 @@
 #include "stm32wlxx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#ifdef USE_USERDATA_JOURNAL
+#include "mcu_flash.h"
+#endif
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -77,6 +80,8 @@ extern RTC_HandleTypeDef hrtc;
 extern SUBGHZ_HandleTypeDef hsubghz;
 extern TIM_HandleTypeDef htim16;
 /* USER CODE BEGIN EV */
+extern DMA_HandleTypeDef hdma_lpuart1_rx;
+extern DMA_HandleTypeDef hdma_lpuart1_tx;
 
 /* USER CODE END EV */
 
@@ -89,7 +94,11 @@ extern TIM_HandleTypeDef htim16;
 void NMI_Handler(void)
 {
   /* USER CODE BEGIN NonMaskableInt_IRQn 0 */
-
+#ifdef USE_USERDATA_JOURNAL
+  /* ECC error while reading USERDATA journal, read reports it */
+  if (MCU_FLASH_nmiHandler())
+    return;
+#endif
   /* USER CODE END NonMaskableInt_IRQn 0 */
   /* USER CODE BEGIN NonMaskableInt_IRQn 1 */
   while (1)
@@ -237,6 +246,20 @@ void RTC_WKUP_IRQHandler(void)
   /* USER CODE END RTC_WKUP_IRQn 1 */
 }
 
+/**
+  * @brief This function handles RTC Alarms (A and B) Interrupt.
+  */
+void RTC_Alarm_IRQHandler(void)
+{
+  /* USER CODE BEGIN RTC_Alarm_IRQn 0 */
+
+  /* USER CODE END RTC_Alarm_IRQn 0 */
+  HAL_RTC_AlarmIRQHandler(&hrtc);
+  /* USER CODE BEGIN RTC_Alarm_IRQn 1 */
+
+  /* USER CODE END RTC_Alarm_IRQn 1 */
+}
+
 /**
   * @brief This function handles TIM16 Global Interrupt.
   */
@@ -257,6 +280,31 @@ void TIM16_IRQHandler(void)
 void LPUART1_IRQHandler(void)
 {
   /* USER CODE BEGIN LPUART1_IRQn 0 */
+  uint32_t u32_rxErr;
+
+  /* Character match (AT console line end) is not served by HAL, notify it as an RX event */
+  if (__HAL_UART_GET_IT(&hlpuart1, UART_IT_CM) != RESET)
+  {
+    __HAL_UART_CLEAR_FLAG(&hlpuart1, UART_CLEAR_CMF);
+    if (hlpuart1.hdmarx != NULL)
+    {
+      HAL_UARTEx_RxEventCallback(&hlpuart1,
+        hlpuart1.RxXferSize - __HAL_DMA_GET_COUNTER(hlpuart1.hdmarx));
+    }
+  }
+
+  /* Line errors (parity, framing, noise) would make HAL abort RX DMA, so that AT console drops
+   * all AT cmds received. DMA is only paused on such error (DMA disabled on RX error): drop the
+   * erroneous character, clear the error so that DMA goes on, then notify it as a non blocking
+   * error. Thus, AT console only drops the line being received.
+   */
+  u32_rxErr = READ_REG(hlpuart1.Instance->ISR) & (USART_ISR_PE | USART_ISR_FE | USART_ISR_NE);
+  if ((u32_rxErr != 0U) && (hlpuart1.RxState == HAL_UART_STATE_BUSY_RX))
+  {
+    __HAL_UART_SEND_REQ(&hlpuart1, UART_RXDATA_FLUSH_REQUEST);
+    __HAL_UART_CLEAR_FLAG(&hlpuart1, UART_CLEAR_PEF | UART_CLEAR_FEF | UART_CLEAR_NEF);
+    HAL_UART_ErrorCallback(&hlpuart1);
+  }
 
   /* USER CODE END LPUART1_IRQn 0 */
   HAL_UART_IRQHandler(&hlpuart1);
@@ -271,7 +319,14 @@ void LPUART1_IRQHandler(void)
 void SUBGHZ_Radio_IRQHandler(void)
 {
   /* USER CODE BEGIN SUBGHZ_Radio_IRQn 0 */
-
+  /* Radio callbacks (libknsrf) use critical sections, thus cannot run above their ceiling. This
+   * ISR only masks radio IRQ line and defers its processing to RADIO_DEFERRED_IRQn, below the
+   * ceiling: radio processing is delayed until any on-going critical section exits. Radio IRQ
+   * line is unmasked once radio IRQ status is cleared.
+   */
+  HAL_NVIC_DisableIRQ(SUBGHZ_Radio_IRQn);
+  HAL_NVIC_SetPendingIRQ(RADIO_DEFERRED_IRQn);
+  return;
   /* USER CODE END SUBGHZ_Radio_IRQn 0 */
   HAL_SUBGHZ_IRQHandler(&hsubghz);
   /* USER CODE BEGIN SUBGHZ_Radio_IRQn 1 */
@@ -281,4 +336,30 @@ void SUBGHZ_Radio_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles SUBGHZ Radio Interrupt deferred by SUBGHZ_Radio_IRQHandler.
+  */
+void COMP_IRQHandler(void)
+{
+  HAL_SUBGHZ_IRQHandler(&hsubghz);
+  HAL_NVIC_ClearPendingIRQ(SUBGHZ_Radio_IRQn);
+  HAL_NVIC_EnableIRQ(SUBGHZ_Radio_IRQn);
+}
+
+/**
+  * @brief This function handles DMA1 Channel 1 Interrupt (LPUART1 RX).
+  */
+void DMA1_Channel1_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_lpuart1_rx);
+}
+
+/**
+  * @brief This function handles DMA1 Channel 2 Interrupt (LPUART1 TX).
+  */
+void DMA1_Channel2_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_lpuart1_tx);
+}
+
 /* USER CODE END 1 */
@@ -21,6 +21,12 @@
 #include "subghz.h"
 
 /* USER CODE BEGIN 0 */
+#include "kns_cs.h"
+
+/* Radio callbacks use critical sections, their processing must be masked by them */
+#if (KNS_CS_PRIO_CEILING != 0) && (RADIO_DEFERRED_IRQ_PRIO < KNS_CS_PRIO_CEILING)
+#error "RADIO_DEFERRED_IRQ_PRIO must not be above critical sections ceiling (CS_PRIO_CEILING)"
+#endif
 
 /* USER CODE END 0 */
 
@@ -61,6 +67,9 @@ void HAL_SUBGHZ_MspInit(SUBGHZ_HandleTypeDef* subghzHandle)
     HAL_NVIC_SetPriority(SUBGHZ_Radio_IRQn, 0, 0);
     HAL_NVIC_EnableIRQ(SUBGHZ_Radio_IRQn);
   /* USER CODE BEGIN SUBGHZ_MspInit 1 */
+    /* Radio IRQ processing, deferred below critical sections ceiling */
+    HAL_NVIC_SetPriority(RADIO_DEFERRED_IRQn, RADIO_DEFERRED_IRQ_PRIO, 0);
+    HAL_NVIC_EnableIRQ(RADIO_DEFERRED_IRQn);
 
   /* USER CODE END SUBGHZ_MspInit 1 */
 }
@@ -77,6 +86,7 @@ void HAL_SUBGHZ_MspDeInit(SUBGHZ_HandleTypeDef* subghzHandle)
     /* SUBGHZ interrupt Deinit */
     HAL_NVIC_DisableIRQ(SUBGHZ_Radio_IRQn);
   /* USER CODE BEGIN SUBGHZ_MspDeInit 1 */
+    HAL_NVIC_DisableIRQ(RADIO_DEFERRED_IRQn);
 
   /* USER CODE END SUBGHZ_MspDeInit 1 */
 }
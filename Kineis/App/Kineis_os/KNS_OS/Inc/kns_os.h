@@ -31,9 +31,57 @@
  * * KNS_OS_TASK_MAC Kineis stack main task
  * * KNS_OS_TASK_IDLE idle tsak entering LPM when other task are not active
  *
+ * @section kns_os_sched Scheduling
+ *
+ * Baremetal Kineis OS is event driven, tasks are not polled. A task is ready when:
+ * * one of the queues it consumes contains some event (refer to qConsumerTask in kns_q_conf.c),
+ * * it was set ready by some ISR, timer or by itself through \ref KNS_OS_setTaskReady.
+ *
+ * Consumer of the highest-priority non-empty queue runs first, then tasks explicitly set ready, from
+ * higher to lower priority. As soon as no task is ready, IDLE task runs and drops into the LPM
+ * policy. It shall check \ref KNS_OS_isSomeTaskReady with interrupts masked before entering low
+ * power mode.
+ *
+ * A task processing only part of its pending work (e.g. one AT command out of several) shall set
+ * itself ready again before returning.
+ *
+ * @section kns_os_rtos FreeRTOS port
+ *
+ * With USE_FREERTOS, same tasks run on FreeRTOS (kns_os_freertos.c):
+ * * each registered task, IDLE excepted, becomes an RTOS task. RTOS priority follows the task
+ *   handler order (cf KNS_OS_RTOS_PRIO_BASE in kns_os_conf.h),
+ * * a task runs while its queues hold some events, then blocks in the kernel on its task
+ *   notification. KNS_Q_push and \ref KNS_OS_setTaskReady notify it, from task or ISR context,
+ * * IDLE task runs from tickless idle, where the kernel is about to sleep. It is in charge of
+ *   entering LPM through the LPM manager. FreeRTOSConfig.h shall contain:
+ *   * configUSE_TICKLESS_IDLE 1
+ *   * configPRE_SLEEP_PROCESSING(x) KNS_OS_preSleepProcessing(&(x))
+ *
+ * @attention SysTick based tickless idle only keeps time across SLEEP mode. Deeper modes (STOP and
+ * below) stop SysTick, thus kernel time is not compensated unless vPortSuppressTicksAndSleep is
+ * provided on a low-power timer.
+ *
+ * @section kns_os_posix POSIX host port
+ *
+ * With USE_POSIX, Kineis OS runs on a Linux (or any POSIX) host, to test and load the application
+ * layer without hardware (kns_os_posix.c, kns_q_posix.c, kns_cs.c):
+ * * each registered task, IDLE excepted, runs on its own pthread, with same run-while-pending then
+ *   block-on-notification loop as with FreeRTOS. Notifying a running task is lock-free, a mutex
+ *   and condition variable are only involved when the task sleeps,
+ * * thread calling \ref KNS_OS_main runs IDLE task, once every other task sleeps with no pending
+ *   event. IDLE task is provided by the host program (e.g. to stop a load test),
+ * * queues are bounded lock-free multi-producer rings with per-slot sequence numbers, as threads
+ *   really run in parallel. KNS_Q_popWait blocks on a condition variable,
+ * * KNS_CS_enter/KNS_CS_exit map to one recursive mutex,
+ * * with KNS_OS_PERF, durations are measured in nanoseconds of the monotonic clock.
+ *
+ * Queues shall be created with KNS_Q_create as with an RTOS. There is no thread priority: the
+ * host scheduler decides, which is what contention measurements need.
+ *
  * @section kns_os_subpages Sub-pages
  *
  * * @subpage kns_os_conf_page
+ * * @subpage kns_os_perf_page
  * * @subpage kns_q_page
  * * @subpage kns_q_conf_page
  */
@@ -78,10 +126,45 @@
 enum KNS_status_t KNS_OS_registerTask(enum KNS_OS_taskHdlr_t tskHdlr, void (*taskFctPtr)(void));
 
 /**
- * @brief This function is the main scheduler of Kineis baremetal OS.
+ * @brief This function is used to mark a task as ready to run
+ *
+ * Task will be scheduled by \ref KNS_OS_main once higher-priority work is done. Flag is cleared
+ * when the task starts running.
+ *
+ * @note This function can be called from ISR context.
+ *
+ * @param[in] tskHdlr: task handler
+ */
+void KNS_OS_setTaskReady(enum KNS_OS_taskHdlr_t tskHdlr);
+
+/**
+ * @brief This function is used to check some task (IDLE excepted) is ready to run
+ *
+ * It is aimed to be used by IDLE task, with interrupts masked, right before entering low power
+ * mode.
+ *
+ * @retval true if some task has work to do, false otherwise.
+ */
+bool KNS_OS_isSomeTaskReady(void);
+
+#ifdef USE_FREERTOS
+/**
+ * @brief Tickless idle hook of FreeRTOS, entering low power mode through IDLE task
+ *
+ * Called by the kernel with interrupts masked, once no RTOS task is ready. It runs the registered
+ * IDLE task, which enters LPM, then tells the kernel not to sleep again.
+ *
+ * @param[in,out] expectedIdleTime: expected idle time in ticks, cleared once LPM was entered
+ */
+void KNS_OS_preSleepProcessing(uint32_t *expectedIdleTime);
+#endif
+
+/**
+ * @brief This function is the main scheduler of Kineis OS.
  *
- * It is in charge to schedule all task registerd before. this main OS task shall be called in main
- * function of the firmaware.
+ * It is in charge to schedule all task registerd before, only running the ones which are ready
+ * (refer to \ref kns_os_sched). this main OS task shall be called in main function of the
+ * firmaware. With an RTOS, it creates the RTOS tasks and starts the kernel.
  *
  * @note This function contains infinite loop and will never exit.
  */
@@ -0,0 +1,157 @@
+/* SPDX-License-Identifier: no SPDX license */
+/**
+ * @file    kns_os_perf.h
+ * @brief   Runtime profiling of baremetal Kineis OS tasks and queues
+ * @author  Kineis
+ */
+
+/**
+ * @page kns_os_perf_page Kineis OS runtime profiling
+ *
+ * When built with KNS_OS_PERF compilation flag (PERF=1 in Makefile), the baremetal Kineis OS
+ * collects:
+ * * per task: number of invocations, cumulative and maximum duration in CPU cycles,
+ * * per queue: number of pushed and popped elements, high-water mark (maximum number of elements
+ *   present at once) and number of push rejected as queue was full.
+ *
+ * Durations are measured with the CPU cycle counter (DWT on Cortex-M, cf MCU_MISC_getCycleCnt).
+ * This counter is stopped in low power modes, so IDLE task duration only reflects the time spent
+ * running, not sleeping. On POSIX host (USE_POSIX), durations are in nanoseconds instead.
+ *
+ * Statistics are read and reset through AT+PERF command. They are useful to size queue lengths in
+ * kns_q_conf.h (compare high-water mark to queue length) and to find latency spikes in tasks.
+ *
+ * Without KNS_OS_PERF, all hooks below are empty and no RAM is used.
+ */
+
+/**
+ * @addtogroup KNS_OS
+ * @{
+ */
+
+#ifndef KNS_OS_PERF_H
+#define KNS_OS_PERF_H
+
+/* Includes ------------------------------------------------------------------------------------ */
+
+#include <stdint.h>
+#include "kns_os_conf.h"
+#include "kns_q_conf.h"
+
+#pragma GCC visibility push(default)
+
+/* Structures ---------------------------------------------------------------------------------- */
+
+/**
+ * @struct KNS_OS_PERF_task_t
+ * @brief Runtime statistics of one task
+ */
+struct KNS_OS_PERF_task_t {
+	uint32_t nbRun;       /**< number of invocations */
+	uint64_t cyclesTotal; /**< cumulative duration in CPU cycles */
+	uint32_t cyclesMax;   /**< longest invocation in CPU cycles */
+};
+
+/**
+ * @struct KNS_OS_PERF_q_t
+ * @brief Runtime statistics of one queue
+ */
+struct KNS_OS_PERF_q_t {
+	uint32_t nbPush;   /**< number of elements pushed (committed) */
+	uint32_t nbPop;    /**< number of elements popped (released) */
+	uint32_t nbQFull;  /**< number of push rejected as queue was full */
+	uint8_t maxLevel;  /**< high-water mark, maximum number of elements present at once */
+};
+
+/* Function prototypes ------------------------------------------------------------------------- */
+
+#ifdef KNS_OS_PERF
+
+/**
+ * @brief Start cycle counter and clear all statistics
+ */
+void KNS_OS_PERF_start(void);
+
+/**
+ * @brief Clear all statistics
+ */
+void KNS_OS_PERF_reset(void);
+
+/**
+ * @brief Get statistics of one task
+ *
+ * @param[in] tskHdlr: task handler
+ * @param[out] stats: copy of task statistics
+ */
+void KNS_OS_PERF_getTaskStats(enum KNS_OS_taskHdlr_t tskHdlr, struct KNS_OS_PERF_task_t *stats);
+
+/**
+ * @brief Get statistics of one queue
+ *
+ * @param[in] qHandle: queue handle
+ * @param[out] stats: copy of queue statistics
+ */
+void KNS_OS_PERF_getQStats(enum KNS_Q_handle_t qHandle, struct KNS_OS_PERF_q_t *stats);
+
+/**
+ * @brief Get current value of the cycle counter used for measurements
+ *
+ * @return number of CPU cycles
+ */
+uint32_t KNS_OS_PERF_getCycles(void);
+
+/**
+ * @brief Account one task invocation (used by Kineis OS scheduler)
+ *
+ * @param[in] tskHdlr: task handler
+ * @param[in] cycles: duration of the invocation in CPU cycles
+ */
+void KNS_OS_PERF_taskRun(enum KNS_OS_taskHdlr_t tskHdlr, uint32_t cycles);
+
+/**
+ * @brief Account one element pushed into a queue (used by KNS_Q, may run under ISR)
+ *
+ * @param[in] qHandle: queue handle
+ * @param[in] level: number of elements in queue once pushed
+ */
+void KNS_OS_PERF_qPush(enum KNS_Q_handle_t qHandle, uint8_t level);
+
+/**
+ * @brief Account one element popped from a queue (used by KNS_Q)
+ *
+ * @param[in] qHandle: queue handle
+ */
+void KNS_OS_PERF_qPop(enum KNS_Q_handle_t qHandle);
+
+/**
+ * @brief Account one push rejected on full queue (used by KNS_Q, may run under ISR)
+ *
+ * @param[in] qHandle: queue handle
+ */
+void KNS_OS_PERF_qFull(enum KNS_Q_handle_t qHandle);
+
+#define KNS_OS_PERF_START()                   KNS_OS_PERF_start()
+#define KNS_OS_PERF_GET_CYCLES()              KNS_OS_PERF_getCycles()
+#define KNS_OS_PERF_TASK_RUN(tskHdlr, cycles) KNS_OS_PERF_taskRun(tskHdlr, cycles)
+#define KNS_OS_PERF_Q_PUSH(qHandle, level)    KNS_OS_PERF_qPush(qHandle, level)
+#define KNS_OS_PERF_Q_POP(qHandle)            KNS_OS_PERF_qPop(qHandle)
+#define KNS_OS_PERF_Q_FULL(qHandle)           KNS_OS_PERF_qFull(qHandle)
+
+#else // else of KNS_OS_PERF
+
+#define KNS_OS_PERF_START()
+#define KNS_OS_PERF_GET_CYCLES()              0
+#define KNS_OS_PERF_TASK_RUN(tskHdlr, cycles)
+#define KNS_OS_PERF_Q_PUSH(qHandle, level)
+#define KNS_OS_PERF_Q_POP(qHandle)
+#define KNS_OS_PERF_Q_FULL(qHandle)
+
+#endif // end of KNS_OS_PERF
+
+#pragma GCC visibility pop
+
+#endif /* KNS_OS_PERF_H */
+
+/**
+ * @}
+ */
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    kns_os_baremetal.c
+ * @brief   Minimalist baremetal OS to be used with Kineis software stack
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup KNS_OS
+ * @brief Kineis SW queues utilities in baremetal environement
+ * @{
+ */
+
+#ifndef KNS_OS_BAREMETAL_C
+#define KNS_OS_BAREMETAL_C
+
+/* Includes ------------------------------------------------------------------------------------ */
+
+#include <stddef.h>
+
+#include "kns_os.h"
+#include "kns_os_perf.h"
+#include "kns_q.h"
+
+#pragma GCC visibility push(default)
+
+/* Defines ------------------------------------------------------------------------------------- */
+
+/* Structures ---------------------------------------------------------------------------------- */
+
+/* Variables ----------------------------------------------------------------------------------- */
+
+void (*taskPool[KNS_OS_TASK_MAX])(void) = {NULL};
+
+/** Bitmap of tasks explicitly set ready (cf @ref KNS_OS_setTaskReady). All tasks are ready at
+ * start-up so that each of them runs at least once.
+ */
+static volatile uint32_t taskReadyMask = (1UL << KNS_OS_TASK_MAX) - 1;
+
+_Static_assert(KNS_OS_TASK_MAX <= 32, "task-ready bitmap holds up to 32 tasks");
+
+/* Local functions ----------------------------------------------------------------------------- */
+
+/**
+ * @brief Select next task to run
+ *
+ * Priorities are handled at queue level: the consumer of the highest-priority non-empty queue runs
+ * first. Then, tasks set ready by ISRs or timers run from higher to lower priority. IDLE task is
+ * selected when nothing else is ready.
+ *
+ * @retval handler of the task to run
+ */
+static enum KNS_OS_taskHdlr_t KNS_OS_getNextTask(void)
+{
+	uint32_t readyMask;
+#ifdef USE_BAREMETAL
+	uint32_t pendingMask = KNS_Q_getPendingMask();
+
+	if (pendingMask != 0)
+		return qConsumerTask[31 - __builtin_clz(pendingMask)];
+#endif
+
+	readyMask = taskReadyMask & ~(1UL << KNS_OS_TASK_IDLE);
+	if (readyMask != 0)
+		return (enum KNS_OS_taskHdlr_t)(31 - __builtin_clz(readyMask));
+
+	return KNS_OS_TASK_IDLE;
+}
+
+/* Function prototypes ------------------------------------------------------------------------- */
+
+enum KNS_status_t KNS_OS_registerTask(enum KNS_OS_taskHdlr_t tskHdlr, void (*taskFctPtr)(void))
+{
+	if (tskHdlr < KNS_OS_TASK_MAX) {
+		taskPool[tskHdlr] = taskFctPtr;
+		return KNS_STATUS_OK;
+	}
+	return KNS_STATUS_BAD_SETTING;
+}
+
+
+void KNS_OS_setTaskReady(enum KNS_OS_taskHdlr_t tskHdlr)
+{
+	if (tskHdlr < KNS_OS_TASK_MAX)
+		__atomic_fetch_or(&taskReadyMask, 1UL << tskHdlr, __ATOMIC_SEQ_CST);
+}
+
+bool KNS_OS_isSomeTaskReady(void)
+{
+#ifdef USE_BAREMETAL
+	if (KNS_Q_getPendingMask() != 0)
+		return true;
+#endif
+	return (taskReadyMask & ~(1UL << KNS_OS_TASK_IDLE)) != 0;
+}
+
+void KNS_OS_main(void)
+{
+	enum KNS_OS_taskHdlr_t tskHdlr;
+	__attribute__((unused)) uint32_t startCycles;
+
+	KNS_OS_PERF_START();
+
+	while (1) {
+		tskHdlr = KNS_OS_getNextTask();
+
+		/** Clear ready flag before running the task, so that any event raised meanwhile
+		 * schedules it again
+		 */
+		__atomic_fetch_and(&taskReadyMask, ~(1UL << tskHdlr), __ATOMIC_SEQ_CST);
+		if (taskPool[tskHdlr] != NULL) {
+			startCycles = KNS_OS_PERF_GET_CYCLES();
+			taskPool[tskHdlr]();
+			KNS_OS_PERF_TASK_RUN(tskHdlr, KNS_OS_PERF_GET_CYCLES() - startCycles);
+		}
+	}
+}
+
+#pragma GCC visibility pop
+
+#endif /* KNS_OS_BAREMETAL_C */
+
+/**
+ * @}
+ */
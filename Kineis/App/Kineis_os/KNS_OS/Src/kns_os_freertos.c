@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    kns_os_freertos.c
+ * @brief   Kineis OS abstraction on top of FreeRTOS
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup KNS_OS
+ * @brief Kineis SW OS utilities based on FreeRTOS
+ * @{
+ */
+
+#ifndef KNS_OS_FREERTOS_C
+#define KNS_OS_FREERTOS_C
+
+/* Includes ------------------------------------------------------------------------------------ */
+
+#include <stddef.h>
+
+#include "kns_os.h"
+#include "kns_q.h"
+#include "kineis_sw_conf.h"
+#include KINEIS_SW_ASSERT_H
+#include "mgr_log.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#pragma GCC visibility push(default)
+
+/* Variables ----------------------------------------------------------------------------------- */
+
+void (*taskPool[KNS_OS_TASK_MAX])(void) = {NULL};
+
+static TaskHandle_t taskRtosHandle[KNS_OS_TASK_MAX];
+
+/* Local functions ----------------------------------------------------------------------------- */
+
+/**
+ * @brief Get bitmap of the queues consumed by a task
+ *
+ * @param[in] tskHdlr: task handler
+ * @retval bitmap of queue handles, as per KNS_Q_getPendingMask
+ */
+static uint32_t KNS_OS_getTaskQMask(enum KNS_OS_taskHdlr_t tskHdlr)
+{
+	enum KNS_Q_handle_t qHandle;
+	uint32_t qMask = 0;
+
+	for (qHandle = 0; qHandle < KNS_Q_MAX; qHandle++) {
+		if (qConsumerTask[qHandle] == tskHdlr)
+			qMask |= 1UL << qHandle;
+	}
+
+	return qMask;
+}
+
+/**
+ * @brief RTOS task wrapping one Kineis OS task
+ *
+ * Kineis OS tasks are run-to-completion steps (same code as with baremetal Kineis OS). The wrapper
+ * runs the step as long as its queues hold some events, then blocks in the kernel until notified
+ * by a push into one of its queues or by @ref KNS_OS_setTaskReady.
+ *
+ * @param[in] param: Kineis OS task handler
+ */
+static void KNS_OS_taskEntry(void *param)
+{
+	enum KNS_OS_taskHdlr_t tskHdlr = (enum KNS_OS_taskHdlr_t)(uintptr_t)param;
+	uint32_t qMask = KNS_OS_getTaskQMask(tskHdlr);
+
+	while (1) {
+		taskPool[tskHdlr]();
+		if ((KNS_Q_getPendingMask() & qMask) == 0)
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	}
+}
+
+/* Function prototypes ------------------------------------------------------------------------- */
+
+enum KNS_status_t KNS_OS_registerTask(enum KNS_OS_taskHdlr_t tskHdlr, void (*taskFctPtr)(void))
+{
+	if (tskHdlr < KNS_OS_TASK_MAX) {
+		taskPool[tskHdlr] = taskFctPtr;
+		return KNS_STATUS_OK;
+	}
+	return KNS_STATUS_BAD_SETTING;
+}
+
+void KNS_OS_setTaskReady(enum KNS_OS_taskHdlr_t tskHdlr)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if ((tskHdlr >= KNS_OS_TASK_MAX) || (taskRtosHandle[tskHdlr] == NULL))
+		return;
+
+	if (xPortIsInsideInterrupt()) {
+		vTaskNotifyGiveFromISR(taskRtosHandle[tskHdlr], &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	} else
+		xTaskNotifyGive(taskRtosHandle[tskHdlr]);
+}
+
+bool KNS_OS_isSomeTaskReady(void)
+{
+	return KNS_Q_isEvtInSomeQ();
+}
+
+void KNS_OS_preSleepProcessing(uint32_t *expectedIdleTime)
+{
+	if (taskPool[KNS_OS_TASK_IDLE] == NULL)
+		return;
+
+	/** IDLE task enters LPM through LPM manager (WFI included), kernel shall not do it again */
+	taskPool[KNS_OS_TASK_IDLE]();
+	*expectedIdleTime = 0;
+}
+
+void KNS_OS_main(void)
+{
+	uint8_t idx;
+	BaseType_t xStatus;
+
+	/** IDLE task is not an RTOS task, it is run from tickless idle (cf KNS_OS_preSleepProcessing)
+	 */
+	for (idx = 0; idx < KNS_OS_TASK_MAX; idx++) {
+		if ((taskPool[idx] == NULL) || (idx == KNS_OS_TASK_IDLE))
+			continue;
+		xStatus = xTaskCreate(KNS_OS_taskEntry, "KNS_OS", KNS_OS_RTOS_STACK_DEPTH,
+			(void *)(uintptr_t)idx, KNS_OS_RTOS_PRIO_BASE + idx, &taskRtosHandle[idx]);
+		kns_assert(xStatus == pdPASS);
+		MGR_LOG_VERBOSE("[KNS_OS] task %d created, RTOS prio %d\r\n", idx,
+			KNS_OS_RTOS_PRIO_BASE + idx);
+	}
+
+	vTaskStartScheduler();
+
+	/** Scheduler only returns when there is not enough heap for idle/timer tasks */
+	kns_assert(0);
+	while (1)
+		;
+}
+
+#pragma GCC visibility pop
+
+#endif /* KNS_OS_FREERTOS_C */
+
+/**
+ * @}
+ */
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    kns_os_perf.c
+ * @brief   Runtime profiling of baremetal Kineis OS tasks and queues
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup KNS_OS
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------------------------ */
+
+#include <string.h>
+
+#include "kns_os_perf.h"
+
+#ifdef KNS_OS_PERF
+
+#include "kns_cs.h"
+#ifdef USE_POSIX
+#include <time.h>
+#else
+#include "mcu_misc.h"
+#endif
+
+#pragma GCC visibility push(default)
+
+/* Variables ----------------------------------------------------------------------------------- */
+
+static struct KNS_OS_PERF_task_t taskStats[KNS_OS_TASK_MAX];
+static struct KNS_OS_PERF_q_t qStats[KNS_Q_MAX];
+
+/* Function prototypes ------------------------------------------------------------------------- */
+
+void KNS_OS_PERF_start(void)
+{
+#ifndef USE_POSIX
+	MCU_MISC_cycleCntStart();
+#endif
+	KNS_OS_PERF_reset();
+}
+
+void KNS_OS_PERF_reset(void)
+{
+	uint32_t csMask;
+
+	/** Queue statistics may be updated from ISR */
+	csMask = KNS_CS_enterSave();
+	memset(taskStats, 0, sizeof(taskStats));
+	memset(qStats, 0, sizeof(qStats));
+	KNS_CS_exitRestore(csMask);
+}
+
+void KNS_OS_PERF_getTaskStats(enum KNS_OS_taskHdlr_t tskHdlr, struct KNS_OS_PERF_task_t *stats)
+{
+	*stats = taskStats[tskHdlr];
+}
+
+void KNS_OS_PERF_getQStats(enum KNS_Q_handle_t qHandle, struct KNS_OS_PERF_q_t *stats)
+{
+	uint32_t csMask;
+
+	csMask = KNS_CS_enterSave();
+	*stats = qStats[qHandle];
+	KNS_CS_exitRestore(csMask);
+}
+
+uint32_t KNS_OS_PERF_getCycles(void)
+{
+#ifdef USE_POSIX
+	/** No cycle counter on host, nanoseconds of monotonic clock are used instead */
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+#else
+	return MCU_MISC_getCycleCnt();
+#endif
+}
+
+void KNS_OS_PERF_taskRun(enum KNS_OS_taskHdlr_t tskHdlr, uint32_t cycles)
+{
+	struct KNS_OS_PERF_task_t *stats = &taskStats[tskHdlr];
+
+	stats->nbRun++;
+	stats->cyclesTotal += cycles;
+	if (cycles > stats->cyclesMax)
+		stats->cyclesMax = cycles;
+}
+
+void KNS_OS_PERF_qPush(enum KNS_Q_handle_t qHandle, uint8_t level)
+{
+	struct KNS_OS_PERF_q_t *stats = &qStats[qHandle];
+	uint8_t maxLevel = __atomic_load_n(&stats->maxLevel, __ATOMIC_RELAXED);
+
+	__atomic_fetch_add(&stats->nbPush, 1, __ATOMIC_RELAXED);
+	while ((level > maxLevel) && !__atomic_compare_exchange_n(&stats->maxLevel, &maxLevel,
+		level, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+}
+
+void KNS_OS_PERF_qPop(enum KNS_Q_handle_t qHandle)
+{
+	__atomic_fetch_add(&qStats[qHandle].nbPop, 1, __ATOMIC_RELAXED);
+}
+
+void KNS_OS_PERF_qFull(enum KNS_Q_handle_t qHandle)
+{
+	__atomic_fetch_add(&qStats[qHandle].nbQFull, 1, __ATOMIC_RELAXED);
+}
+
+#pragma GCC visibility pop
+
+#endif // end of KNS_OS_PERF
+
+/**
+ * @}
+ */
@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    kns_os_posix.c
+ * @brief   Kineis OS abstraction on POSIX host (pthreads)
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup KNS_OS
+ * @brief Kineis SW OS utilities on POSIX host
+ * @{
+ */
+
+#ifndef KNS_OS_POSIX_C
+#define KNS_OS_POSIX_C
+
+/* Includes ------------------------------------------------------------------------------------ */
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "kns_os.h"
+#include "kns_os_perf.h"
+#include "kns_q.h"
+#include "kineis_sw_conf.h"
+#include KINEIS_SW_ASSERT_H
+#include "mgr_log.h"
+
+#pragma GCC visibility push(default)
+
+/* Structures ---------------------------------------------------------------------------------- */
+
+/**
+ * @struct KNS_OS_posixTask_t
+ * @brief Thread context of one Kineis OS task
+ *
+ * Notification works as an RTOS binary task notification: set by producers, consumed by the task
+ * when it blocks. Mutex and condition are only used when the task actually sleeps, so pushing
+ * into the queue of a running task stays lock-free.
+ */
+struct KNS_OS_posixTask_t {
+	pthread_t thread;      /**< thread running the task */
+	pthread_mutex_t lock;  /**< protects sleeping on cond */
+	pthread_cond_t cond;   /**< signaled on notification when task sleeps */
+	uint32_t notified;     /**< pending notification */
+	uint32_t sleeping;     /**< task is blocked (or about to block) on cond */
+};
+
+/* Variables ----------------------------------------------------------------------------------- */
+
+void (*taskPool[KNS_OS_TASK_MAX])(void) = {NULL};
+
+static struct KNS_OS_posixTask_t taskCtx[KNS_OS_TASK_MAX] = {
+	[0 ... KNS_OS_TASK_MAX - 1] = {
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.cond = PTHREAD_COND_INITIALIZER
+	}
+};
+
+/* Local functions ----------------------------------------------------------------------------- */
+
+/**
+ * @brief Get bitmap of the queues consumed by a task
+ *
+ * @param[in] tskHdlr: task handler
+ * @retval bitmap of queue handles, as per KNS_Q_getPendingMask
+ */
+static uint32_t KNS_OS_getTaskQMask(enum KNS_OS_taskHdlr_t tskHdlr)
+{
+	enum KNS_Q_handle_t qHandle;
+	uint32_t qMask = 0;
+
+	for (qHandle = 0; qHandle < KNS_Q_MAX; qHandle++) {
+		if (qConsumerTask[qHandle] == tskHdlr)
+			qMask |= 1UL << qHandle;
+	}
+
+	return qMask;
+}
+
+/**
+ * @brief Give notification to a task, waking it up if it sleeps
+ *
+ * Notification is set before sleeping flag is checked, task sets sleeping flag before checking
+ * notification (sequentially consistent accesses), so one of both sides always sees the other.
+ *
+ * @param[in] tskHdlr: task handler
+ */
+static void KNS_OS_notify(enum KNS_OS_taskHdlr_t tskHdlr)
+{
+	struct KNS_OS_posixTask_t *ctx = &taskCtx[tskHdlr];
+
+	__atomic_store_n(&ctx->notified, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&ctx->sleeping, __ATOMIC_SEQ_CST) != 0) {
+		pthread_mutex_lock(&ctx->lock);
+		pthread_cond_signal(&ctx->cond);
+		pthread_mutex_unlock(&ctx->lock);
+	}
+}
+
+/**
+ * @brief Block calling task until it is notified, then consume the notification
+ *
+ * Once flagged as sleeping, a task notifies IDLE task so that it checks whether the whole system
+ * is idle. Last task going to sleep is thus always seen by IDLE task.
+ *
+ * @param[in] tskHdlr: task handler
+ */
+static void KNS_OS_waitNotification(enum KNS_OS_taskHdlr_t tskHdlr)
+{
+	struct KNS_OS_posixTask_t *ctx = &taskCtx[tskHdlr];
+
+	pthread_mutex_lock(&ctx->lock);
+	__atomic_store_n(&ctx->sleeping, 1, __ATOMIC_SEQ_CST);
+	if (tskHdlr != KNS_OS_TASK_IDLE)
+		KNS_OS_notify(KNS_OS_TASK_IDLE);
+	while (__atomic_exchange_n(&ctx->notified, 0, __ATOMIC_SEQ_CST) == 0)
+		pthread_cond_wait(&ctx->cond, &ctx->lock);
+	__atomic_store_n(&ctx->sleeping, 0, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&ctx->lock);
+}
+
+/**
+ * @brief Thread wrapping one Kineis OS task
+ *
+ * Kineis OS tasks are run-to-completion steps (same code as with baremetal Kineis OS). The thread
+ * runs the step as long as its queues hold some events, then blocks until notified by a commit
+ * into one of its queues or by @ref KNS_OS_setTaskReady.
+ *
+ * @param[in] param: Kineis OS task handler
+ * @retval never returns
+ */
+static void *KNS_OS_taskEntry(void *param)
+{
+	enum KNS_OS_taskHdlr_t tskHdlr = (enum KNS_OS_taskHdlr_t)(uintptr_t)param;
+	uint32_t qMask = KNS_OS_getTaskQMask(tskHdlr);
+	__attribute__((unused)) uint32_t startCycles;
+
+	while (1) {
+		startCycles = KNS_OS_PERF_GET_CYCLES();
+		taskPool[tskHdlr]();
+		KNS_OS_PERF_TASK_RUN(tskHdlr, KNS_OS_PERF_GET_CYCLES() - startCycles);
+		if ((KNS_Q_getPendingMask() & qMask) == 0)
+			KNS_OS_waitNotification(tskHdlr);
+	}
+
+	return NULL;
+}
+
+/* Function prototypes ------------------------------------------------------------------------- */
+
+enum KNS_status_t KNS_OS_registerTask(enum KNS_OS_taskHdlr_t tskHdlr, void (*taskFctPtr)(void))
+{
+	if (tskHdlr < KNS_OS_TASK_MAX) {
+		taskPool[tskHdlr] = taskFctPtr;
+		return KNS_STATUS_OK;
+	}
+	return KNS_STATUS_BAD_SETTING;
+}
+
+void KNS_OS_setTaskReady(enum KNS_OS_taskHdlr_t tskHdlr)
+{
+	if ((tskHdlr >= KNS_OS_TASK_MAX) || (tskHdlr == KNS_OS_TASK_IDLE) ||
+		(taskPool[tskHdlr] == NULL))
+		return;
+
+	KNS_OS_notify(tskHdlr);
+}
+
+bool KNS_OS_isSomeTaskReady(void)
+{
+	uint8_t idx;
+
+	if (KNS_Q_isEvtInSomeQ())
+		return true;
+
+	for (idx = 0; idx < KNS_OS_TASK_MAX; idx++) {
+		if ((idx != KNS_OS_TASK_IDLE) &&
+			((__atomic_load_n(&taskCtx[idx].notified, __ATOMIC_SEQ_CST) != 0) ||
+			(__atomic_load_n(&taskCtx[idx].sleeping, __ATOMIC_SEQ_CST) == 0)))
+			return true;
+	}
+
+	return false;
+}
+
+void KNS_OS_main(void)
+{
+	uint8_t idx;
+	int err;
+
+	KNS_OS_PERF_START();
+
+	/** IDLE task is run from calling thread, once every other task sleeps */
+	for (idx = 0; idx < KNS_OS_TASK_MAX; idx++) {
+		if ((taskPool[idx] == NULL) || (idx == KNS_OS_TASK_IDLE)) {
+			__atomic_store_n(&taskCtx[idx].sleeping, 1, __ATOMIC_SEQ_CST);
+			continue;
+		}
+		err = pthread_create(&taskCtx[idx].thread, NULL, KNS_OS_taskEntry,
+			(void *)(uintptr_t)idx);
+		kns_assert(err == 0);
+		MGR_LOG_VERBOSE("[KNS_OS] task %d created\r\n", idx);
+	}
+
+	while (1) {
+		KNS_OS_waitNotification(KNS_OS_TASK_IDLE);
+		if ((taskPool[KNS_OS_TASK_IDLE] != NULL) && !KNS_OS_isSomeTaskReady())
+			taskPool[KNS_OS_TASK_IDLE]();
+	}
+}
+
+#pragma GCC visibility pop
+
+#endif /* KNS_OS_POSIX_C */
+
+/**
+ * @}
+ */
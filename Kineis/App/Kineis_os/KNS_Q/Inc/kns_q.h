@@ -41,6 +41,21 @@
  * There is write and read pointer to the cells of the array. Roll-over is handled. Check on FIFO
  * full and FIFO empty is done.
  *
+ * In baremetal, queues are lock-free rings: no critical section is taken during push/pop, so the
+ * copy of a large event does not delay RF or UART interrupts. Each queue has one consumer context
+ * (a task) which alone moves the read index. Producers may be a task and/or ISRs: a producer claims
+ * its slot with an atomic compare-and-swap, then the outermost producer publishes the write index
+ * with release ordering once every nested producer is done. Slots are word-aligned and copied
+ * word by word.
+ *
+ * On POSIX host (USE_POSIX), producers are parallel threads rather than nested ISRs, so each slot
+ * carries a sequence number telling whether it is free, committed or released (refer to
+ * kns_q_posix.c). Push and pop stay lock-free as well.
+ *
+ * Large events should be handled in place: producer builds its event into queue storage between
+ * KNS_Q_reserve() and KNS_Q_commit(), consumer reads it between KNS_Q_peek() and KNS_Q_release().
+ * KNS_Q_push() and KNS_Q_pop() are thin wrappers around those, copying the element once.
+ *
  * @attention due to simple FIFO-full mechanism implemented so far, queues needs to be one element
  * longer than expected by the system, in case of baremetaol Kineis OS.
  *
@@ -67,6 +82,11 @@
 
 #pragma GCC visibility push(default)
 
+/* Defines ------------------------------------------------------------------------------------- */
+
+/** Timeout value for @ref KNS_Q_popWait, to wait until some element is received */
+#define KNS_Q_WAIT_FOREVER 0xFFFFFFFFUL
+
 /* Structures ---------------------------------------------------------------------------------- */
 
 /* Function prototypes ------------------------------------------------------------------------- */
@@ -94,12 +114,11 @@ enum KNS_status_t KNS_Q_create(enum KNS_Q_handle_t qHandle, uint8_t qLength, uin
 /**
  * @brief This function is used to push an element into a queue
  *
- * As this routine may be invoked from different ISR/TASK context, processing is under critical
- * section.
+ * This routine may be invoked from different ISR/TASK contexts. In baremetal, it is lock-free:
+ * slot is claimed atomically and element is copied without masking interrupts.
  *
- * @attention In case of FreeRTOS, This routine does not handle being call from ISR context so far.
- * @todo Check caller is from ISR context or not, and call corresponding xQueueSendToBack(FomISR)
- * fct in consequence.
+ * With an RTOS, routine is ISR-aware (FromISR kernel services are used when needed) and the task
+ * consuming the queue is notified (cf @ref KNS_OS_setTaskReady).
  *
  * @param[in] qHandle: queue handle
  * @param[in] qItem: pointer to queue element
@@ -111,26 +130,96 @@ enum KNS_status_t KNS_Q_push(enum KNS_Q_handle_t qHandle, void *qItem);
 /**
  * @brief This function is used to pop next element from a queue
  *
- * As this routine may be invoked from different ISR/TASK context, processing is under critical
- * section.
- *
- * @attention In case of FreeRTOS, This routine does not handle being call from ISR context so far.
- * @todo Check caller is from ISR context or not, and call corresponding xQueueReceive(FomISR)
- * fct in consequence.
+ * Each queue has a single consumer context. In baremetal, pop is lock-free and relies on this:
+ * read index is only ever updated by the consumer.
  *
- * @todo In case of FREERTOS and CMSIS2, fix behaviour, it should return:
- * * KNS_STATUS_QEMPTY when queue was empty,
- * * KNS_STATUS_OK means some valid element received,
- * * KNS_STATUS_ERROR for any other reason
+ * This routine never blocks. Refer to @ref KNS_Q_popWait to wait for an element with an RTOS.
  *
  * @param[in] qHandle: queue handle
  * @param[in] qItem: pointer to queue element
  * @retval KNS_status_t status: KNS_STATUS_OK if some element was found,
- * KNS_STATUS_EMPTY if no element present in queue, KNS_STATUS_ERROR otherwise
+ * KNS_STATUS_QEMPTY if no element present in queue, KNS_STATUS_ERROR otherwise
  */
 enum KNS_status_t KNS_Q_pop(enum KNS_Q_handle_t qHandle, void *qItem);
 
-#ifdef USE_BAREMETAL
+#ifndef USE_BAREMETAL
+/**
+ * @brief This function is used to pop next element from a queue, waiting for it if needed
+ *
+ * Calling task is blocked in the kernel until some element is pushed or timeout elapses.
+ *
+ * @note Only available with an RTOS. Baremetal Kineis OS is run-to-completion, tasks cannot block.
+ *
+ * @param[in] qHandle: queue handle
+ * @param[in] qItem: pointer to queue element
+ * @param[in] timeoutMs: maximum waiting time in ms, KNS_Q_WAIT_FOREVER to wait without limit
+ * @retval KNS_status_t status: KNS_STATUS_OK if some element was received,
+ * KNS_STATUS_QEMPTY if timeout elapsed, KNS_STATUS_ERROR otherwise
+ */
+enum KNS_status_t KNS_Q_popWait(enum KNS_Q_handle_t qHandle, void *qItem, uint32_t timeoutMs);
+#endif
+
+/**
+ * @brief Reserve next free element of a queue, so that producer builds it in place
+ *
+ * Zero-copy counterpart of @ref KNS_Q_push. On success, the element pointed by qItem belongs to
+ * the producer until @ref KNS_Q_commit is called, which makes it visible to the consumer.
+ *
+ * @attention Every successful reservation shall be committed, in the same order and from the
+ * same context. An ISR shall commit its reservation before returning. While a task holds a
+ * reservation, elements pushed by ISRs into the same queue are only delivered on its commit.
+ *
+ * @note With RTOS backends (FreeRTOS, CMSIS-OS2), element is built in a staging buffer then copied
+ * into the RTOS queue on commit. There is one staging buffer for tasks and one for ISRs per queue,
+ * thus a single producer per context: reserving again before commit from the same context (e.g.
+ * another task, a nested ISR) returns KNS_STATUS_ERROR. Free space is checked at reservation only,
+ * so that commit may still return KNS_STATUS_QFULL when another producer filled the queue.
+ *
+ * @param[in] qHandle: queue handle
+ * @param[out] qItem: pointer to the reserved element, NULL if none
+ * @retval KNS_status_t status: KNS_STATUS_OK if element was reserved,
+ * KNS_STATUS_QFULL if no more place in queue, KNS_STATUS_ERROR otherwise.
+ */
+enum KNS_status_t KNS_Q_reserve(enum KNS_Q_handle_t qHandle, void **qItem);
+
+/**
+ * @brief Commit an element previously reserved with @ref KNS_Q_reserve
+ *
+ * @param[in] qHandle: queue handle
+ * @param[in] qItem: pointer to the reserved element
+ * @retval KNS_status_t status: KNS_STATUS_OK if element was committed, KNS_STATUS_QFULL if queue
+ * got full since reservation (RTOS backends), KNS_STATUS_ERROR otherwise.
+ */
+enum KNS_status_t KNS_Q_commit(enum KNS_Q_handle_t qHandle, void *qItem);
+
+/**
+ * @brief Get next element of a queue in place, without removing it
+ *
+ * Zero-copy counterpart of @ref KNS_Q_pop. The element stays owned by the consumer until
+ * @ref KNS_Q_release is called; its storage shall not be accessed afterwards.
+ *
+ * @attention With RTOS backends (FreeRTOS, CMSIS-OS2), peek is destructive: element is popped from
+ * the RTOS queue into a staging buffer, @ref KNS_Q_release only hands this buffer back. Element is
+ * no more seen as pending in queue, and it is lost if not processed. One shall not peek again
+ * before releasing.
+ *
+ * @param[in] qHandle: queue handle
+ * @param[out] qItem: pointer to next element, NULL if none
+ * @retval KNS_status_t status: KNS_STATUS_OK if some element was found,
+ * KNS_STATUS_QEMPTY if no element present in queue, KNS_STATUS_ERROR otherwise
+ */
+enum KNS_status_t KNS_Q_peek(enum KNS_Q_handle_t qHandle, void **qItem);
+
+/**
+ * @brief Release an element previously obtained with @ref KNS_Q_peek
+ *
+ * @param[in] qHandle: queue handle
+ * @param[in] qItem: pointer to the element returned by @ref KNS_Q_peek
+ * @retval KNS_status_t status: KNS_STATUS_OK if element was removed from queue,
+ * KNS_STATUS_ERROR otherwise
+ */
+enum KNS_status_t KNS_Q_release(enum KNS_Q_handle_t qHandle, void *qItem);
+
 /**
  * @brief This function is used to check some higher-priority queue contains elements, meaning
  * preemption is required.
@@ -138,6 +227,9 @@ enum KNS_status_t KNS_Q_pop(enum KNS_Q_handle_t qHandle, void *qItem);
  * This function is aimed to be used inside some lower-priority event scheduler to check exit is
  * required because higher-priority event scheduler needs to preempt.
  *
+ * In baremetal, constant time: queue handles being sorted by priority, this is a masked test of the
+ * pending-queue bitmap maintained on commit/release.
+ *
  * @param[in] qHandle: queue handle
  * @retval true if some element present in higher priority queue, false otherwise.
  */
@@ -149,10 +241,21 @@ bool KNS_Q_isEvtInHigherPrioQ(enum KNS_Q_handle_t qHandle);
  * This function is aimed to be used inside some IDLE task to ensure it is possible to go into low
  * power
  *
+ * In baremetal, constant time: single load of the pending-queue bitmap.
+ *
  * @retval true if some element present in higher priority queue, false otherwise.
  */
 bool KNS_Q_isEvtInSomeQ(void);
-#endif
+
+/**
+ * @brief This function is used to get the bitmap of queues containing some elements
+ *
+ * Bit n is set when queue of handle n is not empty. Baremetal Kineis OS scheduler uses it to find
+ * which task has some event to process.
+ *
+ * @retval bitmap of non-empty queues
+ */
+uint32_t KNS_Q_getPendingMask(void);
 
 #pragma GCC visibility pop
 
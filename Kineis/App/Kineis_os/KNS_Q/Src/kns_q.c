@@ -38,6 +38,15 @@
 #include "kns_q_cmsis_os2.c"
 #endif
 
+#ifdef USE_POSIX
+#if (defined(USE_BAREMETAL) && (USE_BAREMETAL == 1U)) || \
+(defined(USE_FREERTOS) && (USE_FREERTOS == 1U)) || \
+(defined(USE_CMSIS_OS2) && (USE_CMSIS_OS2 == 1U))
+#error choose one single Os in KNS libs
+#endif
+#include "kns_q_posix.c"
+#endif
+
 /**
  * @}
  */
@@ -19,9 +19,11 @@
 
 /* Includes ------------------------------------------------------------------------------------ */
 
-#include "kns_cs.h"
+#include <stddef.h>
+
 #include "kns_q_conf.h"
 #include "kns_q.h"
+#include "kns_os_perf.h"
 
 //#undef VERBOSE
 #include "mgr_log.h"
@@ -33,6 +35,13 @@
 
 extern struct q_desc_t *qPool[KNS_Q_MAX];
 
+/** Bitmap of non-empty queues, bit n set when queue of handle n holds some published element.
+ * Set by producers after publishing, cleared by consumer when it releases the last element.
+ */
+static volatile uint32_t qPendingMask;
+
+_Static_assert(KNS_Q_MAX <= 32, "pending-queue bitmap holds up to 32 queues");
+
 /* Local functions ----------------------------------------------------------------------------- */
 
 /**
@@ -49,6 +58,106 @@ static void MGR_LOG_VERBOSE_array(__attribute__((unused)) uint8_t *data, uint16_
 	MGR_LOG_VERBOSE_RAW("\r\n");
 }
 
+/**
+ * @brief  Copy one queue element, word by word when both ends are word-aligned
+ *
+ * Queue slots are always word-aligned. Caller's item usually is too (event structs start with
+ * an enum), so large MAC events are moved with 32-bit accesses instead of byte per byte.
+ *
+ * @param[out] dst: destination buffer
+ * @param[in] src: source buffer
+ * @param[in] size: number of bytes to copy
+ */
+static void KNS_Q_eltCopy(void *dst, const void *src, uint16_t size)
+{
+	uint8_t *dst8 = (uint8_t *)dst;
+	const uint8_t *src8 = (const uint8_t *)src;
+
+	if ((((uintptr_t)dst8 | (uintptr_t)src8) & (sizeof(uint32_t) - 1)) == 0) {
+		uint32_t *dst32 = (uint32_t *)dst8;
+		const uint32_t *src32 = (const uint32_t *)src8;
+
+		for (; size >= sizeof(uint32_t); size -= sizeof(uint32_t))
+			*dst32++ = *src32++;
+		dst8 = (uint8_t *)dst32;
+		src8 = (const uint8_t *)src32;
+	}
+	while (size--)
+		*dst8++ = *src8++;
+}
+
+/**
+ * @brief  Get address of one slot of the queue
+ * @param[in] q: queue descriptor
+ * @param[in] idx: slot index
+ * @retval pointer to the word-aligned slot
+ */
+static inline uint32_t *KNS_Q_slot(const struct q_desc_t *q, uint8_t idx)
+{
+	return q->data + (uint32_t)KNS_Q_ELT_WORDSIZE(q->eltSize) * idx;
+}
+
+/**
+ * @brief  Claim next free slot of the queue for a producer
+ *
+ * Slot is claimed with a compare-and-swap on the reservation index, so producers running from
+ * nested ISR contexts never get the same slot. Nesting counter is incremented first, so that only
+ * the outermost producer publishes the write index (@ref KNS_Q_slotPublish).
+ *
+ * @param[in] q: queue descriptor
+ * @param[out] idx: claimed slot index
+ * @retval true if a slot was claimed, false if queue is full
+ */
+static bool KNS_Q_slotClaim(struct q_desc_t *q, uint8_t *idx)
+{
+	uint8_t resvIdx, resvIdxNext;
+
+	__atomic_add_fetch(&q->wNest, 1, __ATOMIC_ACQUIRE);
+
+	resvIdx = __atomic_load_n(&q->wResvIdx, __ATOMIC_RELAXED);
+	do {
+		/** Check FIFO full, @note, with this mechanism, there is always one empty element
+		 *  before FIFO full
+		 */
+		resvIdxNext = (resvIdx + 1) % q->nbElt;
+		if (resvIdxNext == __atomic_load_n(&q->rIdx, __ATOMIC_ACQUIRE)) {
+			__atomic_sub_fetch(&q->wNest, 1, __ATOMIC_RELEASE);
+			return false;
+		}
+	} while (!__atomic_compare_exchange_n(&q->wResvIdx, &resvIdx, resvIdxNext, true,
+		__ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+	*idx = resvIdx;
+	return true;
+}
+
+/**
+ * @brief  Publish slots written by producers to the consumer
+ *
+ * As ISR producers are nested (an ISR producer always completes before the interrupted context
+ * resumes), all claimed slots are fully written once nesting counter gets back to zero. Only the
+ * outermost producer then moves the write index up to the reservation index. Publication is
+ * retried in case a new producer slipped in between the load and the store, so the write index
+ * never goes backward. Queue is then flagged in the pending-queue bitmap.
+ *
+ * @param[in] qHandle: queue handle
+ */
+static void KNS_Q_slotPublish(enum KNS_Q_handle_t qHandle)
+{
+	struct q_desc_t *q = qPool[qHandle];
+	uint8_t resvIdx;
+
+	if (__atomic_sub_fetch(&q->wNest, 1, __ATOMIC_RELEASE) != 0)
+		return;
+
+	do {
+		resvIdx = __atomic_load_n(&q->wResvIdx, __ATOMIC_ACQUIRE);
+		__atomic_store_n(&q->wIdx, resvIdx, __ATOMIC_RELEASE);
+	} while (resvIdx != __atomic_load_n(&q->wResvIdx, __ATOMIC_ACQUIRE));
+
+	__atomic_fetch_or(&qPendingMask, 1UL << qHandle, __ATOMIC_SEQ_CST);
+}
+
 /* Function prototypes ------------------------------------------------------------------------- */
 
 #ifndef UNIT_TEST
@@ -68,47 +177,37 @@ enum KNS_status_t KNS_Q_create(enum KNS_Q_handle_t qHandle, uint8_t qLength, uin
 #ifndef UNIT_TEST
 __attribute((__weak__))
 #endif
-enum KNS_status_t KNS_Q_push(enum KNS_Q_handle_t qHandle, void *qItem)
+enum KNS_status_t KNS_Q_reserve(enum KNS_Q_handle_t qHandle, void **qItem)
 {
-	uint16_t eltIdx;
-	uint8_t wIdxNext;
-	uint8_t *qEltPtr, *qItemPtr;
+	uint8_t wIdx;
 	struct q_desc_t *q = qPool[qHandle];
-	uint8_t wIdxPrev = q->wIdx;
 
-	/** Get queue's mutex to write into FIFO
-	 */
-	KNS_CS_enter();
-
-	while (q->mutex == true)
-		;
-	q->mutex = true;
-
-	/** Check FIFO full, @note, with this mechanism, there is always one empty element before
-	 *  FIFO full
-	 */
-	wIdxNext = (q->wIdx  + 1) % q->nbElt;
-	if (wIdxNext == q->rIdx) {
-		q->mutex = false;
-		KNS_CS_exit();
-		MGR_LOG_DEBUG("[KNS_Q] push QFULL %s, idx %d, evt=0x%x\r\n", qIdx2Str[qHandle],
-			wIdxPrev, ((uint8_t *)qItem)[0]);
+	if (!KNS_Q_slotClaim(q, &wIdx)) {
+		MGR_LOG_DEBUG("[KNS_Q] reserve QFULL %s, idx %d\r\n", qIdx2Str[qHandle],
+			q->wResvIdx);
+		KNS_OS_PERF_Q_FULL(qHandle);
+		*qItem = NULL;
 		return KNS_STATUS_QFULL;
 	}
 
-	qEltPtr = q->data + q->eltSize * q->wIdx;
-	qItemPtr = (uint8_t *)qItem;
-	for (eltIdx = 0; eltIdx < q->eltSize; eltIdx++)
-		qEltPtr[eltIdx] = qItemPtr[eltIdx];
+	*qItem = KNS_Q_slot(q, wIdx);
+	return KNS_STATUS_OK;
+}
 
-	q->wIdx = wIdxNext;
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_commit(enum KNS_Q_handle_t qHandle, void *qItem)
+{
+	struct q_desc_t *q = qPool[qHandle];
 
-	q->mutex = false;
-	KNS_CS_exit();
+	KNS_OS_PERF_Q_PUSH(qHandle, (q->wResvIdx + q->nbElt - q->rIdx) % q->nbElt);
+	KNS_Q_slotPublish(qHandle);
 
 	MGR_LOG_VERBOSE("[KNS_Q] push q %s, idx %d, size %d: ", qIdx2Str[qHandle],
-		wIdxPrev, q->eltSize);
-	MGR_LOG_VERBOSE_array(qEltPtr, q->eltSize);
+		(uint8_t)(((uint32_t *)qItem - q->data) / KNS_Q_ELT_WORDSIZE(q->eltSize)),
+		q->eltSize);
+	MGR_LOG_VERBOSE_array((uint8_t *)qItem, q->eltSize);
 
 	return KNS_STATUS_OK;
 }
@@ -116,14 +215,29 @@ enum KNS_status_t KNS_Q_push(enum KNS_Q_handle_t qHandle, void *qItem)
 #ifndef UNIT_TEST
 __attribute((__weak__))
 #endif
-enum KNS_status_t KNS_Q_pop(enum KNS_Q_handle_t qHandle, void *qItem)
+enum KNS_status_t KNS_Q_push(enum KNS_Q_handle_t qHandle, void *qItem)
 {
-	uint16_t eltIdx;
-	uint8_t *qEltPtr, *qItemPtr;
-	struct q_desc_t *q = qPool[qHandle];
-#if (defined(VERBOSE))
-	uint8_t rIdxPrev = q->rIdx;
+	enum KNS_status_t status;
+	void *qEltPtr;
+
+	status = KNS_Q_reserve(qHandle, &qEltPtr);
+	if (status != KNS_STATUS_OK)
+		return status;
+
+	KNS_Q_eltCopy(qEltPtr, qItem, qPool[qHandle]->eltSize);
+
+	return KNS_Q_commit(qHandle, qEltPtr);
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
 #endif
+enum KNS_status_t KNS_Q_peek(enum KNS_Q_handle_t qHandle, void **qItem)
+{
+	struct q_desc_t *q = qPool[qHandle];
+	uint8_t rIdx = q->rIdx;
+
+	*qItem = NULL;
 
 	/** Report current is empty if some event prensent in some higher-priority queues.
 	 * This way, Kineis OS main loop will let corresponding task to process thoses events.
@@ -131,50 +245,76 @@ enum KNS_status_t KNS_Q_pop(enum KNS_Q_handle_t qHandle, void *qItem)
 	if (KNS_Q_isEvtInHigherPrioQ(qHandle))
 		return KNS_STATUS_QEMPTY;
 
-	/** Get queue's mutex to update read pointer of the FIFO
-	 */
-	KNS_CS_enter();
-	while (q->mutex == true)
-		;
-	q->mutex = true;
-
-	/** Check FIFO empty, @note, with this mechanism, there is always one empty element before
-	 *  FIFO full
+	/** Check FIFO empty. Acquire on write index ensures slot content is read after producer
+	 * completed it. Queue has a single consumer, so read index is only updated from here.
 	 */
-	if (q->rIdx == q->wIdx) {
-		q->mutex = false;
-		KNS_CS_exit();
+	if (rIdx == __atomic_load_n(&q->wIdx, __ATOMIC_ACQUIRE)) {
 		//MGR_LOG_VERBOSE("[KNS_Q] pop QEMPTY %s\r\n", qIdx2Str[qHandle]);
 		return KNS_STATUS_QEMPTY;
 	}
 
-	qEltPtr = q->data + q->eltSize * q->rIdx;
-	qItemPtr = (uint8_t *)qItem;
-	for (eltIdx = 0; eltIdx < q->eltSize; eltIdx++)
-		qItemPtr[eltIdx] = qEltPtr[eltIdx];
+	*qItem = KNS_Q_slot(q, rIdx);
+	return KNS_STATUS_OK;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_release(enum KNS_Q_handle_t qHandle, void *qItem)
+{
+	struct q_desc_t *q = qPool[qHandle];
+	uint8_t rIdx = q->rIdx;
+
+	if ((rIdx == q->wIdx) || (qItem != KNS_Q_slot(q, rIdx)))
+		return KNS_STATUS_ERROR;
+
+	/** Give slot back to producers once consumer is done with it */
+	rIdx = (rIdx + 1) % q->nbElt;
+	__atomic_store_n(&q->rIdx, rIdx, __ATOMIC_RELEASE);
 
-	q->rIdx = (q->rIdx  + 1) % q->nbElt;
+	/** Clear pending flag when queue looks empty, then re-check: a producer publishing in
+	 * between has either set its flag after the clear, or made wIdx visible before it.
+	 */
+	if (rIdx == __atomic_load_n(&q->wIdx, __ATOMIC_SEQ_CST)) {
+		__atomic_fetch_and(&qPendingMask, ~(1UL << qHandle), __ATOMIC_SEQ_CST);
+		if (rIdx != __atomic_load_n(&q->wIdx, __ATOMIC_SEQ_CST))
+			__atomic_fetch_or(&qPendingMask, 1UL << qHandle, __ATOMIC_SEQ_CST);
+	}
 
-	q->mutex = false;
-	KNS_CS_exit();
+	KNS_OS_PERF_Q_POP(qHandle);
 
-	MGR_LOG_VERBOSE("[KNS_Q] pop  q %s, idx %d\r\n", qIdx2Str[qHandle], rIdxPrev);
+	MGR_LOG_VERBOSE("[KNS_Q] pop  q %s, idx %d\r\n", qIdx2Str[qHandle],
+		(rIdx + q->nbElt - 1) % q->nbElt);
 
 	return KNS_STATUS_OK;
 }
 
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_pop(enum KNS_Q_handle_t qHandle, void *qItem)
+{
+	enum KNS_status_t status;
+	void *qEltPtr;
+
+	status = KNS_Q_peek(qHandle, &qEltPtr);
+	if (status != KNS_STATUS_OK)
+		return status;
+
+	KNS_Q_eltCopy(qItem, qEltPtr, qPool[qHandle]->eltSize);
+
+	return KNS_Q_release(qHandle, qEltPtr);
+}
+
 bool KNS_Q_isEvtInHigherPrioQ(enum KNS_Q_handle_t qHandle)
 {
-	struct q_desc_t *q;
-	enum KNS_Q_handle_t qHandleTmp;
-
-	for (qHandleTmp = qHandle + 1; qHandleTmp <  KNS_Q_MAX; qHandleTmp++) {
-		q = qPool[qHandleTmp];
-		if (q->rIdx != q->wIdx) {
-			MGR_LOG_VERBOSE("[KNS_Q] higher-prio check q %s, evt found in q %s\r\n",
-				qIdx2Str[qHandle], qIdx2Str[qHandleTmp]);
-			return true;
-		}
+	/** Queues are sorted by priority, so higher-priority ones are the upper bits */
+	uint32_t higherPrioMask = qPendingMask & ~((2UL << qHandle) - 1);
+
+	if (higherPrioMask != 0) {
+		MGR_LOG_VERBOSE("[KNS_Q] higher-prio check q %s, evt found in q %s\r\n",
+			qIdx2Str[qHandle], qIdx2Str[__builtin_ctz(higherPrioMask)]);
+		return true;
 	}
 
 	return false;
@@ -182,21 +322,22 @@ bool KNS_Q_isEvtInHigherPrioQ(enum KNS_Q_handle_t qHandle)
 
 bool KNS_Q_isEvtInSomeQ()
 {
-	struct q_desc_t *q;
-	enum KNS_Q_handle_t qHandleTmp;
-
-	for (qHandleTmp = 0; qHandleTmp <  KNS_Q_MAX; qHandleTmp++) {
-		q = qPool[qHandleTmp];
-		if (q->rIdx != q->wIdx) {
-			MGR_LOG_VERBOSE("[KNS_Q] some-Q check, evt found in q %s\r\n",
-				qIdx2Str[qHandleTmp]);
-			return true;
-		}
+	uint32_t pendingMask = qPendingMask;
+
+	if (pendingMask != 0) {
+		MGR_LOG_VERBOSE("[KNS_Q] some-Q check, evt found in q %s\r\n",
+			qIdx2Str[__builtin_ctz(pendingMask)]);
+		return true;
 	}
 
 	return false;
 }
 
+uint32_t KNS_Q_getPendingMask(void)
+{
+	return qPendingMask;
+}
+
 #pragma GCC visibility pop
 
 #endif /* KNS_Q_BAREMETAL_C */
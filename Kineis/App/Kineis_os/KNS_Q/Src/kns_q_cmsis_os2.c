@@ -19,19 +19,41 @@
 
 /* Includes ------------------------------------------------------------------------------------ */
 
+#include <stdlib.h>
 #include "kns_q_conf.h"
 #include "kns_q.h"
 #include "mgr_log.h"
 #include "cmsis_os.h"
+#include "cmsis_compiler.h"
 
 #pragma GCC visibility push(default)
 
 /* Defines ------------------------------------------------------------------------------------- */
 
+/** Producer contexts owning a distinct staging element for reserve/commit */
+enum KNS_Q_stagingCtx_t {
+	KNS_Q_STAGING_TASK = 0,
+	KNS_Q_STAGING_ISR,
+	KNS_Q_STAGING_MAX
+};
+
 /* Structures ---------------------------------------------------------------------------------- */
 
 static void *qPoolHandle[KNS_Q_MAX];
 
+/** Staging elements used by reserve/commit and peek/release: RTOS queues copy by value, so
+ * element is built (resp. read) in those buffers then copied into (resp. out of) the RTOS queue.
+ *
+ * Tasks and ISRs reserve distinct elements, so that an ISR may reserve while it preempted a task
+ * holding a reservation. There is a single producer per context though: a queue reserved again
+ * before commit in the same context (e.g. two tasks, nested ISRs) is refused.
+ */
+static struct {
+	void *wr[KNS_Q_STAGING_MAX]; /**< element handed out by KNS_Q_reserve, per context */
+	bool wrBusy[KNS_Q_STAGING_MAX]; /**< element is reserved, not yet committed */
+	void *rd; /**< element handed out by KNS_Q_peek */
+} qStaging[KNS_Q_MAX];
+
 /* Function prototypes ------------------------------------------------------------------------- */
 
 #ifndef UNIT_TEST
@@ -45,6 +67,13 @@ enum KNS_status_t KNS_Q_create(enum KNS_Q_handle_t qHandle, uint8_t qLength, uin
 	osMessageQueueId = osMessageQueueNew(qLength, qEltByteSize, NULL);
 	if (osMessageQueueId != NULL) {
 		qPoolHandle[qHandle] = (void *)osMessageQueueId;
+		qStaging[qHandle].wr[KNS_Q_STAGING_TASK] = malloc(qEltByteSize);
+		qStaging[qHandle].wr[KNS_Q_STAGING_ISR] = malloc(qEltByteSize);
+		qStaging[qHandle].rd = malloc(qEltByteSize);
+		if ((qStaging[qHandle].wr[KNS_Q_STAGING_TASK] == NULL) ||
+		    (qStaging[qHandle].wr[KNS_Q_STAGING_ISR] == NULL) ||
+		    (qStaging[qHandle].rd == NULL))
+			return KNS_STATUS_ERROR;
 		MGR_LOG_VERBOSE("[KNS_Q] create q %d, len %d, elt size %d, RTOS hdl 0x%p\r\n",
 			qHandle, qLength, qEltByteSize, (void *)osMessageQueueId);
 		return KNS_STATUS_OK;
@@ -73,21 +102,134 @@ __attribute((__weak__))
 #endif
 enum KNS_status_t KNS_Q_pop(enum KNS_Q_handle_t qHandle, void *qItem)
 {
-	/** @todo handle empty queue should return KNS_STATUS_QEMPTY,
-	 * KNS_STATUS_OK means some valid element received,
-	 * KNS_STATUS_ERROR for any other reason
-	 */
-	/** Prio parameter is internally ignored
-	 * No timeout
-	 */
-	if (osMessageQueueGet(qPoolHandle[qHandle], (void *)qItem, 0, 0) == osOK) {
+	return KNS_Q_popWait(qHandle, qItem, 0);
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_popWait(enum KNS_Q_handle_t qHandle, void *qItem, uint32_t timeoutMs)
+{
+	osStatus_t status;
+	uint32_t timeout = 0;
+
+	if (timeoutMs == KNS_Q_WAIT_FOREVER)
+		timeout = osWaitForever;
+	else if (timeoutMs != 0)
+		timeout = (timeoutMs * osKernelGetTickFreq() + 999) / 1000;
+
+	/** Prio parameter is internally ignored */
+	status = osMessageQueueGet(qPoolHandle[qHandle], (void *)qItem, 0, timeout);
+	if (status == osOK) {
 		MGR_LOG_VERBOSE("[KNS_Q] pop  q %d\r\n", qHandle);
 		return KNS_STATUS_OK;
 	}
+	/** Queue empty is a regular case for consumers looping until QEMPTY, no log then */
+	if ((status == osErrorResource) || (status == osErrorTimeout))
+		return KNS_STATUS_QEMPTY;
 	MGR_LOG_DEBUG("[KNS_Q][ERROR] pop q %d FAILED\r\n", qHandle);
 	return KNS_STATUS_ERROR;
 }
 
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_reserve(enum KNS_Q_handle_t qHandle, void **qItem)
+{
+	enum KNS_Q_stagingCtx_t eCtx = (__get_IPSR() != 0U) ? KNS_Q_STAGING_ISR : KNS_Q_STAGING_TASK;
+	bool bIsFull;
+
+	*qItem = NULL;
+
+	/** Free space is checked, not reserved: it may be taken by another producer before commit */
+	bIsFull = (osMessageQueueGetSpace(qPoolHandle[qHandle]) == 0);
+	if (bIsFull) {
+		MGR_LOG_DEBUG("[KNS_Q] reserve QFULL q %d\r\n", qHandle);
+		return KNS_STATUS_QFULL;
+	}
+
+	if (__atomic_test_and_set(&qStaging[qHandle].wrBusy[eCtx], __ATOMIC_ACQUIRE)) {
+		MGR_LOG_DEBUG("[KNS_Q][ERROR] reserve q %d, already reserved in context %d\r\n",
+			qHandle, eCtx);
+		return KNS_STATUS_ERROR;
+	}
+
+	*qItem = qStaging[qHandle].wr[eCtx];
+	return KNS_STATUS_OK;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_commit(enum KNS_Q_handle_t qHandle, void *qItem)
+{
+	enum KNS_Q_stagingCtx_t eCtx;
+	enum KNS_status_t status;
+
+	for (eCtx = KNS_Q_STAGING_TASK; eCtx < KNS_Q_STAGING_MAX; eCtx++)
+		if (qItem == qStaging[qHandle].wr[eCtx])
+			break;
+	if ((eCtx == KNS_Q_STAGING_MAX) || !qStaging[qHandle].wrBusy[eCtx])
+		return KNS_STATUS_ERROR;
+
+	status = KNS_Q_push(qHandle, qItem);
+	__atomic_clear(&qStaging[qHandle].wrBusy[eCtx], __ATOMIC_RELEASE);
+	return status;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_peek(enum KNS_Q_handle_t qHandle, void **qItem)
+{
+	enum KNS_status_t status;
+
+	/** RTOS queue has no in-place access: element is popped into the staging element, so that
+	 * peek is destructive here. It is no more seen in queue (cf KNS_Q_getPendingMask) and it is
+	 * lost if consumer does not process it.
+	 */
+	*qItem = NULL;
+	status = KNS_Q_pop(qHandle, qStaging[qHandle].rd);
+	if (status == KNS_STATUS_OK)
+		*qItem = qStaging[qHandle].rd;
+	return status;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_release(enum KNS_Q_handle_t qHandle, void *qItem)
+{
+	/** Element was already removed from RTOS queue by KNS_Q_peek */
+	if (qItem != qStaging[qHandle].rd)
+		return KNS_STATUS_ERROR;
+	return KNS_STATUS_OK;
+}
+
+uint32_t KNS_Q_getPendingMask(void)
+{
+	enum KNS_Q_handle_t qHandle;
+	uint32_t pendingMask = 0;
+
+	for (qHandle = 0; qHandle < KNS_Q_MAX; qHandle++) {
+		if ((qPoolHandle[qHandle] != NULL) &&
+		    (osMessageQueueGetCount(qPoolHandle[qHandle]) != 0))
+			pendingMask |= 1UL << qHandle;
+	}
+
+	return pendingMask;
+}
+
+bool KNS_Q_isEvtInHigherPrioQ(enum KNS_Q_handle_t qHandle)
+{
+	return (KNS_Q_getPendingMask() & ~((2UL << qHandle) - 1)) != 0;
+}
+
+bool KNS_Q_isEvtInSomeQ(void)
+{
+	return KNS_Q_getPendingMask() != 0;
+}
+
 #pragma GCC visibility pop
 
 #endif /* KNS_Q_CMSIS_OS2_C */
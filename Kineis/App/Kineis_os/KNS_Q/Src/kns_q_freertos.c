@@ -19,8 +19,11 @@
 
 /* Includes ------------------------------------------------------------------------------------ */
 
+#include <stddef.h>
+
 #include "kns_q_conf.h"
 #include "kns_q.h"
+#include "kns_os.h"
 #include "mgr_log.h"
 #include "FreeRTOS.h"
 #include "queue.h"
@@ -29,10 +32,30 @@
 
 /* Defines ------------------------------------------------------------------------------------- */
 
+/** Producer contexts owning a distinct staging element for reserve/commit */
+enum KNS_Q_stagingCtx_t {
+	KNS_Q_STAGING_TASK = 0,
+	KNS_Q_STAGING_ISR,
+	KNS_Q_STAGING_MAX
+};
+
 /* Structures ---------------------------------------------------------------------------------- */
 
 static void *qPoolHandle[KNS_Q_MAX];
 
+/** Staging elements used by reserve/commit and peek/release: RTOS queues copy by value, so
+ * element is built (resp. read) in those buffers then copied into (resp. out of) the RTOS queue.
+ *
+ * Tasks and ISRs reserve distinct elements, so that an ISR may reserve while it preempted a task
+ * holding a reservation. There is a single producer per context though: a queue reserved again
+ * before commit in the same context (e.g. two tasks, nested ISRs) is refused.
+ */
+static struct {
+	void *wr[KNS_Q_STAGING_MAX]; /**< element handed out by KNS_Q_reserve, per context */
+	bool wrBusy[KNS_Q_STAGING_MAX]; /**< element is reserved, not yet committed */
+	void *rd; /**< element handed out by KNS_Q_peek */
+} qStaging[KNS_Q_MAX];
+
 /* Function prototypes ------------------------------------------------------------------------- */
 
 #ifndef UNIT_TEST
@@ -46,6 +69,13 @@ enum KNS_status_t KNS_Q_create(enum KNS_Q_handle_t qHandle, uint8_t qLength, uin
 	xQueue = xQueueCreate(qLength, qEltByteSize);
 	if (xQueue != NULL) {
 		qPoolHandle[qHandle] = (void *)xQueue;
+		qStaging[qHandle].wr[KNS_Q_STAGING_TASK] = pvPortMalloc(qEltByteSize);
+		qStaging[qHandle].wr[KNS_Q_STAGING_ISR] = pvPortMalloc(qEltByteSize);
+		qStaging[qHandle].rd = pvPortMalloc(qEltByteSize);
+		if ((qStaging[qHandle].wr[KNS_Q_STAGING_TASK] == NULL) ||
+		    (qStaging[qHandle].wr[KNS_Q_STAGING_ISR] == NULL) ||
+		    (qStaging[qHandle].rd == NULL))
+			return KNS_STATUS_ERROR;
 		MGR_LOG_VERBOSE("[KNS_Q] create q %d, len %d, elt size %d, RTOS hdl 0x%p\r\n",
 			qHandle, qLength, qEltByteSize, (void *)xQueue);
 		return KNS_STATUS_OK;
@@ -58,12 +88,28 @@ __attribute((__weak__))
 #endif
 enum KNS_status_t KNS_Q_push(enum KNS_Q_handle_t qHandle, void *qItem)
 {
-	if (xQueueSendToBack(qPoolHandle[qHandle], (void *)qItem, 0) == pdPASS) {
-		MGR_LOG_VERBOSE("[KNS_Q] push q %d, elt 0x%p\r\n", qHandle, (void *)qItem);
-		return KNS_STATUS_OK;
+	BaseType_t xStatus;
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if (xPortIsInsideInterrupt()) {
+		xStatus = xQueueSendToBackFromISR(qPoolHandle[qHandle], (void *)qItem,
+			&xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	} else
+		xStatus = xQueueSendToBack(qPoolHandle[qHandle], (void *)qItem, 0);
+
+	if (xStatus != pdPASS) {
+		MGR_LOG_DEBUG("[KNS_Q] push QFULL q %d, evt=0x%x\r\n", qHandle,
+			((uint8_t *)qItem)[0]);
+		return KNS_STATUS_QFULL;
 	}
-	MGR_LOG_DEBUG("[KNS_Q][ERROR] push q %d FAILED, elt 0x%p\r\n", qHandle, (void *)qItem);
-	return KNS_STATUS_ERROR;
+
+	MGR_LOG_VERBOSE("[KNS_Q] push q %d, elt 0x%p\r\n", qHandle, (void *)qItem);
+
+	/** Wake-up consumer task, blocked in kernel until some event is available */
+	KNS_OS_setTaskReady(qConsumerTask[qHandle]);
+
+	return KNS_STATUS_OK;
 }
 
 #ifndef UNIT_TEST
@@ -71,16 +117,152 @@ __attribute((__weak__))
 #endif
 enum KNS_status_t KNS_Q_pop(enum KNS_Q_handle_t qHandle, void *qItem)
 {
-	/** @todo handle empty queue should return KNS_STATUS_QEMPTY,
-	 * KNS_STATUS_OK means some valid element received,
-	 * KNS_STATUS_ERROR for any other reason
+	BaseType_t xStatus;
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if (xPortIsInsideInterrupt()) {
+		xStatus = xQueueReceiveFromISR(qPoolHandle[qHandle], (void *)qItem,
+			&xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	} else
+		xStatus = xQueueReceive(qPoolHandle[qHandle], (void *)qItem, 0);
+
+	/** Queue empty is a regular case for consumers looping until QEMPTY, no log then */
+	if (xStatus != pdPASS)
+		return KNS_STATUS_QEMPTY;
+
+	MGR_LOG_VERBOSE("[KNS_Q] pop  q %d\r\n", qHandle);
+	return KNS_STATUS_OK;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_popWait(enum KNS_Q_handle_t qHandle, void *qItem, uint32_t timeoutMs)
+{
+	TickType_t xTicksToWait;
+
+	if (xPortIsInsideInterrupt())
+		return KNS_STATUS_ERROR;
+
+	if (timeoutMs == KNS_Q_WAIT_FOREVER)
+		xTicksToWait = portMAX_DELAY;
+	else
+		xTicksToWait = pdMS_TO_TICKS(timeoutMs);
+
+	if (xQueueReceive(qPoolHandle[qHandle], (void *)qItem, xTicksToWait) != pdPASS)
+		return KNS_STATUS_QEMPTY;
+
+	MGR_LOG_VERBOSE("[KNS_Q] pop  q %d\r\n", qHandle);
+	return KNS_STATUS_OK;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_reserve(enum KNS_Q_handle_t qHandle, void **qItem)
+{
+	enum KNS_Q_stagingCtx_t eCtx = xPortIsInsideInterrupt() ? KNS_Q_STAGING_ISR : KNS_Q_STAGING_TASK;
+	bool bIsFull;
+
+	*qItem = NULL;
+
+	/** Free space is checked, not reserved: it may be taken by another producer before commit */
+	if (eCtx == KNS_Q_STAGING_ISR)
+		bIsFull = (xQueueIsQueueFullFromISR(qPoolHandle[qHandle]) != pdFALSE);
+	else
+		bIsFull = (uxQueueSpacesAvailable(qPoolHandle[qHandle]) == 0);
+	if (bIsFull) {
+		MGR_LOG_DEBUG("[KNS_Q] reserve QFULL q %d\r\n", qHandle);
+		return KNS_STATUS_QFULL;
+	}
+
+	if (__atomic_test_and_set(&qStaging[qHandle].wrBusy[eCtx], __ATOMIC_ACQUIRE)) {
+		MGR_LOG_DEBUG("[KNS_Q][ERROR] reserve q %d, already reserved in context %d\r\n",
+			qHandle, eCtx);
+		return KNS_STATUS_ERROR;
+	}
+
+	*qItem = qStaging[qHandle].wr[eCtx];
+	return KNS_STATUS_OK;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_commit(enum KNS_Q_handle_t qHandle, void *qItem)
+{
+	enum KNS_Q_stagingCtx_t eCtx;
+	enum KNS_status_t status;
+
+	for (eCtx = KNS_Q_STAGING_TASK; eCtx < KNS_Q_STAGING_MAX; eCtx++)
+		if (qItem == qStaging[qHandle].wr[eCtx])
+			break;
+	if ((eCtx == KNS_Q_STAGING_MAX) || !qStaging[qHandle].wrBusy[eCtx])
+		return KNS_STATUS_ERROR;
+
+	status = KNS_Q_push(qHandle, qItem);
+	__atomic_clear(&qStaging[qHandle].wrBusy[eCtx], __ATOMIC_RELEASE);
+	return status;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_peek(enum KNS_Q_handle_t qHandle, void **qItem)
+{
+	enum KNS_status_t status;
+
+	/** RTOS queue has no in-place access: element is popped into the staging element, so that
+	 * peek is destructive here. It is no more seen in queue (cf KNS_Q_getPendingMask) and it is
+	 * lost if consumer does not process it.
 	 */
-	if (xQueueReceive(qPoolHandle[qHandle], (void *)qItem, 0) == pdPASS) {
-		MGR_LOG_VERBOSE("[KNS_Q] pop  q %d\r\n", qHandle);
-		return KNS_STATUS_OK;
+	*qItem = NULL;
+	status = KNS_Q_pop(qHandle, qStaging[qHandle].rd);
+	if (status == KNS_STATUS_OK)
+		*qItem = qStaging[qHandle].rd;
+	return status;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_release(enum KNS_Q_handle_t qHandle, void *qItem)
+{
+	/** Element was already removed from RTOS queue by KNS_Q_peek */
+	if (qItem != qStaging[qHandle].rd)
+		return KNS_STATUS_ERROR;
+	return KNS_STATUS_OK;
+}
+
+uint32_t KNS_Q_getPendingMask(void)
+{
+	enum KNS_Q_handle_t qHandle;
+	UBaseType_t uxNbElt;
+	uint32_t pendingMask = 0;
+
+	for (qHandle = 0; qHandle < KNS_Q_MAX; qHandle++) {
+		if (qPoolHandle[qHandle] == NULL)
+			continue;
+		if (xPortIsInsideInterrupt())
+			uxNbElt = uxQueueMessagesWaitingFromISR(qPoolHandle[qHandle]);
+		else
+			uxNbElt = uxQueueMessagesWaiting(qPoolHandle[qHandle]);
+		if (uxNbElt != 0)
+			pendingMask |= 1UL << qHandle;
 	}
-	MGR_LOG_DEBUG("[KNS_Q][ERROR] pop q %d FAILED\r\n", qHandle);
-	return KNS_STATUS_ERROR;
+
+	return pendingMask;
+}
+
+bool KNS_Q_isEvtInHigherPrioQ(enum KNS_Q_handle_t qHandle)
+{
+	return (KNS_Q_getPendingMask() & ~((2UL << qHandle) - 1)) != 0;
+}
+
+bool KNS_Q_isEvtInSomeQ(void)
+{
+	return KNS_Q_getPendingMask() != 0;
 }
 
 #pragma GCC visibility pop
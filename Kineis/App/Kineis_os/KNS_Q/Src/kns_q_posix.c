@@ -0,0 +1,339 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    kns_q_posix.c
+ * @brief   Queues used in kineis_sw, POSIX host port
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup KNS_Q
+ * @brief Kineis SW queue utilities on POSIX host (pthreads)
+ * @{
+ */
+
+#ifndef KNS_Q_POSIX_C
+#define KNS_Q_POSIX_C
+
+/* Includes ------------------------------------------------------------------------------------ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kns_q_conf.h"
+#include "kns_q.h"
+#include "kns_os.h"
+#include "kns_os_perf.h"
+#include "mgr_log.h"
+
+#pragma GCC visibility push(default)
+
+/* Structures ---------------------------------------------------------------------------------- */
+
+/**
+ * @struct KNS_Q_posix_t
+ * @brief POSIX queue descriptor
+ *
+ * Bounded lock-free ring with one sequence number per slot. Host threads really run in parallel,
+ * so producers cannot rely on nesting as baremetal ISRs do. Instead, each slot tells its state:
+ * * seq == pos: slot free for the producer claiming position pos,
+ * * seq == pos + 1: slot committed, readable by the consumer at position pos,
+ * * seq is moved to pos + nbElt once consumer released it, ready for next lap.
+ *
+ * Producers claim positions with a compare-and-swap on wPos, consumer alone moves rPos. All
+ * nbElt slots are usable (no spare slot as in baremetal). Positions are 64-bit so that they never
+ * wrap, whatever the queue length.
+ */
+struct KNS_Q_posix_t {
+	uint64_t wPos;              /**< next position claimed by producers */
+	uint64_t rPos;              /**< next position read by consumer */
+	uint32_t nbElt;             /**< number of slots */
+	uint16_t eltSize;           /**< element size in bytes */
+	uint64_t *seq;              /**< per-slot sequence numbers */
+	uint32_t *data;             /**< slots storage, KNS_Q_ELT_WORDSIZE(eltSize) words each */
+	uint32_t nbWaiter;          /**< number of threads blocked in KNS_Q_popWait */
+	pthread_mutex_t waitLock;   /**< protects blocking in KNS_Q_popWait only */
+	pthread_cond_t waitCond;    /**< signaled on commit when some thread waits */
+};
+
+/* Variables ----------------------------------------------------------------------------------- */
+
+static struct KNS_Q_posix_t *qPoolPosix[KNS_Q_MAX];
+
+/* Local functions ----------------------------------------------------------------------------- */
+
+/**
+ * @brief  Get slot index of an element handed out by KNS_Q_reserve or KNS_Q_peek
+ * @param[in] q: queue descriptor
+ * @param[in] qItem: pointer to element
+ * @retval slot index, nbElt if pointer is not a slot of the queue
+ */
+static uint32_t KNS_Q_slotIdx(const struct KNS_Q_posix_t *q, const void *qItem)
+{
+	size_t offset = (const uint32_t *)qItem - q->data;
+	uint32_t eltWords = KNS_Q_ELT_WORDSIZE(q->eltSize);
+
+	if (((const uint32_t *)qItem < q->data) || ((offset % eltWords) != 0) ||
+		((offset / eltWords) >= q->nbElt))
+		return q->nbElt;
+	return offset / eltWords;
+}
+
+/**
+ * @brief  Check next element of a queue is committed
+ * @param[in] q: queue descriptor
+ * @retval true if consumer can read it
+ */
+static bool KNS_Q_isHeadReady(struct KNS_Q_posix_t *q)
+{
+	uint64_t rPos = __atomic_load_n(&q->rPos, __ATOMIC_RELAXED);
+
+	return __atomic_load_n(&q->seq[rPos % q->nbElt], __ATOMIC_SEQ_CST) == rPos + 1;
+}
+
+/* Function prototypes ------------------------------------------------------------------------- */
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_create(enum KNS_Q_handle_t qHandle, uint8_t qLength, uint16_t qEltByteSize)
+{
+	struct KNS_Q_posix_t *q;
+	uint32_t idx;
+
+	if ((qHandle >= KNS_Q_MAX) || (qLength == 0) || (qEltByteSize == 0))
+		return KNS_STATUS_BAD_SETTING;
+
+	q = calloc(1, sizeof(*q));
+	if (q == NULL)
+		return KNS_STATUS_ERROR;
+	q->nbElt = qLength;
+	q->eltSize = qEltByteSize;
+	q->seq = calloc(qLength, sizeof(uint64_t));
+	q->data = calloc(qLength, KNS_Q_ELT_WORDSIZE(qEltByteSize) * sizeof(uint32_t));
+	if ((q->seq == NULL) || (q->data == NULL)) {
+		free(q->seq);
+		free(q->data);
+		free(q);
+		return KNS_STATUS_ERROR;
+	}
+	for (idx = 0; idx < qLength; idx++)
+		q->seq[idx] = idx;
+	pthread_mutex_init(&q->waitLock, NULL);
+	pthread_cond_init(&q->waitCond, NULL);
+
+	qPoolPosix[qHandle] = q;
+	MGR_LOG_VERBOSE("[KNS_Q] create q %d, len %d, elt size %d\r\n", qHandle, qLength,
+		qEltByteSize);
+	return KNS_STATUS_OK;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_reserve(enum KNS_Q_handle_t qHandle, void **qItem)
+{
+	struct KNS_Q_posix_t *q = qPoolPosix[qHandle];
+	uint64_t wPos, seq;
+	int64_t diff;
+
+	*qItem = NULL;
+
+	wPos = __atomic_load_n(&q->wPos, __ATOMIC_RELAXED);
+	while (1) {
+		seq = __atomic_load_n(&q->seq[wPos % q->nbElt], __ATOMIC_ACQUIRE);
+		diff = (int64_t)(seq - wPos);
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&q->wPos, &wPos, wPos + 1, true,
+				__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			/** Slot of previous lap not released yet */
+			MGR_LOG_DEBUG("[KNS_Q] reserve QFULL q %d\r\n", qHandle);
+			KNS_OS_PERF_Q_FULL(qHandle);
+			return KNS_STATUS_QFULL;
+		} else
+			wPos = __atomic_load_n(&q->wPos, __ATOMIC_RELAXED);
+	}
+
+	KNS_OS_PERF_Q_PUSH(qHandle, wPos + 1 - __atomic_load_n(&q->rPos, __ATOMIC_RELAXED));
+	*qItem = q->data + KNS_Q_ELT_WORDSIZE(q->eltSize) * (wPos % q->nbElt);
+	return KNS_STATUS_OK;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_commit(enum KNS_Q_handle_t qHandle, void *qItem)
+{
+	struct KNS_Q_posix_t *q = qPoolPosix[qHandle];
+	uint32_t idx = KNS_Q_slotIdx(q, qItem);
+
+	if (idx >= q->nbElt)
+		return KNS_STATUS_ERROR;
+
+	/** Slot is owned by this producer since claim, its sequence still is the claimed position.
+	 * Sequentially consistent store pairs with the waiter count check below (and the opposite
+	 * order in KNS_Q_popWait), so that a blocked consumer is never missed.
+	 */
+	__atomic_store_n(&q->seq[idx], q->seq[idx] + 1, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(&q->nbWaiter, __ATOMIC_SEQ_CST) != 0) {
+		pthread_mutex_lock(&q->waitLock);
+		pthread_cond_broadcast(&q->waitCond);
+		pthread_mutex_unlock(&q->waitLock);
+	}
+
+	MGR_LOG_VERBOSE("[KNS_Q] push q %d, idx %d\r\n", qHandle, idx);
+
+	/** Wake-up consumer task, blocked until some event is available */
+	KNS_OS_setTaskReady(qConsumerTask[qHandle]);
+
+	return KNS_STATUS_OK;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_push(enum KNS_Q_handle_t qHandle, void *qItem)
+{
+	enum KNS_status_t status;
+	void *qEltPtr;
+
+	status = KNS_Q_reserve(qHandle, &qEltPtr);
+	if (status != KNS_STATUS_OK)
+		return status;
+
+	memcpy(qEltPtr, qItem, qPoolPosix[qHandle]->eltSize);
+
+	return KNS_Q_commit(qHandle, qEltPtr);
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_peek(enum KNS_Q_handle_t qHandle, void **qItem)
+{
+	struct KNS_Q_posix_t *q = qPoolPosix[qHandle];
+	uint64_t rPos = q->rPos;
+
+	*qItem = NULL;
+
+	/** Acquire on slot sequence ensures content is read after producer completed it */
+	if (__atomic_load_n(&q->seq[rPos % q->nbElt], __ATOMIC_ACQUIRE) != rPos + 1)
+		return KNS_STATUS_QEMPTY;
+
+	*qItem = q->data + KNS_Q_ELT_WORDSIZE(q->eltSize) * (rPos % q->nbElt);
+	return KNS_STATUS_OK;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_release(enum KNS_Q_handle_t qHandle, void *qItem)
+{
+	struct KNS_Q_posix_t *q = qPoolPosix[qHandle];
+	uint64_t rPos = q->rPos;
+	uint32_t idx = rPos % q->nbElt;
+
+	if ((KNS_Q_slotIdx(q, qItem) != idx) ||
+		(__atomic_load_n(&q->seq[idx], __ATOMIC_RELAXED) != rPos + 1))
+		return KNS_STATUS_ERROR;
+
+	/** Give slot back to producers for next lap */
+	__atomic_store_n(&q->seq[idx], rPos + q->nbElt, __ATOMIC_RELEASE);
+	__atomic_store_n(&q->rPos, rPos + 1, __ATOMIC_RELAXED);
+
+	KNS_OS_PERF_Q_POP(qHandle);
+	MGR_LOG_VERBOSE("[KNS_Q] pop  q %d, idx %d\r\n", qHandle, idx);
+
+	return KNS_STATUS_OK;
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_pop(enum KNS_Q_handle_t qHandle, void *qItem)
+{
+	enum KNS_status_t status;
+	void *qEltPtr;
+
+	status = KNS_Q_peek(qHandle, &qEltPtr);
+	if (status != KNS_STATUS_OK)
+		return status;
+
+	memcpy(qItem, qEltPtr, qPoolPosix[qHandle]->eltSize);
+
+	return KNS_Q_release(qHandle, qEltPtr);
+}
+
+#ifndef UNIT_TEST
+__attribute((__weak__))
+#endif
+enum KNS_status_t KNS_Q_popWait(enum KNS_Q_handle_t qHandle, void *qItem, uint32_t timeoutMs)
+{
+	struct KNS_Q_posix_t *q = qPoolPosix[qHandle];
+	struct timespec deadline;
+	int err = 0;
+
+	if (KNS_Q_pop(qHandle, qItem) == KNS_STATUS_OK)
+		return KNS_STATUS_OK;
+	if (timeoutMs == 0)
+		return KNS_STATUS_QEMPTY;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeoutMs / 1000;
+	deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	/** Waiter is registered before checking queue again, producers check it after commit */
+	pthread_mutex_lock(&q->waitLock);
+	__atomic_add_fetch(&q->nbWaiter, 1, __ATOMIC_SEQ_CST);
+	while (!KNS_Q_isHeadReady(q) && (err != ETIMEDOUT)) {
+		if (timeoutMs == KNS_Q_WAIT_FOREVER)
+			pthread_cond_wait(&q->waitCond, &q->waitLock);
+		else
+			err = pthread_cond_timedwait(&q->waitCond, &q->waitLock, &deadline);
+	}
+	__atomic_sub_fetch(&q->nbWaiter, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&q->waitLock);
+
+	return KNS_Q_pop(qHandle, qItem);
+}
+
+uint32_t KNS_Q_getPendingMask(void)
+{
+	enum KNS_Q_handle_t qHandle;
+	uint32_t pendingMask = 0;
+
+	for (qHandle = 0; qHandle < KNS_Q_MAX; qHandle++) {
+		if ((qPoolPosix[qHandle] != NULL) && KNS_Q_isHeadReady(qPoolPosix[qHandle]))
+			pendingMask |= 1UL << qHandle;
+	}
+
+	return pendingMask;
+}
+
+bool KNS_Q_isEvtInHigherPrioQ(enum KNS_Q_handle_t qHandle)
+{
+	return (KNS_Q_getPendingMask() & ~((2UL << qHandle) - 1)) != 0;
+}
+
+bool KNS_Q_isEvtInSomeQ(void)
+{
+	return KNS_Q_getPendingMask() != 0;
+}
+
+#pragma GCC visibility pop
+
+#endif /* KNS_Q_POSIX_C */
+
+/**
+ * @}
+ */
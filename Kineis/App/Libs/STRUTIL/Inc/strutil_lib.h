@@ -57,6 +57,49 @@ bool bUTIL_strcmp(uint8_t *pu8_Str1, const uint8_t *pu8_Str2, uint8_t u8_strLeng
  */
 uint8_t u8UTIL_convertCharToHex4bits(uint8_t u8_num);
 
+/**
+ * @brief convert hexadecimal ASCII characters into a binary buffer
+ *
+ * Conversion stops on first character which is not an hexadecimal digit (e.g. `,` or `\0`) or
+ * after u16_maxCharNb characters. Input is read 4 characters (one 32-bit word) at a time, each
+ * digit being validated and converted through a lookup table. Words are never read beyond the
+ * end-of-string '\0' or u16_maxCharNb characters, whichever comes first.
+ *
+ * Data are MSB first: when number of characters is odd, last digit is set in the upper nibble of
+ * last byte, lower nibble being 0.
+ *
+ * @note Decoding in place is allowed, i.e. pu8_outData may be equal to pu8_inStr.
+ *
+ * @param [out] pu8_outData : output binary buffer, at least ((u16_maxCharNb + 1) / 2) long
+ * @param [in] pu8_inStr : hexadecimal ASCII characters to be converted, '\0'-terminated or at
+ * least u16_maxCharNb long
+ * @param [in] u16_maxCharNb : maximum number of characters to be converted
+ *
+ * @return number of characters converted. Corresponding data length in bits is 4 times this value.
+ */
+uint16_t u16UTIL_convertAsciiToHex(uint8_t *pu8_outData, const uint8_t *pu8_inStr,
+	uint16_t u16_maxCharNb);
+
+/**
+ * @brief convert a binary buffer into hexadecimal ASCII characters (upper case)
+ *
+ * Conversion is done 2 bytes at a time: the 4 nibbles are spread in the 4 bytes of a 32-bit word
+ * then converted to ASCII all together (SWAR), leading to one 32-bit write per 2 input bytes.
+ *
+ * Data are MSB first. When bit length is not a multiple of 8, last incomplete byte is converted
+ * as 2 characters if it contains more than 4 bits, as 1 character (its upper nibble) otherwise.
+ *
+ * @note Output string is not null-terminated.
+ *
+ * @param [out] pu8_outStr : output buffer, should be at least ((u16_dataLenBit + 3) / 4) long
+ * @param [in] pu8_inData : binary data to be converted
+ * @param [in] u16_dataLenBit : length of binary data in bits
+ *
+ * @return number of characters written in output buffer
+ */
+uint16_t u16UTIL_convertHexToAscii(uint8_t *pu8_outStr, const uint8_t *pu8_inData,
+	uint16_t u16_dataLenBit);
+
 #endif /* __STRLIB_H */
 
 /**
@@ -14,8 +14,58 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <string.h>
 #include "strutil_lib.h"
 
+/* Private variables ---------------------------------------------------------*/
+
+/** 4-bit value of hexadecimal ASCII digits, \ref HEX_DEC_4BIT_CONVERSION_FAILED_CODE otherwise */
+static const uint8_t au8_hexDigitValue[256] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief convert 2 bytes into 4 hexadecimal ASCII characters
+ *
+ * Each nibble is placed in its own byte lane of a 32-bit word, in output order when word is
+ * stored in little endian. ASCII conversion is then done on all lanes at once: '0' is added to
+ * each lane, plus 7 ('A' - '9' - 1) for lanes above 9. Lanes above 9 are identified by bit 4 of
+ * (lane + 6), which cannot carry over next lane.
+ *
+ * @param [in] u8_first : first byte to be converted
+ * @param [in] u8_second : second byte to be converted
+ *
+ * @return 4 ASCII characters, first one in lowest byte
+ */
+static inline uint32_t u32UTIL_hex2BytesToAscii(uint8_t u8_first, uint8_t u8_second)
+{
+	uint32_t u32_lanes;
+
+	u32_lanes = ((uint32_t)(u8_first >> 4)) |
+		    ((uint32_t)(u8_first & 0x0F) << 8) |
+		    ((uint32_t)(u8_second >> 4) << 16) |
+		    ((uint32_t)(u8_second & 0x0F) << 24);
+
+	return u32_lanes + 0x30303030UL + ((((u32_lanes + 0x06060606UL) >> 4) & 0x01010101UL) * 7);
+}
+
 /* Functions Implementation --------------------------------------------------*/
 
 bool bUTIL_strcmp(uint8_t *pu8_Str1, const uint8_t *pu8_Str2, uint8_t u8_strLength)
@@ -35,16 +85,85 @@ bool bUTIL_strcmp(uint8_t *pu8_Str1, const uint8_t *pu8_Str2, uint8_t u8_strLeng
 
 uint8_t u8UTIL_convertCharToHex4bits(uint8_t u8_num)
 {
-	if ((u8_num >= 'A') && (u8_num <= 'F'))
-		return u8_num - 'A' + 10;
+	return au8_hexDigitValue[u8_num];
+}
+
+uint16_t u16UTIL_convertAsciiToHex(uint8_t *pu8_outData, const uint8_t *pu8_inStr,
+	uint16_t u16_maxCharNb)
+{
+	const uint8_t *pu8_strEnd;
+	uint16_t u16_charNb = 0;
+	uint32_t u32_chars;
+	uint8_t au8_val[4];
+	uint8_t u8_val;
+
+	/** Words are read up to end of string only, input may be shorter than u16_maxCharNb */
+	pu8_strEnd = memchr(pu8_inStr, '\0', u16_maxCharNb);
+	if (pu8_strEnd != NULL)
+		u16_maxCharNb = pu8_strEnd - pu8_inStr;
+
+	/** Four characters are read at once then converted to 2 bytes. Output is written after
+	 * input was read and is at most half the input index, so that in-place decoding is safe.
+	 */
+	while ((u16_maxCharNb - u16_charNb) >= 4) {
+		memcpy(&u32_chars, &pu8_inStr[u16_charNb], sizeof(u32_chars));
+		au8_val[0] = au8_hexDigitValue[u32_chars & 0xFF];
+		au8_val[1] = au8_hexDigitValue[(u32_chars >> 8) & 0xFF];
+		au8_val[2] = au8_hexDigitValue[(u32_chars >> 16) & 0xFF];
+		au8_val[3] = au8_hexDigitValue[u32_chars >> 24];
+		/** Invalid digits have upper nibble set, end of digits is found below */
+		if ((au8_val[0] | au8_val[1] | au8_val[2] | au8_val[3]) & 0xF0)
+			break;
+		pu8_outData[u16_charNb >> 1] = (au8_val[0] << 4) | au8_val[1];
+		pu8_outData[(u16_charNb >> 1) + 1] = (au8_val[2] << 4) | au8_val[3];
+		u16_charNb += 4;
+	}
+
+	for (; u16_charNb < u16_maxCharNb; u16_charNb++) {
+		u8_val = au8_hexDigitValue[pu8_inStr[u16_charNb]];
+		if (u8_val == HEX_DEC_4BIT_CONVERSION_FAILED_CODE)
+			break;
+		if (u16_charNb & 1)
+			pu8_outData[u16_charNb >> 1] |= u8_val;
+		else
+			pu8_outData[u16_charNb >> 1] = u8_val << 4;
+	}
+
+	return u16_charNb;
+}
+
+uint16_t u16UTIL_convertHexToAscii(uint8_t *pu8_outStr, const uint8_t *pu8_inData,
+	uint16_t u16_dataLenBit)
+{
+	static const uint8_t au8_hexDigit[] = "0123456789ABCDEF";
+	uint16_t u16_nbByte = u16_dataLenBit >> 3;
+	uint16_t u16_remainingBits = u16_dataLenBit & 0x7;
+	uint8_t *pu8_out = pu8_outStr;
+	uint32_t u32_chars;
 
-	if ((u8_num >= 'a') && (u8_num <= 'f'))
-		return u8_num - 'a' + 10;
+	for (; u16_nbByte >= 2; u16_nbByte -= 2) {
+		u32_chars = u32UTIL_hex2BytesToAscii(pu8_inData[0], pu8_inData[1]);
+		/** Only little endian targets are supported here (Cortex-M) */
+		memcpy(pu8_out, &u32_chars, sizeof(u32_chars));
+		pu8_out += sizeof(u32_chars);
+		pu8_inData += 2;
+	}
 
-	if ((u8_num >= '0') && (u8_num <= '9'))
-		return u8_num - '0';
+	if (u16_nbByte != 0) {
+		*pu8_out++ = au8_hexDigit[*pu8_inData >> 4];
+		*pu8_out++ = au8_hexDigit[*pu8_inData & 0x0F];
+		pu8_inData++;
+	}
+
+	if (u16_remainingBits > 4) {
+		*pu8_out++ = au8_hexDigit[*pu8_inData >> 4];
+		*pu8_out++ = au8_hexDigit[*pu8_inData & 0x0F];
+	} else if (u16_remainingBits > 0) {
+		*pu8_out++ = au8_hexDigit[*pu8_inData >> 4];
+	}
+	/* else no additional bits */
 
-	return HEX_DEC_4BIT_CONVERSION_FAILED_CODE;
+	return (uint16_t)(pu8_out - pu8_outStr);
 }
 
 /**
@@ -24,7 +24,7 @@
  * @section user_data_design_apis APIs
  *
  * The APIs proposed by this library are about to:
- * * add a new message at the beginning or at the end of the FIFO
+ * * add a new message at the beginning or at the end of the FIFO, or of its priority class
  * * remove an element
  * * count the number of message already located in the FIFO
  * * count the remaining free place in FIFO
@@ -51,11 +51,43 @@
  * on satellite, at first transmission. Some message will need several retransmission, some other
  * will not. Thus, some later-added messages may be removed first from the FIFO.
  *
- * For that purpose, the fifo is implemented as a chained list. A pointer to first element is
- * available. Each element contains a pointer to next element. The last element of the fifo
- * is point is pointing to NULL.
+ * For that purpose, the fifo is implemented as a doubly chained list, elements being the slots of
+ * a static array. Pointers to first and last elements and the number of elements are kept, each
+ * element points to previous and next elements. Free slots are tracked in a bitmap. Thus, all FIFO
+ * operations (reserve, add back/front, remove, membership check, count) run in constant time,
+ * whatever USERDATA_TX_FIFO_SIZE is.
  *
- * As each message is independent, the FIFO is internally designed as a chained list.
+ * @subsection user_data_design_point_hdl Message handles
+ *
+ * Each reserved element gets a 16-bit message handle. The handle encodes the slot of the element
+ * in the static array plus a generation counter incremented at each reservation, so that:
+ * * the element is found back from its handle in constant time (\ref USERDATA_txFifoGetEltByHandle)
+ * * a handle kept after its element was freed (and the slot reused) is detected as stale
+ *
+ * Upper layers use it to correlate lower-layer completion events to messages, and to report it to
+ * the host.
+ *
+ * @subsection user_data_design_point_sched TX scheduling policy
+ *
+ * The order of the fifo is driven by a pluggable policy (\ref USERDATA_txFifoSetPolicy). Each
+ * element added in fifo is given a priority class (\ref eUserDataTxClass), computed by the policy
+ * from the user data attribute. The chained list is kept sorted by class: an element is added at
+ * the back (or front) of its class, right after the last element of upper classes. The last element
+ * of each class is kept, so that adding an element stays in constant time. Lower layers serving the
+ * fifo from its first element thus serve classes in strict priority order.
+ *
+ * On top of that, the policy may set:
+ * * an aging period: a message waiting longer than it in its class is promoted to the upper one
+ *   (\ref USERDATA_txFifoAge), so that low priority messages are not starved. Emergency class is
+ *   never reached by aging.
+ * * an overflow strategy: when fifo is full, the oldest message (or the oldest message of the lowest
+ *   class) may be dropped in favour of the new one (\ref USERDATA_txFifoGetDropCandidate). A message
+ *   of an upper class than the new one, or already submitted to lower layer, is never dropped.
+ *
+ * Default policy is the plain FIFO: all messages in USERDATA_TX_CLASS_NORMAL class, no aging, no
+ * drop. \ref USERDATA_txFifoGetClassByAttr is a ready-to-use class function driven by the service
+ * and priority fields of the attribute. Counters of each class (\ref USERDATA_txFifoGetClassStats)
+ * show how classes are served.
  *
  * @subsection user_data_design_point_cs Critical sections
  *
@@ -76,13 +108,14 @@
  * @subsection user_data_design_point_es Element size
  *
  * Depending on transmission protocol (KINEIS, NB-IOT, ...), the user data length can be different.
- * Optimizing the memory resource with dynamic user data size in a chained list is difficult.
- *
- * At first step, the data buffer will be an array where each element as the maximum size allowed
- * among all protocols.
- *
- * In next design iterations, two or three data size may be considered (e.g. bigger buffer for HDA4
- * data). This will lead the higher layer to reserve place in a buffer fitting its user-data length.
+ * Data are stored in binary, out of the fifo elements, in blocks of a slab allocator with a few
+ * size classes (e.g. 3 bytes for VLDA4, 25 bytes for LDA2, 633 bytes for HDA4). The higher layer
+ * gives the user data length when reserving an element, which gets a block of the smallest size
+ * class fitting it (or a larger one when the class is exhausted). Thus, short messages do not
+ * waste retention RAM sized for the longest protocol.
+ *
+ * Size and number of blocks of each class are set at build time (USERDATA_TX_SLAB_xxx). Data
+ * blocks are placed in non-initialized retention RAM, so that they do not take space in flash.
  */
 
 /**
@@ -106,10 +139,6 @@
  * @brief Maximum number of bytes of user data field
  *
  * On Kineis RAT, the maximum size is 196 bits which is 24.5 bytes. Round it to 25.
- *
- * @note So far MGR_AT_CMD makes the FIFO to contain the USER data as ASCII-HEX string. Thus:
- * * multiply length by 2
- * * add 1 extra for end-of-string ('\0')
  */
 #ifndef USERDATA_TX_DATAFIELD_SIZE
 #ifdef USE_HDA4
@@ -119,10 +148,6 @@
 #endif
 #endif
 
-#ifndef USERDATA_TX_PAYLOAD_MAX_SIZE
-#define USERDATA_TX_PAYLOAD_MAX_SIZE ((USERDATA_TX_DATAFIELD_SIZE * 2) + 1)
-#endif
-
 #if (USERDATA_TX_DATAFIELD_SIZE < 25)
 #error "USERDATA TX FIFO MAX SIZE does not support maximum payload size for KINEIS network"
 #endif
@@ -134,9 +159,63 @@
 #define USERDATA_DFT_POS_ON_RX_PAYLOAD	0
 #endif
 
-/**< Max TX fifo size  */
+/**
+ * @brief Size classes of TX data slab allocator: block size in bytes and number of blocks
+ *
+ * Classes are sorted by increasing block size. A class with no block is disabled.
+ */
+#ifndef USERDATA_TX_SLAB_SMALL_SIZE
+#define USERDATA_TX_SLAB_SMALL_SIZE	3
+#endif
+#ifndef USERDATA_TX_SLAB_SMALL_NB
+#define USERDATA_TX_SLAB_SMALL_NB	8
+#endif
+#ifndef USERDATA_TX_SLAB_MEDIUM_SIZE
+#define USERDATA_TX_SLAB_MEDIUM_SIZE	25
+#endif
+#ifndef USERDATA_TX_SLAB_MEDIUM_NB
+#define USERDATA_TX_SLAB_MEDIUM_NB	8
+#endif
+#ifndef USERDATA_TX_SLAB_LARGE_SIZE
+#define USERDATA_TX_SLAB_LARGE_SIZE	USERDATA_TX_DATAFIELD_SIZE
+#endif
+#ifndef USERDATA_TX_SLAB_LARGE_NB
+#ifdef USE_HDA4
+#define USERDATA_TX_SLAB_LARGE_NB	4
+#else
+#define USERDATA_TX_SLAB_LARGE_NB	0
+#endif
+#endif
+
+#if ((USERDATA_TX_SLAB_SMALL_SIZE > USERDATA_TX_SLAB_MEDIUM_SIZE) || \
+     (USERDATA_TX_SLAB_MEDIUM_SIZE > USERDATA_TX_SLAB_LARGE_SIZE))
+#error "USERDATA TX slab classes shall be sorted by increasing block size"
+#endif
+
+#if (((USERDATA_TX_SLAB_LARGE_NB > 0) && \
+      (USERDATA_TX_SLAB_LARGE_SIZE < USERDATA_TX_DATAFIELD_SIZE)) || \
+     ((USERDATA_TX_SLAB_LARGE_NB == 0) && \
+      ((USERDATA_TX_SLAB_MEDIUM_NB == 0) || \
+       (USERDATA_TX_SLAB_MEDIUM_SIZE < USERDATA_TX_DATAFIELD_SIZE))))
+#error "USERDATA TX slab largest class does not fit maximum user data size"
+#endif
+
+/**< Max TX fifo size, one element per data block by default */
 #ifndef USERDATA_TX_FIFO_SIZE
-#define USERDATA_TX_FIFO_SIZE		4
+#define USERDATA_TX_FIFO_SIZE		(USERDATA_TX_SLAB_SMALL_NB + USERDATA_TX_SLAB_MEDIUM_NB + \
+					 USERDATA_TX_SLAB_LARGE_NB)
+#endif
+
+#if (USERDATA_TX_FIFO_SIZE > 0xFFFF)
+#error "USERDATA TX FIFO SIZE exceeds element counter range"
+#endif
+
+/** Value of a message handle which never refers to any element */
+#define USERDATA_TX_HANDLE_INVALID	0xFFFF
+
+/** Default aging period of TX scheduling policy, in ms, cf @ref sUserDataTxPolicy_t */
+#ifndef USERDATA_TX_AGING_MS
+#define USERDATA_TX_AGING_MS		600000
 #endif
 
 /* Enums --------------------------------------------------------------------------------------- */
@@ -160,7 +239,9 @@ enum eUserDataAttrService {
  * strategies to transmit the message. So far, attribute is defined as:
  * * bit0-2: service (000 no, 001 mail request, 010 ACK, ... reserved)
  * * bit3  : add back/front (0 back, 1 front)
- * * bit4-7: reserved
+ * * bit4-5: priority (00 from service, 01 high, 10 normal, 11 low), cf @ref eUserDataTxClass
+ * * bit6  : aggregation (0 sent alone, 1 may be packed with other small messages in one frame)
+ * * bit7  : reserved
  *
  */
 union sUserDataAttribute_t {
@@ -168,11 +249,33 @@ union sUserDataAttribute_t {
 		/* FW status */
 		enum eUserDataAttrService sf:3;
 		uint8_t backFront:1;
-		uint8_t reserved:4;
+		uint8_t prio:2;
+		uint8_t agg:1;
+		uint8_t reserved:1;
 	};
 	uint8_t u8_raw;
 };
 
+/**
+ * @brief enum listing priority classes of TX fifo, served in this order
+ */
+enum eUserDataTxClass {
+	USERDATA_TX_CLASS_EMERGENCY = 0, /**< emergency messages, ahead of all others */
+	USERDATA_TX_CLASS_HIGH,          /**< e.g. messages requesting ACK or mail */
+	USERDATA_TX_CLASS_NORMAL,        /**< default class, the only one of FIFO policy */
+	USERDATA_TX_CLASS_LOW,           /**< e.g. periodic position fixes, dropped first */
+	USERDATA_TX_CLASS_MAX
+};
+
+/**
+ * @brief enum listing overflow strategies of TX fifo
+ */
+enum eUserDataTxDrop {
+	USERDATA_TX_DROP_NONE = 0, /**< new message is rejected when fifo is full */
+	USERDATA_TX_DROP_OLDEST,   /**< oldest message is dropped */
+	USERDATA_TX_DROP_LOWEST    /**< oldest message of the lowest class is dropped */
+};
+
 /**
  * @brief enum listing RAT using the USERDATA fifo
  *
@@ -218,13 +321,22 @@ struct sUserDataTxFifoRatCtrl_t {
  * @brief structure defining one element of the TX fifo
  */
 struct sUserDataTxFifoElt_t {
-	uint8_t u8DataBuf[USERDATA_TX_PAYLOAD_MAX_SIZE];
+	uint8_t *pu8DataBuf;     /**< user data in binary, block from TX data slab allocator */
+	uint16_t u16DataBufSize; /**< size of data block in bytes */
 	bool bIsToBeTransmit;  /** when true, element is reserved, ready to be added in fifo when
 				* correctly filled-up
 				*/
 	union sUserDataAttribute_t u8Attr;
 	uint16_t u16DataBitLen;
 	struct sUserDataTxFifoRatCtrl_t sRatCtrl; /**< struct w/ ctrl info from RAT managers */
+	uint16_t u16Handle; /**< message handle, unique among reserved elements */
+	uint32_t u32JournalId; /**< message identifier in flash journal, 0 if not journaled */
+	uint8_t u8TxClass; /**< priority class (enum eUserDataTxClass), set when added in fifo */
+	bool bIsSubmitted; /**< handed to lower layer, set by lower layer, never dropped then */
+	uint16_t u16EnqueueNb; /**< order of addition in fifo, wraps around */
+	uint32_t u32ClassTimeMs; /**< time the element entered its class, for aging */
+	bool bIsInFifo; /**< element is linked in the chained list */
+	struct sUserDataTxFifoElt_t *spPrev; /**< pointer to previous element of the chained list */
 	struct sUserDataTxFifoElt_t *spNext; /**< pointer to next element of the chained list */
 };
 
@@ -243,6 +355,35 @@ struct sUserDataClientCb_t {
 	 bool (*USERDATA_txFifoFlushCb)(void); /**< fifo flush triggered by someone */
 };
 
+/**
+ * @brief structure defining a TX scheduling policy, cf @ref user_data_design_point_sched
+ *
+ * Callbacks can be set to NULL if not needed.
+ */
+struct sUserDataTxPolicy_t {
+	/** class of a message from its attribute, NULL to put all in USERDATA_TX_CLASS_NORMAL */
+	enum eUserDataTxClass (*USERDATA_txPolicyGetClassCb)(union sUserDataAttribute_t u8Attr);
+	/** current time in ms for aging, NULL to disable aging */
+	uint32_t (*USERDATA_txPolicyGetTimeMsCb)(void);
+	uint32_t u32AgingMs; /**< time spent in a class before promotion, 0 to disable aging */
+	enum eUserDataTxDrop eDrop; /**< overflow strategy */
+};
+
+/**
+ * @brief structure containing counters of a TX priority class
+ *
+ * A message is counted as removed or dropped in the class it belongs to at that time, i.e. after
+ * its promotions if any.
+ */
+struct sUserDataTxClassStats_t {
+	uint16_t u16Count;     /**< messages currently in fifo */
+	uint16_t u16MaxCount;  /**< high-water mark of u16Count */
+	uint32_t u32AddNb;     /**< messages added in fifo */
+	uint32_t u32RemoveNb;  /**< messages removed from fifo (transmitted, failed, flushed) */
+	uint32_t u32DropNb;    /**< messages dropped on overflow */
+	uint32_t u32PromoteNb; /**< messages promoted to upper class by aging */
+};
+
 /* Externs ------------------------------------------------------------------------------------- */
 
 extern struct sUserDataClientCb_t sUserDataClientCb[];
@@ -256,19 +397,26 @@ extern struct sUserDataClientCb_t sUserDataClientCb[];
 /**
  * @brief Get an element from memory pool in a way to push it later
  *
+ * The element gets a zeroed data block (pu8DataBuf) of at least u16DataByteLen bytes, from the
+ * smallest size class having a free block.
+ *
  * \note The found element is internally no more considered free after calling this function.
  * The caller will have to handle it later by adding the element into the fifo.
  * It possible to delete by calling API USERDATA_txFifoRemoveElt once the element is in the fifo.
  *
- * @return pointer on element, NULL if no more free element
+ * @param[in] u16DataByteLen length of user data to be stored, in bytes
+ *
+ * @return pointer on element, NULL if no more free element or data block
  */
-struct sUserDataTxFifoElt_t *USERDATA_txFifoReserveElt();
+struct sUserDataTxFifoElt_t *USERDATA_txFifoReserveElt(uint16_t u16DataByteLen);
 
 /**
  * @brief Add element in TX fifo
  *
+ * The element is given a priority class by the TX scheduling policy, cf @ref sUserDataTxPolicy_t.
+ *
  * @param[in] spEltToAdd pointer to the element to add
- * @param[in] bIsAddBack add elt at the back of the fifo if true, add it at the front if false
+ * @param[in] bIsAddBack add elt at the back of its class if true, add it at the front if false
  *
  * @return true is success, false else
  */
@@ -297,7 +445,7 @@ bool USERDATA_txFifoIsEltInFifo(struct sUserDataTxFifoElt_t *spEltToFind);
  *
  * @return number of elements in the fifo
  */
-uint8_t USERDATA_txFifoGetCount(void);
+uint16_t USERDATA_txFifoGetCount(void);
 
 /**
  * @brief flush TX fifo
@@ -314,14 +462,95 @@ bool USERDATA_txFifoFlush(void);
 struct sUserDataTxFifoElt_t *USERDATA_txFifoGetFirst(void);
 
 /**
- * @brief get first element which contains the expected payload
+ * @brief get reserved element from its message handle
  *
- * @param[in] data pointer to dat payload
- * @param[in] bitlen length of the data payload in bits
+ * @param[in] u16Handle message handle, as set in element at reservation
  *
- * @return pointer to the first element
+ * @return pointer to the element, NULL if handle is stale or invalid
+ */
+struct sUserDataTxFifoElt_t *USERDATA_txFifoGetEltByHandle(uint16_t u16Handle);
+
+/**
+ * @brief check element contains the expected payload
+ *
+ * Only the u16Bitlen first bits of the data are compared, remaining bits of last byte are ignored.
+ *
+ * @param[in] spElt pointer to the element
+ * @param[in] pu8Data pointer to data payload
+ * @param[in] u16Bitlen length of the data payload in bits
+ *
+ * @return true if payload is the same, false otherwise
+ */
+bool USERDATA_txFifoIsPayloadEqual(struct sUserDataTxFifoElt_t *spElt, uint8_t *pu8Data,
+	uint16_t u16Bitlen);
+
+/**
+ * @brief Set TX scheduling policy
+ *
+ * Elements already in fifo, but not submitted to lower layer yet, are classified again with the new
+ * policy. Order of elements of a same class is kept.
+ *
+ * @param[in] spPolicy pointer to the policy, kept by the library. NULL for default FIFO policy
+ */
+void USERDATA_txFifoSetPolicy(const struct sUserDataTxPolicy_t *spPolicy);
+
+/**
+ * @brief Class function driven by user data attribute, to be used in a TX scheduling policy
+ *
+ * * service PACK_EMERGENCY: USERDATA_TX_CLASS_EMERGENCY
+ * * priority field set: USERDATA_TX_CLASS_HIGH, USERDATA_TX_CLASS_NORMAL or USERDATA_TX_CLASS_LOW
+ * * otherwise, service PACK or MAIL_REQUEST: USERDATA_TX_CLASS_HIGH
+ * * otherwise: USERDATA_TX_CLASS_NORMAL
+ *
+ * @param[in] u8Attr user data attribute
+ *
+ * @return priority class
+ */
+enum eUserDataTxClass USERDATA_txFifoGetClassByAttr(union sUserDataAttribute_t u8Attr);
+
+/**
+ * @brief Promote elements which waited longer than aging period in their class
+ *
+ * Elements are promoted by one class at a time, up to USERDATA_TX_CLASS_HIGH. Elements submitted to
+ * lower layer are left as is. To be called by lower layer before serving the fifo.
+ *
+ * @return number of promoted elements
+ */
+uint16_t USERDATA_txFifoAge(void);
+
+/**
+ * @brief Get the element to drop so that a new message fits in a full fifo
+ *
+ * Dropping the returned element (\ref USERDATA_txFifoDropElt) frees an element slot and a data
+ * block large enough for the new message.
+ *
+ * @param[in] u16DataByteLen length of user data of the new message, in bytes
+ * @param[in] u8Attr attribute of the new message
+ *
+ * @return pointer to the element, NULL if policy does not allow to drop any
+ */
+struct sUserDataTxFifoElt_t *USERDATA_txFifoGetDropCandidate(uint16_t u16DataByteLen,
+	union sUserDataAttribute_t u8Attr);
+
+/**
+ * @brief Drop an element from the TX fifo, counted as dropped in class counters
+ *
+ * @param[in] spEltToDrop pointer to the element to be dropped
+ *
+ * @return true when element is found and removed, false otherwise
+ */
+bool USERDATA_txFifoDropElt(struct sUserDataTxFifoElt_t *spEltToDrop);
+
+/**
+ * @brief Get counters of a TX priority class
+ *
+ * Counters are kept in retention RAM along with the fifo, they are cleared when it is lost.
+ *
+ * @param[in] eClass priority class
+ * @param[out] spStats counters
  */
-struct sUserDataTxFifoElt_t *USERDATA_txFifoFindPayload(uint8_t *data, uint16_t bitlen);
+void USERDATA_txFifoGetClassStats(enum eUserDataTxClass eClass,
+	struct sUserDataTxClassStats_t *spStats);
 
 #endif /* USE_USERDATA_TX */
 
@@ -0,0 +1,199 @@
+/* SPDX-License-Identifier: no SPDX license */
+/**
+ * @file   user_data_journal.h
+ * @brief  Power-loss-safe flash journal of the USERDATA TX fifo
+ * @author Kinéis
+ */
+
+/**
+ * @page user_data_journal_page User data TX journal
+ *
+ * The USERDATA TX fifo lives in retention RAM (SRAM2), which survives STOP and STANDBY modes but
+ * not SHUTDOWN, brown-out, reset or power loss. The journal keeps a copy of the fifo content in
+ * flash (\ref mcu_flash_page), so that pending messages are recovered at boot.
+ *
+ * @section user_data_journal_records Records
+ *
+ * The journal is log-structured: each fifo operation appends a record, nothing is modified in
+ * place. Each record holds a sequence number, incremented for each record, and a CRC32. A message
+ * is identified by the sequence number of its ENQ record, kept along with the fifo element.
+ * * ENQ: message added in fifo, with its attribute and data
+ * * MOVE: copy of a still pending ENQ record, written by compaction, which supersedes it
+ * * DEQ: message removed from fifo (transmitted, failed, ...)
+ * * FLUSH: fifo was flushed, all previous records are obsolete
+ * * TRIM: written by compaction before erasing a page, previous records are obsolete
+ *
+ * A record interrupted by power loss is detected by its CRC (or by flash ECC), and ignored. A page
+ * whose erase was interrupted is detected thanks to TRIM records, and erased again.
+ *
+ * @section user_data_journal_pages Pages and compaction
+ *
+ * Flash pages of the journal area are used as a ring: records are appended to the head page, and
+ * the oldest page is erased once its still pending messages are copied (MOVE) to the head page.
+ * Thus, pages are erased one after the other (wear levelling).
+ *
+ * Compaction is done in background (\ref USERDATA_journalProcess) so that at least 2 pages stay
+ * erased. It is never done when appending a record, as fifo operations occur while radio is on: if
+ * it did not run in time, records stay staged in RAM until next compaction. When even the staging
+ * area is full, next fifo operations are not journaled (see u16Dropped statistic).
+ *
+ * @section user_data_journal_recovery Recovery
+ *
+ * At boot, when retention RAM content was lost, \ref USERDATA_journalRecover replays the records
+ * in sequence order to find pending messages. They are added back in fifo sorted by identifier,
+ * i.e. in their original order, even for the ones moved by compaction.
+ *
+ * @section user_data_journal_sync Sync policy
+ *
+ * Records are written as soon as the fifo operation occurs (default), or staged in RAM and written
+ * by batches of N records (\ref USERDATA_journalSetSyncBatch). Batching saves flash programming
+ * time and wear, as a message dequeued before being synced is never written at all. Staged records
+ * are lost on power loss, so up to N-1 fifo operations can be lost.
+ *
+ * Staged records are written anyway:
+ * * USERDATA_JOURNAL_SYNC_LATENCY_MS after the first of them was staged
+ *   (\ref USERDATA_journalSyncProcess)
+ * * before entering STANDBY or SHUTDOWN modes, through the USERDATA LPM client
+ *   (lpm_cli_user_data.h)
+ */
+
+/**
+ * @addtogroup USER_DATA
+ * @{
+ */
+
+#ifndef USER_DATA_JOURNAL_H
+#define USER_DATA_JOURNAL_H
+
+/* Includes ------------------------------------------------------------------------------------ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "user_data.h"
+
+#pragma GCC visibility push(default)
+
+/* Defines ------------------------------------------------------------------------------------- */
+
+/** Number of flash pages of the journal area */
+#ifndef USERDATA_JOURNAL_PAGE_NB
+#define USERDATA_JOURNAL_PAGE_NB	4
+#endif
+
+/** Maximum number of records staged in RAM before being written, 1 to write immediately */
+#ifndef USERDATA_JOURNAL_SYNC_BATCH_MAX
+#define USERDATA_JOURNAL_SYNC_BATCH_MAX	8
+#endif
+
+/** Default number of records written at once */
+#ifndef USERDATA_JOURNAL_SYNC_BATCH
+#define USERDATA_JOURNAL_SYNC_BATCH	1
+#endif
+
+/** Maximum time a record stays staged in RAM before being written, in ms */
+#ifndef USERDATA_JOURNAL_SYNC_LATENCY_MS
+#define USERDATA_JOURNAL_SYNC_LATENCY_MS	60000
+#endif
+
+#if (USERDATA_JOURNAL_SYNC_BATCH < 1) || \
+	(USERDATA_JOURNAL_SYNC_BATCH > USERDATA_JOURNAL_SYNC_BATCH_MAX)
+#error "USERDATA_JOURNAL_SYNC_BATCH out of range"
+#endif
+
+/* Structs ------------------------------------------------------------------------------------- */
+
+/**
+ * @brief journal statistics
+ */
+struct sUserDataJournalStats_t {
+	uint32_t u32RecordNb;   /**< records written since boot */
+	uint32_t u32EraseNb;    /**< pages erased since boot */
+	uint16_t u16Recovered;  /**< messages recovered at boot */
+	uint16_t u16Corrupted;  /**< corrupted records found at boot */
+	uint16_t u16Dropped;    /**< records dropped as journal was full */
+	uint8_t u8ErasedPageNb; /**< erased pages ready to be written */
+};
+
+/* Public functions ---------------------------------------------------------------------------- */
+
+/**
+ * @brief Recover TX fifo from journal
+ *
+ * To be called once at boot, when retention RAM was lost (i.e. not after STOP or STANDBY), before
+ * any use of the TX fifo. Without this call, the journal is not used.
+ *
+ * @note Journal state is kept in retention RAM along with the fifo, nothing is needed when waking
+ * up from STOP or STANDBY.
+ *
+ * @return number of recovered messages
+ */
+uint16_t USERDATA_journalRecover(void);
+
+/**
+ * @brief Journal an element added in fifo
+ *
+ * @param[in] spElt pointer to the element
+ */
+void USERDATA_journalEnqueue(struct sUserDataTxFifoElt_t *spElt);
+
+/**
+ * @brief Journal an element removed from fifo
+ *
+ * @param[in] spElt pointer to the element
+ */
+void USERDATA_journalDequeue(struct sUserDataTxFifoElt_t *spElt);
+
+/**
+ * @brief Journal a fifo flush
+ */
+void USERDATA_journalFlush(void);
+
+/**
+ * @brief Write all staged records into flash
+ *
+ * Records which cannot be written (no room until next compaction) stay staged, they are written
+ * by \ref USERDATA_journalProcess.
+ */
+void USERDATA_journalSync(void);
+
+/**
+ * @brief Set sync policy
+ *
+ * @param[in] u8BatchNb number of records written at once (1 to write each record immediately),
+ * up to USERDATA_JOURNAL_SYNC_BATCH_MAX
+ *
+ * @return true if success, false if out of range
+ */
+bool USERDATA_journalSetSyncBatch(uint8_t u8BatchNb);
+
+/**
+ * @brief Background job: write staged records once sync latency timer expired
+ *
+ * To be called from APP task, which is woken-up on timer expiry. Unlike compaction, it only
+ * programs flash and can be called while radio is on.
+ */
+void USERDATA_journalSyncProcess(void);
+
+/**
+ * @brief Background job: compact journal when running out of erased pages, then write records left
+ * staged for lack of room
+ *
+ * @attention Erasing a page stalls the CPU for ~22 ms. Call it when no time-critical activity is
+ * on-going (e.g. radio off).
+ */
+void USERDATA_journalProcess(void);
+
+/**
+ * @brief Get journal statistics
+ *
+ * @param[out] spStats statistics
+ */
+void USERDATA_journalGetStats(struct sUserDataJournalStats_t *spStats);
+
+#pragma GCC visibility pop
+
+#endif /* USER_DATA_JOURNAL_H */
+
+/**
+ * @}
+ */
@@ -14,8 +14,12 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 #include "kns_cs.h"
 #include "user_data.h"
+#ifdef USE_USERDATA_JOURNAL
+#include "user_data_journal.h"
+#endif
 #include "kineis_sw_conf.h"  // for assert include below
 #include KINEIS_SW_ASSERT_H
 
@@ -24,8 +28,30 @@
 
 /* Struct -------------------------------------------------------------------------------------- */
 
+/** Number of 32-bit words of the TX element slot bitmap */
+#define USERDATA_TX_SLOT_MAP_SIZE	((USERDATA_TX_FIFO_SIZE + 31) / 32)
+
+/** Number of handle generations, so that handle never reaches USERDATA_TX_HANDLE_INVALID */
+#define USERDATA_TX_HANDLE_GEN_NB	(USERDATA_TX_HANDLE_INVALID / USERDATA_TX_FIFO_SIZE)
+
 struct sUserDataTxFifo_t {
 	struct sUserDataTxFifoElt_t *spFirst; /**< fifo start pointer */
+	struct sUserDataTxFifoElt_t *spLast;  /**< fifo end pointer */
+	uint16_t u16Count;                    /**< number of elements in fifo */
+	uint32_t au32UsedSlot[USERDATA_TX_SLOT_MAP_SIZE]; /**< bit n set when slot n is reserved */
+	uint16_t u16HandleGen;                /**< generation of next message handle */
+	uint16_t u16EnqueueNb;                /**< order of next element added in fifo */
+	struct sUserDataTxFifoElt_t *aspClassLast[USERDATA_TX_CLASS_MAX]; /**< last elt of classes */
+};
+
+/**
+ * @brief Size class of the TX data slab allocator
+ */
+struct sUserDataTxSlab_t {
+	uint8_t *pu8Pool;      /**< contiguous blocks of the class */
+	uint32_t *pu32UsedMap; /**< bit n set when block n is allocated */
+	uint16_t u16BlockSize; /**< size of one block in bytes */
+	uint16_t u16BlockNb;   /**< number of blocks of the class */
 };
 
 struct sUserDataRx_t {
@@ -38,11 +64,20 @@ struct sUserDataRx_t {
 #ifdef USE_USERDATA_TX
 /* default values of TX fifo elements */
 const struct sUserDataTxFifoElt_t sUserDataTxEltDflt =  {
-		.u8DataBuf = {0},
+		.pu8DataBuf = NULL,
+		.u16DataBufSize = 0,
 		.bIsToBeTransmit = false,
 		.u8Attr.u8_raw = 0x00,
 		.u16DataBitLen = 0,
 		//.sRatCtrl = {0}, //.sRatCtrl will be initialized by calling client's callbacks
+		.u16Handle = USERDATA_TX_HANDLE_INVALID,
+		.u32JournalId = 0,
+		.u8TxClass = USERDATA_TX_CLASS_NORMAL,
+		.bIsSubmitted = false,
+		.u16EnqueueNb = 0,
+		.u32ClassTimeMs = 0,
+		.bIsInFifo = false,
+		.spPrev = NULL,
 		.spNext = NULL
 };
 
@@ -54,6 +89,84 @@ static
 __attribute__((__section__(".retentionRamData")))
 struct sUserDataTxFifo_t sUserDataTxFifo = {
 		.spFirst  = NULL,
+		.spLast  = NULL,
+		.u16Count = 0,
+		.au32UsedSlot = {0},
+		.u16HandleGen = 0,
+		.u16EnqueueNb = 0,
+		.aspClassLast = {NULL}
+};
+
+static
+__attribute__((__section__(".retentionRamBss")))
+struct sUserDataTxClassStats_t asUserDataTxClassStats[USERDATA_TX_CLASS_MAX];
+
+/* default TX scheduling policy: plain FIFO */
+static const struct sUserDataTxPolicy_t sUserDataTxPolicyFifo = {
+		.USERDATA_txPolicyGetClassCb = NULL,
+		.USERDATA_txPolicyGetTimeMsCb = NULL,
+		.u32AgingMs = 0,
+		.eDrop = USERDATA_TX_DROP_NONE
+};
+
+static const struct sUserDataTxPolicy_t *spUserDataTxPolicy = &sUserDataTxPolicyFifo;
+
+#if (USERDATA_TX_SLAB_SMALL_NB > 0)
+static
+__attribute__((__section__(".retentionRamBss")))
+uint8_t au8UserDataTxSlabSmall[USERDATA_TX_SLAB_SMALL_NB * USERDATA_TX_SLAB_SMALL_SIZE];
+
+static
+__attribute__((__section__(".retentionRamBss")))
+uint32_t au32UserDataTxSlabSmallMap[(USERDATA_TX_SLAB_SMALL_NB + 31) / 32];
+#endif
+
+#if (USERDATA_TX_SLAB_MEDIUM_NB > 0)
+static
+__attribute__((__section__(".retentionRamBss")))
+uint8_t au8UserDataTxSlabMedium[USERDATA_TX_SLAB_MEDIUM_NB * USERDATA_TX_SLAB_MEDIUM_SIZE];
+
+static
+__attribute__((__section__(".retentionRamBss")))
+uint32_t au32UserDataTxSlabMediumMap[(USERDATA_TX_SLAB_MEDIUM_NB + 31) / 32];
+#endif
+
+#if (USERDATA_TX_SLAB_LARGE_NB > 0)
+static
+__attribute__((__section__(".retentionRamBss")))
+uint8_t au8UserDataTxSlabLarge[USERDATA_TX_SLAB_LARGE_NB * USERDATA_TX_SLAB_LARGE_SIZE];
+
+static
+__attribute__((__section__(".retentionRamBss")))
+uint32_t au32UserDataTxSlabLargeMap[(USERDATA_TX_SLAB_LARGE_NB + 31) / 32];
+#endif
+
+/* size classes of TX data slab allocator, sorted by increasing block size */
+static const struct sUserDataTxSlab_t sUserDataTxSlab[] = {
+#if (USERDATA_TX_SLAB_SMALL_NB > 0)
+	{
+		.pu8Pool = au8UserDataTxSlabSmall,
+		.pu32UsedMap = au32UserDataTxSlabSmallMap,
+		.u16BlockSize = USERDATA_TX_SLAB_SMALL_SIZE,
+		.u16BlockNb = USERDATA_TX_SLAB_SMALL_NB
+	},
+#endif
+#if (USERDATA_TX_SLAB_MEDIUM_NB > 0)
+	{
+		.pu8Pool = au8UserDataTxSlabMedium,
+		.pu32UsedMap = au32UserDataTxSlabMediumMap,
+		.u16BlockSize = USERDATA_TX_SLAB_MEDIUM_SIZE,
+		.u16BlockNb = USERDATA_TX_SLAB_MEDIUM_NB
+	},
+#endif
+#if (USERDATA_TX_SLAB_LARGE_NB > 0)
+	{
+		.pu8Pool = au8UserDataTxSlabLarge,
+		.pu32UsedMap = au32UserDataTxSlabLargeMap,
+		.u16BlockSize = USERDATA_TX_SLAB_LARGE_SIZE,
+		.u16BlockNb = USERDATA_TX_SLAB_LARGE_NB
+	},
+#endif
 };
 #endif /* USE_USERDATA_TX */
 
@@ -84,9 +197,10 @@ static bool USERDATA_txFifoIsInBuf(struct sUserDataTxFifoElt_t *spElt);
 static void USERDATA_txFifoLog(void)
 {
 	struct sUserDataTxFifoElt_t *spTxFifoElt = sUserDataTxFifo.spFirst;
+	uint32_t u32_csMask;
 
 	/* make fifo log atomic, by putting all code under critical section */
-	KNS_CS_enter();
+	u32_csMask = KNS_CS_enterSave();
 
 	MGR_LOG_VERBOSE("USERDATA: TX FIFO:");
 	/* From top of the fifo, log address of each element */
@@ -98,7 +212,98 @@ static void USERDATA_txFifoLog(void)
 	MGR_LOG_VERBOSE_RAW(":\r\n");
 
 	/* Enable interrupts back only if they were enabled before we disabled it in this fct */
-	KNS_CS_exit();
+	KNS_CS_exitRestore(u32_csMask);
+}
+
+/**
+ * @brief Allocate first free bit of a bitmap
+ *
+ * @param[in,out] pu32Map bitmap, bit set when allocated
+ * @param[in] u16BitNb number of bits of the bitmap
+ *
+ * @return index of allocated bit, u16BitNb if bitmap is full
+ */
+static uint16_t USERDATA_bitmapAlloc(uint32_t *pu32Map, uint16_t u16BitNb)
+{
+	uint16_t u16WordIdx;
+	uint16_t u16BitIdx;
+	uint32_t u32FreeBits;
+
+	/* search some free bit, 32 bits at a time */
+	for (u16WordIdx = 0; u16WordIdx < ((u16BitNb + 31) / 32); u16WordIdx++) {
+		u32FreeBits = ~pu32Map[u16WordIdx];
+		if (u32FreeBits == 0)
+			continue;
+		u16BitIdx = (u16WordIdx * 32) + __builtin_ctz(u32FreeBits);
+		/* unused bits of last bitmap word are seen free, filter them out */
+		if (u16BitIdx >= u16BitNb)
+			break;
+		pu32Map[u16WordIdx] |= 1UL << (u16BitIdx % 32);
+		return u16BitIdx;
+	}
+	return u16BitNb;
+}
+
+/**
+ * @brief Free a bit of a bitmap
+ *
+ * @param[in,out] pu32Map bitmap, bit set when allocated
+ * @param[in] u16BitIdx index of bit to free
+ */
+static inline void USERDATA_bitmapFree(uint32_t *pu32Map, uint16_t u16BitIdx)
+{
+	pu32Map[u16BitIdx / 32] &= ~(1UL << (u16BitIdx % 32));
+}
+
+/**
+ * @brief Allocate a data block from the smallest size class fitting the length
+ *
+ * @param[in] u16ByteLen length of data in bytes
+ * @param[out] pu16BlockSize size of allocated block in bytes
+ *
+ * @return pointer to the block, NULL if no free block is large enough
+ */
+static uint8_t *USERDATA_txSlabAlloc(uint16_t u16ByteLen, uint16_t *pu16BlockSize)
+{
+	const struct sUserDataTxSlab_t *spSlab;
+	uint16_t u16BlockIdx;
+	uint8_t u8SlabIdx;
+
+	for (u8SlabIdx = 0; u8SlabIdx < (sizeof(sUserDataTxSlab) / sizeof(sUserDataTxSlab[0]));
+	     u8SlabIdx++) {
+		spSlab = &sUserDataTxSlab[u8SlabIdx];
+		if (spSlab->u16BlockSize < u16ByteLen)
+			continue;
+		u16BlockIdx = USERDATA_bitmapAlloc(spSlab->pu32UsedMap, spSlab->u16BlockNb);
+		if (u16BlockIdx < spSlab->u16BlockNb) {
+			*pu16BlockSize = spSlab->u16BlockSize;
+			return &spSlab->pu8Pool[u16BlockIdx * spSlab->u16BlockSize];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Give back a data block to its size class
+ *
+ * @param[in] pu8Block pointer to the block, as returned by USERDATA_txSlabAlloc
+ */
+static void USERDATA_txSlabFree(uint8_t *pu8Block)
+{
+	const struct sUserDataTxSlab_t *spSlab;
+	uintptr_t offset;
+	uint8_t u8SlabIdx;
+
+	for (u8SlabIdx = 0; u8SlabIdx < (sizeof(sUserDataTxSlab) / sizeof(sUserDataTxSlab[0]));
+	     u8SlabIdx++) {
+		spSlab = &sUserDataTxSlab[u8SlabIdx];
+		offset = (uintptr_t)pu8Block - (uintptr_t)spSlab->pu8Pool;
+		if (offset < ((uintptr_t)spSlab->u16BlockNb * spSlab->u16BlockSize)) {
+			USERDATA_bitmapFree(spSlab->pu32UsedMap, offset / spSlab->u16BlockSize);
+			return;
+		}
+	}
+	kns_assert(0);
 }
 
 /**
@@ -110,44 +315,172 @@ static void USERDATA_txFifoLog(void)
  */
 static bool USERDATA_txFifoIsInBuf(struct sUserDataTxFifoElt_t *spElt)
 {
-	uint8_t eltIdx;
+	uintptr_t offset = (uintptr_t)spElt - (uintptr_t)sUserDataTxFifoBuf;
 
-	/* search element */
-	for (eltIdx = 0;
-	     eltIdx < USERDATA_TX_FIFO_SIZE &&
-	     &sUserDataTxFifoBuf[eltIdx] != spElt;
-	     eltIdx++)
-		/* empty for loop */
-		;
+	/* pointer below buffer wraps to a large offset */
+	return (offset < sizeof(sUserDataTxFifoBuf)) &&
+		((offset % sizeof(sUserDataTxFifoBuf[0])) == 0);
+}
 
-	if (eltIdx == USERDATA_TX_FIFO_SIZE)
-		return false;
+/**
+ * @brief get slot index of an element of sUserDataTxFifoBuf buffer
+ *
+ * @param[in] spElt pointer to the element, in buffer
+ *
+ * @return slot index
+ */
+static inline uint16_t USERDATA_txFifoSlotIdx(struct sUserDataTxFifoElt_t *spElt)
+{
+	return (uint16_t)(spElt - sUserDataTxFifoBuf);
+}
+
+/**
+ * @brief Unlink an element from the chained list
+ *
+ * @param[in] spElt pointer to the element, in fifo
+ */
+static void USERDATA_txFifoUnlink(struct sUserDataTxFifoElt_t *spElt)
+{
+	uint8_t u8Class = spElt->u8TxClass;
+
+	/* previous element becomes last of the class, if it is part of it */
+	if (sUserDataTxFifo.aspClassLast[u8Class] == spElt)
+		sUserDataTxFifo.aspClassLast[u8Class] =
+			((spElt->spPrev != NULL) && (spElt->spPrev->u8TxClass == u8Class)) ?
+			spElt->spPrev : NULL;
+
+	if (spElt->spPrev != NULL)
+		spElt->spPrev->spNext = spElt->spNext;
+	else
+		sUserDataTxFifo.spFirst = spElt->spNext;
+	if (spElt->spNext != NULL)
+		spElt->spNext->spPrev = spElt->spPrev;
+	else
+		sUserDataTxFifo.spLast = spElt->spPrev;
+
+	spElt->spPrev = NULL;
+	spElt->spNext = NULL;
+	spElt->bIsInFifo = false;
+	sUserDataTxFifo.u16Count--;
+	asUserDataTxClassStats[u8Class].u16Count--;
+}
+
+/**
+ * @brief Link an element in the chained list, at the back or front of its class
+ *
+ * The element is inserted right after the last element of the classes served before it (front),
+ * or before and with it (back).
+ *
+ * @param[in] spElt pointer to the element, not in fifo, with its class set
+ * @param[in] bIsAddBack add elt at the back of its class if true, at the front if false
+ */
+static void USERDATA_txFifoLink(struct sUserDataTxFifoElt_t *spElt, bool bIsAddBack)
+{
+	struct sUserDataTxClassStats_t *spStats = &asUserDataTxClassStats[spElt->u8TxClass];
+	struct sUserDataTxFifoElt_t *spPrev = NULL;
+	uint8_t u8Class = spElt->u8TxClass + (bIsAddBack ? 1 : 0);
+
+	while ((spPrev == NULL) && (u8Class > 0))
+		spPrev = sUserDataTxFifo.aspClassLast[--u8Class];
+
+	spElt->spPrev = spPrev;
+	spElt->spNext = (spPrev != NULL) ? spPrev->spNext : sUserDataTxFifo.spFirst;
+	if (spElt->spNext != NULL)
+		spElt->spNext->spPrev = spElt;
+	else
+		sUserDataTxFifo.spLast = spElt;
+	if (spPrev != NULL)
+		spPrev->spNext = spElt;
 	else
-		return true;
+		sUserDataTxFifo.spFirst = spElt;
+	if (bIsAddBack || (sUserDataTxFifo.aspClassLast[spElt->u8TxClass] == NULL))
+		sUserDataTxFifo.aspClassLast[spElt->u8TxClass] = spElt;
+
+	spElt->bIsInFifo = true;
+	sUserDataTxFifo.u16Count++;
+	if (++spStats->u16Count > spStats->u16MaxCount)
+		spStats->u16MaxCount = spStats->u16Count;
 }
 
-struct sUserDataTxFifoElt_t *USERDATA_txFifoReserveElt(void)
+/**
+ * @brief Get priority class of a message as per current TX scheduling policy
+ *
+ * @param[in] u8Attr user data attribute of the message
+ *
+ * @return priority class
+ */
+static uint8_t USERDATA_txFifoGetClass(union sUserDataAttribute_t u8Attr)
 {
-	uint8_t eltIdx;
+	enum eUserDataTxClass eClass = USERDATA_TX_CLASS_NORMAL;
+
+	if (spUserDataTxPolicy->USERDATA_txPolicyGetClassCb != NULL)
+		eClass = spUserDataTxPolicy->USERDATA_txPolicyGetClassCb(u8Attr);
+	kns_assert(eClass < USERDATA_TX_CLASS_MAX);
+
+	return (uint8_t)eClass;
+}
+
+/**
+ * @brief Get current time of TX scheduling policy
+ *
+ * @return time in ms, 0 if policy has no time base
+ */
+static uint32_t USERDATA_txFifoGetTimeMs(void)
+{
+	if (spUserDataTxPolicy->USERDATA_txPolicyGetTimeMsCb == NULL)
+		return 0;
+	return spUserDataTxPolicy->USERDATA_txPolicyGetTimeMsCb();
+}
+
+/**
+ * @brief Give back the slot of an element and its data block to the memory pool
+ *
+ * @param[in] spElt pointer to the element, in buffer
+ */
+static void USERDATA_txFifoFreeSlot(struct sUserDataTxFifoElt_t *spElt)
+{
+	if (!spElt->bIsToBeTransmit)
+		return;
+
+	spElt->bIsToBeTransmit = false;
+	USERDATA_txSlabFree(spElt->pu8DataBuf);
+	spElt->pu8DataBuf = NULL;
+	spElt->u16DataBufSize = 0;
+	USERDATA_bitmapFree(sUserDataTxFifo.au32UsedSlot, USERDATA_txFifoSlotIdx(spElt));
+}
+
+struct sUserDataTxFifoElt_t *USERDATA_txFifoReserveElt(uint16_t u16DataByteLen)
+{
+	uint16_t u16SlotIdx;
+	uint16_t u16BlockSize = 0;
+	uint8_t *pu8Block;
 	struct sUserDataTxFifoElt_t *spFreeElt = NULL;
 
-	/* search some free element */
-	for (eltIdx = 0;
-	     eltIdx < USERDATA_TX_FIFO_SIZE &&
-	     sUserDataTxFifoBuf[eltIdx].bIsToBeTransmit == true;
-	     eltIdx++)
-		/* empty for loop */
-		;
+	u16SlotIdx = USERDATA_bitmapAlloc(sUserDataTxFifo.au32UsedSlot, USERDATA_TX_FIFO_SIZE);
+	if (u16SlotIdx < USERDATA_TX_FIFO_SIZE) {
+		pu8Block = USERDATA_txSlabAlloc(u16DataByteLen, &u16BlockSize);
+		if (pu8Block == NULL) {
+			USERDATA_bitmapFree(sUserDataTxFifo.au32UsedSlot, u16SlotIdx);
+			MGR_LOG_VERBOSE("USERDATA: TX FIFO: no data block for %d bytes\r\n",
+				u16DataByteLen);
+			return NULL;
+		}
 
-	if (eltIdx < USERDATA_TX_FIFO_SIZE) {
-		spFreeElt = &sUserDataTxFifoBuf[eltIdx];
+		spFreeElt = &sUserDataTxFifoBuf[u16SlotIdx];
 
 		/* check elt is not already part of the fifo */
-		kns_assert(!USERDATA_txFifoIsEltInFifo(spFreeElt));
+		kns_assert(!spFreeElt->bIsInFifo);
 
 		/* tag as reserved, caller will have to add it in fifo after fill-up */
 		*spFreeElt = sUserDataTxEltDflt;
 		spFreeElt->bIsToBeTransmit = true;
+		spFreeElt->pu8DataBuf = pu8Block;
+		spFreeElt->u16DataBufSize = u16BlockSize;
+		memset(pu8Block, 0, u16BlockSize);
+		spFreeElt->u16Handle = (sUserDataTxFifo.u16HandleGen * USERDATA_TX_FIFO_SIZE) +
+			u16SlotIdx;
+		sUserDataTxFifo.u16HandleGen = (sUserDataTxFifo.u16HandleGen + 1) %
+			USERDATA_TX_HANDLE_GEN_NB;
 	}
 
 	MGR_LOG_VERBOSE("USERDATA: TX FIFO: reserve 0x%x\r\n", spFreeElt);
@@ -155,19 +488,15 @@ struct sUserDataTxFifoElt_t *USERDATA_txFifoReserveElt(void)
 	return spFreeElt;
 }
 
-
-#pragma GCC push_options
-#pragma GCC optimize("O0")
 bool USERDATA_txFifoAddElt(struct sUserDataTxFifoElt_t *spEltToAdd, bool bIsAddBack)
 {
 	uint8_t u8IdxClient;
-	struct sUserDataTxFifoElt_t *spTxFifoElt = sUserDataTxFifo.spFirst;
 
 	if (USERDATA_txFifoIsInBuf(spEltToAdd) == false)
 		return false;
 
 	/* check elt is not already part of the fifo */
-	if (USERDATA_txFifoIsEltInFifo(spEltToAdd) == true)
+	if (spEltToAdd->bIsInFifo)
 		return false;
 
 	/* \note "u8IdxClient + 1 <= USERDATA_RAT_MAX" condition is used instead of
@@ -179,38 +508,32 @@ bool USERDATA_txFifoAddElt(struct sUserDataTxFifoElt_t *spEltToAdd, bool bIsAddB
 		if (sUserDataClientCb[u8IdxClient].USERDATA_txFifoAddEltCb != NULL)
 			sUserDataClientCb[u8IdxClient].USERDATA_txFifoAddEltCb(spEltToAdd);
 
-	/* if no element in FIFO  or add in front */
-	if (spTxFifoElt == NULL || !bIsAddBack) {
-		spEltToAdd->spNext = sUserDataTxFifo.spFirst;
-		sUserDataTxFifo.spFirst = spEltToAdd;
-	} else {
-		/* add in back of the TX Fifo, go to last element */
-		for (;
-		     spTxFifoElt->spNext != NULL;
-		     spTxFifoElt = spTxFifoElt->spNext)
-			/* empty for loop */
-			;
-
-		/* \note coding like below will only execute second instruction because of compiler
-		 * optimization:
-		 *     spTxFifoElt->spNext = spEltToAdd;
-		 *     spTxFifoElt->spNext = NULL;
-		 * Need to code like below then
-		 */
-		 spEltToAdd->spNext = NULL;
-		 spTxFifoElt->spNext = spEltToAdd;
-	}
+	spEltToAdd->u8TxClass = USERDATA_txFifoGetClass(spEltToAdd->u8Attr);
+	spEltToAdd->u32ClassTimeMs = USERDATA_txFifoGetTimeMs();
+	spEltToAdd->u16EnqueueNb = sUserDataTxFifo.u16EnqueueNb++;
+	USERDATA_txFifoLink(spEltToAdd, bIsAddBack);
+	asUserDataTxClassStats[spEltToAdd->u8TxClass].u32AddNb++;
 
 	USERDATA_txFifoLog();
 
+#ifdef USE_USERDATA_JOURNAL
+	USERDATA_journalEnqueue(spEltToAdd);
+#endif
+
 	return true;
 }
-#pragma GCC pop_options
 
-bool USERDATA_txFifoRemoveElt(struct sUserDataTxFifoElt_t *spEltToRemove)
+/**
+ * @brief Delete an element from the TX fifo
+ *
+ * @param[in] spEltToRemove pointer to the element to be removed
+ * @param[in] bIsDropped element is dropped on overflow, not removed after transmission
+ *
+ * @return true when element is found and removed, false otherwise
+ */
+static bool USERDATA_txFifoDelete(struct sUserDataTxFifoElt_t *spEltToRemove, bool bIsDropped)
 {
 	uint8_t u8IdxClient;
-	struct sUserDataTxFifoElt_t *spTxFifoElt = sUserDataTxFifo.spFirst;
 
 	if (USERDATA_txFifoIsInBuf(spEltToRemove) == false)
 		return false;
@@ -225,89 +548,71 @@ bool USERDATA_txFifoRemoveElt(struct sUserDataTxFifoElt_t *spEltToRemove)
 			kns_assert(sUserDataClientCb[u8IdxClient].USERDATA_txFifoTxCompleteCb(
 				spEltToRemove));
 
+#ifdef USE_USERDATA_JOURNAL
+	/* journal needs element content, before it is freed */
+	if (spEltToRemove->bIsInFifo)
+		USERDATA_journalDequeue(spEltToRemove);
+#endif
+
 	/* Free element from the memory buffer */
-	spEltToRemove->bIsToBeTransmit = false;
+	USERDATA_txFifoFreeSlot(spEltToRemove);
 
-	/* Remove element from TX fifo if present: */
-	/* - if no element in FIFO, exit */
-	if (spTxFifoElt == NULL)
+	/* Remove element from TX fifo if present */
+	if (!spEltToRemove->bIsInFifo)
 		return false;
-	/* - check element is the first one or not */
-	if (spTxFifoElt == spEltToRemove) {
-		sUserDataTxFifo.spFirst = spEltToRemove->spNext;
-		MGR_LOG_VERBOSE("USERDATA: TX FIFO: remove 0x%x\r\n", spEltToRemove);
-		USERDATA_txFifoLog();
-		return true;
-	}
-	/* - From top of the fifo, search the element to be removed */
-	for (;
-	     spTxFifoElt->spNext != NULL && spTxFifoElt->spNext != spEltToRemove;
-	     spTxFifoElt = spTxFifoElt->spNext)
-		/* empty for loop */
-		;
-	/* - if element found in list */
-	if (spTxFifoElt->spNext == spEltToRemove) {
-		spTxFifoElt->spNext = spEltToRemove->spNext;
-		MGR_LOG_VERBOSE("USERDATA: TX FIFO: remove 0x%x\r\n", spEltToRemove);
-		USERDATA_txFifoLog();
-		return true;
-	}
 
-	return false;
+	if (bIsDropped)
+		asUserDataTxClassStats[spEltToRemove->u8TxClass].u32DropNb++;
+	else
+		asUserDataTxClassStats[spEltToRemove->u8TxClass].u32RemoveNb++;
+	USERDATA_txFifoUnlink(spEltToRemove);
+	MGR_LOG_VERBOSE("USERDATA: TX FIFO: remove 0x%x\r\n", spEltToRemove);
+	USERDATA_txFifoLog();
+
+	return true;
 }
 
-bool USERDATA_txFifoIsEltInFifo(struct sUserDataTxFifoElt_t *spEltToFind)
+bool USERDATA_txFifoRemoveElt(struct sUserDataTxFifoElt_t *spEltToRemove)
 {
-	struct sUserDataTxFifoElt_t *spTxFifoElt = sUserDataTxFifo.spFirst;
+	return USERDATA_txFifoDelete(spEltToRemove, false);
+}
 
-	if (USERDATA_txFifoIsInBuf(spEltToFind) == false)
+bool USERDATA_txFifoDropElt(struct sUserDataTxFifoElt_t *spEltToDrop)
+{
+	if (!USERDATA_txFifoIsEltInFifo(spEltToDrop) || spEltToDrop->bIsSubmitted)
 		return false;
 
-	/* - if no element in FIFO, exit */
-	if (spTxFifoElt == NULL)
-		return false;
-	/* - check element is the first one or not */
-	if (spTxFifoElt == spEltToFind)
-		return true;
-	/* - From top of the fifo, search the element to be removed */
-	for (;
-	     spTxFifoElt->spNext != NULL && spTxFifoElt->spNext != spEltToFind;
-	     spTxFifoElt = spTxFifoElt->spNext)
-		/* empty for loop */
-		;
-	/* - if element found in list */
-	if (spTxFifoElt->spNext == spEltToFind)
-		return true;
-
-	return false;
+	MGR_LOG_DEBUG("USERDATA: TX FIFO: drop message %u of class %u\r\n",
+		spEltToDrop->u16Handle, spEltToDrop->u8TxClass);
+
+	return USERDATA_txFifoDelete(spEltToDrop, true);
 }
 
-uint8_t USERDATA_txFifoGetCount(void)
+bool USERDATA_txFifoIsEltInFifo(struct sUserDataTxFifoElt_t *spEltToFind)
 {
-	uint8_t u8EltCnt;
-	struct sUserDataTxFifoElt_t *spTxFifoElt = sUserDataTxFifo.spFirst;
+	if (USERDATA_txFifoIsInBuf(spEltToFind) == false)
+		return false;
 
-	/* From top of the fifo, search the element pointing on NULL */
-	for (u8EltCnt = 0;
-	     spTxFifoElt != NULL;
-	     spTxFifoElt = spTxFifoElt->spNext, u8EltCnt++)
-		/* empty for loop */
-		;
+	return spEltToFind->bIsInFifo;
+}
 
-	MGR_LOG_VERBOSE("USERDATA: TX FIFO contains %d elt\r\n", u8EltCnt);
+uint16_t USERDATA_txFifoGetCount(void)
+{
+	MGR_LOG_VERBOSE("USERDATA: TX FIFO contains %d elt\r\n", sUserDataTxFifo.u16Count);
 
-	kns_assert(u8EltCnt <= USERDATA_TX_FIFO_SIZE);
+	kns_assert(sUserDataTxFifo.u16Count <= USERDATA_TX_FIFO_SIZE);
 
-	return u8EltCnt;
+	return sUserDataTxFifo.u16Count;
 }
 
 bool USERDATA_txFifoFlush(void)
 {
 	uint8_t u8IdxClient;
 	struct sUserDataTxFifoElt_t *spTxFifoElt;
+	uint32_t u32_csMask;
 
 	/* make fifo flush atomic, by putting all code under critical section */
-	KNS_CS_enter();
+	u32_csMask = KNS_CS_enterSave();
 
 	/* \note "u8IdxClient + 1 <= USERDATA_RAT_MAX" condition is used instead of
 	 *       "u8IdxClient < USERDATA_RAT_MAX" to avoid comparison-is-always-false compilation
@@ -318,15 +623,20 @@ bool USERDATA_txFifoFlush(void)
 		if (sUserDataClientCb[u8IdxClient].USERDATA_txFifoFlushCb != NULL)
 			kns_assert(sUserDataClientCb[u8IdxClient].USERDATA_txFifoFlushCb());
 
-	spTxFifoElt = sUserDataTxFifo.spFirst;
-	sUserDataTxFifo.spFirst = NULL;
-
 	/* From top of the fifo, free each element */
-	for (; spTxFifoElt != NULL; spTxFifoElt = spTxFifoElt->spNext)
-		spTxFifoElt->bIsToBeTransmit = false;
+	while ((spTxFifoElt = sUserDataTxFifo.spFirst) != NULL) {
+		asUserDataTxClassStats[spTxFifoElt->u8TxClass].u32RemoveNb++;
+		USERDATA_txFifoUnlink(spTxFifoElt);
+		USERDATA_txFifoFreeSlot(spTxFifoElt);
+	}
 
 	/* Enable interrupts back only if they were enabled before we disabled it in this fct */
-	KNS_CS_exit();
+	KNS_CS_exitRestore(u32_csMask);
+
+#ifdef USE_USERDATA_JOURNAL
+	/* flash is written out of critical section */
+	USERDATA_journalFlush();
+#endif
 
 	USERDATA_txFifoLog();
 
@@ -340,38 +650,180 @@ struct sUserDataTxFifoElt_t *USERDATA_txFifoGetFirst()
 	return sUserDataTxFifo.spFirst;
 }
 
-struct sUserDataTxFifoElt_t *USERDATA_txFifoFindPayload(uint8_t *data, uint16_t bitlen)
+struct sUserDataTxFifoElt_t *USERDATA_txFifoGetEltByHandle(uint16_t u16Handle)
 {
-	struct sUserDataTxFifoElt_t *spTxFifoElt;
-	uint16_t dataIdx;
-	uint8_t mask;
+	struct sUserDataTxFifoElt_t *spElt;
 
-	/* - From top of the fifo, search the element to be removed */
-	for (spTxFifoElt = sUserDataTxFifo.spFirst;
-	     spTxFifoElt != NULL;
-	     spTxFifoElt = spTxFifoElt->spNext) {
-		if (spTxFifoElt->u16DataBitLen != bitlen)
+	if (u16Handle == USERDATA_TX_HANDLE_INVALID)
+		return NULL;
+
+	spElt = &sUserDataTxFifoBuf[u16Handle % USERDATA_TX_FIFO_SIZE];
+	if ((spElt->bIsToBeTransmit == false) || (spElt->u16Handle != u16Handle))
+		return NULL;
+
+	return spElt;
+}
+
+bool USERDATA_txFifoIsPayloadEqual(struct sUserDataTxFifoElt_t *spElt, uint8_t *pu8Data,
+	uint16_t u16Bitlen)
+{
+	uint16_t u16ByteNb = u16Bitlen / 8;
+	uint8_t u8Mask;
+
+	if (spElt->u16DataBitLen != u16Bitlen)
+		return false;
+	if (memcmp(spElt->pu8DataBuf, pu8Data, u16ByteNb) != 0)
+		return false;
+	/* check remaining bits of last byte if any */
+	if (u16Bitlen % 8) {
+		u8Mask = (uint8_t)(0xFF << (8 - (u16Bitlen % 8))); // 7: 0b11111110, 1: 0b10000000
+		if ((spElt->pu8DataBuf[u16ByteNb] & u8Mask) != (pu8Data[u16ByteNb] & u8Mask))
+			return false;
+	}
+	return true;
+}
+
+void USERDATA_txFifoSetPolicy(const struct sUserDataTxPolicy_t *spPolicy)
+{
+	struct sUserDataTxFifoElt_t *spElt;
+	struct sUserDataTxFifoElt_t *spNext;
+	uint32_t u32NowMs;
+	uint8_t u8Class;
+
+	spUserDataTxPolicy = (spPolicy != NULL) ? spPolicy : &sUserDataTxPolicyFifo;
+	u32NowMs = USERDATA_txFifoGetTimeMs();
+
+	/* Rebuild the chained list from its first element, so that order within a class is kept */
+	spElt = sUserDataTxFifo.spFirst;
+	sUserDataTxFifo.spFirst = NULL;
+	sUserDataTxFifo.spLast = NULL;
+	sUserDataTxFifo.u16Count = 0;
+	for (u8Class = 0; u8Class < USERDATA_TX_CLASS_MAX; u8Class++) {
+		sUserDataTxFifo.aspClassLast[u8Class] = NULL;
+		asUserDataTxClassStats[u8Class].u16Count = 0;
+	}
+	for (; spElt != NULL; spElt = spNext) {
+		spNext = spElt->spNext;
+		if (!spElt->bIsSubmitted) {
+			spElt->u8TxClass = USERDATA_txFifoGetClass(spElt->u8Attr);
+			spElt->u32ClassTimeMs = u32NowMs;
+		}
+		USERDATA_txFifoLink(spElt, true);
+	}
+
+	USERDATA_txFifoLog();
+}
+
+enum eUserDataTxClass USERDATA_txFifoGetClassByAttr(union sUserDataAttribute_t u8Attr)
+{
+	if (u8Attr.sf == ATTR_PACK_EMERGENCY)
+		return USERDATA_TX_CLASS_EMERGENCY;
+
+	switch (u8Attr.prio) {
+	case 1:
+		return USERDATA_TX_CLASS_HIGH;
+	break;
+	case 2:
+		return USERDATA_TX_CLASS_NORMAL;
+	break;
+	case 3:
+		return USERDATA_TX_CLASS_LOW;
+	break;
+	default:
+	break;
+	}
+
+	if ((u8Attr.sf == ATTR_PACK) || (u8Attr.sf == ATTR_MAIL_REQUEST))
+		return USERDATA_TX_CLASS_HIGH;
+
+	return USERDATA_TX_CLASS_NORMAL;
+}
+
+uint16_t USERDATA_txFifoAge(void)
+{
+	struct sUserDataTxFifoElt_t *spElt;
+	struct sUserDataTxFifoElt_t *spNext;
+	uint32_t u32NowMs;
+	int32_t i32AgeMs;
+	uint16_t u16PromoteNb = 0;
+
+	if ((spUserDataTxPolicy->USERDATA_txPolicyGetTimeMsCb == NULL) ||
+	    (spUserDataTxPolicy->u32AgingMs == 0))
+		return 0;
+
+	u32NowMs = USERDATA_txFifoGetTimeMs();
+
+	/* A promoted element moves before the next one, it is not visited twice */
+	for (spElt = sUserDataTxFifo.spFirst; spElt != NULL; spElt = spNext) {
+		spNext = spElt->spNext;
+		if (spElt->bIsSubmitted || (spElt->u8TxClass <= USERDATA_TX_CLASS_HIGH))
 			continue;
-		if (spTxFifoElt->bIsToBeTransmit == false)
+		i32AgeMs = (int32_t)(u32NowMs - spElt->u32ClassTimeMs);
+		if (i32AgeMs < 0) {
+			/* time base restarted since element was added (e.g. wake-up from STANDBY) */
+			spElt->u32ClassTimeMs = u32NowMs;
 			continue;
-		for (dataIdx = 0;
-			(dataIdx < (bitlen/8)) &&
-			(spTxFifoElt->u8DataBuf[dataIdx] == data[dataIdx]) ;
-			dataIdx++)
-			; // empty loop
-		if (dataIdx != (bitlen/8))
+		}
+		if ((uint32_t)i32AgeMs < spUserDataTxPolicy->u32AgingMs)
+			continue;
+
+		asUserDataTxClassStats[spElt->u8TxClass].u32PromoteNb++;
+		USERDATA_txFifoUnlink(spElt);
+		spElt->u8TxClass--;
+		spElt->u32ClassTimeMs = u32NowMs;
+		USERDATA_txFifoLink(spElt, true);
+		u16PromoteNb++;
+	}
+
+	if (u16PromoteNb != 0) {
+		MGR_LOG_VERBOSE("USERDATA: TX FIFO: %u elt promoted\r\n", u16PromoteNb);
+		USERDATA_txFifoLog();
+	}
+
+	return u16PromoteNb;
+}
+
+struct sUserDataTxFifoElt_t *USERDATA_txFifoGetDropCandidate(uint16_t u16DataByteLen,
+	union sUserDataAttribute_t u8Attr)
+{
+	struct sUserDataTxFifoElt_t *spElt;
+	struct sUserDataTxFifoElt_t *spCandidate = NULL;
+	uint8_t u8Class;
+
+	if (spUserDataTxPolicy->eDrop == USERDATA_TX_DROP_NONE)
+		return NULL;
+
+	u8Class = USERDATA_txFifoGetClass(u8Attr);
+
+	for (spElt = sUserDataTxFifo.spFirst; spElt != NULL; spElt = spElt->spNext) {
+		/* never drop upper class, submitted msg, nor a msg freeing a too small block */
+		if ((spElt->u8TxClass < u8Class) || spElt->bIsSubmitted ||
+		    (spElt->u16DataBufSize < u16DataByteLen))
+			continue;
+		if (spCandidate == NULL) {
+			spCandidate = spElt;
+			continue;
+		}
+		if ((spUserDataTxPolicy->eDrop == USERDATA_TX_DROP_LOWEST) &&
+		    (spElt->u8TxClass != spCandidate->u8TxClass)) {
+			if (spElt->u8TxClass > spCandidate->u8TxClass)
+				spCandidate = spElt;
 			continue;
-		/* check remaining bits of last byte if any */
-		if (bitlen % 8) {
-			mask = (1 << (bitlen % 8)) - 1;    // 7: 0b01111111, 1: 0b00000001
-			mask = mask << (8 - (bitlen % 8)); // 7: 0b11111110, 1: 0b10000000
-			if ((spTxFifoElt->u8DataBuf[bitlen % 8] & mask) !=
-			    (data[bitlen % 8] & mask))
-				continue;
 		}
-		return spTxFifoElt;
+		/* enqueue order wraps, fifo being much shorter than its range */
+		if ((int16_t)(spElt->u16EnqueueNb - spCandidate->u16EnqueueNb) < 0)
+			spCandidate = spElt;
 	}
-	return NULL;
+
+	return spCandidate;
+}
+
+void USERDATA_txFifoGetClassStats(enum eUserDataTxClass eClass,
+	struct sUserDataTxClassStats_t *spStats)
+{
+	kns_assert(eClass < USERDATA_TX_CLASS_MAX);
+
+	*spStats = asUserDataTxClassStats[eClass];
 }
 
 #endif /* USE_USERDATA_TX */
@@ -0,0 +1,821 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    user_data_journal.c
+ * @brief   Power-loss-safe flash journal of the USERDATA TX fifo
+ * @note    see \ref user_data_journal_page
+ */
+
+/**
+ * @addtogroup USER_DATA
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------------------------ */
+
+#ifdef USE_USERDATA_JOURNAL
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "mcu_flash.h"
+#include "mcu_tim_srv.h"
+#include "kns_os.h"
+#include "user_data.h"
+#include "user_data_journal.h"
+#include "kineis_sw_conf.h"  // for assert include below
+#include KINEIS_SW_ASSERT_H
+
+#include "mgr_log.h"
+
+/* Defines ------------------------------------------------------------------------------------- */
+
+/** Size of record header in bytes, multiple of MCU_FLASH_PROG_UNIT */
+#define USERDATA_JOURNAL_HDR_SIZE	16
+
+/** Size of a record in flash, data being padded to MCU_FLASH_PROG_UNIT */
+#define USERDATA_JOURNAL_REC_SIZE(u16ByteLen)	(USERDATA_JOURNAL_HDR_SIZE + \
+	((((u16ByteLen) + MCU_FLASH_PROG_UNIT - 1) / MCU_FLASH_PROG_UNIT) * MCU_FLASH_PROG_UNIT))
+
+/** Flash space taken by ENQ/MOVE records when all TX data blocks are used */
+#define USERDATA_JOURNAL_LIVE_MAX_SIZE	\
+	((USERDATA_TX_SLAB_SMALL_NB * USERDATA_JOURNAL_REC_SIZE(USERDATA_TX_SLAB_SMALL_SIZE)) + \
+	 (USERDATA_TX_SLAB_MEDIUM_NB * USERDATA_JOURNAL_REC_SIZE(USERDATA_TX_SLAB_MEDIUM_SIZE)) + \
+	 (USERDATA_TX_SLAB_LARGE_NB * USERDATA_JOURNAL_REC_SIZE(USERDATA_TX_SLAB_LARGE_SIZE)))
+
+#if (USERDATA_JOURNAL_PAGE_NB < 3)
+#error "USERDATA journal needs at least 3 pages: head, compaction spare and oldest"
+#endif
+
+#if (USERDATA_JOURNAL_REC_SIZE(USERDATA_TX_DATAFIELD_SIZE) > MCU_FLASH_PAGE_SIZE)
+#error "USERDATA journal record of maximum user data size does not fit a flash page"
+#endif
+
+/* compaction of the oldest page always ends once all pending messages fit the other pages */
+#if ((USERDATA_JOURNAL_LIVE_MAX_SIZE + USERDATA_JOURNAL_HDR_SIZE) > \
+     ((USERDATA_JOURNAL_PAGE_NB - 2) * MCU_FLASH_PAGE_SIZE))
+#error "USERDATA journal is too small for TX data slab allocator, increase its page number"
+#endif
+
+/* Enums --------------------------------------------------------------------------------------- */
+
+/**
+ * @brief type of journal record
+ */
+enum eUserDataJournalRecType {
+	USERDATA_JOURNAL_REC_ENQ   = 0x01, /**< message added, u32Ref is its identifier */
+	USERDATA_JOURNAL_REC_MOVE  = 0x02, /**< copy of pending message u32Ref */
+	USERDATA_JOURNAL_REC_DEQ   = 0x03, /**< message u32Ref removed */
+	USERDATA_JOURNAL_REC_FLUSH = 0x04, /**< all messages removed */
+	USERDATA_JOURNAL_REC_TRIM  = 0x05  /**< records before sequence u32Ref are obsolete */
+};
+
+/* Struct -------------------------------------------------------------------------------------- */
+
+/**
+ * @brief header of journal record, followed by data in flash
+ */
+struct sUserDataJournalRec_t {
+	uint32_t u32Seq;        /**< sequence number of the record, never 0 */
+	uint32_t u32Ref;        /**< message identifier, see eUserDataJournalRecType */
+	uint8_t u8Type;         /**< see eUserDataJournalRecType */
+	uint8_t u8Attr;         /**< user data attribute (ENQ, MOVE) */
+	uint16_t u16DataBitLen; /**< user data length in bits (ENQ, MOVE) */
+	uint32_t u32Crc;        /**< CRC32 of header (this field excluded) and data */
+};
+
+_Static_assert(sizeof(struct sUserDataJournalRec_t) == USERDATA_JOURNAL_HDR_SIZE,
+	"USERDATA journal record header size mismatch");
+
+/**
+ * @brief record waiting in RAM to be written in flash
+ */
+struct sUserDataJournalStaged_t {
+	struct sUserDataTxFifoElt_t *spElt; /**< element to write (ENQ) */
+	uint32_t u32Ref;                    /**< message identifier (DEQ) */
+	uint8_t u8Type;                     /**< see eUserDataJournalRecType */
+};
+
+/**
+ * @brief journal state
+ */
+struct sUserDataJournal_t {
+	uint32_t u32AreaAddr;   /**< start address of journal area in flash */
+	uint32_t u32NextSeq;    /**< sequence number of next record */
+	uint16_t u16HeadOffset; /**< offset of next record in head page */
+	uint8_t u8OldestPage;   /**< oldest used page */
+	uint8_t u8HeadPage;     /**< page where records are appended */
+	uint8_t u8SyncBatch;    /**< number of records written at once */
+	uint8_t u8StagedNb;     /**< number of staged records */
+	bool bIsReady;          /**< journal recovered, fifo operations are journaled */
+	bool bIsRoomReq;        /**< staged records wait for compaction to make room */
+	struct sUserDataJournalStaged_t asStaged[USERDATA_JOURNAL_SYNC_BATCH_MAX];
+	struct sUserDataJournalStats_t sStats;
+};
+
+/**
+ * @brief pending message found during recovery
+ */
+struct sUserDataJournalLive_t {
+	uint32_t u32Id;     /**< message identifier */
+	uint32_t u32RecAddr; /**< address of its latest ENQ/MOVE record */
+};
+
+/* Variables ----------------------------------------------------------------------------------- */
+
+/** Journal state is kept along with the fifo, in retention RAM */
+static
+__attribute__((__section__(".retentionRamBss")))
+struct sUserDataJournal_t sUserDataJournal;
+
+/** Sync latency timer, staged records are written at the latest on its expiry */
+static struct MCU_TIM_SRV_timer_t sUserDataJournalSyncTim;
+
+/** Sync requested by latency timer expiry */
+static volatile bool bUserDataJournalIsSyncReq;
+
+/** CRC32 (IEEE 802.3, reflected) lookup table, 4 bits at a time */
+static const uint32_t au32UserDataJournalCrcTbl[16] = {
+	0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158,
+	0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4,
+	0xA00AE278, 0xBDBDF21C
+};
+
+/* Local functions ----------------------------------------------------------------------------- */
+
+/**
+ * @brief Update CRC32 with some data
+ *
+ * @param[in] u32Crc current CRC, 0xFFFFFFFF at start, to be inverted at end
+ * @param[in] pu8Data data
+ * @param[in] u16Len data length in bytes
+ *
+ * @return updated CRC
+ */
+static uint32_t USERDATA_journalCrc(uint32_t u32Crc, const uint8_t *pu8Data, uint16_t u16Len)
+{
+	while (u16Len--) {
+		u32Crc ^= *pu8Data++;
+		u32Crc = (u32Crc >> 4) ^ au32UserDataJournalCrcTbl[u32Crc & 0x0F];
+		u32Crc = (u32Crc >> 4) ^ au32UserDataJournalCrcTbl[u32Crc & 0x0F];
+	}
+	return u32Crc;
+}
+
+static inline uint32_t USERDATA_journalPageAddr(uint8_t u8Page)
+{
+	return sUserDataJournal.u32AreaAddr + ((uint32_t)u8Page * MCU_FLASH_PAGE_SIZE);
+}
+
+static inline uint8_t USERDATA_journalNextPage(uint8_t u8Page)
+{
+	return (u8Page + 1) % USERDATA_JOURNAL_PAGE_NB;
+}
+
+/**
+ * @brief Number of erased pages, i.e. pages out of oldest..head range
+ */
+static inline uint8_t USERDATA_journalErasedPageNb(void)
+{
+	return USERDATA_JOURNAL_PAGE_NB - 1 -
+		((sUserDataJournal.u8HeadPage + USERDATA_JOURNAL_PAGE_NB -
+		  sUserDataJournal.u8OldestPage) % USERDATA_JOURNAL_PAGE_NB);
+}
+
+/**
+ * @brief Check a flash area is fully erased
+ *
+ * @param[in] u32Addr start address
+ * @param[in] u16Len length in bytes
+ *
+ * @return true if all bytes read 0xFF without ECC error
+ */
+static bool USERDATA_journalIsBlank(uint32_t u32Addr, uint16_t u16Len)
+{
+	uint8_t au8Chunk[32];
+	uint16_t u16ChunkLen;
+	uint16_t u16Idx;
+
+	while (u16Len > 0) {
+		u16ChunkLen = (u16Len < sizeof(au8Chunk)) ? u16Len : sizeof(au8Chunk);
+		if (!MCU_FLASH_read(u32Addr, au8Chunk, u16ChunkLen))
+			return false;
+		for (u16Idx = 0; u16Idx < u16ChunkLen; u16Idx++)
+			if (au8Chunk[u16Idx] != 0xFF)
+				return false;
+		u32Addr += u16ChunkLen;
+		u16Len -= u16ChunkLen;
+	}
+	return true;
+}
+
+/**
+ * @brief Read and check a record from flash
+ *
+ * @param[in] u32Addr address of the record
+ * @param[in] u16Room bytes left in the page from this address
+ * @param[out] spRec record header
+ * @param[out] pbIsBlank true when end of records is reached (erased flash or end of page)
+ *
+ * @return true if record is valid, false otherwise (end of records or corrupted record)
+ */
+static bool USERDATA_journalReadRec(uint32_t u32Addr, uint16_t u16Room,
+	struct sUserDataJournalRec_t *spRec, bool *pbIsBlank)
+{
+	uint8_t au8Chunk[32];
+	uint16_t u16ByteLen;
+	uint16_t u16ChunkLen;
+	uint32_t u32Crc;
+
+	*pbIsBlank = true;
+	if (u16Room < USERDATA_JOURNAL_HDR_SIZE)
+		return false;
+	if (USERDATA_journalIsBlank(u32Addr, USERDATA_JOURNAL_HDR_SIZE))
+		return false;
+
+	*pbIsBlank = false;
+	if (!MCU_FLASH_read(u32Addr, spRec, USERDATA_JOURNAL_HDR_SIZE))
+		return false;
+	if ((spRec->u8Type < USERDATA_JOURNAL_REC_ENQ) ||
+	    (spRec->u8Type > USERDATA_JOURNAL_REC_TRIM) ||
+	    (spRec->u16DataBitLen > (USERDATA_TX_DATAFIELD_SIZE * 8)))
+		return false;
+	u16ByteLen = (spRec->u16DataBitLen + 7) / 8;
+	if (USERDATA_JOURNAL_REC_SIZE(u16ByteLen) > u16Room)
+		return false;
+
+	u32Crc = USERDATA_journalCrc(0xFFFFFFFF, (const uint8_t *)spRec,
+		offsetof(struct sUserDataJournalRec_t, u32Crc));
+	u32Addr += USERDATA_JOURNAL_HDR_SIZE;
+	while (u16ByteLen > 0) {
+		u16ChunkLen = (u16ByteLen < sizeof(au8Chunk)) ? u16ByteLen : sizeof(au8Chunk);
+		if (!MCU_FLASH_read(u32Addr, au8Chunk, u16ChunkLen))
+			return false;
+		u32Crc = USERDATA_journalCrc(u32Crc, au8Chunk, u16ChunkLen);
+		u32Addr += u16ChunkLen;
+		u16ByteLen -= u16ChunkLen;
+	}
+
+	return (spRec->u32Crc == ~u32Crc);
+}
+
+/**
+ * @brief Find fifo element of a journaled message
+ *
+ * @param[in] u32Id message identifier
+ *
+ * @return pointer to the element, NULL if message is not in fifo anymore
+ */
+static struct sUserDataTxFifoElt_t *USERDATA_journalFindElt(uint32_t u32Id)
+{
+	struct sUserDataTxFifoElt_t *spElt;
+
+	for (spElt = USERDATA_txFifoGetFirst(); spElt != NULL; spElt = spElt->spNext)
+		if (spElt->u32JournalId == u32Id)
+			return spElt;
+	return NULL;
+}
+
+/**
+ * @brief Make room for a record in head page, moving to next erased page if needed
+ *
+ * Appending records keeps one erased page spare, for the MOVE records written by compaction.
+ * No page is erased here: fifo operations may occur while radio is on, compaction is left to
+ * \ref USERDATA_journalProcess.
+ *
+ * @param[in] u16RecSize size of the record in bytes
+ * @param[in] bIsCompaction true when record is written by compaction
+ *
+ * @return true if record can be written at head, false if journal is full
+ */
+static bool USERDATA_journalMakeRoom(uint16_t u16RecSize, bool bIsCompaction)
+{
+	if ((sUserDataJournal.u16HeadOffset + u16RecSize) <= MCU_FLASH_PAGE_SIZE)
+		return true;
+
+	if (USERDATA_journalErasedPageNb() < (bIsCompaction ? 1 : 2))
+		return false;
+
+	sUserDataJournal.u8HeadPage = USERDATA_journalNextPage(sUserDataJournal.u8HeadPage);
+	sUserDataJournal.u16HeadOffset = 0;
+
+	return true;
+}
+
+/**
+ * @brief Program data into flash, last programming unit being padded
+ *
+ * @param[in] u32Addr destination address, aligned on MCU_FLASH_PROG_UNIT
+ * @param[in] pu8Data data
+ * @param[in] u16Len data length in bytes
+ *
+ * @return true if success, false otherwise
+ */
+static bool USERDATA_journalProgramData(uint32_t u32Addr, const uint8_t *pu8Data,
+	uint16_t u16Len)
+{
+	uint8_t au8Unit[MCU_FLASH_PROG_UNIT];
+	uint16_t u16BodyLen = u16Len - (u16Len % MCU_FLASH_PROG_UNIT);
+
+	if ((u16BodyLen > 0) && !MCU_FLASH_program(u32Addr, pu8Data, u16BodyLen))
+		return false;
+	if (u16BodyLen == u16Len)
+		return true;
+
+	memset(au8Unit, 0xFF, sizeof(au8Unit));
+	memcpy(au8Unit, &pu8Data[u16BodyLen], u16Len - u16BodyLen);
+	return MCU_FLASH_program(u32Addr + u16BodyLen, au8Unit, sizeof(au8Unit));
+}
+
+/**
+ * @brief Append a record to the journal
+ *
+ * @param[in] u8Type record type, see eUserDataJournalRecType
+ * @param[in] u32Ref message identifier (MOVE, DEQ)
+ * @param[in] spElt element holding message data (ENQ, MOVE), its identifier is set on ENQ
+ * @param[in] bIsCompaction true when record is written by compaction
+ *
+ * @return true if success, false otherwise
+ */
+static bool USERDATA_journalAppend(uint8_t u8Type, uint32_t u32Ref,
+	struct sUserDataTxFifoElt_t *spElt, bool bIsCompaction)
+{
+	struct sUserDataJournalRec_t sRec;
+	uint16_t u16ByteLen = 0;
+	uint16_t u16RecSize;
+	uint32_t u32Addr;
+	bool bIsOk;
+
+	if (spElt != NULL)
+		u16ByteLen = (spElt->u16DataBitLen + 7) / 8;
+	u16RecSize = USERDATA_JOURNAL_REC_SIZE(u16ByteLen);
+
+	/* compaction may append records first, take sequence number afterwards */
+	if (!USERDATA_journalMakeRoom(u16RecSize, bIsCompaction))
+		return false;
+
+	sRec.u32Seq = sUserDataJournal.u32NextSeq;
+	sRec.u32Ref = (u8Type == USERDATA_JOURNAL_REC_ENQ) ? sRec.u32Seq : u32Ref;
+	sRec.u8Type = u8Type;
+	sRec.u8Attr = (spElt != NULL) ? spElt->u8Attr.u8_raw : 0;
+	sRec.u16DataBitLen = (spElt != NULL) ? spElt->u16DataBitLen : 0;
+	sRec.u32Crc = USERDATA_journalCrc(0xFFFFFFFF, (const uint8_t *)&sRec,
+		offsetof(struct sUserDataJournalRec_t, u32Crc));
+	if (u16ByteLen > 0)
+		sRec.u32Crc = USERDATA_journalCrc(sRec.u32Crc, spElt->pu8DataBuf, u16ByteLen);
+	sRec.u32Crc = ~sRec.u32Crc;
+
+	u32Addr = USERDATA_journalPageAddr(sUserDataJournal.u8HeadPage) +
+		sUserDataJournal.u16HeadOffset;
+	sUserDataJournal.u16HeadOffset += u16RecSize;
+	sUserDataJournal.u32NextSeq++;
+
+	bIsOk = MCU_FLASH_program(u32Addr, &sRec, USERDATA_JOURNAL_HDR_SIZE);
+	if (bIsOk && (u16ByteLen > 0))
+		bIsOk = USERDATA_journalProgramData(u32Addr + USERDATA_JOURNAL_HDR_SIZE,
+			spElt->pu8DataBuf, u16ByteLen);
+	if (!bIsOk) {
+		/* length of a broken record cannot be trusted at recovery, close the page */
+		sUserDataJournal.u16HeadOffset = MCU_FLASH_PAGE_SIZE;
+		return false;
+	}
+
+	sUserDataJournal.sStats.u32RecordNb++;
+	if (u8Type == USERDATA_JOURNAL_REC_ENQ)
+		spElt->u32JournalId = sRec.u32Seq;
+
+	return true;
+}
+
+/**
+ * @brief Copy pending messages of the oldest page to the head page, then erase it
+ *
+ * A TRIM record is appended before erase, so that recovery ignores records of the page if erase
+ * is interrupted.
+ *
+ * @return true if oldest page was erased, false otherwise
+ */
+static bool USERDATA_journalCompactOldest(void)
+{
+	struct sUserDataJournalRec_t sRec;
+	struct sUserDataTxFifoElt_t *spElt;
+	uint32_t u32PageAddr;
+	uint32_t u32LastSeq = 0;
+	uint16_t u16Offset = 0;
+	bool bIsBlank;
+
+	if (sUserDataJournal.u8OldestPage == sUserDataJournal.u8HeadPage)
+		return false;
+
+	u32PageAddr = USERDATA_journalPageAddr(sUserDataJournal.u8OldestPage);
+	while (USERDATA_journalReadRec(u32PageAddr + u16Offset, MCU_FLASH_PAGE_SIZE - u16Offset,
+				       &sRec, &bIsBlank)) {
+		u16Offset += USERDATA_JOURNAL_REC_SIZE((sRec.u16DataBitLen + 7) / 8);
+		u32LastSeq = sRec.u32Seq;
+		if ((sRec.u8Type != USERDATA_JOURNAL_REC_ENQ) &&
+		    (sRec.u8Type != USERDATA_JOURNAL_REC_MOVE))
+			continue;
+		spElt = USERDATA_journalFindElt(sRec.u32Ref);
+		if (spElt == NULL)
+			continue;
+		if (!USERDATA_journalAppend(USERDATA_JOURNAL_REC_MOVE, sRec.u32Ref, spElt, true))
+			return false;
+	}
+
+	/* an interrupted erase may leave some records readable, they must not be replayed */
+	if ((u32LastSeq != 0) &&
+	    !USERDATA_journalAppend(USERDATA_JOURNAL_REC_TRIM, u32LastSeq + 1, NULL, true))
+		return false;
+
+	if (!MCU_FLASH_erasePage(u32PageAddr))
+		return false;
+	sUserDataJournal.sStats.u32EraseNb++;
+	sUserDataJournal.u8OldestPage = USERDATA_journalNextPage(sUserDataJournal.u8OldestPage);
+	MGR_LOG_VERBOSE("USERDATA: journal: page compacted, %d erased\r\n",
+		USERDATA_journalErasedPageNb());
+
+	return true;
+}
+
+/**
+ * @brief Sync latency timer expiry, from ISR: request APP task to write staged records
+ *
+ * @param[in] ctx unused
+ */
+static void USERDATA_journalSyncTimCb(void *ctx __attribute__((unused)))
+{
+	bUserDataJournalIsSyncReq = true;
+	KNS_OS_setTaskReady(KNS_OS_TASK_APP);
+}
+
+/**
+ * @brief Stage a record, then write staged records when batch is complete
+ *
+ * Sync latency timer is started along with the first staged record, so that no record stays in
+ * RAM longer than USERDATA_JOURNAL_SYNC_LATENCY_MS.
+ *
+ * @param[in] u8Type record type, see eUserDataJournalRecType
+ * @param[in] u32Ref message identifier (DEQ)
+ * @param[in] spElt element (ENQ)
+ */
+static void USERDATA_journalStage(uint8_t u8Type, uint32_t u32Ref,
+	struct sUserDataTxFifoElt_t *spElt)
+{
+	struct sUserDataJournalStaged_t *spStaged;
+
+	if (sUserDataJournal.u8StagedNb >= USERDATA_JOURNAL_SYNC_BATCH_MAX) {
+		/* journal full until next compaction, this fifo operation is lost on power loss */
+		sUserDataJournal.sStats.u16Dropped++;
+		MGR_LOG_DEBUG("USERDATA: journal: no room, record dropped\r\n");
+		return;
+	}
+	spStaged = &sUserDataJournal.asStaged[sUserDataJournal.u8StagedNb++];
+	spStaged->u8Type = u8Type;
+	spStaged->u32Ref = u32Ref;
+	spStaged->spElt = spElt;
+
+	if (sUserDataJournal.u8StagedNb >= sUserDataJournal.u8SyncBatch) {
+		if (!sUserDataJournal.bIsRoomReq)
+			USERDATA_journalSync();
+	} else if (!MCU_TIM_SRV_isRunning(&sUserDataJournalSyncTim)) {
+		MCU_TIM_SRV_create(&sUserDataJournalSyncTim, USERDATA_journalSyncTimCb, NULL);
+		MCU_TIM_SRV_start(&sUserDataJournalSyncTim, USERDATA_JOURNAL_SYNC_LATENCY_MS, 0);
+	}
+}
+
+/**
+ * @brief Insert a message found during recovery, or update its latest record
+ *
+ * @param[in,out] asLive pending messages
+ * @param[in,out] pu16LiveNb number of pending messages
+ * @param[in] u32Id message identifier
+ * @param[in] u32RecAddr address of ENQ/MOVE record
+ */
+static void USERDATA_journalLiveSet(struct sUserDataJournalLive_t *asLive, uint16_t *pu16LiveNb,
+	uint32_t u32Id, uint32_t u32RecAddr)
+{
+	uint16_t u16Idx;
+
+	for (u16Idx = 0; u16Idx < *pu16LiveNb; u16Idx++) {
+		if (asLive[u16Idx].u32Id == u32Id) {
+			asLive[u16Idx].u32RecAddr = u32RecAddr;
+			return;
+		}
+	}
+	if (*pu16LiveNb >= USERDATA_TX_FIFO_SIZE) {
+		sUserDataJournal.sStats.u16Corrupted++;
+		return;
+	}
+	asLive[*pu16LiveNb].u32Id = u32Id;
+	asLive[*pu16LiveNb].u32RecAddr = u32RecAddr;
+	(*pu16LiveNb)++;
+}
+
+/**
+ * @brief Remove a message found during recovery
+ *
+ * @param[in,out] asLive pending messages
+ * @param[in,out] pu16LiveNb number of pending messages
+ * @param[in] u32Id message identifier
+ */
+static void USERDATA_journalLiveClear(struct sUserDataJournalLive_t *asLive,
+	uint16_t *pu16LiveNb, uint32_t u32Id)
+{
+	uint16_t u16Idx;
+
+	for (u16Idx = 0; u16Idx < *pu16LiveNb; u16Idx++) {
+		if (asLive[u16Idx].u32Id == u32Id) {
+			/* order does not matter yet, messages are sorted once all replayed */
+			asLive[u16Idx] = asLive[--(*pu16LiveNb)];
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Add a recovered message back in fifo
+ *
+ * @param[in] u32RecAddr address of its latest ENQ/MOVE record
+ * @param[in] u32Id message identifier
+ *
+ * @return true if success, false otherwise
+ */
+static bool USERDATA_journalRestore(uint32_t u32RecAddr, uint32_t u32Id)
+{
+	struct sUserDataJournalRec_t sRec;
+	struct sUserDataTxFifoElt_t *spElt;
+	uint16_t u16ByteLen;
+	bool bIsBlank;
+
+	if (!USERDATA_journalReadRec(u32RecAddr, MCU_FLASH_PAGE_SIZE -
+				     ((u32RecAddr - sUserDataJournal.u32AreaAddr) %
+				      MCU_FLASH_PAGE_SIZE), &sRec, &bIsBlank))
+		return false;
+
+	u16ByteLen = (sRec.u16DataBitLen + 7) / 8;
+	spElt = USERDATA_txFifoReserveElt(u16ByteLen);
+	if (spElt == NULL)
+		return false;
+	if ((u16ByteLen > 0) &&
+	    !MCU_FLASH_read(u32RecAddr + USERDATA_JOURNAL_HDR_SIZE, spElt->pu8DataBuf,
+			    u16ByteLen)) {
+		USERDATA_txFifoRemoveElt(spElt);
+		return false;
+	}
+	spElt->u8Attr.u8_raw = sRec.u8Attr;
+	spElt->u16DataBitLen = sRec.u16DataBitLen;
+	spElt->u32JournalId = u32Id;
+
+	return USERDATA_txFifoAddElt(spElt, true);
+}
+
+/* Public functions ---------------------------------------------------------------------------- */
+
+uint16_t USERDATA_journalRecover(void)
+{
+	static struct sUserDataJournalLive_t asLive[USERDATA_TX_FIFO_SIZE];
+	uint32_t au32FirstSeq[USERDATA_JOURNAL_PAGE_NB];
+	struct sUserDataJournalRec_t sRec;
+	struct sUserDataJournalLive_t sLive;
+	uint32_t u32AreaSize;
+	uint32_t u32PageAddr;
+	uint32_t u32MaxSeq = 0;
+	uint32_t u32TrimSeq = 0;
+	uint16_t u16LiveNb = 0;
+	uint16_t u16Offset;
+	uint16_t u16Idx;
+	uint16_t u16SortIdx;
+	uint8_t u8Page;
+	bool bIsBlank;
+	bool bIsUsed;
+
+	memset(&sUserDataJournal, 0, sizeof(sUserDataJournal));
+	sUserDataJournal.u8SyncBatch = USERDATA_JOURNAL_SYNC_BATCH;
+	MCU_FLASH_getJournalArea(&sUserDataJournal.u32AreaAddr, &u32AreaSize);
+	kns_assert(u32AreaSize >= (USERDATA_JOURNAL_PAGE_NB * MCU_FLASH_PAGE_SIZE));
+
+	/* Find used pages from their first record, erase pages left partially erased or broken */
+	for (u8Page = 0; u8Page < USERDATA_JOURNAL_PAGE_NB; u8Page++) {
+		u32PageAddr = USERDATA_journalPageAddr(u8Page);
+		au32FirstSeq[u8Page] = 0;
+		if (USERDATA_journalReadRec(u32PageAddr, MCU_FLASH_PAGE_SIZE, &sRec, &bIsBlank)) {
+			au32FirstSeq[u8Page] = sRec.u32Seq;
+		} else if (!bIsBlank ||
+			   !USERDATA_journalIsBlank(u32PageAddr, MCU_FLASH_PAGE_SIZE)) {
+			MCU_FLASH_erasePage(u32PageAddr);
+			sUserDataJournal.sStats.u32EraseNb++;
+		}
+	}
+
+	/* Find records made obsolete by compaction, their page erase may have been interrupted */
+	for (u8Page = 0; u8Page < USERDATA_JOURNAL_PAGE_NB; u8Page++) {
+		if (au32FirstSeq[u8Page] == 0)
+			continue;
+		u32PageAddr = USERDATA_journalPageAddr(u8Page);
+		u16Offset = 0;
+		while (USERDATA_journalReadRec(u32PageAddr + u16Offset,
+					       MCU_FLASH_PAGE_SIZE - u16Offset, &sRec, &bIsBlank)) {
+			if ((sRec.u8Type == USERDATA_JOURNAL_REC_TRIM) &&
+			    (sRec.u32Ref > u32TrimSeq))
+				u32TrimSeq = sRec.u32Ref;
+			u16Offset += USERDATA_JOURNAL_REC_SIZE((sRec.u16DataBitLen + 7) / 8);
+		}
+	}
+
+	/* Oldest and head pages have lowest and highest first sequence numbers */
+	for (u8Page = 0; u8Page < USERDATA_JOURNAL_PAGE_NB; u8Page++) {
+		if ((au32FirstSeq[u8Page] != 0) && (au32FirstSeq[u8Page] < u32TrimSeq)) {
+			MCU_FLASH_erasePage(USERDATA_journalPageAddr(u8Page));
+			sUserDataJournal.sStats.u32EraseNb++;
+			au32FirstSeq[u8Page] = 0;
+		}
+		if (au32FirstSeq[u8Page] == 0)
+			continue;
+		if ((au32FirstSeq[sUserDataJournal.u8OldestPage] == 0) ||
+		    (au32FirstSeq[u8Page] < au32FirstSeq[sUserDataJournal.u8OldestPage]))
+			sUserDataJournal.u8OldestPage = u8Page;
+		if (au32FirstSeq[u8Page] > au32FirstSeq[sUserDataJournal.u8HeadPage])
+			sUserDataJournal.u8HeadPage = u8Page;
+	}
+
+	/* Pages out of oldest..head range are not part of the journal anymore */
+	for (u8Page = 0; u8Page < USERDATA_JOURNAL_PAGE_NB; u8Page++) {
+		bIsUsed = ((u8Page + USERDATA_JOURNAL_PAGE_NB - sUserDataJournal.u8OldestPage) %
+			   USERDATA_JOURNAL_PAGE_NB) <= ((sUserDataJournal.u8HeadPage +
+			   USERDATA_JOURNAL_PAGE_NB - sUserDataJournal.u8OldestPage) %
+			   USERDATA_JOURNAL_PAGE_NB);
+		if (!bIsUsed && (au32FirstSeq[u8Page] != 0)) {
+			MCU_FLASH_erasePage(USERDATA_journalPageAddr(u8Page));
+			sUserDataJournal.sStats.u32EraseNb++;
+		}
+	}
+
+	/* Replay records of used pages, from oldest to head */
+	u8Page = sUserDataJournal.u8OldestPage;
+	do {
+		u32PageAddr = USERDATA_journalPageAddr(u8Page);
+		u16Offset = 0;
+		while (USERDATA_journalReadRec(u32PageAddr + u16Offset,
+					       MCU_FLASH_PAGE_SIZE - u16Offset, &sRec, &bIsBlank)) {
+			switch (sRec.u8Type) {
+			case USERDATA_JOURNAL_REC_ENQ:
+			case USERDATA_JOURNAL_REC_MOVE:
+				USERDATA_journalLiveSet(asLive, &u16LiveNb, sRec.u32Ref,
+					u32PageAddr + u16Offset);
+				break;
+			case USERDATA_JOURNAL_REC_DEQ:
+				USERDATA_journalLiveClear(asLive, &u16LiveNb, sRec.u32Ref);
+				break;
+			case USERDATA_JOURNAL_REC_FLUSH:
+				u16LiveNb = 0;
+				break;
+			case USERDATA_JOURNAL_REC_TRIM:
+			default:
+				break;
+			}
+			if (sRec.u32Seq > u32MaxSeq)
+				u32MaxSeq = sRec.u32Seq;
+			u16Offset += USERDATA_JOURNAL_REC_SIZE((sRec.u16DataBitLen + 7) / 8);
+		}
+		if (!bIsBlank) {
+			/* record interrupted by power loss, nothing can be appended after it */
+			sUserDataJournal.sStats.u16Corrupted++;
+			u16Offset = MCU_FLASH_PAGE_SIZE;
+		}
+		sUserDataJournal.u16HeadOffset = u16Offset;
+		if (u8Page == sUserDataJournal.u8HeadPage)
+			break;
+		u8Page = USERDATA_journalNextPage(u8Page);
+	} while (u8Page != sUserDataJournal.u8OldestPage);
+	sUserDataJournal.u32NextSeq = u32MaxSeq + 1;
+
+	/* Add pending messages back in fifo, in their original order */
+	for (u16Idx = 1; u16Idx < u16LiveNb; u16Idx++) {
+		sLive = asLive[u16Idx];
+		for (u16SortIdx = u16Idx;
+		     (u16SortIdx > 0) && (asLive[u16SortIdx - 1].u32Id > sLive.u32Id); u16SortIdx--)
+			asLive[u16SortIdx] = asLive[u16SortIdx - 1];
+		asLive[u16SortIdx] = sLive;
+	}
+	for (u16Idx = 0; u16Idx < u16LiveNb; u16Idx++) {
+		if (USERDATA_journalRestore(asLive[u16Idx].u32RecAddr, asLive[u16Idx].u32Id))
+			sUserDataJournal.sStats.u16Recovered++;
+		else
+			sUserDataJournal.sStats.u16Corrupted++;
+	}
+
+	sUserDataJournal.bIsReady = true;
+	MGR_LOG_DEBUG("USERDATA: journal: %d messages recovered, %d corrupted records\r\n",
+		sUserDataJournal.sStats.u16Recovered, sUserDataJournal.sStats.u16Corrupted);
+
+	return sUserDataJournal.sStats.u16Recovered;
+}
+
+void USERDATA_journalEnqueue(struct sUserDataTxFifoElt_t *spElt)
+{
+	if (!sUserDataJournal.bIsReady)
+		return;
+
+	USERDATA_journalStage(USERDATA_JOURNAL_REC_ENQ, 0, spElt);
+}
+
+void USERDATA_journalDequeue(struct sUserDataTxFifoElt_t *spElt)
+{
+	uint8_t u8Idx;
+
+	if (!sUserDataJournal.bIsReady)
+		return;
+
+	/* message not synced yet: drop its ENQ record, nothing to write at all */
+	for (u8Idx = 0; u8Idx < sUserDataJournal.u8StagedNb; u8Idx++) {
+		if ((sUserDataJournal.asStaged[u8Idx].u8Type == USERDATA_JOURNAL_REC_ENQ) &&
+		    (sUserDataJournal.asStaged[u8Idx].spElt == spElt)) {
+			sUserDataJournal.u8StagedNb--;
+			memmove(&sUserDataJournal.asStaged[u8Idx],
+				&sUserDataJournal.asStaged[u8Idx + 1],
+				(sUserDataJournal.u8StagedNb - u8Idx) *
+				sizeof(sUserDataJournal.asStaged[0]));
+			return;
+		}
+	}
+	if (spElt->u32JournalId == 0)
+		return;
+
+	USERDATA_journalStage(USERDATA_JOURNAL_REC_DEQ, spElt->u32JournalId, NULL);
+}
+
+void USERDATA_journalFlush(void)
+{
+	if (!sUserDataJournal.bIsReady)
+		return;
+
+	/* staged records are obsolete */
+	sUserDataJournal.u8StagedNb = 0;
+	USERDATA_journalStage(USERDATA_JOURNAL_REC_FLUSH, 0, NULL);
+}
+
+void USERDATA_journalSync(void)
+{
+	struct sUserDataJournalStaged_t *spStaged;
+	uint8_t u8Idx;
+
+	MCU_TIM_SRV_stop(&sUserDataJournalSyncTim);
+	bUserDataJournalIsSyncReq = false;
+	sUserDataJournal.bIsRoomReq = false;
+
+	for (u8Idx = 0; u8Idx < sUserDataJournal.u8StagedNb; u8Idx++) {
+		spStaged = &sUserDataJournal.asStaged[u8Idx];
+		if (!USERDATA_journalAppend(spStaged->u8Type, spStaged->u32Ref, spStaged->spElt,
+					    false)) {
+			/* keep failed and next records staged, retried after next compaction */
+			MGR_LOG_DEBUG("USERDATA: journal: failed to write record\r\n");
+			sUserDataJournal.bIsRoomReq = true;
+			break;
+		}
+	}
+	sUserDataJournal.u8StagedNb -= u8Idx;
+	memmove(&sUserDataJournal.asStaged[0], &sUserDataJournal.asStaged[u8Idx],
+		sUserDataJournal.u8StagedNb * sizeof(sUserDataJournal.asStaged[0]));
+}
+
+bool USERDATA_journalSetSyncBatch(uint8_t u8BatchNb)
+{
+	if ((u8BatchNb < 1) || (u8BatchNb > USERDATA_JOURNAL_SYNC_BATCH_MAX))
+		return false;
+
+	sUserDataJournal.u8SyncBatch = u8BatchNb;
+	if (sUserDataJournal.u8StagedNb >= u8BatchNb)
+		USERDATA_journalSync();
+
+	return true;
+}
+
+void USERDATA_journalSyncProcess(void)
+{
+	if (bUserDataJournalIsSyncReq)
+		USERDATA_journalSync();
+}
+
+void USERDATA_journalProcess(void)
+{
+	if (!sUserDataJournal.bIsReady)
+		return;
+
+	if (USERDATA_journalErasedPageNb() <= 1)
+		USERDATA_journalCompactOldest();
+
+	/* records left staged by a sync which ran out of room */
+	if (sUserDataJournal.bIsRoomReq)
+		USERDATA_journalSync();
+}
+
+void USERDATA_journalGetStats(struct sUserDataJournalStats_t *spStats)
+{
+	*spStats = sUserDataJournal.sStats;
+	spStats->u8ErasedPageNb = USERDATA_journalErasedPageNb();
+}
+
+#endif // end of USE_USERDATA_JOURNAL
+
+/**
+ * @}
+ */
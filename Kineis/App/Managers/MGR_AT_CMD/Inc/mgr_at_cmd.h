@@ -71,13 +71,23 @@ bool MGR_AT_CMD_isPendingAt(void);
 /**
  * @brief API used to get next AT command stored in internal fifo
  *
- * @retval Pointer to the AT cmd to be decoded
+ * Characters received on AT console since last call are parsed first (cf
+ * \ref MCU_AT_CONSOLE_rxPoll), so that it is to be called from APP task context.
+ *
+ * The AT command remains in fifo, and its characters in AT console RX buffer, until it is decoded
+ * by \ref MGR_AT_CMD_decodeAt. Thus, calling this API again before decoding returns the same AT
+ * command.
+ *
+ * @retval Pointer to the AT cmd to be decoded, NULL if fifo is empty
  */
 uint8_t *MGR_AT_CMD_popNextAt(void);
 
 /**
  * @brief Decode and exectue AT cmd if valid
  *
+ * Once executed, the AT cmd got from \ref MGR_AT_CMD_popNextAt is removed from fifo and its
+ * characters are released to the AT console.
+ *
  * @param[in] pu8_atcmd pointer to AT command
  *
  * @retval true if command was decoded and correctly executed, false otherwise
@@ -94,6 +104,13 @@ bool MGR_AT_CMD_decodeAt(uint8_t *pu8_atcmd);
  */
 enum KNS_status_t MGR_AT_CMD_macEvtProcess(void);
 
+/**
+ * @brief Send TX messages waiting for aggregation once their latency timer expired
+ *
+ * Latency timer runs from ISR and sets APP task ready, this fct is to be called from APP task loop.
+ */
+void MGR_AT_CMD_txAggProcess(void);
+
 #endif /* __MGR_AT_CMD_H */
 
 /**
@@ -41,7 +41,9 @@ enum atcmd_rsp_type_t {
 	ATCMD_RSP_SATDET,	    /**< At command delayed response for SAT detection */
 	ATCMD_RSP_RXOK,		    /**< At command delayed response for RX frame reception */
 	ATCMD_RSP_DLOK,		    /**< At command delayed response for RX frame reception */
-	ATCMD_RSP_RXTIMEOUT	    /**< At command delayed response for RX timeout */
+	ATCMD_RSP_RXTIMEOUT,	    /**< At command delayed response for RX timeout */
+	ATCMD_RSP_TXDROP,	    /**< At command delayed response for msg dropped on fifo overflow */
+	ATCMD_RSP_TXACCEPTED	    /**< At command response for TX msg accepted, with its handle */
 };
 
 
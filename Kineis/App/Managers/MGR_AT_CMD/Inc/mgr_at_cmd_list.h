@@ -33,9 +33,11 @@ enum  atcmd_idx_t {
 	AT_RCONF,        /**< Get/Set radio configuration command */
 	AT_SAVE_RCONF,   /**< Save radio configuration into Flash command */
 	AT_LPM,          /**< Get/Set low power mode command */
+	AT_PERF,         /**< Get/Reset runtime profiling statistics command */
 
 	// User data commands
 	AT_TX,           /**< Index for TX commands */
+	AT_TXQ,          /**< Index for TX fifo counters command */
 #ifdef USE_RX_STACK
 	AT_RX,           /**< Index for TX commands */
 #endif
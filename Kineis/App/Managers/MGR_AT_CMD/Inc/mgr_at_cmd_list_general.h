@@ -160,6 +160,27 @@ bool bMGR_AT_CMD_SAVE_RCONF_cmd(uint8_t *pu8_cmdParamString, enum atcmd_type_t e
  */
 bool bMGR_AT_CMD_LPM_cmd(uint8_t *pu8_cmdParamString, enum atcmd_type_t e_exec_mode);
 
+/** @brief Process AT command "AT+PERF" to get or reset runtime profiling statistics
+ *
+ * Only available when FW is built with KNS_OS_PERF flag (cf @ref kns_os_perf_page), returns an
+ * error otherwise.
+ *
+ * "AT+PERF=?" returns the cycle counter frequency, one line per task and per queue, then the
+ * longest interval spent with interrupts masked by critical sections:
+ * * "+PERF=CLK,<cycle counter frequency in Hz>"
+ * * "+PERF=TASK,<task handler>,<nb runs>,<cumulative kcycles>,<max cycles>"
+ * * "+PERF=Q,<queue handle>,<nb push>,<nb pop>,<high-water mark>,<nb push rejected on QFULL>"
+ * * "+PERF=CS,<max masked cycles>,<code address which entered this critical section, hex>"
+ *
+ * "AT+PERF=RESET" clears all statistics.
+ *
+ * @param[in] pu8_cmdParamString: string containing AT command
+ * @param[in] e_exec_mode: type of the command (status command or action command)
+ *
+ * @return true if command is correctly received and processed, false if error
+ */
+bool bMGR_AT_CMD_PERF_cmd(uint8_t *pu8_cmdParamString, enum atcmd_type_t e_exec_mode);
+
 #endif /* __MGR_AT_CMD_LIST_GENERAL_H */
 /**
  * @}
@@ -55,7 +55,25 @@ uint16_t u16MGR_AT_CMD_convertAsciiBinary(uint8_t *pu8InputBuffer, uint16_t u16_
  * "Attr": attribute of the data to be transmitted. So far, attribute is defined as 8-bits-bitmap:
  * * bit0-2: service (000 no, 001 mail request, 010 ACK, ... reserved)
  * * bit3  : add back/front (0 back, 1 front)
- * * bit4-7: reserved
+ * * bit4-5: priority (00 from service, 01 high, 10 normal, 11 low)
+ * * bit6  : aggregation (0 sent alone, 1 may be packed with other small messages in one frame)
+ * * bit7  : reserved
+ *
+ * AT+TX is acknowledged with "+OK=<Handle>", where "Handle" is the USERDATA message handle
+ * (decimal), unique among messages waiting in the TX fifo. Once transmitted,
+ * "+TX=<Status>,<HexData>,<Handle>" is reported with the same handle. It allows to tell apart
+ * messages with identical data.
+ *
+ * Messages with the aggregation bit are answered "+OK=<Handle>" at once, then packed as records of a
+ * container, sent as one frame. Container is nibble-aligned, MSB first: a 4-bit version (1), then
+ * for each record its length in nibbles (8 bits) followed by its data. Up to 46 nibbles per record
+ * (LDA2), 255 (HDA4), without service. The container is sent once no more record fits in it, or at
+ * the latest MGR_AT_CMD_AGG_LATENCY_MS after its oldest record was queued. "+TX=..." is reported
+ * for each record.
+ *
+ * When TX fifo is full, the TX scheduling policy may drop an older message of same or lower
+ * priority in favour of the new one (cf @ref user_data_design_point_sched). The dropped message is
+ * reported as "+TX=21,<HexData>,<Handle>" (ERROR_DATA_QUEUE_FULL).
  *
  * @attention For VLDA4 on Kineis, data payload is 3 bytes
  *
@@ -66,6 +84,22 @@ uint16_t u16MGR_AT_CMD_convertAsciiBinary(uint8_t *pu8InputBuffer, uint16_t u16_
  */
 bool bMGR_AT_CMD_TX_cmd(uint8_t *pu8_cmdParamString, enum atcmd_type_t e_exec_mode);
 
+/**
+ * @brief Process AT command "AT+TXQ" to get counters of TX fifo priority classes
+ *
+ * "AT+TXQ=?" returns one line per priority class, from the most urgent one (0: emergency, 1: high,
+ * 2: normal, 3: low), then the number of messages submitted to MAC layer:
+ * * "+TXQ=<class>,<nb in fifo>,<high-water mark>,<nb added>,<nb removed>,<nb dropped>,<nb promoted>"
+ * * "+TXQ=MAC,<nb of frames submitted to MAC layer>,<max nb submitted at once>"
+ * * "+TXQ=AGG,<nb of containers submitted>,<nb of records aggregated in them>"
+ *
+ * @param[in] pu8_cmdParamString: string containing AT command
+ * @param[in] e_exec_mode: type of the command (status command or action command)
+ *
+ * @return true if command is correctly received and processed, false if error
+ */
+bool bMGR_AT_CMD_TXQ_cmd(uint8_t *pu8_cmdParamString, enum atcmd_type_t e_exec_mode);
+
 #ifdef USE_RX_STACK
 /**
  * @brief Process AT command "AT+RX" received data. This is mainly aimed at updating AOP/CS data
@@ -95,6 +129,13 @@ bool bMGR_AT_CMD_RX_cmd(uint8_t *pu8_cmdParamString, enum atcmd_type_t e_exec_mo
  */
 enum KNS_status_t MGR_AT_CMD_macEvtProcess(void);
 
+/**
+ * @brief Send TX messages waiting for aggregation once their latency timer expired
+ *
+ * Latency timer runs from ISR and sets APP task ready, this fct is to be called from APP task loop.
+ */
+void MGR_AT_CMD_txAggProcess(void);
+
 #endif /* __MGR_AT_CMD_USERDATA_H */
 
 /**
@@ -21,6 +21,7 @@
 #include "mcu_at_console.h"
 #include "kineis_sw_conf.h"
 #include KINEIS_SW_ASSERT_H
+#include "kns_os.h"
 #include "mgr_log.h"
 
 /* Defines --------------------------------------------------------------------------------------*/
@@ -34,8 +35,12 @@
  * @attention Ensure there is always one extra free space in fifo between write index and read
  *            index meaning that if you expect to store 3 AT cmd at maximum, FIFO size should be
  *            3+1 minimum if you want to avoid overflow.
+ *
+ * @note FIFO only stores AT cmds location in console RX buffer. AT cmds characters are kept there
+ *       until decoded, thus console RX buffer should be sized to hold the expected AT cmds.
  */
 #define FIFO_MAX_SIZE                                   4
+/** AT cmd maximum length. Longer AT cmds are truncated */
 #ifdef USE_HDA4
 #define FRAME_MAX_LEN                                   1280
 #else
@@ -46,11 +51,51 @@
 #error "FIFO_MAX_SIZE must be superior or equal to 2"
 #endif
 
+/** Size of the hash table indexing AT cmds by name. It must be a power of 2, greater than
+ * ATCMD_MAX_COUNT. Keeping it about twice the number of commands limits collisions.
+ */
+#define ATCMD_HASH_TABLE_SIZE                           32
+#define ATCMD_HASH_INIT                                 2166136261UL /**< FNV-1a offset basis */
+#define ATCMD_HASH_PRIME                                16777619UL   /**< FNV-1a prime */
+
+#if (ATCMD_HASH_TABLE_SIZE & (ATCMD_HASH_TABLE_SIZE - 1)) != 0
+#error "ATCMD_HASH_TABLE_SIZE must be a power of 2"
+#endif
+
+_Static_assert(ATCMD_MAX_COUNT < ATCMD_HASH_TABLE_SIZE, "hash table needs a free slot per lookup");
+
 /* Structure Declaration ------------------------------------------------------------------------*/
+
+/** Location of an AT command in the console RX circular buffer */
+struct atcmdslice_t {
+	uint16_t u16_idx; /**< index of AT cmd first character in RX buffer */
+	uint16_t u16_len; /**< AT cmd length, end-of-string '\0' included */
+};
+
 struct atcmdfifo_t {
-	uint8_t au8_fifo[FIFO_MAX_SIZE][FRAME_MAX_LEN];
+	struct atcmdslice_t as_fifo[FIFO_MAX_SIZE];
 	uint8_t u8_widx;
 	uint8_t u8_ridx;
+	bool b_isPopped; /**< AT cmd at read index was popped and is being decoded */
+};
+
+/** States of the AT cmd stream parser */
+enum atcmd_parser_state_t {
+	ATCMD_PARSER_WAIT_A = 0,   /**< waiting for 'A' of "AT+" start pattern */
+	ATCMD_PARSER_WAIT_T,       /**< 'A' received, waiting for 'T' */
+	ATCMD_PARSER_WAIT_PLUS,    /**< "AT" received, waiting for '+' */
+	ATCMD_PARSER_IN_FRAME      /**< "AT+" received, waiting for "\r\n" end pattern */
+};
+
+/** Context of the AT cmd stream parser, kept between two received data chunks */
+struct atcmdparser_t {
+	enum atcmd_parser_state_t e_state;
+	uint8_t *pu8_rxBuf;      /**< console RX circular buffer */
+	uint16_t u16_rxBufSize;  /**< console RX circular buffer size */
+	uint16_t u16_frameIdx;   /**< index of current frame first character in RX buffer */
+	uint16_t u16_frameLen;   /**< number of characters of the current frame, "AT+" included */
+	uint16_t u16_nextIdx;    /**< index of next character to be parsed in RX buffer */
+	uint8_t u8_lastChar;     /**< last character received in current frame */
 };
 
 struct atcmd_info_t {
@@ -61,102 +106,268 @@ struct atcmd_info_t {
 /* Private variables ----------------------------------------------------------------------------*/
 
 static struct atcmdfifo_t s_atcmdfifo; /**< A FIFO used to store AT commands received from UART */
+static struct atcmdparser_t s_atcmdparser; /**< AT cmd stream parser context */
+/** AT cmds indexes in \ref cas_atcmd_list_array, sorted by name hash */
+static uint8_t au8_atcmdHashTable[ATCMD_HASH_TABLE_SIZE];
+/** Buffer used to make contiguous an AT cmd wrapping around the end of console RX buffer */
+static uint8_t au8_atcmdLinearBuf[FRAME_MAX_LEN];
 
 /* Private functions ----------------------------------------------------------------------------*/
 
 /**
- * @brief API used to extract the latest AT cmds from the incoming received data stream.
+ * @brief Get a character of the console RX buffer, relatively to a given index
  *
- * This fct is looking for the start pattern ("AT+") and the end pattern ("\r\n") in the stream.
- * If several frames are received in a row, only the last AT cmd is extracted
+ * @param[in] u16_idx index in RX buffer
+ * @param[in] i16_offset offset from index, may be negative
  *
- * Once AT cmd is found, it is removed from the stream and stored into the FIFO if not full.
+ * @retval pointer to the character
+ */
+static inline uint8_t *MGR_AT_CMD_rxChar(uint16_t u16_idx, int16_t i16_offset)
+{
+	return &s_atcmdparser.pu8_rxBuf[(u16_idx + s_atcmdparser.u16_rxBufSize + i16_offset) %
+					s_atcmdparser.u16_rxBufSize];
+}
+
+/**
+ * @brief Get index of the oldest character still needed in console RX buffer
+ *
+ * It is the first character of the oldest AT cmd in FIFO, or of the frame being received.
  *
- * As this fct is the entry point into FW, it is real-time critical and may be more robust. Some
- * design limitations are describerd below.
+ * @retval index in console RX buffer
+ */
+static uint16_t MGR_AT_CMD_getOldestRxIdx(void)
+{
+	if (s_atcmdfifo.u8_ridx % FIFO_MAX_SIZE != s_atcmdfifo.u8_widx % FIFO_MAX_SIZE)
+		return s_atcmdfifo.as_fifo[s_atcmdfifo.u8_ridx % FIFO_MAX_SIZE].u16_idx;
+	if (s_atcmdparser.e_state != ATCMD_PARSER_WAIT_A)
+		return s_atcmdparser.u16_frameIdx;
+	return s_atcmdparser.u16_nextIdx;
+}
+
+/**
+ * @brief Terminate frame being received and push it into the FIFO
  *
- * @attention This fct may be called from ISR context
+ * The frame stays in place in console RX buffer. Its last character ('\n') is replaced by
+ * end-of-string '\0'.
  *
- * @note Any garbage after the found AT cmd is also removed from stream. But the garbage before
- *       remains in the original stream.
+ * @note In case of AT cmd length overflow, the frame is truncated to maximum length (the last
+ *       character is replaced by end-of-string '\0').
  *
- * @param[in,out] pu8_RxBuffer pointer to start of RX buffer
- * @param[in,out] pi16_nbRxValidChar number of valid charecters in RX buffer
+ * In case FIFO is full (read index is reached), this new AT CMD is skipped. We need to wait for FW
+ * to consume the previous AT CMDs before.
  *
- * @retval true if a valid frame was extracted, false if nothing was extracted
+ * @param[in] u16_idx index of frame last character in RX buffer
  */
-static bool MGR_AT_CMD_parseStreamCb(uint8_t *pu8_RxBuffer, int16_t *pi16_nbRxValidChar)
+static void MGR_AT_CMD_endFrame(uint16_t u16_idx)
 {
-	int16_t idxEnd = 0;
-	int16_t idxStart = 0;
-	int16_t i16_atcmdLen = 0;
-	bool isEOLdetected = false;
-	bool isFirstCharDetected = false;
-
-	char C = (char)(pu8_RxBuffer[*pi16_nbRxValidChar - 1]);
-	/* Process buffer only once termination caracter has been found */
-	if (C != '\n')
-	  return false;
-
-	/* AT cmd starts with 'AT+' and ends with '\r\n'. Minimum packet length is ("AT+\r\n") */
-	if (*pi16_nbRxValidChar < 5)
-		return false;
-
-	/* Search beginning of AT cmd from the end of the buffer */
-	for (idxStart = *pi16_nbRxValidChar - 1; idxStart >= 0; idxStart--)
-		if (pu8_RxBuffer[idxStart] == 'A' &&
-		    pu8_RxBuffer[idxStart + 1] == 'T' &&
-		    pu8_RxBuffer[idxStart + 2] == '+') {
-			isFirstCharDetected = true;
-			break;
-		}
+	struct atcmdslice_t *ps_slice;
 
-	/* Return if we can not find the beginning of the frame*/
-	if (!isFirstCharDetected)
-		return false;
+	s_atcmdparser.e_state = ATCMD_PARSER_WAIT_A;
 
-	/* Find last characters of the frame : '\r\n' */
-	for (idxEnd = idxStart + 2; idxEnd <= *pi16_nbRxValidChar; idxEnd++) {
-		if (pu8_RxBuffer[idxEnd - 2] == '\r' && pu8_RxBuffer[idxEnd - 1] == '\n') {
-			isEOLdetected = true;
-			break;
+	if (((s_atcmdfifo.u8_widx+1) % FIFO_MAX_SIZE) == (s_atcmdfifo.u8_ridx % FIFO_MAX_SIZE))
+		return;
+
+	ps_slice = &s_atcmdfifo.as_fifo[s_atcmdfifo.u8_widx % FIFO_MAX_SIZE];
+	ps_slice->u16_idx = s_atcmdparser.u16_frameIdx;
+	ps_slice->u16_len = s_atcmdparser.u16_frameLen;
+	*MGR_AT_CMD_rxChar(u16_idx, 0) = '\0';
+	if (ps_slice->u16_len > FRAME_MAX_LEN) {
+		ps_slice->u16_len = FRAME_MAX_LEN;
+		*MGR_AT_CMD_rxChar(ps_slice->u16_idx, FRAME_MAX_LEN - 1) = '\0';
+	}
+
+	s_atcmdfifo.u8_widx++;
+
+	/** Wake-up APP task which is in charge of AT cmds decoding */
+	KNS_OS_setTaskReady(KNS_OS_TASK_APP);
+}
+
+/**
+ * @brief Feed AT cmd stream parser with one received character
+ *
+ * AT cmd starts with "AT+" and ends with "\r\n". The parser is a small state machine, thus work
+ * per character is constant whatever the amount of data already received.
+ *
+ * If some new "AT+" pattern is found inside a frame, the frame restarts from this pattern. This
+ * way, garbage received before an AT cmd is dropped.
+ *
+ * @param[in] u16_idx index of received character in console RX buffer
+ */
+static void MGR_AT_CMD_parseChar(uint16_t u16_idx)
+{
+	uint8_t u8_char = *MGR_AT_CMD_rxChar(u16_idx, 0);
+
+	switch (s_atcmdparser.e_state) {
+	case ATCMD_PARSER_WAIT_A:
+		if (u8_char == 'A') {
+			s_atcmdparser.u16_frameIdx = u16_idx;
+			s_atcmdparser.e_state = ATCMD_PARSER_WAIT_T;
 		}
+		break;
+	case ATCMD_PARSER_WAIT_T:
+		if (u8_char == 'T')
+			s_atcmdparser.e_state = ATCMD_PARSER_WAIT_PLUS;
+		else if (u8_char == 'A')
+			s_atcmdparser.u16_frameIdx = u16_idx;
+		else
+			s_atcmdparser.e_state = ATCMD_PARSER_WAIT_A;
+		break;
+	case ATCMD_PARSER_WAIT_PLUS:
+		if (u8_char == '+') {
+			s_atcmdparser.u16_frameLen = 3;
+			s_atcmdparser.u8_lastChar = u8_char;
+			s_atcmdparser.e_state = ATCMD_PARSER_IN_FRAME;
+		} else if (u8_char == 'A') {
+			s_atcmdparser.u16_frameIdx = u16_idx;
+			s_atcmdparser.e_state = ATCMD_PARSER_WAIT_T;
+		} else
+			s_atcmdparser.e_state = ATCMD_PARSER_WAIT_A;
+		break;
+	case ATCMD_PARSER_IN_FRAME:
+		s_atcmdparser.u16_frameLen++;
+		if ((u8_char == '\n') && (s_atcmdparser.u8_lastChar == '\r'))
+			MGR_AT_CMD_endFrame(u16_idx);
+		else if ((u8_char == '+') && (s_atcmdparser.u16_frameLen >= 6) &&
+			 (*MGR_AT_CMD_rxChar(u16_idx, -2) == 'A') &&
+			 (*MGR_AT_CMD_rxChar(u16_idx, -1) == 'T')) {
+			s_atcmdparser.u16_frameIdx = MGR_AT_CMD_rxChar(u16_idx, -2) -
+						     s_atcmdparser.pu8_rxBuf;
+			s_atcmdparser.u16_frameLen = 3;
+			s_atcmdparser.u8_lastChar = u8_char;
+		} else
+			s_atcmdparser.u8_lastChar = u8_char;
+		break;
+	default:
+		s_atcmdparser.e_state = ATCMD_PARSER_WAIT_A;
+		break;
 	}
-	/* Return if we can not find the EOL characters */
-	if (!isEOLdetected)
-		return false;
+}
 
-	/* As some AT cmd was consummed from the end at idxStart position,
-	 * idxStart characters remaing to be parsed at the beginning of the buffer.
-	 * Assume they are all valid.
-	 *
-	 */
-	*pi16_nbRxValidChar = idxStart;
+/**
+ * @brief API used to extract AT cmds from the incoming received data stream.
+ *
+ * All received characters are fed to the stream parser (cf \ref MGR_AT_CMD_parseChar). Parser
+ * keeps its context between two calls, thus each character is parsed once and all AT cmds are
+ * extracted in arrival order, even when several frames are received in a row.
+ *
+ * Once AT cmd is complete, its location in console RX buffer is stored into the FIFO if not full.
+ * AT cmds are not copied, their characters are released to the console once decoded. Characters
+ * which are not part of any AT cmd are released immediately.
+ *
+ * @note This fct is called by console from APP task context (cf \ref MGR_AT_CMD_popNextAt)
+ *
+ * @param[in] pu8_RxBuffer pointer to console RX circular buffer
+ * @param[in] u16_rxBufSize console RX circular buffer size
+ * @param[in] u16_rxIdx index of first received character in RX buffer
+ * @param[in] u16_nbRxChar number of received characters
+ */
+static void MGR_AT_CMD_parseStreamCb(uint8_t *pu8_RxBuffer, uint16_t u16_rxBufSize,
+				     uint16_t u16_rxIdx, uint16_t u16_nbRxChar)
+{
+	uint16_t u16_idx;
 
-	/* In case FIFO is full (read index is reached), skip this new AT CMD. We need to wait for
-	 * FW to consume the previous AT CMDs before.
-	 */
-	if ( ((s_atcmdfifo.u8_widx+1) % FIFO_MAX_SIZE) == (s_atcmdfifo.u8_ridx % FIFO_MAX_SIZE))
-		return true;
-	/* Set the frame in the UART fifo */
-	i16_atcmdLen = idxEnd - idxStart;
-	/* Check AT cmd length overflow. Limit AT cmd len to maximum if overflow was
-	 * detected (reserve last character for end-of-string'\0').
-	 */
-	if ((i16_atcmdLen + 1) > FRAME_MAX_LEN)
-		i16_atcmdLen = FRAME_MAX_LEN - 1;
-	memcpy(s_atcmdfifo.au8_fifo[s_atcmdfifo.u8_widx % FIFO_MAX_SIZE],
-		&pu8_RxBuffer[idxStart], i16_atcmdLen);
-	s_atcmdfifo.au8_fifo[s_atcmdfifo.u8_widx % FIFO_MAX_SIZE][i16_atcmdLen] = '\0';
-	/* Increment write index to next free position */
-	s_atcmdfifo.u8_widx++;
+	s_atcmdparser.pu8_rxBuf = pu8_RxBuffer;
+	s_atcmdparser.u16_rxBufSize = u16_rxBufSize;
 
-	/* In case read index is reached, skip oldest stored AT cmd to let a newest one to come */
-	if (s_atcmdfifo.u8_widx % FIFO_MAX_SIZE == s_atcmdfifo.u8_ridx % FIFO_MAX_SIZE)
-		kns_assert(0); // should no more happen
-		// s_atcmdfifo.u8_ridx++;
+	for (u16_idx = u16_rxIdx; u16_idx < (u16_rxIdx + u16_nbRxChar); u16_idx++)
+		MGR_AT_CMD_parseChar(u16_idx);
 
-	return true;
+	s_atcmdparser.u16_nextIdx = u16_idx % u16_rxBufSize;
+	MCU_AT_CONSOLE_rxRelease(MGR_AT_CMD_getOldestRxIdx());
+}
+
+/**
+ * @brief Callback invoked by console when unreleased received characters were dropped
+ *
+ * All AT cmds in FIFO and the frame being received are lost.
+ *
+ * @note This fct is called by console from APP task context (cf \ref MGR_AT_CMD_popNextAt)
+ */
+static void MGR_AT_CMD_rxOverflowCb(void)
+{
+	s_atcmdfifo.u8_ridx = s_atcmdfifo.u8_widx;
+	s_atcmdfifo.b_isPopped = false;
+	s_atcmdparser.e_state = ATCMD_PARSER_WAIT_A;
+}
+
+/**
+ * @brief Callback invoked by console when a line error corrupted the frame being received
+ *
+ * Only this frame is dropped, AT cmds already in FIFO are kept. Remaining characters of the
+ * corrupted line are then skipped until some new "AT+" pattern.
+ *
+ * @note This fct is called by console from APP task context (cf \ref MGR_AT_CMD_popNextAt)
+ */
+static void MGR_AT_CMD_rxErrorCb(void)
+{
+	s_atcmdparser.e_state = ATCMD_PARSER_WAIT_A;
+	MCU_AT_CONSOLE_rxRelease(MGR_AT_CMD_getOldestRxIdx());
+}
+
+/**
+ * @brief Callback invoked by console under interrupt when some characters are received
+ *
+ * Wake-up APP task which polls the console then decodes AT cmds.
+ *
+ * @attention This fct is called from console ISR, above critical section ceiling
+ */
+static void MGR_AT_CMD_rxNotifyCb(void)
+{
+	KNS_OS_setTaskReady(KNS_OS_TASK_APP);
+}
+
+/**
+ * @brief Remove AT cmd being decoded from FIFO and release its characters to the console
+ */
+static void MGR_AT_CMD_releaseAt(void)
+{
+	if (s_atcmdfifo.b_isPopped) {
+		s_atcmdfifo.u8_ridx++;
+		s_atcmdfifo.b_isPopped = false;
+	}
+	MCU_AT_CONSOLE_rxRelease(MGR_AT_CMD_getOldestRxIdx());
+}
+
+/**
+ * @brief Hash one more character of an AT cmd name (FNV-1a)
+ *
+ * @param[in] u32_hash hash of previous characters, \ref ATCMD_HASH_INIT for first one
+ * @param[in] u8_char character to be hashed
+ *
+ * @retval updated hash
+ */
+static inline uint32_t MGR_AT_CMD_hashChar(uint32_t u32_hash, uint8_t u8_char)
+{
+	return (u32_hash ^ u8_char) * ATCMD_HASH_PRIME;
+}
+
+/**
+ * @brief Build the hash table indexing AT cmds list by name
+ *
+ * This is done once at AT cmd manager start, from \ref cas_atcmd_list_array. Thus the index
+ * remains consistent with commands enabled by compilation flags.
+ */
+static void MGR_AT_CMD_buildHashTable(void)
+{
+	uint8_t u8_idx;
+	uint8_t u8_char;
+	uint8_t u8_slot;
+	uint32_t u32_hash;
+
+	memset(au8_atcmdHashTable, ATCMD_UNKNOWN_COMMAND, sizeof(au8_atcmdHashTable));
+
+	for (u8_idx = 0; u8_idx < ATCMD_MAX_COUNT; u8_idx++) {
+		u32_hash = ATCMD_HASH_INIT;
+		for (u8_char = 0; u8_char < cas_atcmd_list_array[u8_idx].u8_cmdNameLen; u8_char++)
+			u32_hash = MGR_AT_CMD_hashChar(u32_hash,
+				(uint8_t)cas_atcmd_list_array[u8_idx].pu8_cmdNameString[u8_char]);
+
+		/* open addressing, linear probing on collision */
+		u8_slot = u32_hash & (ATCMD_HASH_TABLE_SIZE - 1);
+		while (au8_atcmdHashTable[u8_slot] != ATCMD_UNKNOWN_COMMAND)
+			u8_slot = (u8_slot + 1) & (ATCMD_HASH_TABLE_SIZE - 1);
+		au8_atcmdHashTable[u8_slot] = u8_idx;
+	}
 }
 
 /**
@@ -168,7 +379,9 @@ static bool MGR_AT_CMD_parseStreamCb(uint8_t *pu8_RxBuffer, int16_t *pi16_nbRxVa
  * AT cmds without pattern above is an action-type command. It is used to set some information into
  * the device (e.g. "AT+TX=<...>\r\n").
  *
- * @note This fct may be called from ISR context
+ * The AT cmd name is read once, up to its delimiter ('=', '\r' or '\n'), while computing its hash.
+ * The type is deduced from the delimiter, then the name is looked up in the hash table. Thus the
+ * lookup cost does not depend on the number of commands in the list.
  *
  * @param[in] pu8_atcmd pointer to the AT command
  *
@@ -176,51 +389,47 @@ static bool MGR_AT_CMD_parseStreamCb(uint8_t *pu8_RxBuffer, int16_t *pi16_nbRxVa
  */
 static struct atcmd_info_t MGR_AT_CMD_getAtType(uint8_t *pu8_atcmd)
 {
-	uint8_t __u8_k;
-	uint8_t *p_atcmd_start;
-	uint8_t u8foundCmdIndex = ATCMD_UNKNOWN_COMMAND;
-	uint16_t u16_offset_search = 0;
+	uint8_t *pu8_char = pu8_atcmd;
+	uint8_t u8_slot;
+	uint8_t u8_idx;
+	uint16_t u16_nameLen;
+	uint32_t u32_hash = ATCMD_HASH_INIT;
 	struct atcmd_info_t atcmd_info;
 
+	atcmd_info.ATcmdIndex = ATCMD_UNKNOWN_COMMAND;
+	atcmd_info.ATcmdExecType = ATCMD_INVALID_USAGE;
 
-	atcmd_info.ATcmdIndex = u8foundCmdIndex;
-
-	/* Loop over table and check for match */
-	for (__u8_k = 0; __u8_k < ATCMD_MAX_COUNT; __u8_k++) {
-		u16_offset_search = cas_atcmd_list_array[__u8_k].u8_cmdNameLen;
+	while ((*pu8_char != '=') && (*pu8_char != '\r') && (*pu8_char != '\n') &&
+	       (*pu8_char != '\0'))
+		u32_hash = MGR_AT_CMD_hashChar(u32_hash, *pu8_char++);
+	u16_nameLen = pu8_char - pu8_atcmd;
 
-		if (bUTIL_strcmp((uint8_t *)cas_atcmd_list_array[__u8_k].pu8_cmdNameString,
-					pu8_atcmd,
-					u16_offset_search)) {
-			u8foundCmdIndex = (enum atcmd_idx_t)__u8_k;
+	/* Checks if next characters after command are either "=?\r", "=?\n" or
+	 * "=<params>\r" or "=<params>\n"
+	 *
+	 * @note "AT+<cmd>\r\n" is considered as action mode. it will be filtered in the
+	 * next parsing level.
+	 */
+	if ((pu8_char[0] == '=') && (pu8_char[1] == '?') &&
+	    ((pu8_char[2] == '\r') || (pu8_char[2] == '\n')))
+		atcmd_info.ATcmdExecType = ATCMD_STATUS_MODE;
+	else if (*pu8_char != '\0')
+		atcmd_info.ATcmdExecType = ATCMD_ACTION_MODE;
+	else
+		return atcmd_info;
+
+	for (u8_slot = u32_hash & (ATCMD_HASH_TABLE_SIZE - 1);
+	     au8_atcmdHashTable[u8_slot] != ATCMD_UNKNOWN_COMMAND;
+	     u8_slot = (u8_slot + 1) & (ATCMD_HASH_TABLE_SIZE - 1)) {
+		u8_idx = au8_atcmdHashTable[u8_slot];
+		if ((cas_atcmd_list_array[u8_idx].u8_cmdNameLen == u16_nameLen) &&
+		    bUTIL_strcmp((uint8_t *)cas_atcmd_list_array[u8_idx].pu8_cmdNameString,
+				 pu8_atcmd, u16_nameLen)) {
+			atcmd_info.ATcmdIndex = (enum atcmd_idx_t)u8_idx;
 			break;
 		}
 	}
-	/* If command is found in list, check type */
-	if (u8foundCmdIndex < ATCMD_UNKNOWN_COMMAND) {
-		u16_offset_search = cas_atcmd_list_array[u8foundCmdIndex].u8_cmdNameLen;
-		p_atcmd_start = pu8_atcmd;
-
-		/* Checks if next characters after command are either "=?\r", "=?\n" or
-		 * "=<params>\r" or "=<params>\n"
-		 *
-		 * @note "AT+<cmd>\r\n" is considered as action mode. it will be filtered in the
-		 * next parsing level.
-		 */
-		if ((p_atcmd_start[u16_offset_search] == '=')
-				&& (p_atcmd_start[u16_offset_search+1] == '?')
-				&& ((p_atcmd_start[u16_offset_search+2] == '\r')
-					|| (p_atcmd_start[u16_offset_search+2] == '\n'))) {
-			atcmd_info.ATcmdExecType = ATCMD_STATUS_MODE;
-			atcmd_info.ATcmdIndex = u8foundCmdIndex;
-		} else if ((p_atcmd_start[u16_offset_search] == '=')
-				|| (p_atcmd_start[u16_offset_search] == '\r')
-				|| (p_atcmd_start[u16_offset_search] == '\n')) {
-			atcmd_info.ATcmdExecType = ATCMD_ACTION_MODE;
-			atcmd_info.ATcmdIndex = u8foundCmdIndex;
-		} else
-			atcmd_info.ATcmdIndex = ATCMD_UNKNOWN_COMMAND;
-	}
+
 	return atcmd_info;
 }
 
@@ -228,7 +437,10 @@ static struct atcmd_info_t MGR_AT_CMD_getAtType(uint8_t *pu8_atcmd)
 
 bool MGR_AT_CMD_start(void *context)
 {
-	return MCU_AT_CONSOLE_register(context, MGR_AT_CMD_parseStreamCb);
+	MGR_AT_CMD_buildHashTable();
+	s_atcmdparser.e_state = ATCMD_PARSER_WAIT_A;
+	return MCU_AT_CONSOLE_register(context, MGR_AT_CMD_parseStreamCb, MGR_AT_CMD_rxOverflowCb,
+				       MGR_AT_CMD_rxErrorCb, MGR_AT_CMD_rxNotifyCb);
 
 }
 
@@ -239,10 +451,27 @@ bool MGR_AT_CMD_isPendingAt(void)
 
 uint8_t *MGR_AT_CMD_popNextAt(void)
 {
-	if (s_atcmdfifo.u8_ridx % FIFO_MAX_SIZE != s_atcmdfifo.u8_widx % FIFO_MAX_SIZE)
-		return s_atcmdfifo.au8_fifo[s_atcmdfifo.u8_ridx++ % FIFO_MAX_SIZE];
-	else
+	struct atcmdslice_t s_slice;
+	uint16_t u16_firstPartLen;
+
+	/** Parse characters received since last call */
+	MCU_AT_CONSOLE_rxPoll();
+
+	if (s_atcmdfifo.u8_ridx % FIFO_MAX_SIZE == s_atcmdfifo.u8_widx % FIFO_MAX_SIZE)
 		return NULL;
+
+	s_slice = s_atcmdfifo.as_fifo[s_atcmdfifo.u8_ridx % FIFO_MAX_SIZE];
+	s_atcmdfifo.b_isPopped = true;
+
+	if ((s_slice.u16_idx + s_slice.u16_len) <= s_atcmdparser.u16_rxBufSize)
+		return &s_atcmdparser.pu8_rxBuf[s_slice.u16_idx];
+
+	/* AT cmd wraps around the end of console RX buffer, make it contiguous */
+	u16_firstPartLen = s_atcmdparser.u16_rxBufSize - s_slice.u16_idx;
+	memcpy(au8_atcmdLinearBuf, &s_atcmdparser.pu8_rxBuf[s_slice.u16_idx], u16_firstPartLen);
+	memcpy(&au8_atcmdLinearBuf[u16_firstPartLen], s_atcmdparser.pu8_rxBuf,
+	       s_slice.u16_len - u16_firstPartLen);
+	return au8_atcmdLinearBuf;
 }
 
 bool MGR_AT_CMD_decodeAt(uint8_t *pu8_atcmd)
@@ -262,6 +491,7 @@ bool MGR_AT_CMD_decodeAt(uint8_t *pu8_atcmd)
 			bMGR_AT_CMD_logFailedMsg(ERROR_UNKNOWN_AT_CMD);
 			MGR_LOG_VERBOSE("[ERROR] Unknown AT command\r\n");
 		}
+		MGR_AT_CMD_releaseAt();
 	} else {
 		bMGR_AT_CMD_logFailedMsg(ERROR_UNKNOWN);
 		MGR_LOG_DEBUG("[ERROR] input param is Nil\r\n");
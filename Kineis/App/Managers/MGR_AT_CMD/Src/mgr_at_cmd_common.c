@@ -40,32 +40,49 @@ bool bMGR_AT_CMD_sendResponse(enum atcmd_rsp_type_t atcmd_response_type, void *a
 		if (atcmd_rsp_data != NULL) {
 			struct sUserDataTxFifoElt_t *spUserDataMsg =
 						(struct sUserDataTxFifoElt_t *)atcmd_rsp_data;
-			uint8_t *pu8UserDataPtr = spUserDataMsg->u8DataBuf;
+			uint8_t *pu8UserDataPtr = spUserDataMsg->pu8DataBuf;
 			uint16_t u16UserDataBitlen = spUserDataMsg->u16DataBitLen;
 
-			MCU_AT_CONSOLE_send("+TX=0,");
-			MCU_AT_CONSOLE_send_dataBuf(pu8UserDataPtr, u16UserDataBitlen);
-			MCU_AT_CONSOLE_send("\r\n");
+			MCU_AT_CONSOLE_rspStart("+TX=0,");
+			MCU_AT_CONSOLE_rspAddDataBuf(pu8UserDataPtr, u16UserDataBitlen);
+			MCU_AT_CONSOLE_rspEnd(",%u\r\n", spUserDataMsg->u16Handle);
 		}
 		return true;
 	}
 	break;
 	case ATCMD_RSP_RXTIMEOUT:
 	case ATCMD_RSP_TXNOTOK:
+	case ATCMD_RSP_TXDROP:
 	{
 		if (atcmd_rsp_data != NULL) {
 			struct sUserDataTxFifoElt_t *spUserDataMsg =
 						(struct sUserDataTxFifoElt_t *)atcmd_rsp_data;
-			uint8_t *pu8UserDataPtr = spUserDataMsg->u8DataBuf;
+			uint8_t *pu8UserDataPtr = spUserDataMsg->pu8DataBuf;
 			uint16_t u16UserDataBitlen = spUserDataMsg->u16DataBitLen;
 			enum ERROR_RETURN_T error_id = ERROR_UNKNOWN;
 
 			if (atcmd_response_type == ATCMD_RSP_RXTIMEOUT)
 				error_id = ERROR_RX_TIMEOUT;
+			if (atcmd_response_type == ATCMD_RSP_TXDROP)
+				error_id = ERROR_DATA_QUEUE_FULL;
 
-			MCU_AT_CONSOLE_send("+TX=%d,", error_id);
-			MCU_AT_CONSOLE_send_dataBuf(pu8UserDataPtr, u16UserDataBitlen);
-			MCU_AT_CONSOLE_send("\r\n");
+			MCU_AT_CONSOLE_rspStart("+TX=%d,", error_id);
+			MCU_AT_CONSOLE_rspAddDataBuf(pu8UserDataPtr, u16UserDataBitlen);
+			MCU_AT_CONSOLE_rspEnd(",%u\r\n", spUserDataMsg->u16Handle);
+		}
+		return true;
+	}
+	break;
+	case ATCMD_RSP_TXACCEPTED:
+	{
+		/** message may already be gone (e.g. fifo flushed), acknowledge without handle */
+		if (atcmd_rsp_data != NULL) {
+			struct sUserDataTxFifoElt_t *spUserDataMsg =
+						(struct sUserDataTxFifoElt_t *)atcmd_rsp_data;
+
+			MCU_AT_CONSOLE_send("+OK=%u\r\n", spUserDataMsg->u16Handle);
+		} else {
+			MCU_AT_CONSOLE_send("+OK\r\n");
 		}
 		return true;
 	}
@@ -98,9 +115,9 @@ bool bMGR_AT_CMD_sendResponse(enum atcmd_rsp_type_t atcmd_response_type, void *a
 			uint8_t *rxFrmDataPtr = receivedFrm->data;
 			uint16_t rxFrmDataBitlen = receivedFrm->data_bitlen;
 
-			MCU_AT_CONSOLE_send("+RX=");
-			MCU_AT_CONSOLE_send_dataBuf(rxFrmDataPtr, rxFrmDataBitlen);
-			MCU_AT_CONSOLE_send("\r\n");
+			MCU_AT_CONSOLE_rspStart("+RX=");
+			MCU_AT_CONSOLE_rspAddDataBuf(rxFrmDataPtr, rxFrmDataBitlen);
+			MCU_AT_CONSOLE_rspEnd("\r\n");
 		}
 		return true;
 	}
@@ -113,9 +130,9 @@ bool bMGR_AT_CMD_sendResponse(enum atcmd_rsp_type_t atcmd_response_type, void *a
 			uint8_t *rxMsgDataPtr = reeceivedMsg->data;
 			uint16_t rxMsgDataBitlen = reeceivedMsg->data_bitlen;
 
-			MCU_AT_CONSOLE_send("+DL=");
-			MCU_AT_CONSOLE_send_dataBuf(rxMsgDataPtr, rxMsgDataBitlen);
-			MCU_AT_CONSOLE_send("\r\n");
+			MCU_AT_CONSOLE_rspStart("+DL=");
+			MCU_AT_CONSOLE_rspAddDataBuf(rxMsgDataPtr, rxMsgDataBitlen);
+			MCU_AT_CONSOLE_rspEnd("\r\n");
 		}
 		return true;
 	}
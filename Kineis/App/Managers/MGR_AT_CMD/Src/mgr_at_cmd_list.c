@@ -19,7 +19,7 @@
 #include "mgr_at_cmd_list_mac.h"
 #include "mgr_at_cmd_list_certif.h"
 
-const char *atcmd_version = "v0.5";
+const char *atcmd_version = "v0.9";
 
 /** @attention update AT cmd version above if you add or remove commands in this list */
 const struct atcmd_desc_t cas_atcmd_list_array[ATCMD_MAX_COUNT] = {
@@ -33,9 +33,11 @@ const struct atcmd_desc_t cas_atcmd_list_array[ATCMD_MAX_COUNT] = {
 	{ "AT+RCONF",         8, bMGR_AT_CMD_RCONF_cmd},
 	{ "AT+SAVE_RCONF",   13, bMGR_AT_CMD_SAVE_RCONF_cmd},
 	{ "AT+LPM",           6, bMGR_AT_CMD_LPM_cmd},
+	{ "AT+PERF",          7, bMGR_AT_CMD_PERF_cmd},
 
 	/**< User data commands */
 	{ "AT+TX",            5, bMGR_AT_CMD_TX_cmd},
+	{ "AT+TXQ",           6, bMGR_AT_CMD_TXQ_cmd},
 #ifdef USE_RX_STACK
 	{ "AT+RX",            5, bMGR_AT_CMD_RX_cmd},
 #endif
@@ -27,6 +27,12 @@
 #include "kns_cfg.h"
 #include "lpm.h" // used for AT+LPM command all is hardcoded so far
 #include "build_info.h"
+#include "kns_os_perf.h"
+#ifdef KNS_OS_PERF
+#include "mcu_misc.h"
+#include "kineis_sw_conf.h"
+#include KINEIS_CS_H
+#endif
 #include "mgr_log.h"
 
 
@@ -225,6 +231,44 @@ bool bMGR_AT_CMD_LPM_cmd(uint8_t *pu8_cmdParamString __attribute__((unused)),
 	return false;
 }
 
+bool bMGR_AT_CMD_PERF_cmd(uint8_t *pu8_cmdParamString __attribute__((unused)),
+	enum atcmd_type_t e_exec_mode __attribute__((unused)))
+{
+#ifdef KNS_OS_PERF
+	uint8_t idx;
+	struct KNS_OS_PERF_task_t taskStats;
+	struct KNS_OS_PERF_q_t qStats;
+	uint32_t u32_csCycles;
+	uintptr_t csCaller;
+
+	if (e_exec_mode == ATCMD_STATUS_MODE) {
+		MCU_AT_CONSOLE_send("+PERF=CLK,%lu\r\n", MCU_MISC_getCycleCntFreq());
+		for (idx = 0; idx < KNS_OS_TASK_MAX; idx++) {
+			KNS_OS_PERF_getTaskStats(idx, &taskStats);
+			MCU_AT_CONSOLE_send("+PERF=TASK,%u,%lu,%lu,%lu\r\n", idx, taskStats.nbRun,
+				(uint32_t)(taskStats.cyclesTotal / 1000), taskStats.cyclesMax);
+		}
+		for (idx = 0; idx < KNS_Q_MAX; idx++) {
+			KNS_OS_PERF_getQStats(idx, &qStats);
+			MCU_AT_CONSOLE_send("+PERF=Q,%u,%lu,%lu,%u,%lu\r\n", idx, qStats.nbPush,
+				qStats.nbPop, qStats.maxLevel, qStats.nbQFull);
+		}
+		u32_csCycles = KNS_CS_getMaxMasked(&csCaller);
+		MCU_AT_CONSOLE_send("+PERF=CS,%lu,%08lX\r\n", u32_csCycles, (uint32_t)csCaller);
+		return true;
+	}
+	if (e_exec_mode == ATCMD_ACTION_MODE) {
+		if (strcmp((const char *)pu8_cmdParamString, "AT+PERF=RESET") != 0)
+			return bMGR_AT_CMD_logFailedMsg(ERROR_PARAMETER_FORMAT);
+		KNS_OS_PERF_reset();
+		KNS_CS_resetMaxMasked();
+		return bMGR_AT_CMD_logSucceedMsg();
+	}
+#endif
+
+	return bMGR_AT_CMD_logFailedMsg(ERROR_UNKNOWN_AT_CMD);
+}
+
 /**
  * @}
  */
@@ -35,7 +35,6 @@ bool bMGR_AT_CMD_KMAC_cmd(uint8_t *pu8_cmdParamString, enum atcmd_type_t e_exec_
 	enum KNS_status_t status = KNS_STATUS_OK;
 	struct KNS_MAC_prflInfo_t prfl_info;
 	uint8_t *prflCfgPtr;
-	uint16_t idx;
 
 	uint8_t prflCtxtData[13]; // 6 bytes doubled due to sscanf ASCII + end \0
 	struct KNS_MAC_appEvt_t appEvt = {
@@ -49,11 +48,10 @@ bool bMGR_AT_CMD_KMAC_cmd(uint8_t *pu8_cmdParamString, enum atcmd_type_t e_exec_
 	if (e_exec_mode == ATCMD_STATUS_MODE) {
 		KNS_MAC_getPrflInfo(&prfl_info);
 		prflCfgPtr = &prfl_info.prflCfgPtr;
-		MCU_AT_CONSOLE_send("+KMAC=%d,",prfl_info.id);
+		MCU_AT_CONSOLE_rspStart("+KMAC=%d,", prfl_info.id);
 		// log profile context, reduce size by 1 due to `id` field of KNS_MAC_prflInfo_t
-		for (idx = 0; idx < (sizeof(prfl_info) - 1); idx++)
-			MCU_AT_CONSOLE_send("%02X", prflCfgPtr[idx]);
-		MCU_AT_CONSOLE_send("\r\n");
+		MCU_AT_CONSOLE_rspAddDataBuf(prflCfgPtr, (sizeof(prfl_info) - 1) * 8);
+		MCU_AT_CONSOLE_rspEnd("\r\n");
 
 		return true;
 	}
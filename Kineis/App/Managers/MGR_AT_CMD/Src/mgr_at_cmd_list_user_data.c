@@ -18,8 +18,11 @@
 #include "kns_types.h"
 #include "user_data.h"
 #include "mgr_at_cmd_list_user_data.h"
+#include "mcu_at_console.h"
 #include "kns_q.h"
 #include "kns_mac.h"
+#include "kns_os.h"
+#include "mcu_tim_srv.h"
 #include "kineis_sw_conf.h"  // for assert include below and ERROR_RETURN_T type
 #include KINEIS_SW_ASSERT_H
 #include "mgr_log.h"
@@ -30,8 +33,511 @@
 
 /* Private macro -------------------------------------------------------------*/
 
+/**
+ * @brief Maximum number of messages submitted to MAC layer at once
+ *
+ * Once submitted, messages are scheduled by MAC layer. Other messages wait in USERDATA fifo, sorted
+ * by the TX scheduling policy, and are submitted as previous ones complete. A small window thus
+ * lets urgent messages overtake the ones already queued. Emergency messages are submitted even
+ * when the window is full.
+ *
+ * Default is to submit each message at once, i.e. USERDATA fifo order is not used.
+ */
+#ifndef MGR_AT_CMD_MAC_TX_WINDOW
+#ifdef USE_USERDATA_TX_PRIO
+#define MGR_AT_CMD_MAC_TX_WINDOW	1
+#else
+#define MGR_AT_CMD_MAC_TX_WINDOW	USERDATA_TX_FIFO_SIZE
+#endif
+#endif
+
+/** Maximum number of MAC replies (OK/ERROR) to SEND_DATA requests which can be awaited */
+#define MGR_AT_CMD_MAC_RSP_MAX		32
+
+/** Maximum number of hexadecimal characters of AT+TX user data, i.e. longest MAC frame payload
+ *
+ * So far, LDA2 is limited to 49 chars, i.e. 24.5 bytes, HDA4 to 1265 chars, i.e. 632.5 bytes.
+ */
+#ifdef USE_HDA4
+#define MGR_AT_CMD_TX_MAX_CHAR_NB	1265
+#else
+#define MGR_AT_CMD_TX_MAX_CHAR_NB	49
+#endif
+
+/**
+ * @brief Aggregation container, cf @ref bMGR_AT_CMD_TX_cmd
+ *
+ * Messages with the aggregation attribute are packed as records of a container, sent as one MAC
+ * frame. Container is nibble-aligned, MSB first:
+ * * version: 4 bits (MGR_AT_CMD_AGG_VERSION)
+ * * then, for each record: length in nibbles (8 bits, 1..255), followed by record data
+ *
+ * Records are never split between frames, so that each one is reported on its own.
+ */
+#define MGR_AT_CMD_AGG_VERSION		0x1
+#define MGR_AT_CMD_AGG_HDR_BITLEN	4
+#define MGR_AT_CMD_AGG_LEN_BITLEN	8
+#define MGR_AT_CMD_AGG_FRAME_BITLEN	(MGR_AT_CMD_TX_MAX_CHAR_NB * 4)
+
+/** Longest record of a container, in hexadecimal characters */
+#if (MGR_AT_CMD_AGG_FRAME_BITLEN - MGR_AT_CMD_AGG_HDR_BITLEN - MGR_AT_CMD_AGG_LEN_BITLEN) / 4 < 255
+#define MGR_AT_CMD_AGG_RECORD_MAX_CHAR_NB \
+	((MGR_AT_CMD_AGG_FRAME_BITLEN - MGR_AT_CMD_AGG_HDR_BITLEN - MGR_AT_CMD_AGG_LEN_BITLEN) / 4)
+#else
+#define MGR_AT_CMD_AGG_RECORD_MAX_CHAR_NB	255
+#endif
+
+/**
+ * @brief Maximum time a message to be aggregated waits for other ones, in ms
+ *
+ * A container is sent as soon as no more record can fit in it. Otherwise, it is sent once this
+ * delay elapsed since the oldest waiting record was queued.
+ */
+#ifndef MGR_AT_CMD_AGG_LATENCY_MS
+#define MGR_AT_CMD_AGG_LATENCY_MS	300000
+#endif
+
+/* Private variables ----------------------------------------------------------*/
+
+/**
+ * @brief Handles of USERDATA messages submitted to MAC layer, in submission order
+ *
+ * MAC events do not carry any message reference, only the payload. MAC completes messages in
+ * submission order, so the completion event is expected to refer to the oldest message. Its
+ * payload is still checked, other submitted messages being searched only when it does not match.
+ * Thus, identical payloads are reported in submission order with their own handle.
+ *
+ * MAC layer replies OK/ERROR to each SEND_DATA request, in request order. This reply is the AT+TX
+ * response when the message is submitted at once. When it is submitted later, AT+TX was already
+ * answered, the reply is not forwarded to host (OK) or reported as a TX failure (ERROR).
+ *
+ * Aggregated messages are submitted together, as records of one MAC frame. They are stored next
+ * to each other, the first one standing for the frame. MAC events refer to this frame, whose
+ * payload is built again to be matched.
+ *
+ * Kept in retention RAM along with USERDATA fifo and MAC layer context, so that completion events
+ * following a STANDBY wake-up still find their message.
+ */
+static
+__attribute__((__section__(".retentionRamBss")))
+struct {
+	uint16_t au16Handle[USERDATA_TX_FIFO_SIZE];
+	bool abIsFrameNext[USERDATA_TX_FIFO_SIZE]; /**< record in same frame as previous one */
+	uint16_t u16Count;
+	uint16_t u16FrameNb; /**< MAC frames submitted, i.e. records not in previous one's frame */
+	bool bIsBacklog; /**< some fifo messages were not submitted yet, e.g. recovered at boot */
+	uint8_t u8MacRspNb; /**< MAC replies to SEND_DATA still awaited */
+	uint8_t u8MacRspRdIdx; /**< position of oldest awaited MAC reply */
+	uint32_t u32MacRspSilentMap; /**< bit set at position of awaited reply not for host */
+	uint16_t au16MacRspHandle[MGR_AT_CMD_MAC_RSP_MAX]; /**< first message of awaited reply */
+	uint32_t u32AggFrameNb; /**< containers submitted since boot */
+	uint32_t u32AggRecordNb; /**< records submitted in containers since boot */
+} sMacTxPending;
+
+/**
+ * @brief Latency timer of messages waiting for aggregation
+ *
+ * Timer callback runs from ISR, it only requests a flush, done by APP task.
+ */
+static struct {
+	struct MCU_TIM_SRV_timer_t sFlushTim;
+	volatile bool bIsFlush; /**< send containers even if not full */
+} sTxAgg;
+
+/** Frame payload built to match MAC events against submitted frames */
+static uint8_t au8MacTxFrame[KNS_MAC_USRDATA_MAXLEN];
+
 /* Private functions ----------------------------------------------------------*/
 
+/** @brief Get number of records of the frame starting at some index of submitted messages table
+ *
+ * @param[in] u16Idx index of the first record of the frame
+ *
+ * @return number of records
+ */
+static uint16_t u16MGR_AT_CMD_getMacTxFrameLen(uint16_t u16Idx)
+{
+	uint16_t u16RecordNb = 1;
+
+	while (((u16Idx + u16RecordNb) < sMacTxPending.u16Count) &&
+	       sMacTxPending.abIsFrameNext[u16Idx + u16RecordNb])
+		u16RecordNb++;
+
+	return u16RecordNb;
+}
+
+/** @brief Get index of a frame in submitted messages table
+ *
+ * @param[in] spUserDataMsg first record of the frame
+ *
+ * @return index, sMacTxPending.u16Count if message was not submitted
+ */
+static uint16_t u16MGR_AT_CMD_getMacTxFrameIdx(struct sUserDataTxFifoElt_t *spUserDataMsg)
+{
+	uint16_t idx;
+
+	for (idx = 0; idx < sMacTxPending.u16Count; idx++)
+		if (sMacTxPending.au16Handle[idx] == spUserDataMsg->u16Handle)
+			break;
+
+	return idx;
+}
+
+/** @brief Build the payload of a MAC frame from its records
+ *
+ * A message sent alone is copied as is. Aggregated messages are packed in a container, cf
+ * MGR_AT_CMD_AGG_VERSION.
+ *
+ * @param[in] pu16Handle handles of the records of the frame
+ * @param[in] u16RecordNb number of records
+ * @param[out] pu8Data payload, KNS_MAC_USRDATA_MAXLEN bytes
+ *
+ * @return payload length in bits, 0 if some record is not in fifo anymore
+ */
+static uint16_t u16MGR_AT_CMD_buildMacTxFrame(const uint16_t *pu16Handle, uint16_t u16RecordNb,
+	uint8_t *pu8Data)
+{
+	struct sUserDataTxFifoElt_t *spRecord;
+	uint16_t u16NibbleIdx = 0;
+	uint16_t u16RecordIdx;
+	uint16_t u16Idx;
+	uint8_t u8Nibble;
+	uint8_t u8CharNb;
+
+	spRecord = USERDATA_txFifoGetEltByHandle(pu16Handle[0]);
+	if (spRecord == NULL)
+		return 0;
+	if (!spRecord->u8Attr.agg) {
+		memcpy(pu8Data, spRecord->pu8DataBuf, (spRecord->u16DataBitLen + 7) / 8);
+		return spRecord->u16DataBitLen;
+	}
+
+	/** nibbles are written in order, even ones set the byte, odd ones complete it */
+	pu8Data[u16NibbleIdx++ / 2] = MGR_AT_CMD_AGG_VERSION << 4;
+	for (u16RecordIdx = 0; u16RecordIdx < u16RecordNb; u16RecordIdx++) {
+		spRecord = USERDATA_txFifoGetEltByHandle(pu16Handle[u16RecordIdx]);
+		if (spRecord == NULL)
+			return 0;
+		u8CharNb = (uint8_t)(spRecord->u16DataBitLen / 4);
+		for (u16Idx = 0; u16Idx < (2 + u8CharNb); u16Idx++, u16NibbleIdx++) {
+			if (u16Idx < 2)
+				u8Nibble = (u16Idx == 0) ? (u8CharNb >> 4) : (u8CharNb & 0x0F);
+			else if ((u16Idx % 2) == 0)
+				u8Nibble = spRecord->pu8DataBuf[(u16Idx - 2) / 2] >> 4;
+			else
+				u8Nibble = spRecord->pu8DataBuf[(u16Idx - 2) / 2] & 0x0F;
+			if ((u16NibbleIdx % 2) == 0)
+				pu8Data[u16NibbleIdx / 2] = u8Nibble << 4;
+			else
+				pu8Data[u16NibbleIdx / 2] |= u8Nibble;
+		}
+	}
+	kns_assert((u16NibbleIdx * 4) <= MGR_AT_CMD_AGG_FRAME_BITLEN);
+
+	return u16NibbleIdx * 4;
+}
+
+/** @brief Get the USERDATA message a MAC TX-complete event refers to
+ *
+ * @param[in] spTxCtxt TX-complete context of the MAC event
+ *
+ * @return pointer to USERDATA element, first record of the frame, NULL if no submitted frame
+ * matches
+ */
+static struct sUserDataTxFifoElt_t *spMGR_AT_CMD_getMacTxMsg(
+	struct KNS_MAC_TX_cplt_ctxt_t *spTxCtxt)
+{
+	struct sUserDataTxFifoElt_t *spUserDataMsg;
+	uint16_t u16RecordNb;
+	uint16_t u16BitLen;
+	uint16_t idx;
+
+	for (idx = 0; idx < sMacTxPending.u16Count; idx += u16RecordNb) {
+		u16RecordNb = u16MGR_AT_CMD_getMacTxFrameLen(idx);
+		spUserDataMsg = USERDATA_txFifoGetEltByHandle(sMacTxPending.au16Handle[idx]);
+		if (spUserDataMsg == NULL)
+			continue;
+		if (!spUserDataMsg->u8Attr.agg) {
+			if (!USERDATA_txFifoIsPayloadEqual(spUserDataMsg, spTxCtxt->data,
+				spTxCtxt->data_bitlen))
+				continue;
+		} else {
+			/** container length is a multiple of 4 bits, ignore unused last nibble */
+			u16BitLen = u16MGR_AT_CMD_buildMacTxFrame(&sMacTxPending.au16Handle[idx],
+				u16RecordNb, au8MacTxFrame);
+			if ((u16BitLen != spTxCtxt->data_bitlen) ||
+			    (memcmp(au8MacTxFrame, spTxCtxt->data, u16BitLen / 8) != 0))
+				continue;
+			if (((u16BitLen % 8) != 0) &&
+			    (((au8MacTxFrame[u16BitLen / 8] ^ spTxCtxt->data[u16BitLen / 8]) & 0xF0)
+			     != 0))
+				continue;
+		}
+		if (idx != 0)
+			MGR_LOG_DEBUG("MAC TX completion out of order (%d)\r\n", idx);
+		return spUserDataMsg;
+	}
+	return NULL;
+}
+
+/** @brief Select the records of the MAC frame starting with some message
+ *
+ * A message without the aggregation attribute is alone in its frame. Otherwise, next messages to be
+ * aggregated are added in fifo order, as long as they fit in the container.
+ *
+ * @param[in] spUserDataMsg first record of the frame, not submitted yet
+ * @param[out] pu16Handle handles of the records, USERDATA_TX_FIFO_SIZE entries
+ * @param[out] pbIsFull true if no more record can be added to the frame
+ *
+ * @return number of records
+ */
+static uint16_t u16MGR_AT_CMD_selectMacTxFrame(struct sUserDataTxFifoElt_t *spUserDataMsg,
+	uint16_t *pu16Handle, bool *pbIsFull)
+{
+	struct sUserDataTxFifoElt_t *spRecord;
+	uint16_t u16BitLen = MGR_AT_CMD_AGG_HDR_BITLEN;
+	uint16_t u16RecordNb = 0;
+
+	*pbIsFull = true;
+	if (!spUserDataMsg->u8Attr.agg) {
+		pu16Handle[u16RecordNb++] = spUserDataMsg->u16Handle;
+		return u16RecordNb;
+	}
+
+	for (spRecord = spUserDataMsg; spRecord != NULL; spRecord = spRecord->spNext) {
+		if (spRecord->bIsSubmitted || !spRecord->u8Attr.agg)
+			continue;
+		/** records keep fifo order, next one does not fit: frame is full */
+		if ((u16BitLen + MGR_AT_CMD_AGG_LEN_BITLEN + spRecord->u16DataBitLen) >
+		    MGR_AT_CMD_AGG_FRAME_BITLEN)
+			return u16RecordNb;
+		u16BitLen += MGR_AT_CMD_AGG_LEN_BITLEN + spRecord->u16DataBitLen;
+		pu16Handle[u16RecordNb++] = spRecord->u16Handle;
+	}
+	*pbIsFull = ((MGR_AT_CMD_AGG_FRAME_BITLEN - u16BitLen) < (MGR_AT_CMD_AGG_LEN_BITLEN + 4));
+
+	return u16RecordNb;
+}
+
+/** @brief Submit a MAC frame to MAC layer
+ *
+ * @param[in] pu16Handle: handles of the USERDATA messages of the frame, in fifo
+ * @param[in] u16RecordNb: number of messages
+ * @param[in] bIsSilent: MAC reply to this request is not the response of an AT cmd
+ *
+ * @return KNS_STATUS_OK if frame was queued to MAC layer, error otherwise
+ */
+static enum KNS_status_t eMGR_AT_CMD_submitMacTxFrame(const uint16_t *pu16Handle,
+	uint16_t u16RecordNb, bool bIsSilent)
+{
+	enum KNS_status_t status;
+	struct sUserDataTxFifoElt_t *spUserDataMsg = USERDATA_txFifoGetEltByHandle(pu16Handle[0]);
+	uint16_t idx;
+	uint8_t u8RspIdx;
+	struct KNS_MAC_appEvt_t appEvt = {
+		.id = KNS_MAC_SEND_DATA,
+		.data_ctxt = {
+			.usrdata = {0},
+			.sf = (enum KNS_serviceFlag_t)(spUserDataMsg->u8Attr.sf),
+		}
+	};
+
+	appEvt.data_ctxt.usrdata_bitlen = u16MGR_AT_CMD_buildMacTxFrame(pu16Handle, u16RecordNb,
+		appEvt.data_ctxt.usrdata);
+	kns_assert(appEvt.data_ctxt.usrdata_bitlen != 0);
+
+	status = KNS_Q_push(KNS_Q_DL_APP2MAC, (void *)&appEvt);
+	if (status == KNS_STATUS_OK) {
+		/** every reserved element has a slot, table cannot overflow */
+		kns_assert((sMacTxPending.u16Count + u16RecordNb) <= USERDATA_TX_FIFO_SIZE);
+		for (idx = 0; idx < u16RecordNb; idx++) {
+			spUserDataMsg = USERDATA_txFifoGetEltByHandle(pu16Handle[idx]);
+			spUserDataMsg->bIsSubmitted = true;
+			sMacTxPending.abIsFrameNext[sMacTxPending.u16Count] = (idx != 0);
+			sMacTxPending.au16Handle[sMacTxPending.u16Count++] = pu16Handle[idx];
+		}
+		sMacTxPending.u16FrameNb++;
+		if (spUserDataMsg->u8Attr.agg) {
+			sMacTxPending.u32AggFrameNb++;
+			sMacTxPending.u32AggRecordNb += u16RecordNb;
+		}
+		kns_assert(sMacTxPending.u8MacRspNb < MGR_AT_CMD_MAC_RSP_MAX);
+		u8RspIdx = (sMacTxPending.u8MacRspRdIdx + sMacTxPending.u8MacRspNb) %
+			   MGR_AT_CMD_MAC_RSP_MAX;
+		if (bIsSilent)
+			sMacTxPending.u32MacRspSilentMap |= 1UL << u8RspIdx;
+		else
+			sMacTxPending.u32MacRspSilentMap &= ~(1UL << u8RspIdx);
+		sMacTxPending.au16MacRspHandle[u8RspIdx] = pu16Handle[0];
+		sMacTxPending.u8MacRspNb++;
+	}
+
+	return status;
+}
+
+/** @brief Consume the oldest awaited MAC reply to a SEND_DATA request
+ *
+ * @param[out] pu16Handle handle of the first message of the frame, USERDATA_TX_HANDLE_INVALID if
+ * no reply was awaited
+ *
+ * @return true if this reply is not to be forwarded to host as AT cmd response
+ */
+static bool bMGR_AT_CMD_isMacRspSilent(uint16_t *pu16Handle)
+{
+	bool bIsSilent;
+
+	*pu16Handle = USERDATA_TX_HANDLE_INVALID;
+	if (sMacTxPending.u8MacRspNb == 0)
+		return false;
+
+	bIsSilent = (sMacTxPending.u32MacRspSilentMap & (1UL << sMacTxPending.u8MacRspRdIdx)) != 0;
+	*pu16Handle = sMacTxPending.au16MacRspHandle[sMacTxPending.u8MacRspRdIdx];
+	sMacTxPending.u8MacRspRdIdx = (sMacTxPending.u8MacRspRdIdx + 1) % MGR_AT_CMD_MAC_RSP_MAX;
+	sMacTxPending.u8MacRspNb--;
+
+	return bIsSilent;
+}
+
+/** @brief Aggregation latency timer expiry, from ISR: request APP task to flush containers
+ *
+ * @param[in] ctx unused
+ */
+static void vMGR_AT_CMD_aggFlushCb(void *ctx __attribute__((unused)))
+{
+	sTxAgg.bIsFlush = true;
+	KNS_OS_setTaskReady(KNS_OS_TASK_APP);
+}
+
+/** @brief Run aggregation latency timer as long as some record waits for its container
+ *
+ * Timer is started when the first record is waiting, so that its latency is bounded. Flush
+ * request ends once no more record waits.
+ */
+static void vMGR_AT_CMD_updateAggTimer(void)
+{
+	struct sUserDataTxFifoElt_t *spUserDataMsg;
+
+	for (spUserDataMsg = USERDATA_txFifoGetFirst(); spUserDataMsg != NULL;
+	     spUserDataMsg = spUserDataMsg->spNext)
+		if (!spUserDataMsg->bIsSubmitted && spUserDataMsg->u8Attr.agg)
+			break;
+
+	if (spUserDataMsg == NULL) {
+		MCU_TIM_SRV_stop(&sTxAgg.sFlushTim);
+		sTxAgg.bIsFlush = false;
+	} else if (!MCU_TIM_SRV_isRunning(&sTxAgg.sFlushTim)) {
+		MCU_TIM_SRV_create(&sTxAgg.sFlushTim, vMGR_AT_CMD_aggFlushCb, NULL);
+		MCU_TIM_SRV_start(&sTxAgg.sFlushTim, MGR_AT_CMD_AGG_LATENCY_MS, 0);
+	}
+}
+
+/** @brief Submit to MAC layer the fifo messages not submitted yet
+ *
+ * Messages are submitted in fifo order, i.e. as per TX scheduling policy, up to
+ * MGR_AT_CMD_MAC_TX_WINDOW frames at once. MAC queue is short too, messages which do not fit are
+ * submitted later, as previous ones complete.
+ *
+ * Messages to be aggregated are submitted once their container is full, or upon flush request of
+ * the latency timer. Until then, they stay in backlog.
+ */
+static void vMGR_AT_CMD_submitMacTxBacklog(void)
+{
+	struct sUserDataTxFifoElt_t *spUserDataMsg;
+	uint16_t au16Handle[USERDATA_TX_FIFO_SIZE];
+	uint16_t u16RecordNb;
+	bool bIsAggWaiting = false;
+	bool bIsFull;
+
+	USERDATA_txFifoAge();
+
+	for (spUserDataMsg = USERDATA_txFifoGetFirst(); spUserDataMsg != NULL;
+	     spUserDataMsg = spUserDataMsg->spNext) {
+		if (spUserDataMsg->bIsSubmitted || (bIsAggWaiting && spUserDataMsg->u8Attr.agg))
+			continue;
+		/** fifo is sorted by class, no more emergency message after this one */
+		if ((sMacTxPending.u16FrameNb >= MGR_AT_CMD_MAC_TX_WINDOW) &&
+		    (spUserDataMsg->u8TxClass != USERDATA_TX_CLASS_EMERGENCY))
+			break;
+		u16RecordNb = u16MGR_AT_CMD_selectMacTxFrame(spUserDataMsg, au16Handle, &bIsFull);
+		if (!bIsFull && !sTxAgg.bIsFlush) {
+			bIsAggWaiting = true;
+			continue;
+		}
+		if (eMGR_AT_CMD_submitMacTxFrame(au16Handle, u16RecordNb, true) != KNS_STATUS_OK)
+			break;
+		MGR_LOG_DEBUG("MGR_AT_CMD: TX backlog: message %u submitted (%u records)\r\n",
+			spUserDataMsg->u16Handle, u16RecordNb);
+	}
+	/** whole fifo was gone through, only messages waiting for aggregation are left */
+	if (spUserDataMsg == NULL)
+		sMacTxPending.bIsBacklog = bIsAggWaiting;
+
+	vMGR_AT_CMD_updateAggTimer();
+}
+
+/** @brief Free a MAC frame and forget it was submitted to MAC layer
+ *
+ * @param[in] spUserDataMsg pointer to USERDATA element, first record of the frame
+ */
+static void vMGR_AT_CMD_releaseMacTxMsg(struct sUserDataTxFifoElt_t *spUserDataMsg)
+{
+	struct sUserDataTxFifoElt_t *spRecord;
+	uint16_t u16RecordNb;
+	uint16_t idx;
+
+	idx = u16MGR_AT_CMD_getMacTxFrameIdx(spUserDataMsg);
+	if (idx < sMacTxPending.u16Count) {
+		u16RecordNb = u16MGR_AT_CMD_getMacTxFrameLen(idx);
+		/** first record is removed last, as caller still refers to it */
+		while (--u16RecordNb > 0) {
+			spRecord = USERDATA_txFifoGetEltByHandle(
+				sMacTxPending.au16Handle[idx + u16RecordNb]);
+			if (spRecord != NULL)
+				USERDATA_txFifoRemoveElt(spRecord);
+		}
+		u16RecordNb = u16MGR_AT_CMD_getMacTxFrameLen(idx);
+		sMacTxPending.u16Count -= u16RecordNb;
+		sMacTxPending.u16FrameNb--;
+		for (; idx < sMacTxPending.u16Count; idx++) {
+			sMacTxPending.au16Handle[idx] = sMacTxPending.au16Handle[idx + u16RecordNb];
+			sMacTxPending.abIsFrameNext[idx] =
+				sMacTxPending.abIsFrameNext[idx + u16RecordNb];
+		}
+	}
+	USERDATA_txFifoRemoveElt(spUserDataMsg);
+
+	/** room in MAC queue for messages not submitted yet */
+	if (sMacTxPending.bIsBacklog)
+		vMGR_AT_CMD_submitMacTxBacklog();
+}
+
+/** @brief Report completion of each record of a MAC frame to host, then free the frame
+ *
+ * @param[in] eRsp AT cmd response reported for each record
+ * @param[in] spUserDataMsg pointer to USERDATA element, first record of the frame
+ */
+static void vMGR_AT_CMD_completeMacTxMsg(enum atcmd_rsp_type_t eRsp,
+	struct sUserDataTxFifoElt_t *spUserDataMsg)
+{
+	struct sUserDataTxFifoElt_t *spRecord;
+	uint16_t u16RecordNb = 1;
+	uint16_t idx;
+	uint16_t u16Idx;
+
+	idx = u16MGR_AT_CMD_getMacTxFrameIdx(spUserDataMsg);
+	if (idx < sMacTxPending.u16Count)
+		u16RecordNb = u16MGR_AT_CMD_getMacTxFrameLen(idx);
+
+	bMGR_AT_CMD_sendResponse(eRsp, (void *)spUserDataMsg);
+	for (u16Idx = 1; u16Idx < u16RecordNb; u16Idx++) {
+		spRecord = USERDATA_txFifoGetEltByHandle(sMacTxPending.au16Handle[idx + u16Idx]);
+		if (spRecord != NULL)
+			bMGR_AT_CMD_sendResponse(eRsp, (void *)spRecord);
+	}
+
+	vMGR_AT_CMD_releaseMacTxMsg(spUserDataMsg);/* Free as host notified */
+}
+
 /** @brief  Set/clear a GPIO around transmission
  *
  * @note It is assumed a GPIO named LED1 is defined. Compile with USE_TX_LED to call STM32 HAL APIs
@@ -108,7 +614,7 @@ static enum ERROR_RETURN_T convKnsStatusToAtErr(enum KNS_status_t knsStatus)
 
 /** @brief Handle new TX data, this is the core function of AT+TX cmd
  *
- * @attention This fct assumes user data set by user is multiple of 8 bits.
+ * Expected format is `AT+TX=<data>[,0x<attribute>]`.
  *
  * This fct is sensible from security point of view, as it is USER entry. It should be robust to
  * overflow.
@@ -120,159 +626,210 @@ static enum ERROR_RETURN_T convKnsStatusToAtErr(enum KNS_status_t knsStatus)
  * Here, at AT cmd and USERDATA level, it only checks incoming data is not exceeding the USERDATA
  * buffer size.
  *
+ * User data are decoded once, in place in the AT cmd string, the decoder stopping on the first
+ * character which is not an hexadecimal digit. The command is then fully checked, and decoded
+ * data are copied into a USERDATA data block sized for them.
+ *
  * @param[in] pu8_cmdParamString: string containing AT command
- * @param[in] pcAtCmdPattern: AT command pattern to parse
+ * @param[in] u16_maxCharNb: maximum number of hexadecimal characters accepted as user data
  *
  * @return true if data is correctly processed, else otherwise
  */
-static bool bMGR_AT_CMD_handleNewTxData(uint8_t *pu8_cmdParamString, const char *pcAtCmdPattern)
+static bool bMGR_AT_CMD_handleNewTxData(uint8_t *pu8_cmdParamString, uint16_t u16_maxCharNb)
 {
 	enum KNS_status_t status = KNS_STATUS_OK;
 	struct sUserDataTxFifoElt_t *spUserDataMsg;
+	struct sUserDataTxFifoElt_t *spDroppedMsg;
 	union sUserDataAttribute_t u8UserDataAttr;
-	uint8_t *pu8UserDataBuf;
-	int16_t i16_scan_param_res;
+	uint8_t *pu8UserDataStr;
+	uint8_t *pu8UserDataEnd;
+	uint16_t u16UserDataAttr;
 	uint16_t u16UserDataCharNb;
 	uint16_t u16UserDataBitlen;
-	uint16_t idx;
 
-//	enum KNS_status_t knsStatus;
-	struct KNS_MAC_appEvt_t appEvt = {
-		.id = KNS_MAC_SEND_DATA,
-		.data_ctxt = {
-			.usrdata = {0},
-			.usrdata_bitlen = 0,      /* to be filled-up later below */
-			.sf = KNS_SF_NO_SERVICE,
-		}
-	};
+	/** USERDATA must be able to store the longest user data once decoded */
+	kns_assert(((u16_maxCharNb + 1) / 2) <= USERDATA_TX_DATAFIELD_SIZE);
 
-	spUserDataMsg = USERDATA_txFifoReserveElt();
-	if (spUserDataMsg != NULL) {
+	pu8UserDataStr = (uint8_t *)strchr((const char *)pu8_cmdParamString, '=');
+	if (pu8UserDataStr == NULL) {
+		MGR_LOG_VERBOSE("[ERROR] AT+TX command is badly formatted\r\n");
+		return bMGR_AT_CMD_logFailedMsg(ERROR_MISSING_PARAMETERS);
+	}
+	pu8UserDataStr++;
 
-		for (idx = 0; idx < sizeof(spUserDataMsg->u8DataBuf); idx++)
-			spUserDataMsg->u8DataBuf[idx] = 0;
-		pu8UserDataBuf =  spUserDataMsg->u8DataBuf;
-		kns_assert(pu8UserDataBuf != NULL);
+	/** Decode USER DATA in place, one more character than allowed is enough to detect overflow.
+	 * Decoded data never overwrite the characters following the hexadecimal digits.
+	 */
+	u16UserDataCharNb = u16UTIL_convertAsciiToHex(pu8UserDataStr, pu8UserDataStr,
+		u16_maxCharNb + 1);
+	pu8UserDataEnd = pu8UserDataStr + u16UserDataCharNb;
+	MGR_LOG_VERBOSE("[%s %d] %d\r\n", __func__, __LINE__, u16UserDataCharNb);
 
+	/** Case ARGOS Message without user data */
+	if (u16UserDataCharNb == 0) {
+		MGR_LOG_VERBOSE("[ERROR] AT+TX command is badly formatted\r\n");
+		return bMGR_AT_CMD_logFailedMsg(ERROR_MISSING_PARAMETERS);
+	}
 
-		/** Extract USER DATA from pu8_cmdParamString */
-		i16_scan_param_res = sscanf((const char *)pu8_cmdParamString, pcAtCmdPattern,
-					    pu8UserDataBuf,
-					    &u8UserDataAttr.u8_raw);
-		u16UserDataCharNb = strlen((const char *)pu8UserDataBuf);
-		MGR_LOG_VERBOSE("[%s %d] %d %d\r\n", __func__, __LINE__, i16_scan_param_res, u16UserDataCharNb);
+	/** More hexadecimal characters than allowed */
+	if (u16UserDataCharNb > u16_maxCharNb) {
+		MGR_LOG_VERBOSE("[ERROR] User data is badly formatted (check length)\r\n");
+		return bMGR_AT_CMD_logFailedMsg(ERROR_INVALID_USER_DATA_LENGTH);
+	}
 
-		/** Assert when the number of characters received from AT command is bigger than
-		 * authorized
-		 */
-		kns_assert(u16UserDataCharNb <= (USERDATA_TX_PAYLOAD_MAX_SIZE -1 ));
+	/** Case ARGOS Message with user data + optional attribute */
+	u8UserDataAttr.u8_raw = 0x0; /* default attribute to data, no service */
+	switch (*pu8UserDataEnd) {
+	case ',':
+		if (sscanf((const char *)pu8UserDataEnd, ",0x%hX", &u16UserDataAttr) != 1) {
+			MGR_LOG_VERBOSE("[ERROR] AT+TX command is badly formatted\r\n");
+			return bMGR_AT_CMD_logFailedMsg(ERROR_PARAMETER_FORMAT);
+		}
+		u8UserDataAttr.u8_raw = (uint8_t)u16UserDataAttr;
+	break;
+	case '\r':
+	case '\n':
+	case '\0':
+	break;
+	default:
+		/** User data ended by some non-hexadecimal character */
+		MGR_LOG_VERBOSE("[ERROR] User data is badly formatted (not hexadecimal)\r\n");
+		return bMGR_AT_CMD_logFailedMsg(ERROR_PARAMETER_FORMAT);
+	break;
+	}
 
-		switch (i16_scan_param_res) {
-		case 1:/** Case ARGOS Message with user data only */
-			u8UserDataAttr.u8_raw = 0x0; /* default attribute to data, no service */
-		case 2:/** Case ARGOS Message with user data + optional attribute:
-			 * User data should be converted form string format to Hex format
-			 */
-			u16UserDataBitlen = u16MGR_AT_CMD_convertAsciiBinary(pu8UserDataBuf,
-									     u16UserDataCharNb);
-			if (u16UserDataBitlen <= (USERDATA_TX_DATAFIELD_SIZE * 8)) {
-				spUserDataMsg->u16DataBitLen = u16UserDataBitlen;
-				spUserDataMsg->u8Attr = u8UserDataAttr;
-				kns_assert(USERDATA_txFifoAddElt(spUserDataMsg, true));
-
-				for (idx = 0; idx < sizeof(appEvt.data_ctxt.usrdata); idx++)
-					appEvt.data_ctxt.usrdata[idx] =
-						spUserDataMsg->u8DataBuf[idx];
-				appEvt.data_ctxt.usrdata_bitlen = spUserDataMsg->u16DataBitLen;
-				appEvt.data_ctxt.sf =
-					(enum KNS_serviceFlag_t)(spUserDataMsg->u8Attr.sf);
-
-				/** @note appEvt.send_ctxt already filled-up at declaration */
-				appEvt.id = KNS_MAC_SEND_DATA;
-				status = KNS_Q_push(KNS_Q_DL_APP2MAC, (void *)&appEvt);
-				switch (status) {
-				case KNS_STATUS_QFULL:
-					return bMGR_AT_CMD_logFailedMsg(ERROR_DATA_QUEUE_FULL);
-				break;
-				default:
-					return bMGR_AT_CMD_logFailedMsg(ERROR_UNKNOWN);
-				break;
-				case KNS_STATUS_OK:
-					return true;
-				break;
-				}
-			}
-			MGR_LOG_VERBOSE("[ERROR] User data is badly formatted (check length)\r\n");
+	/** Message to be aggregated: services (ACK, mail) are per MAC frame, not per record, and
+	 * record shall fit in a container
+	 */
+	if (u8UserDataAttr.agg) {
+		if (u8UserDataAttr.sf != ATTR_NONE) {
+			MGR_LOG_VERBOSE("[ERROR] Aggregation is not compatible with services\r\n");
+			return bMGR_AT_CMD_logFailedMsg(ERROR_INCOMPATIBLE_VALUE);
+		}
+		if (u16UserDataCharNb > MGR_AT_CMD_AGG_RECORD_MAX_CHAR_NB) {
+			MGR_LOG_VERBOSE("[ERROR] User data too long to be aggregated\r\n");
 			return bMGR_AT_CMD_logFailedMsg(ERROR_INVALID_USER_DATA_LENGTH);
-		case 0: /* Case ARGOS Message without user data */
-		default:
-			MGR_LOG_VERBOSE("[ERROR] AT+TX command is badly formatted\r\n");
-			return bMGR_AT_CMD_logFailedMsg(ERROR_MISSING_PARAMETERS);
 		}
-	} else {
+	}
+
+	u16UserDataBitlen = u16UserDataCharNb * 4;
+	if (u16UserDataBitlen > (USERDATA_TX_DATAFIELD_SIZE * 8)) {
+		MGR_LOG_VERBOSE("[ERROR] User data is badly formatted (check length)\r\n");
+		return bMGR_AT_CMD_logFailedMsg(ERROR_INVALID_USER_DATA_LENGTH);
+	}
+
+	/** Command is valid, get a data block fitting user data and decode them straight into it.
+	 * When fifo is full, scheduling policy may drop some older message in favour of this one.
+	 */
+	spUserDataMsg = USERDATA_txFifoReserveElt((u16UserDataCharNb + 1) / 2);
+	if (spUserDataMsg == NULL) {
+		spDroppedMsg = USERDATA_txFifoGetDropCandidate((u16UserDataCharNb + 1) / 2,
+			u8UserDataAttr);
+		if (spDroppedMsg != NULL) {
+			bMGR_AT_CMD_sendResponse(ATCMD_RSP_TXDROP, (void *)spDroppedMsg);
+			USERDATA_txFifoDropElt(spDroppedMsg);
+			spUserDataMsg = USERDATA_txFifoReserveElt((u16UserDataCharNb + 1) / 2);
+		}
+	}
+	if (spUserDataMsg == NULL) {
 		MGR_LOG_VERBOSE("[ERROR] TX FIFO full, cannot get extra data.\r\n");
 		return bMGR_AT_CMD_logFailedMsg(ERROR_DATA_QUEUE_FULL);
 	}
+	memcpy(spUserDataMsg->pu8DataBuf, pu8UserDataStr, (u16UserDataCharNb + 1) / 2);
+
+	spUserDataMsg->u16DataBitLen = u16UserDataBitlen;
+	spUserDataMsg->u8Attr = u8UserDataAttr;
+	kns_assert(USERDATA_txFifoAddElt(spUserDataMsg, u8UserDataAttr.backFront == 0));
+
+	/** Other messages wait for their turn, MAC window is full or message waits for
+	 * aggregation: message waits in fifo and will be submitted as per scheduling policy. AT cmd
+	 * is answered now.
+	 */
+	if (sMacTxPending.bIsBacklog || u8UserDataAttr.agg ||
+	    ((sMacTxPending.u16FrameNb >= MGR_AT_CMD_MAC_TX_WINDOW) &&
+	     (spUserDataMsg->u8TxClass != USERDATA_TX_CLASS_EMERGENCY))) {
+		sMacTxPending.bIsBacklog = true;
+		vMGR_AT_CMD_submitMacTxBacklog();
+		return bMGR_AT_CMD_sendResponse(ATCMD_RSP_TXACCEPTED, (void *)spUserDataMsg);
+	}
+
+	/** Otherwise, submit it at once, MAC layer reply is the AT cmd response */
+	status = eMGR_AT_CMD_submitMacTxFrame(&spUserDataMsg->u16Handle, 1, false);
+	switch (status) {
+	case KNS_STATUS_QFULL:
+		USERDATA_txFifoRemoveElt(spUserDataMsg);
+		return bMGR_AT_CMD_logFailedMsg(ERROR_DATA_QUEUE_FULL);
+	break;
+	default:
+		USERDATA_txFifoRemoveElt(spUserDataMsg);
+		return bMGR_AT_CMD_logFailedMsg(ERROR_UNKNOWN);
+	break;
+	case KNS_STATUS_OK:
+		return true;
+	break;
+	}
 }
 
 /* Public functions ----------------------------------------------------------*/
 
 uint16_t u16MGR_AT_CMD_convertAsciiBinary(uint8_t *pu8InputBuffer, uint16_t u16_charNb)
 {
-	uint16_t u16_index = 0;
-	uint8_t u8_high, u8_low;
-
-	for (u16_index = 0; u16_index < (u16_charNb / 2); u16_index++) {
-		u8_high = u8UTIL_convertCharToHex4bits(pu8InputBuffer[2 * u16_index]);
-		u8_low = u8UTIL_convertCharToHex4bits(pu8InputBuffer[2 * u16_index + 1]);
-		if ((u8_high != 0xFF) && (u8_low != 0xFF))
-			pu8InputBuffer[u16_index] = (u8_high << 4) | u8_low;
-		else
-			return 0;
-	}
+	uint16_t u16_index;
 
-	/** Case : characters number is an odd number */
-	if (u16_charNb % 2 != 0) {
-		u8_high = u8UTIL_convertCharToHex4bits(pu8InputBuffer[u16_charNb - 1]);
-		u8_low = 0;
-		if (u8_high != 0xFF)
-			pu8InputBuffer[u16_index++] = (u8_high << 4) | u8_low;
-		else
-			return 0;
-	}
+	if (u16UTIL_convertAsciiToHex(pu8InputBuffer, pu8InputBuffer, u16_charNb) != u16_charNb)
+		return 0;
 
 	/** Set other bytes to zero */
-	for (; u16_index < u16_charNb; u16_index++)
+	for (u16_index = (u16_charNb + 1) / 2; u16_index < u16_charNb; u16_index++)
 		pu8InputBuffer[u16_index] = 0;
 
 	/** Return data length in bits */
-	return (((u16_charNb / 2) * 8) + ((u16_charNb % 2) ? 4 : 0));
+	return u16_charNb * 4;
 }
 
 bool bMGR_AT_CMD_TX_cmd(uint8_t *pu8_cmdParamString, enum atcmd_type_t e_exec_mode)
 {
-	/** @attention pattern length below shall not be longer than the length defined by
-	 * FRAME_MAX_LEN.
-	 *
-	 * So far, here in LDA2 example; limit size to 48 chars, i.e. 24 bytes
+	/** @attention user data length below shall not be longer than the length defined by
+	 * FRAME_MAX_LEN, cf MGR_AT_CMD_TX_MAX_CHAR_NB
 	 */
-#ifdef USE_HDA4
-	static const char cAtCmdPattern[] = "AT+TX=%1265[0-9A-Fa-f],0x%hX";
-#else
-	static const char cAtCmdPattern[] = "AT+TX=%49[0-9A-Fa-f],0x%hX";
-#endif
+	static const uint16_t u16_userDataMaxCharNb = MGR_AT_CMD_TX_MAX_CHAR_NB;
 
 	if (e_exec_mode == ATCMD_STATUS_MODE) {
 		MGR_LOG_VERBOSE("[ERROR] Status mode is unauthorized for this AT cmd\r\n");
 		return bMGR_AT_CMD_logFailedMsg(ERROR_UNKNOWN_AT_CMD);
 	}
 
-	if (bMGR_AT_CMD_handleNewTxData(pu8_cmdParamString, cAtCmdPattern))
+	if (bMGR_AT_CMD_handleNewTxData(pu8_cmdParamString, u16_userDataMaxCharNb))
 		return true;
 	else
 		return false;
 }
 
+bool bMGR_AT_CMD_TXQ_cmd(uint8_t *pu8_cmdParamString __attribute__((unused)),
+	enum atcmd_type_t e_exec_mode)
+{
+	struct sUserDataTxClassStats_t sStats;
+	uint8_t u8Class;
+
+	if (e_exec_mode != ATCMD_STATUS_MODE) {
+		MGR_LOG_VERBOSE("[ERROR] Only status mode is authorized for this AT cmd\r\n");
+		return bMGR_AT_CMD_logFailedMsg(ERROR_UNKNOWN_AT_CMD);
+	}
+
+	for (u8Class = 0; u8Class < USERDATA_TX_CLASS_MAX; u8Class++) {
+		USERDATA_txFifoGetClassStats((enum eUserDataTxClass)u8Class, &sStats);
+		MCU_AT_CONSOLE_send("+TXQ=%u,%u,%u,%lu,%lu,%lu,%lu\r\n", u8Class, sStats.u16Count,
+			sStats.u16MaxCount, sStats.u32AddNb, sStats.u32RemoveNb, sStats.u32DropNb,
+			sStats.u32PromoteNb);
+	}
+	MCU_AT_CONSOLE_send("+TXQ=MAC,%u,%u\r\n", sMacTxPending.u16FrameNb,
+		MGR_AT_CMD_MAC_TX_WINDOW);
+	MCU_AT_CONSOLE_send("+TXQ=AGG,%lu,%lu\r\n", sMacTxPending.u32AggFrameNb,
+		sMacTxPending.u32AggRecordNb);
+
+	return true;
+}
+
 #ifdef USE_RX_STACK
 bool bMGR_AT_CMD_RX_cmd(uint8_t *pu8_cmdParamString, enum atcmd_type_t e_exec_mode)
 {
@@ -339,46 +896,41 @@ bool bMGR_AT_CMD_RX_cmd(uint8_t *pu8_cmdParamString, enum atcmd_type_t e_exec_mo
 enum KNS_status_t MGR_AT_CMD_macEvtProcess(void)
 {
 	enum KNS_status_t cbStatus;
-	struct KNS_MAC_srvcEvt_t srvcEvt;
+	struct KNS_MAC_srvcEvt_t *srvcEvt;
 	struct sUserDataTxFifoElt_t *spUserDataMsg = USERDATA_txFifoGetFirst();
+	uint16_t u16MacRspHandle;
+	bool bIsMacRspSilent;
 
-	cbStatus = KNS_Q_pop(KNS_Q_UL_MAC2APP, (void *)&srvcEvt);
+	/** Event is processed in place, in queue storage, then released at the end */
+	cbStatus = KNS_Q_peek(KNS_Q_UL_MAC2APP, (void **)&srvcEvt);
 
 	if (cbStatus != KNS_STATUS_OK)
 		return cbStatus;
 
 	/** get pointer to user data FIFO element when possible */
-	switch (srvcEvt.id) {
+	switch (srvcEvt->id) {
 	case (KNS_MAC_TX_DONE):
 	case (KNS_MAC_TXACK_DONE):
 	case (KNS_MAC_TX_TIMEOUT):
 	case (KNS_MAC_TXACK_TIMEOUT):
 	case (KNS_MAC_RX_ERROR):
 	case (KNS_MAC_RX_TIMEOUT):
-		spUserDataMsg = USERDATA_txFifoFindPayload(srvcEvt.tx_ctxt.data,
-			srvcEvt.tx_ctxt.data_bitlen);
+		spUserDataMsg = spMGR_AT_CMD_getMacTxMsg(&srvcEvt->tx_ctxt);
 		kns_assert(spUserDataMsg != NULL);
 	break;
-	case (KNS_MAC_ERROR):
-		if (srvcEvt.app_evt == KNS_MAC_SEND_DATA) {
-			spUserDataMsg = USERDATA_txFifoFindPayload(srvcEvt.tx_ctxt.data,
-				srvcEvt.tx_ctxt.data_bitlen);
-			kns_assert(spUserDataMsg != NULL);
-		}
-	break;
 	default:
 	break;
 	}
 
 	/** process event */
-	switch (srvcEvt.id) {
+	switch (srvcEvt->id) {
 	case (KNS_MAC_TX_DONE):
 //		MGR_LOG_DEBUG("MGR_AT_CMD TX_DONE callback reached\r\n");
 //		MGR_LOG_DEBUG("TX DONE for usrdata (%d bits = %d bytes + %d bits): 0x",
-//			srvcEvt.tx_ctxt.data_bitlen,
-//			srvcEvt.tx_ctxt.data_bitlen>>3,
-//			srvcEvt.tx_ctxt.data_bitlen&0x07);
-//		MGR_LOG_array(srvcEvt.tx_ctxt.data, (srvcEvt.tx_ctxt.data_bitlen+7)>>3);
+//			srvcEvt->tx_ctxt.data_bitlen,
+//			srvcEvt->tx_ctxt.data_bitlen>>3,
+//			srvcEvt->tx_ctxt.data_bitlen&0x07);
+//		MGR_LOG_array(srvcEvt->tx_ctxt.data, (srvcEvt->tx_ctxt.data_bitlen+7)>>3);
 		kns_assert(spUserDataMsg->bIsToBeTransmit);
 		/** Upon TX done of a mail request message, it means some DL_BC was received
 		 * Thus, UL ACK of DL_BC will transmitted by lower layer internally just
@@ -389,15 +941,11 @@ enum KNS_status_t MGR_AT_CMD_macEvtProcess(void)
 		if (spUserDataMsg->u8Attr.sf == ATTR_MAIL_REQUEST) {
 			Set_TX_LED(0);
 		} else {
-			/** @todo Should check integrity between data reported by event
-			 * above and the one stored in user data buffer
-			 *
-			 * So far, as only one user data, consider this is the correct one:
+			/** Element was matched against data reported by event above:
 			 * * notify host with AT cmd response then
 			 * * free element from user data buffer.
 			 */
-			bMGR_AT_CMD_sendResponse(ATCMD_RSP_TXOK, (void *)spUserDataMsg);
-			USERDATA_txFifoRemoveElt(spUserDataMsg);/* Free as host notified */
+			vMGR_AT_CMD_completeMacTxMsg(ATCMD_RSP_TXOK, spUserDataMsg);
 			Set_TX_LED(0);
 		}
 		cbStatus = KNS_STATUS_OK;
@@ -415,27 +963,23 @@ enum KNS_status_t MGR_AT_CMD_macEvtProcess(void)
 		else
 			bMGR_AT_CMD_sendResponse(ATCMD_RSP_TXACKOK, NULL);
 
-		USERDATA_txFifoRemoveElt(spUserDataMsg);/* Free as host notified */
+		vMGR_AT_CMD_releaseMacTxMsg(spUserDataMsg);/* Free as host notified */
 		Set_TX_LED(0);
 		cbStatus = KNS_STATUS_OK;
 	break;
 	case (KNS_MAC_TX_TIMEOUT):
 //		MGR_LOG_DEBUG("MGR_AT_CMD TX_TIMEOUT callback reached\r\n");
 //		MGR_LOG_DEBUG("TX TIMEOUT for usrdata (%d bits = %d bytes + %d bits): 0X",
-//			srvcEvt.tx_ctxt.data_bitlen,
-//			srvcEvt.tx_ctxt.data_bitlen>>3,
-//			srvcEvt.tx_ctxt.data_bitlen&0x07);
-//		MGR_LOG_array(srvcEvt.tx_ctxt.data, (srvcEvt.tx_ctxt.data_bitlen+7)>>3);
+//			srvcEvt->tx_ctxt.data_bitlen,
+//			srvcEvt->tx_ctxt.data_bitlen>>3,
+//			srvcEvt->tx_ctxt.data_bitlen&0x07);
+//		MGR_LOG_array(srvcEvt->tx_ctxt.data, (srvcEvt->tx_ctxt.data_bitlen+7)>>3);
 		kns_assert(spUserDataMsg->bIsToBeTransmit);
-		/** @todo Should check integrity between data reported by event above and
-		 * the one stored in user data buffer
-		 *
-		 * So far, as only one user data, consider this is the correct one:
+		/** Element was matched against data reported by event above:
 		 * * notify host with AT cmd response then
 		 * * free element from user data buffer.
 		 */
-		bMGR_AT_CMD_sendResponse(ATCMD_RSP_TXNOTOK, (void *)spUserDataMsg);
-		USERDATA_txFifoRemoveElt(spUserDataMsg);/* Free as host notified */
+		vMGR_AT_CMD_completeMacTxMsg(ATCMD_RSP_TXNOTOK, spUserDataMsg);
 		Set_TX_LED(0);
 		cbStatus = KNS_STATUS_TIMEOUT;
 	break;
@@ -443,7 +987,7 @@ enum KNS_status_t MGR_AT_CMD_macEvtProcess(void)
 //		MGR_LOG_DEBUG("MGR_AT_CMD TXACK_TIMEOUT callback reached\r\n");
 		kns_assert(spUserDataMsg->bIsToBeTransmit);
 		bMGR_AT_CMD_sendResponse(ATCMD_RSP_TXACKNOTOK, NULL);
-		USERDATA_txFifoRemoveElt(spUserDataMsg);/* Free as host notified */
+		vMGR_AT_CMD_releaseMacTxMsg(spUserDataMsg);/* Free as host notified */
 		Set_TX_LED(0);
 		cbStatus = KNS_STATUS_TIMEOUT;
 	break;
@@ -451,20 +995,16 @@ enum KNS_status_t MGR_AT_CMD_macEvtProcess(void)
 //		MGR_LOG_DEBUG("MGR_AT_CMD TX callback reached\r\n");
 		if (spUserDataMsg->bIsToBeTransmit) {
 //			MGR_LOG_DEBUG("RX enable ERROR (%d bits = %d bytes + %d bits): 0x",
-//				srvcEvt.tx_ctxt.data_bitlen,
-//				srvcEvt.tx_ctxt.data_bitlen>>3,
-//				srvcEvt.tx_ctxt.data_bitlen&0x07);
-//			MGR_LOG_array(srvcEvt.tx_ctxt.data,
-//				(srvcEvt.tx_ctxt.data_bitlen+7)>>3);
-			/** @todo Should check integrity between data reported by event
-			 * above and the one stored in user data buffer
-			 *
-			 * So far, as only one user data, consider this is the correct one:
+//				srvcEvt->tx_ctxt.data_bitlen,
+//				srvcEvt->tx_ctxt.data_bitlen>>3,
+//				srvcEvt->tx_ctxt.data_bitlen&0x07);
+//			MGR_LOG_array(srvcEvt->tx_ctxt.data,
+//				(srvcEvt->tx_ctxt.data_bitlen+7)>>3);
+			/** Element was matched against data reported by event above:
 			 * * notify host with AT cmd response then
 			 * * free element from user data buffer.
 			 */
-			bMGR_AT_CMD_sendResponse(ATCMD_RSP_TXNOTOK, (void *)spUserDataMsg);
-			USERDATA_txFifoRemoveElt(spUserDataMsg);/* Free as host notified */
+			vMGR_AT_CMD_completeMacTxMsg(ATCMD_RSP_TXNOTOK, spUserDataMsg);
 			Set_TX_LED(0);
 			cbStatus = KNS_STATUS_TR_ERR;
 		} else {
@@ -481,19 +1021,15 @@ enum KNS_status_t MGR_AT_CMD_macEvtProcess(void)
 		 */
 //		MGR_LOG_DEBUG("MGR_AT_CMD RX timeout callback reached\r\n");
 //		MGR_LOG_DEBUG("ERROR: no DL frm for (%d bits = %d bytes + %d bits): 0x",
-//			srvcEvt.tx_ctxt.data_bitlen,
-//			srvcEvt.tx_ctxt.data_bitlen>>3,
-//			srvcEvt.tx_ctxt.data_bitlen&0x07);
-//		MGR_LOG_array(srvcEvt.tx_ctxt.data, (srvcEvt.tx_ctxt.data_bitlen+7)>>3);
-		/** @todo Should check integrity between data reported by event above and
-		 * the one stored in user data buffer
-		 *
-		 * So far, as only one user data, consider this is the correct one:
+//			srvcEvt->tx_ctxt.data_bitlen,
+//			srvcEvt->tx_ctxt.data_bitlen>>3,
+//			srvcEvt->tx_ctxt.data_bitlen&0x07);
+//		MGR_LOG_array(srvcEvt->tx_ctxt.data, (srvcEvt->tx_ctxt.data_bitlen+7)>>3);
+		/** Element was matched against data reported by event above:
 		 * * notify host with AT cmd response then
 		 * * free element from user data buffer.
 		 */
-		bMGR_AT_CMD_sendResponse(ATCMD_RSP_RXTIMEOUT, (void *)spUserDataMsg);
-		USERDATA_txFifoRemoveElt(spUserDataMsg);/* Free as host notified */
+		vMGR_AT_CMD_completeMacTxMsg(ATCMD_RSP_RXTIMEOUT, spUserDataMsg);
 		Set_TX_LED(0);
 		cbStatus = KNS_STATUS_TIMEOUT;
 	break;
@@ -502,10 +1038,10 @@ enum KNS_status_t MGR_AT_CMD_macEvtProcess(void)
 	case (KNS_MAC_DL_BC):
 //		MGR_LOG_DEBUG("MGR_AT_CMD DL callback reached\r\n");
 //		MGR_LOG_DEBUG("decoded msg (%d bits = %d bytes + %d bits): 0x",
-//			srvcEvt.rx_ctxt.data_bitlen,
-//			srvcEvt.rx_ctxt.data_bitlen>>3,
-//			srvcEvt.rx_ctxt.data_bitlen&0x07);
-//		MGR_LOG_array(srvcEvt.rx_ctxt.data, (srvcEvt.rx_ctxt.data_bitlen+7)>>3);
+//			srvcEvt->rx_ctxt.data_bitlen,
+//			srvcEvt->rx_ctxt.data_bitlen>>3,
+//			srvcEvt->rx_ctxt.data_bitlen&0x07);
+//		MGR_LOG_array(srvcEvt->rx_ctxt.data, (srvcEvt->rx_ctxt.data_bitlen+7)>>3);
 		/** @todo Should check integrity between data reported by event above and
 		 * the one stored in user data buffer
 		 *
@@ -513,16 +1049,16 @@ enum KNS_status_t MGR_AT_CMD_macEvtProcess(void)
 		 * * notify host with AT cmd response then
 		 * * free element from user data buffer.
 		 */
-		bMGR_AT_CMD_sendResponse(ATCMD_RSP_DLOK, (void *)&(srvcEvt.rx_ctxt));
+		bMGR_AT_CMD_sendResponse(ATCMD_RSP_DLOK, (void *)&(srvcEvt->rx_ctxt));
 		cbStatus = KNS_STATUS_OK;
 	break;
 	case (KNS_MAC_RX_RECEIVED):
 //		MGR_LOG_DEBUG("MGR_AT_CMD RX callback reached\r\n");
 //		MGR_LOG_DEBUG("bitstream (%d bits = %d bytes + %d bits): 0x",
-//			srvcEvt.rx_ctxt.data_bitlen,
-//			srvcEvt.rx_ctxt.data_bitlen>>3,
-//			srvcEvt.rx_ctxt.data_bitlen&0x07);
-//		MGR_LOG_array(srvcEvt.rx_ctxt.data, (srvcEvt.rx_ctxt.data_bitlen+7)>>3);
+//			srvcEvt->rx_ctxt.data_bitlen,
+//			srvcEvt->rx_ctxt.data_bitlen>>3,
+//			srvcEvt->rx_ctxt.data_bitlen&0x07);
+//		MGR_LOG_array(srvcEvt->rx_ctxt.data, (srvcEvt->rx_ctxt.data_bitlen+7)>>3);
 		/** @todo Should check integrity between data reported by event above and
 		 * the one stored in user data buffer
 		 *
@@ -530,7 +1066,7 @@ enum KNS_status_t MGR_AT_CMD_macEvtProcess(void)
 		 * * notify host with AT cmd response then
 		 * * free element from user data buffer.
 		 */
-		bMGR_AT_CMD_sendResponse(ATCMD_RSP_RXOK, (void *)&(srvcEvt.rx_ctxt));
+		bMGR_AT_CMD_sendResponse(ATCMD_RSP_RXOK, (void *)&(srvcEvt->rx_ctxt));
 		cbStatus = KNS_STATUS_OK;
 	break;
 	case (KNS_MAC_SAT_DETECTED):
@@ -547,18 +1083,54 @@ enum KNS_status_t MGR_AT_CMD_macEvtProcess(void)
 #endif
 	case (KNS_MAC_OK):
 //		MGR_LOG_DEBUG("MGR_AT_CMD MAC reported OK to previous command.\r\n");
-		bMGR_AT_CMD_logSucceedMsg();
-		if (srvcEvt.app_evt == KNS_MAC_SEND_DATA)
+		if (srvcEvt->app_evt == KNS_MAC_SEND_DATA) {
+			if (!bMGR_AT_CMD_isMacRspSilent(&u16MacRspHandle))
+				bMGR_AT_CMD_sendResponse(ATCMD_RSP_TXACCEPTED,
+					USERDATA_txFifoGetEltByHandle(u16MacRspHandle));
 			Set_TX_LED(1);
-		if (srvcEvt.app_evt == KNS_MAC_STOP_SEND_DATA)
+		} else {
+			bMGR_AT_CMD_logSucceedMsg();
+		}
+		if (srvcEvt->app_evt == KNS_MAC_STOP_SEND_DATA) {
 			kns_assert(USERDATA_txFifoFlush() == true);
+			sMacTxPending.u16Count = 0;
+			sMacTxPending.u16FrameNb = 0;
+			sMacTxPending.bIsBacklog = false;
+			/** MAC dropped its queue, no more reply awaited for flushed frames. Kept
+			 * in retention RAM, stale entries would be consumed by next SEND_DATA
+			 * replies.
+			 */
+			sMacTxPending.u8MacRspNb = 0;
+			sMacTxPending.u8MacRspRdIdx = 0;
+			sMacTxPending.u32MacRspSilentMap = 0;
+			vMGR_AT_CMD_updateAggTimer();
+		}
+		/** MAC profile is ready, submit messages left in fifo (e.g. recovered at boot) */
+		if (srvcEvt->app_evt == KNS_MAC_INIT) {
+			sMacTxPending.bIsBacklog = true;
+			vMGR_AT_CMD_submitMacTxBacklog();
+		}
 		cbStatus = KNS_STATUS_OK;
 	break;
 	case (KNS_MAC_ERROR):
 //		MGR_LOG_DEBUG("MGR_AT_CMD MAC reported ERROR to previous command.\r\n");
-		bMGR_AT_CMD_logFailedMsg(ERROR_UNKNOWN);
-		if (srvcEvt.app_evt == KNS_MAC_SEND_DATA)
-			USERDATA_txFifoRemoveElt(spUserDataMsg);/* Free as host notified */
+		if (srvcEvt->app_evt == KNS_MAC_SEND_DATA) {
+			/** Rejected frame is the one of the awaited reply, no payload to match
+			 * here. AT+TX already answered if message was submitted later.
+			 */
+			bIsMacRspSilent = bMGR_AT_CMD_isMacRspSilent(&u16MacRspHandle);
+			spUserDataMsg = USERDATA_txFifoGetEltByHandle(u16MacRspHandle);
+			if (!bIsMacRspSilent)
+				bMGR_AT_CMD_logFailedMsg(ERROR_UNKNOWN);
+			if (spUserDataMsg == NULL)
+				MGR_LOG_DEBUG("MAC SEND_DATA error, frame already freed\r\n");
+			else if (bIsMacRspSilent)
+				vMGR_AT_CMD_completeMacTxMsg(ATCMD_RSP_TXNOTOK, spUserDataMsg);
+			else
+				vMGR_AT_CMD_releaseMacTxMsg(spUserDataMsg);
+		} else {
+			bMGR_AT_CMD_logFailedMsg(ERROR_UNKNOWN);
+		}
 		cbStatus = KNS_STATUS_ERROR;
 	break;
 	default:
@@ -567,9 +1139,18 @@ enum KNS_status_t MGR_AT_CMD_macEvtProcess(void)
 	break;
 	}
 
+	kns_assert(KNS_Q_release(KNS_Q_UL_MAC2APP, (void *)srvcEvt) == KNS_STATUS_OK);
+
 	return cbStatus;
 }
 
+void MGR_AT_CMD_txAggProcess(void)
+{
+	/** latency timer expired, send containers even if not full */
+	if (sTxAgg.bIsFlush && sMacTxPending.bIsBacklog)
+		vMGR_AT_CMD_submitMacTxBacklog();
+}
+
 /**
  * @}
  */
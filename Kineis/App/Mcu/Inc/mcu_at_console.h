@@ -14,14 +14,36 @@
  * **Reception**
  *
  * On reception side, this wrapper should handle incoming ASCII character as a data stream.
- * The client of this wrapper should register a callback which will be invoked each time a new
- * character is received.
+ * The client of this wrapper should register a callback which will be invoked each time new
+ * characters are received.
+ *
+ * Reception interrupts only record new characters and notify the client. Characters are given to
+ * the client from task context, when it polls the console (cf \ref MCU_AT_CONSOLE_rxPoll). Thus,
+ * console interrupts do not share any data with critical sections and can run above the critical
+ * section ceiling (cf KNS_CS_PRIO_CEILING).
+ *
+ * Received characters are given in place, in the RX circular buffer of the console. Client keeps
+ * them as long as needed (e.g. until an AT cmd is decoded) then releases them. This way, no copy is
+ * needed between reception and AT cmd decoding.
+ *
+ * The STM32 implementation receives data through DMA in circular mode. Client is notified on UART
+ * IDLE line detection, on line end character match ('\n') and on DMA half/complete transfer.
+ * Reception status, such as RX buffer level and overflows, can be read through
+ * \ref MCU_AT_CONSOLE_getRxStatus.
  *
  * **Transmission**
  *
  * On transmission side, it is possible to send strings on same base as classic printf fucntion.
  * A specific API is also available to send the content of a binary buffer. It shold convert binary
  * data into ASCII printable strings.
+ *
+ * Responses made of a header, a binary buffer and a trailer (e.g. `+TX=0,<data>,<handle>\r\n`)
+ * are built in one piece through \ref MCU_AT_CONSOLE_rspStart,
+ * \ref MCU_AT_CONSOLE_rspAddDataBuf and \ref MCU_AT_CONSOLE_rspEnd, then queued as one transmission.
+ *
+ * Transmission is not blocking. Characters are queued in a TX circular buffer, drained by DMA on
+ * STM32 implementation. The caller only waits in case TX buffer is full. Before entering a low power
+ * mode, one can check all characters were sent through \ref MCU_AT_CONSOLE_isTxBusy.
  */
 
 /**
@@ -44,30 +66,88 @@ extern "C" {
 #include <stdbool.h>
 #include <stdint.h>
 
+/* Structures ----------------------------------------------------------------*/
+
+/** @brief AT CMD console reception status */
+struct MCU_AT_CONSOLE_rxStatus_t {
+	uint16_t u16_bufSize;     /**< size of RX buffer, in bytes */
+	uint16_t u16_bufLevel;    /**< number of received bytes not yet released by client */
+	uint16_t u16_bufMaxLevel; /**< highest RX buffer level reached since console start */
+	uint16_t u16_overflowCnt; /**< number of RX buffer overflows, unreleased bytes were dropped */
+	uint16_t u16_errorCnt;    /**< number of RX errors reported by the link (framing, noise...) */
+};
+
 /* Functions prototypes ------------------------------------------------------*/
 
 /** @brief Start AT CMD console for AT cmd reception
  *
- * It registers client's callback used to treat the received data stream. The callback will be
- * called each a new character is received.
+ * It registers client's callbacks used to treat the received data stream. The RX notify callback
+ * is called under interrupt context each time new characters are received. Client is then expected
+ * to call \ref MCU_AT_CONSOLE_rxPoll from task context, which invokes the RX event callback with
+ * the new characters.
  *
- * @attention This callback may be called under interrupt context. thus, it must not last too long.
+ * @attention RX notify callback runs in console interrupts, above the critical section ceiling. It
+ * must not last long, nor call KNS_CS API (e.g. only set a task ready).
  *
- * The format of client's callback is:
+ * The format of client's RX event callback is:
  @verbatim
-bool (*rx_evt_cb)(uint8_t *pu8_RxBuffer, int16_t *pi16_nbRxValidChar));
+void (*rx_evt_cb)(uint8_t *pu8_RxBuffer, uint16_t u16_rxBufSize, uint16_t u16_rxIdx,
+		  uint16_t u16_nbRxChar);
  @endverbatim
- * At each received character, the callback is said to consume data, it updates the buffer pointer
- * and the number-of-valid-char reduced by what was consummed.
- * * [in/out] pu8_RxBuffer pointer to the data (update internally if some characters are consummed
- * * [in/out] pi16_nbRxValidChar number of valid/remaining char
+ * * [in] pu8_RxBuffer pointer to the RX circular buffer of the console
+ * * [in] u16_rxBufSize size of the RX circular buffer
+ * * [in] u16_rxIdx index of the first new character in RX circular buffer
+ * * [in] u16_nbRxChar number of new characters. They are contiguous in RX circular buffer.
+ *
+ * Received characters remain valid in RX circular buffer until client releases them (cf
+ * \ref MCU_AT_CONSOLE_rxRelease).
+ *
+ * The RX overflow callback is called, from \ref MCU_AT_CONSOLE_rxPoll too, when new characters
+ * overwrote unreleased ones. In such case, all unreleased characters are dropped and client must
+ * forget about them.
+ *
+ * The RX error callback is called, from \ref MCU_AT_CONSOLE_rxPoll too, when a line error (e.g.
+ * framing, noise) corrupted the line being received. Characters received before the error were
+ * given to the client just before. Client must drop the line they end with, but may keep the
+ * previous complete lines.
  *
  * @param[in] context pointer which may be usefull to configure console (e.g. UART handle)
- * @param[in] rx_evt_cb pointer to callback invoked at each RX event, i.e. at each received char
+ * @param[in] rx_evt_cb pointer to callback invoked at each RX event
+ * @param[in] rx_ovf_cb pointer to callback invoked on RX buffer overflow
+ * @param[in] rx_err_cb pointer to callback invoked on RX line error
+ * @param[in] rx_notify_cb pointer to callback invoked under interrupt when characters are received
  * @return true if console is correcly started, false otherwise.
  */
 bool MCU_AT_CONSOLE_register(void *context,
-		bool (*rx_evt_cb)(uint8_t *pu8_RxBuffer, int16_t *pi16_nbRxValidChar));
+		void (*rx_evt_cb)(uint8_t *pu8_RxBuffer, uint16_t u16_rxBufSize,
+				  uint16_t u16_rxIdx, uint16_t u16_nbRxChar),
+		void (*rx_ovf_cb)(void), void (*rx_err_cb)(void),
+		void (*rx_notify_cb)(void));
+
+/** @brief Give characters received since last call to client
+ *
+ * Client's RX event callback is invoked with new characters, or RX overflow callback in case some
+ * unreleased characters were dropped meanwhile. RX error callback is invoked in between characters
+ * received before and after a line error.
+ *
+ * @attention To be called from task context only, same one releasing characters.
+ */
+void MCU_AT_CONSOLE_rxPoll(void);
+
+/** @brief Release received characters
+ *
+ * Characters of the RX circular buffer, received before the given index, are no more needed by
+ * the client. They can be overwritten by new incoming characters.
+ *
+ * @param[in] u16_rxIdx index of the oldest character still needed by client in RX buffer
+ */
+void MCU_AT_CONSOLE_rxRelease(uint16_t u16_rxIdx);
+
+/** @brief Get AT CMD console reception status
+ *
+ * @param[out] pRxStatus pointer to status filled with current reception status
+ */
+void MCU_AT_CONSOLE_getRxStatus(struct MCU_AT_CONSOLE_rxStatus_t *pRxStatus);
 
 /** @brief Send AT CMD response to console
  *
@@ -81,6 +161,51 @@ bool MCU_AT_CONSOLE_register(void *context,
  */
 void MCU_AT_CONSOLE_send(const char *format, ...);
 
+/** @brief Queue raw characters to be sent on console
+ *
+ * Characters are copied in TX buffer then function returns, transmission is on-going in background.
+ * When TX buffer is full, this function waits for some characters to be sent. In case it is called
+ * under interrupt context (or interrupts masked), it cannot wait and characters which do not fit
+ * in TX buffer are dropped.
+ *
+ * @param[in] pu8_data pointer to characters to be sent
+ * @param[in] u16_len number of characters
+ */
+void MCU_AT_CONSOLE_write(const uint8_t *pu8_data, uint16_t u16_len);
+
+/** @brief Check whether some characters are still being sent on console
+ *
+ * @return true if TX buffer is not empty or last character is not fully sent yet, false otherwise.
+ */
+bool MCU_AT_CONSOLE_isTxBusy(void);
+
+/** @brief Start building an AT CMD response
+ *
+ * Formatted string is the beginning of the response. Nothing is sent until
+ * \ref MCU_AT_CONSOLE_rspEnd is called.
+ *
+ * @param[in] format refer to printf manual pages
+ */
+void MCU_AT_CONSOLE_rspStart(const char *format, ...);
+
+/** @brief Append content of a binary data buffer to the AT CMD response being built
+ *
+ * Binary data are converted into hexadecimal ASCII characters.
+ *
+ * @param[in] pu8_inDataBuff: pointer to data buffer
+ * @param[in] u16_dataLenBit: length of data buffer in bit
+ */
+void MCU_AT_CONSOLE_rspAddDataBuf(const uint8_t *pu8_inDataBuff, uint16_t u16_dataLenBit);
+
+/** @brief End the AT CMD response being built and send it to console
+ *
+ * Formatted string is appended at the end of the response, then the whole response is sent at
+ * once.
+ *
+ * @param[in] format refer to printf manual pages
+ */
+void MCU_AT_CONSOLE_rspEnd(const char *format, ...);
+
 /** @brief Write content of a binary data buffer as AT cmd response
  *
  * @param[in] pu8_inDataBuff: pointer to data buffer
@@ -0,0 +1,108 @@
+/* SPDX-License-Identifier: no SPDX license */
+/**
+ * @file    mcu_flash.h
+ * @author  Kinéis
+ * @brief   MCU wrapper for internal flash memory used as data storage
+ */
+
+/**
+ * @page mcu_flash_page MCU wrapper: FLASH storage
+ *
+ * This wrapper gives access to an area of the internal flash memory reserved to store application
+ * data, such as the USERDATA TX journal (\ref user_data_journal_page). The area is made of pages
+ * which are erased as a whole. Once erased, a page is programmed by units of
+ * \ref MCU_FLASH_PROG_UNIT bytes, each unit being programmed only once before next erase.
+ *
+ * On STM32WL, the flash is protected by ECC. Reading a unit whose programming was interrupted (e.g.
+ * power loss) may raise a double ECC error, reported through NMI. Reads done through
+ * \ref MCU_FLASH_read are guarded: NMI handler calls \ref MCU_FLASH_nmiHandler which acknowledges
+ * the error, and the read returns false instead of ending in a fault.
+ *
+ * @attention Code runs from the same flash bank: CPU (interrupts included) is stalled during
+ * programming (~100 us per unit) and page erase (~22 ms).
+ */
+
+/**
+ * @addtogroup MCU_APP_WRAPPERS
+ * @{
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MCU_FLASH_H
+#define __MCU_FLASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+/** Size of an erasable page in bytes */
+#define MCU_FLASH_PAGE_SIZE	2048
+
+/** Programming unit in bytes, address and length of programmed data are aligned on it */
+#define MCU_FLASH_PROG_UNIT	8
+
+/* Functions -----------------------------------------------------------------*/
+
+/**
+ * @brief Get flash area reserved to the USERDATA journal
+ *
+ * @param[out] pu32_addr: start address of the area, aligned on a page
+ * @param[out] pu32_size: size of the area in bytes, multiple of page size
+ */
+void MCU_FLASH_getJournalArea(uint32_t *pu32_addr, uint32_t *pu32_size);
+
+/**
+ * @brief Erase one page
+ *
+ * @param[in] u32_addr: start address of the page
+ *
+ * @return true if success, false otherwise
+ */
+bool MCU_FLASH_erasePage(uint32_t u32_addr);
+
+/**
+ * @brief Program data into erased flash
+ *
+ * @param[in] u32_addr: destination address, aligned on MCU_FLASH_PROG_UNIT
+ * @param[in] p_data: data to program
+ * @param[in] u16_len: number of bytes to program, multiple of MCU_FLASH_PROG_UNIT
+ *
+ * @return true if success, false otherwise
+ */
+bool MCU_FLASH_program(uint32_t u32_addr, const void *p_data, uint16_t u16_len);
+
+/**
+ * @brief Read data from flash, robust to ECC errors
+ *
+ * @param[in] u32_addr: source address
+ * @param[out] p_data: destination buffer
+ * @param[in] u16_len: number of bytes to read
+ *
+ * @return true if success, false if some ECC error was detected (data are not reliable)
+ */
+bool MCU_FLASH_read(uint32_t u32_addr, void *p_data, uint16_t u16_len);
+
+/**
+ * @brief Check NMI is due to an ECC error during a flash read of this wrapper
+ *
+ * To be called first in NMI handler.
+ *
+ * @return true if NMI was handled (caller returns from NMI), false otherwise
+ */
+bool MCU_FLASH_nmiHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MCU_FLASH_H */
+
+/**
+ * @}
+ */
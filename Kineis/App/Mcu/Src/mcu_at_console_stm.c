@@ -21,16 +21,14 @@
 #include <stdarg.h>
 #include <string.h>
 #include <stdio.h>
+#include "mcu_at_console.h"
 #include "kns_app_conf.h" // for STM32 HAL include on UART
 #include STM32_HAL_H
 #include "kineis_sw_conf.h" // for assert include below
 #include KINEIS_SW_ASSERT_H
+#include "strutil_lib.h"
 
 /* Defines -------------------------------------------------------------------*/
-#if defined(STM32WLE5xx) || defined(STM32WL55xx)
-#define USART_ISR_RXNE USART_ISR_RXNE_RXFNE
-#endif
-
 #ifdef USE_HDA4
 #define TXBUF_SIZE 2560
 #define RXBUF_SIZE 2560
@@ -39,13 +37,31 @@
 #define RXBUF_SIZE 256
 #endif
 
+#define RX_LINE_END_CHAR '\n'
+
 /* Variables -----------------------------------------------------------------*/
 
 static UART_HandleTypeDef *huart_handle; /** This AT console needs some UART link */
-static char uartTxBuf[TXBUF_SIZE];
-static uint8_t uartRxBuf[RXBUF_SIZE];
-
-static bool (*rxEvtCb)(uint8_t *pu8_RxBuffer, int16_t *pi16_nbRxValidChar);
+static char uartTxBuf[TXBUF_SIZE]; /**< staging buffer used to format one response */
+static uint16_t u16_txBufLen; /**< number of characters of the response being built */
+static uint8_t uartTxRing[TXBUF_SIZE]; /**< TX circular buffer, read by DMA */
+static volatile uint16_t u16_txWrIdx; /**< next free position in TX buffer */
+static volatile uint16_t u16_txRdIdx; /**< oldest character not yet sent from TX buffer */
+static volatile uint16_t u16_txDmaLen; /**< number of characters currently sent by DMA, 0 if none */
+static uint8_t uartRxBuf[RXBUF_SIZE]; /**< RX circular buffer, written by DMA */
+static volatile uint16_t u16_rxWrIdx; /**< DMA write position at last RX event, set by ISR */
+static volatile bool bRxFlush; /**< unreleased characters were overwritten, to be dropped */
+static volatile bool bRxLineErr; /**< line error corrupted the line received before error index */
+static volatile uint16_t u16_rxErrIdx; /**< DMA write position at last line error, set by ISR */
+static uint16_t u16_rxRdIdx; /**< next character to be given to client from RX buffer */
+static volatile uint16_t u16_rxRelIdx; /**< oldest character not yet released by client */
+static struct MCU_AT_CONSOLE_rxStatus_t rxStatus;
+
+static void (*rxEvtCb)(uint8_t *pu8_RxBuffer, uint16_t u16_rxBufSize, uint16_t u16_rxIdx,
+		       uint16_t u16_nbRxChar);
+static void (*rxOvfCb)(void);
+static void (*rxErrCb)(void);
+static void (*rxNotifyCb)(void);
 
 /* Private function prototypes -----------------------------------------------*/
 
@@ -69,224 +85,484 @@ static bool (*rxEvtCb)(uint8_t *pu8_RxBuffer, int16_t *pi16_nbRxValidChar);
 //    return str;
 //}
 
-/** @brief RX interrupt handler for 7 or 8 bits data word length .
+/** @brief Get BASEPRI value masking console interrupts
  *
- * This function is highly based on STM32HAL_UART expect callback is called at each received
- * character. This allow to treat RX received characters as a continuous stream.
+ * @return console interrupts priority, in BASEPRI format
+ */
+static uint32_t MCU_AT_CONSOLE_irqBasePri(void)
+{
+	return NVIC_GetPriority(AT_CONSOLE_UART_IRQn) << (8U - __NVIC_PRIO_BITS);
+}
+
+/** @brief Mask console interrupts
  *
- * At each received character, the callback is said to consume data, it updates the buffer pointer
- * and the number-of-valid-char reduced by what was consummed.
+ * Console interrupts run above the critical section ceiling (cf KNS_CS_PRIO_CEILING). Data shared
+ * with them are thus protected by raising BASEPRI up to the console priority. Interrupts of higher
+ * priority are kept enabled.
  *
- * @note In case of overflow on RX buffer, force write from the beginning of the buffer pRxBuffPtr.
- *       thus, the entire buffer may be lost. Actually, such case may only happen in case:
- *       * user sent too much data in console, this is not an expected scenario
- *       * user has sent some garbage before its several AT cmds, leading accumuation to overflow.
- *       This is not an expected behaviour as well.
+ * @return previous BASEPRI value, to be given back to @ref MCU_AT_CONSOLE_unlock
+ */
+static uint32_t MCU_AT_CONSOLE_lock(void)
+{
+	uint32_t u32_basePri = __get_BASEPRI();
+
+	__set_BASEPRI_MAX(MCU_AT_CONSOLE_irqBasePri());
+	return u32_basePri;
+}
+
+/** @brief Unmask console interrupts
  *
- * @todo circular buffer may be implemented instead of overflowing sometimes.
+ * @param[in] u32_basePri BASEPRI value returned by @ref MCU_AT_CONSOLE_lock
+ */
+static void MCU_AT_CONSOLE_unlock(uint32_t u32_basePri)
+{
+	__set_BASEPRI(u32_basePri);
+}
+
+/** @brief Record new write position of DMA in RX circular buffer and notify client
  *
- * STM32HAL_UART base function prototype:
- @verbatim
-static void UART_RxISR_8BIT(UART_HandleTypeDef *huart)
- @endverbatim
+ * Characters are not given to client here, but later from task context (cf
+ * @ref MCU_AT_CONSOLE_rxPoll). Thus, console interrupts never wait for a critical section.
  *
- * @param huart UART handle.
- * @retval None
+ * @note DMA keeps on writing circularly whatever client released or not. In case new characters
+ *       overwrote some unreleased ones, the overflow is reported in RX status (cf
+ *       @ref MCU_AT_CONSOLE_getRxStatus) and all unreleased characters are dropped at next poll.
+ *       Such case may only happen in case user sent too much data in console while client is not
+ *       consuming.
+ *
+ * @attention This function is called under interrupt context (UART IDLE, character match, DMA
+ *            half/complete transfer). All those interrupts share the same priority level thus
+ *            cannot preempt each other. As they are raised at least twice per RX buffer round,
+ *            no more than one round can be received between two calls.
+ *
+ * @param[in] u16_wrIdx write position of DMA in the RX circular buffer
  */
-static void KINEIS_RxISR_8BIT(UART_HandleTypeDef *huart)
+static void MCU_AT_CONSOLE_rxNotify(uint16_t u16_wrIdx)
 {
-	uint16_t uhMask = huart->Mask;
-	uint16_t  uhdata;
-	uint8_t *pu8_RxBuffer = NULL;
-	int16_t i16_nbRxValidChar = 0;
-
-	i16_nbRxValidChar = huart->RxXferSize - huart->RxXferCount;
-	pu8_RxBuffer = huart->pRxBuffPtr - i16_nbRxValidChar;
-	//< pu8_RxBuffer points to the 1st element of the RX array
-
-	/* Check that a Rx process is ongoing */
-	if (huart->RxState == HAL_UART_STATE_BUSY_RX) {
-		/* consume all incomming data in same interrupt. RXNE is set by HW and cleared by
-		 * reading RDR reg
-		 */
-		while ((READ_REG(huart->Instance->ISR) & USART_ISR_RXNE) != 0U) {
-			uhdata = (uint16_t) READ_REG(huart->Instance->RDR);
-			*huart->pRxBuffPtr = (uint8_t)(uhdata & (uint8_t)uhMask);
-
-			/* In case of overflow, force writing from the beginning of the buffer
-			 */
-			if (huart->RxXferCount == 1U) {
-				huart->pRxBuffPtr = huart->pRxBuffPtr - huart->RxXferSize +
-							huart->RxXferCount;
-				huart->RxXferCount = huart->RxXferSize;
-			} else {
-				huart->pRxBuffPtr++;
-				huart->RxXferCount--;
-			}
-		}
+	uint16_t u16_nbNewChar;
+	uint16_t u16_level;
+
+	u16_wrIdx %= RXBUF_SIZE;
+	u16_nbNewChar = (u16_wrIdx + RXBUF_SIZE - u16_rxWrIdx) % RXBUF_SIZE;
+	if (u16_nbNewChar == 0)
+		return;
+
+	if (!bRxFlush) {
+		u16_level = ((u16_rxWrIdx + RXBUF_SIZE - u16_rxRelIdx) % RXBUF_SIZE) + u16_nbNewChar;
+		if (u16_level >= RXBUF_SIZE) {
+			rxStatus.u16_overflowCnt++;
+			bRxFlush = true;
+		} else if (u16_level > rxStatus.u16_bufMaxLevel)
+			rxStatus.u16_bufMaxLevel = u16_level;
+	}
+	u16_rxWrIdx = u16_wrIdx;
 
-		/* Should raise an os_event to main task/function */
-		/* \todo implement call back mechanism to raise os event instead of using
-		 * global variables directly.
-		 */
+	if (rxNotifyCb != NULL)
+		rxNotifyCb();
+}
 
-		if (rxEvtCb != NULL) {
-			i16_nbRxValidChar = huart->RxXferSize - huart->RxXferCount;
-			pu8_RxBuffer = huart->pRxBuffPtr - i16_nbRxValidChar;
-			//< pu8_RxBuffer points to the 1st element of the RX array
-			while (rxEvtCb(pu8_RxBuffer, &i16_nbRxValidChar) == true) {
-				// empty loop
-			};
-			//< realign huart to the beginning of found AT cmd
-			huart->pRxBuffPtr = pu8_RxBuffer + i16_nbRxValidChar;
-			huart->RxXferCount = huart->RxXferSize - i16_nbRxValidChar;
+/** @brief Give received characters to client, up to a given index of RX circular buffer
+ *
+ * Client's RX event callback is invoked once with contiguous characters, twice in case they wrap
+ * around the end of RX buffer.
+ *
+ * @param[in] u16_wrIdx index following the last character to be given
+ */
+static void MCU_AT_CONSOLE_rxDeliver(uint16_t u16_wrIdx)
+{
+	if (u16_wrIdx == u16_rxRdIdx)
+		return;
+
+	if (rxEvtCb != NULL) {
+		if (u16_wrIdx < u16_rxRdIdx) {
+			rxEvtCb(uartRxBuf, RXBUF_SIZE, u16_rxRdIdx, RXBUF_SIZE - u16_rxRdIdx);
+			u16_rxRdIdx = 0;
 		}
-	} else {
-		/* Clear RXNE interrupt flag */
-		__HAL_UART_SEND_REQ(huart, UART_RXDATA_FLUSH_REQUEST);
-	}
+		rxEvtCb(uartRxBuf, RXBUF_SIZE, u16_rxRdIdx, u16_wrIdx - u16_rxRdIdx);
+	} else
+		u16_rxRelIdx = u16_wrIdx;
+	u16_rxRdIdx = u16_wrIdx;
 }
 
-/** @brief Enable and start RX interrupt from UART
+/** @brief Enable and start RX DMA from UART in circular mode
  *
- * This function is highly based on STM32HAL_UART expect it called internal interrupt handler
- * instead of generic one.
+ * DMA is filling the RX circular buffer continuously. RX events are raised to
+ * @ref HAL_UARTEx_RxEventCallback on:
+ * * DMA half-transfer and transfer-complete,
+ * * UART IDLE line detection,
+ * * UART character match on line end character (served in LPUART1_IRQHandler).
+ *
+ * DMA starts writing from the beginning of RX buffer.
  *
-  @verbatim
-HAL_StatusTypeDef UART_Start_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
-HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
-  @endverbatim
  * @param huart UART handle.
- * @param pData Pointer to data buffer (u8 or u16 data elements).
- * @param Size  Amount of data elements (u8 or u16) to be received.
  * @retval HAL status
  */
-static HAL_StatusTypeDef KINEIS_UART_StartRx_IT(UART_HandleTypeDef *huart, uint8_t *pData,
-						uint16_t Size)
+static HAL_StatusTypeDef KINEIS_UART_StartRx_DMA(UART_HandleTypeDef *huart)
 {
-	if (huart ==  NULL)
-		return HAL_ERROR;
+	HAL_StatusTypeDef status;
 
-	/* Check that a Rx process is not already ongoing */
-	if (huart->RxState == HAL_UART_STATE_READY) {
-		if ((pData == NULL) || (Size == 0U))
-			return HAL_ERROR;
+	status = HAL_UARTEx_ReceiveToIdle_DMA(huart, uartRxBuf, sizeof(uartRxBuf));
+	if (status == HAL_OK)
+		__HAL_UART_ENABLE_IT(huart, UART_IT_CM);
 
-		__HAL_LOCK(huart);
+	return status;
+}
 
-		huart->pRxBuffPtr  = pData;
-		huart->RxXferSize  = Size;
-		huart->RxXferCount = Size;
-		huart->RxISR       = NULL;
+/** @brief Start DMA transfer of pending characters of the TX circular buffer, if not yet on-going
+ *
+ * Only contiguous characters are sent at once. Remaining ones (after TX buffer wrap) are sent on
+ * transfer completion (cf @ref HAL_UART_TxCpltCallback).
+ *
+ * @attention This function must be called from console interrupts, or with them masked (cf
+ *            @ref MCU_AT_CONSOLE_lock).
+ */
+static void MCU_AT_CONSOLE_txKick(void)
+{
+	uint16_t u16_len;
 
-		/* Computation of UART mask to apply to RDR register */
-		UART_MASK_COMPUTATION(huart);
+	if ((u16_txDmaLen != 0) || (u16_txWrIdx == u16_txRdIdx) || (huart_handle == NULL))
+		return;
 
-		huart->ErrorCode = HAL_UART_ERROR_NONE;
-		huart->RxState = HAL_UART_STATE_BUSY_RX;
+	if (u16_txWrIdx > u16_txRdIdx)
+		u16_len = u16_txWrIdx - u16_txRdIdx;
+	else
+		u16_len = TXBUF_SIZE - u16_txRdIdx;
 
-		/* Enable the UART Error Interrupt: (Frame error, noise error, overrun error) */
-		SET_BIT(huart->Instance->CR3, USART_CR3_EIE);
+	/** UART may be busy with some blocking transfer (e.g. logs). In such case, transfer is
+	 * started again later (cf @ref MCU_AT_CONSOLE_isTxBusy)
+	 */
+	if (HAL_UART_Transmit_DMA(huart_handle, &uartTxRing[u16_txRdIdx], u16_len) == HAL_OK)
+		u16_txDmaLen = u16_len;
+}
 
-		/* Set the Rx ISR function pointer according to the data word length */
-		if ((huart->Init.WordLength != UART_WORDLENGTH_9B) ||
-			(huart->Init.Parity != UART_PARITY_NONE)) {
-			huart->RxISR = KINEIS_RxISR_8BIT;
-		}
+/** @brief Wait for some free space in TX circular buffer
+ *
+ * When called from task context, it waits for DMA to send enough characters. When called from
+ * interrupt context or with console interrupts masked (PRIMASK, or BASEPRI at or above console
+ * priority), DMA completion cannot be served, so that no wait is done. Characters which do not fit
+ * are then dropped.
+ *
+ * @note Critical sections with a ceiling below console priority do not prevent from waiting (cf
+ *       KNS_CS_PRIO_CEILING).
+ *
+ * @param[in] u16_len number of characters to be written
+ * @return number of characters which can be written now, up to u16_len
+ */
+static uint16_t MCU_AT_CONSOLE_txWaitFreeSpace(uint16_t u16_len)
+{
+	uint16_t u16_free;
+	uint32_t u32_basePri = __get_BASEPRI();
+	bool bCanWait = (__get_IPSR() == 0U) && (__get_PRIMASK() == 0U) &&
+		((u32_basePri == 0U) || (u32_basePri > MCU_AT_CONSOLE_irqBasePri()));
+
+	do {
+		u16_free = TXBUF_SIZE - 1 - ((u16_txWrIdx + TXBUF_SIZE - u16_txRdIdx) % TXBUF_SIZE);
+		if (u16_free == 0)
+			MCU_AT_CONSOLE_isTxBusy();
+	} while ((u16_free == 0) && bCanWait);
+
+	return (u16_len < u16_free) ? u16_len : u16_free;
+}
 
-		__HAL_UNLOCK(huart);
+/** @brief Format characters at the end of the response being built in TX staging buffer
+ *
+ * @param[in] format refer to printf manual pages
+ * @param[in] args arguments list as per format
+ */
+static void MCU_AT_CONSOLE_txBufAppend(const char *format, va_list args)
+{
+	int s32_len;
 
-		/* Enable the UART Parity Error interrupt and Data Register Not Empty interrupt */
-#if defined(STM32WLE5xx) || defined(STM32WL55xx)
-		ATOMIC_SET_BIT(huart->Instance->CR1, USART_CR1_PEIE | USART_CR1_RXNEIE_RXFNEIE);
-#else
-		SET_BIT(huart->Instance->CR1, USART_CR1_PEIE | USART_CR1_RXNEIE);
-#endif
-		return HAL_OK;
-	} else {
-		return HAL_BUSY;
-	}
+	s32_len = vsnprintf(&uartTxBuf[u16_txBufLen], sizeof(uartTxBuf) - u16_txBufLen, format,
+		args);
+	/** Check buffer is not overflowed, meaning console is not well dimensionned regarding
+	 * AT cmd responses length
+	 */
+	kns_assert((s32_len >= 0) && ((uint32_t)s32_len < (sizeof(uartTxBuf) - u16_txBufLen)));
+	u16_txBufLen += (uint16_t)s32_len;
 }
 
 /* Functions -----------------------------------------------------------------*/
 
-bool MCU_AT_CONSOLE_register(void *handle, bool (*rx_evt_cb)(uint8_t *pu8_RxBuffer,
-	int16_t *pi16_nbRxValidChar))
+bool MCU_AT_CONSOLE_register(void *handle,
+	void (*rx_evt_cb)(uint8_t *pu8_RxBuffer, uint16_t u16_rxBufSize, uint16_t u16_rxIdx,
+			  uint16_t u16_nbRxChar),
+	void (*rx_ovf_cb)(void), void (*rx_err_cb)(void), void (*rx_notify_cb)(void))
 {
 	huart_handle = (UART_HandleTypeDef *)handle;
+	if ((huart_handle == NULL) || (huart_handle->hdmarx == NULL))
+		return false;
 
-	if (KINEIS_UART_StartRx_IT(huart_handle, uartRxBuf, sizeof(uartRxBuf)) == HAL_OK) {
-		rxEvtCb = rx_evt_cb;
+	/** Console interrupts are masked through BASEPRI, which cannot mask priority 0 */
+	kns_assert(NVIC_GetPriority(AT_CONSOLE_UART_IRQn) != 0);
+
+	memset(&rxStatus, 0, sizeof(rxStatus));
+	rxStatus.u16_bufSize = sizeof(uartRxBuf);
+	u16_rxWrIdx = 0;
+	u16_rxRdIdx = 0;
+	u16_rxRelIdx = 0;
+	bRxFlush = false;
+	bRxLineErr = false;
+	rxEvtCb = rx_evt_cb;
+	rxOvfCb = rx_ovf_cb;
+	rxErrCb = rx_err_cb;
+	rxNotifyCb = rx_notify_cb;
+
+	/* Character match address can only be written when UART is disabled */
+	__HAL_UART_DISABLE(huart_handle);
+	MODIFY_REG(huart_handle->Instance->CR2, USART_CR2_ADD,
+		((uint32_t)RX_LINE_END_CHAR << UART_CR2_ADDRESS_LSB_POS));
+	__HAL_UART_ENABLE(huart_handle);
+
+	if (KINEIS_UART_StartRx_DMA(huart_handle) == HAL_OK)
 		return true;
-	} else
-		return false;
+
+	rxEvtCb = NULL;
+	rxOvfCb = NULL;
+	rxErrCb = NULL;
+	rxNotifyCb = NULL;
+	return false;
+}
+
+void MCU_AT_CONSOLE_rxPoll(void)
+{
+	uint16_t u16_wrIdx;
+	uint16_t u16_errIdx;
+	uint32_t u32_basePri;
+	bool bFlush;
+	bool bLineErr;
+
+	u32_basePri = MCU_AT_CONSOLE_lock();
+	u16_wrIdx = u16_rxWrIdx;
+	u16_errIdx = u16_rxErrIdx;
+	bFlush = bRxFlush;
+	/** Flush drops all characters received up to now, including the corrupted line */
+	bLineErr = bRxLineErr && !bFlush;
+	bRxFlush = false;
+	bRxLineErr = false;
+	if (bFlush) {
+		u16_rxRdIdx = u16_wrIdx;
+		u16_rxRelIdx = u16_wrIdx;
+	}
+	MCU_AT_CONSOLE_unlock(u32_basePri);
+
+	if (bFlush && (rxOvfCb != NULL))
+		rxOvfCb();
+
+	/** Characters received before line error are given first, so that client only drops the
+	 * line they end with
+	 */
+	if (bLineErr) {
+		MCU_AT_CONSOLE_rxDeliver(u16_errIdx);
+		if (rxErrCb != NULL)
+			rxErrCb();
+	}
+
+	MCU_AT_CONSOLE_rxDeliver(u16_wrIdx);
+}
+
+void MCU_AT_CONSOLE_rxRelease(uint16_t u16_rxIdx)
+{
+	u16_rxRelIdx = u16_rxIdx % RXBUF_SIZE;
+}
+
+void MCU_AT_CONSOLE_getRxStatus(struct MCU_AT_CONSOLE_rxStatus_t *pRxStatus)
+{
+	uint32_t u32_basePri;
+
+	kns_assert(pRxStatus != NULL);
+
+	u32_basePri = MCU_AT_CONSOLE_lock();
+	*pRxStatus = rxStatus;
+	pRxStatus->u16_bufLevel = (u16_rxWrIdx + RXBUF_SIZE - u16_rxRelIdx) % RXBUF_SIZE;
+	MCU_AT_CONSOLE_unlock(u32_basePri);
 }
 
 void MCU_AT_CONSOLE_send(const char *format, ...)
 {
 	va_list args;
 
-	/* Reset output buffer */
-	memset(uartTxBuf, 0x00, sizeof(uartTxBuf));
+	u16_txBufLen = 0;
+	va_start(args, format);
+	MCU_AT_CONSOLE_txBufAppend(format, args);
+	va_end(args);
+
+	MCU_AT_CONSOLE_write((uint8_t *)uartTxBuf, u16_txBufLen);
+}
 
+void MCU_AT_CONSOLE_rspStart(const char *format, ...)
+{
+	va_list args;
+
+	u16_txBufLen = 0;
 	va_start(args, format);
-	vsprintf(uartTxBuf, format, args);
+	MCU_AT_CONSOLE_txBufAppend(format, args);
 	va_end(args);
-	/** Check buffer is not overflowed, meaning console is not well dimensionned regarding
+}
+
+void MCU_AT_CONSOLE_rspAddDataBuf(const uint8_t *pu8_inDataBuff, uint16_t u16_dataLenBit)
+{
+	/** Check response fits in buffer, meaning console is not well dimensionned regarding
 	 * AT cmd responses length
 	 */
-	kns_assert(strlen(uartTxBuf) < sizeof(uartTxBuf));
-
-	/* Send log message via UART */
-	if (huart_handle != NULL)
-		HAL_UART_Transmit(huart_handle, (uint8_t *)uartTxBuf, strlen(uartTxBuf), 500);
-	else {
-		/** Console is said to be correctly initialized before use
-		 *
+	kns_assert(((uint32_t)u16_dataLenBit + 3) / 4 < (sizeof(uartTxBuf) - u16_txBufLen));
+
+	u16_txBufLen += u16UTIL_convertHexToAscii((uint8_t *)&uartTxBuf[u16_txBufLen],
+		pu8_inDataBuff, u16_dataLenBit);
+}
+
+void MCU_AT_CONSOLE_rspEnd(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	MCU_AT_CONSOLE_txBufAppend(format, args);
+	va_end(args);
+
+	MCU_AT_CONSOLE_write((uint8_t *)uartTxBuf, u16_txBufLen);
+	u16_txBufLen = 0;
+}
+
+void MCU_AT_CONSOLE_write(const uint8_t *pu8_data, uint16_t u16_len)
+{
+	uint16_t u16_chunk;
+	uint16_t u16_wrIdx;
+	uint16_t u16_firstPart;
+	uint32_t u32_basePri;
+
+	/** Console is said to be correctly initialized before use */
+	kns_assert(huart_handle != NULL);
+
+	while (u16_len > 0) {
+		u16_chunk = MCU_AT_CONSOLE_txWaitFreeSpace(u16_len);
+		if (u16_chunk == 0)
+			break;
+		u16_len -= u16_chunk;
+
+		/** Only this function moves the write index, DMA only moves the read index. Thus,
+		 * characters can be copied before being committed to DMA with console interrupts
+		 * masked.
 		 */
-		kns_assert(0);
+		u16_wrIdx = u16_txWrIdx;
+		u16_firstPart = TXBUF_SIZE - u16_wrIdx;
+		if (u16_chunk < u16_firstPart)
+			u16_firstPart = u16_chunk;
+		memcpy(&uartTxRing[u16_wrIdx], pu8_data, u16_firstPart);
+		memcpy(uartTxRing, &pu8_data[u16_firstPart], u16_chunk - u16_firstPart);
+		pu8_data += u16_chunk;
+
+		u32_basePri = MCU_AT_CONSOLE_lock();
+		u16_txWrIdx = (u16_wrIdx + u16_chunk) % TXBUF_SIZE;
+		MCU_AT_CONSOLE_txKick();
+		MCU_AT_CONSOLE_unlock(u32_basePri);
 	}
 }
 
+bool MCU_AT_CONSOLE_isTxBusy(void)
+{
+	bool bIsBusy;
+	uint32_t u32_basePri;
+
+	u32_basePri = MCU_AT_CONSOLE_lock();
+	/** Restart transfer in case it could not be started earlier (UART was busy) */
+	MCU_AT_CONSOLE_txKick();
+	bIsBusy = (u16_txWrIdx != u16_txRdIdx);
+	MCU_AT_CONSOLE_unlock(u32_basePri);
+
+	return bIsBusy;
+}
+
 void MCU_AT_CONSOLE_send_dataBuf(uint8_t *pu8_inDataBuff, uint16_t u16_dataLenBit)
 {
-	uint16_t u16_remainingBits;
-	const uint16_t u16_dataLenByte_trunc = u16_dataLenBit >> 3;
-	uint8_t *pu8_hex;
+	u16_txBufLen = 0;
+	MCU_AT_CONSOLE_rspAddDataBuf(pu8_inDataBuff, u16_dataLenBit);
 
-	/*
-	 * Convert data hex to ascii per byte then last byte is
-	 * treated per nibble
-	 */
+	MCU_AT_CONSOLE_write((uint8_t *)uartTxBuf, u16_txBufLen);
+}
+
+/**
+ * @brief  UART RX event callback, invoked on DMA half/complete transfer and UART IDLE detection.
+ *
+ * This function overrides the generic defined one from STM32HAL_UART. It is also called from
+ * LPUART1_IRQHandler on character match.
+ *
+ * @param  huart UART handle.
+ * @param  Size position of DMA in RX circular buffer
+ * @retval None
+ */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+	if (huart == huart_handle)
+		MCU_AT_CONSOLE_rxNotify(Size);
+}
+
+/**
+ * @brief  UART TX complete callback, invoked once last character sent by DMA left the UART.
+ *
+ * This function overrides the generic defined one from STM32HAL_UART.
+ *
+ * @param  huart UART handle.
+ * @retval None
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if ((huart != huart_handle) || (u16_txDmaLen == 0))
+		return;
 
-	for (pu8_hex = pu8_inDataBuff;
-			(pu8_hex < (pu8_inDataBuff + u16_dataLenByte_trunc));
-			pu8_hex++)
-		MCU_AT_CONSOLE_send("%02X", *pu8_hex);
-
-	u16_remainingBits = u16_dataLenBit - (u16_dataLenByte_trunc << 3);
-	if (u16_remainingBits > 4)
-		MCU_AT_CONSOLE_send("%02X", *pu8_hex);
-	else if (u16_remainingBits > 0)
-		MCU_AT_CONSOLE_send("%01X", *pu8_hex);
-	/* else no additional bits */
+	u16_txRdIdx = (u16_txRdIdx + u16_txDmaLen) % TXBUF_SIZE;
+	u16_txDmaLen = 0;
+	MCU_AT_CONSOLE_txKick();
 }
 
 /**
-  * @brief  UART error callback. Can raise in case of UART OVERFLOW, DMA RX ERROR, ...
+ * @brief  UART error callback. Can raise in case of UART framing/noise error, DMA RX ERROR, ...
  *
  * This function is highly based on STM32HAL_UART. It overrides the generic defined error callback
  *
- * @note So far, this callback is emptied
+ * Line errors (parity, framing, noise) are served in LPUART1_IRQHandler before HAL: erroneous
+ * character is dropped and RX DMA goes on. This callback is then called with reception still
+ * on-going. Characters received up to now are recorded, and only the line being received is
+ * dropped by client at next poll. AT cmds already received are kept.
  *
-  * @param  huart UART handle.
-  * @retval None
-  */
-//void HAL_UART_ErrorCallback(__attribute__((unused)) UART_HandleTypeDef *huart)
-//{
-//	MCU_AT_CONSOLE_send("\r\n+UART_ERROR (OVR, RX error) => PLEASE RESET MODULE.\r\n\r\n");
-//	kns_assert(0);
-//}
+ * In case several line errors are raised between two polls, only the line of the last one is
+ * dropped.
+ *
+ * Otherwise (e.g. DMA RX error), RX DMA was aborted thus reception is restarted. Restarting DMA
+ * leads to write again from the beginning of RX buffer, thus unreleased characters are dropped at
+ * next poll.
+ *
+ * In case DMA TX transfer was aborted, characters being sent are dropped and next ones are sent.
+ *
+ * @param  huart UART handle.
+ * @retval None
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	if (huart != huart_handle)
+		return;
+
+	if ((huart->gState == HAL_UART_STATE_READY) && (u16_txDmaLen != 0)) {
+		u16_txRdIdx = (u16_txRdIdx + u16_txDmaLen) % TXBUF_SIZE;
+		u16_txDmaLen = 0;
+		MCU_AT_CONSOLE_txKick();
+	}
+
+	rxStatus.u16_errorCnt++;
+	if (huart->RxState == HAL_UART_STATE_READY) {
+		u16_rxWrIdx = 0;
+		bRxFlush = true;
+		if (KINEIS_UART_StartRx_DMA(huart) != HAL_OK)
+			kns_assert(0);
+		if (rxNotifyCb != NULL)
+			rxNotifyCb();
+	} else if (huart->hdmarx != NULL) {
+		MCU_AT_CONSOLE_rxNotify(huart->RxXferSize - __HAL_DMA_GET_COUNTER(huart->hdmarx));
+		u16_rxErrIdx = u16_rxWrIdx;
+		bRxLineErr = true;
+		if (rxNotifyCb != NULL)
+			rxNotifyCb();
+	}
+}
 
 /**
  * @}
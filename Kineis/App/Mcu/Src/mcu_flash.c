@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    mcu_flash.c
+ * @author  Kinéis
+ * @brief   MCU wrapper for internal flash memory used as data storage
+ */
+
+/**
+ * @addtogroup MCU_APP_WRAPPERS
+ * @brief MCU wrapper used by Kineis Application example.
+ *
+ * One has to implement API as per its microcontroller and its platform ressources.
+ * @{
+ */
+
+#include "mcu_flash_stm.c"
+
+/**
+ * @}
+ */
@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    mcu_flash_stm.c
+ * @author  Kinéis
+ * @brief   MCU wrapper for internal flash memory used as data storage
+ */
+
+/**
+ * @addtogroup MCU_APP_WRAPPERS
+ * @brief MCU wrapper used by Kineis Application example.
+ *
+ * One has to implement API as per its microcontroller and its platform ressources.
+ * This version is for STM32 uC such as STM32WLE5xx, STM32WL55xx.
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "mcu_flash.h"
+#include "kns_app_conf.h" // for STM32 HAL include on FLASH
+#include STM32_HAL_H
+
+#if (MCU_FLASH_PAGE_SIZE != FLASH_PAGE_SIZE)
+#error "MCU_FLASH_PAGE_SIZE does not match flash page size of the uC"
+#endif
+
+/* Variables -----------------------------------------------------------------*/
+
+/** Journal area boundaries, defined in linker script */
+extern uint8_t _suserdata_jrnl[];
+extern uint8_t _euserdata_jrnl[];
+
+static volatile bool bReadOngoing; /**< guarded read in progress */
+static volatile bool bReadEccError; /**< ECC error detected during guarded read */
+
+/* Functions -----------------------------------------------------------------*/
+
+void MCU_FLASH_getJournalArea(uint32_t *pu32_addr, uint32_t *pu32_size)
+{
+	*pu32_addr = (uint32_t)_suserdata_jrnl;
+	*pu32_size = (uint32_t)(_euserdata_jrnl - _suserdata_jrnl);
+}
+
+bool MCU_FLASH_erasePage(uint32_t u32_addr)
+{
+	FLASH_EraseInitTypeDef sEraseInit = {
+		.TypeErase = FLASH_TYPEERASE_PAGES,
+		.Page = (u32_addr - FLASH_BASE) / FLASH_PAGE_SIZE,
+		.NbPages = 1
+	};
+	uint32_t u32_pageError;
+	HAL_StatusTypeDef eStatus;
+
+	if (HAL_FLASH_Unlock() != HAL_OK)
+		return false;
+	eStatus = HAL_FLASHEx_Erase(&sEraseInit, &u32_pageError);
+	HAL_FLASH_Lock();
+
+	return (eStatus == HAL_OK);
+}
+
+bool MCU_FLASH_program(uint32_t u32_addr, const void *p_data, uint16_t u16_len)
+{
+	const uint8_t *pu8_data = (const uint8_t *)p_data;
+	uint64_t u64_unit;
+	uint16_t u16_idx;
+	HAL_StatusTypeDef eStatus = HAL_OK;
+
+	if (((u32_addr % MCU_FLASH_PROG_UNIT) != 0) || ((u16_len % MCU_FLASH_PROG_UNIT) != 0))
+		return false;
+
+	if (HAL_FLASH_Unlock() != HAL_OK)
+		return false;
+	for (u16_idx = 0; (u16_idx < u16_len) && (eStatus == HAL_OK);
+	     u16_idx += MCU_FLASH_PROG_UNIT) {
+		/** data may not be aligned on 64 bits */
+		memcpy(&u64_unit, &pu8_data[u16_idx], sizeof(u64_unit));
+		eStatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, u32_addr + u16_idx,
+			u64_unit);
+	}
+	HAL_FLASH_Lock();
+
+	return (eStatus == HAL_OK);
+}
+
+bool MCU_FLASH_read(uint32_t u32_addr, void *p_data, uint16_t u16_len)
+{
+	bReadEccError = false;
+	bReadOngoing = true;
+	memcpy(p_data, (const void *)u32_addr, u16_len);
+	bReadOngoing = false;
+
+	return !bReadEccError;
+}
+
+bool MCU_FLASH_nmiHandler(void)
+{
+	if (!bReadOngoing || !__HAL_FLASH_GET_FLAG(FLASH_FLAG_ECCD))
+		return false;
+
+	__HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ECCD);
+	bReadEccError = true;
+
+	return true;
+}
+
+/**
+ * @}
+ */
@@ -14,9 +14,17 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include "kns_q.h"
+#include "kns_os.h"
 #include "kns_mac.h"
 #include "kns_cfg.h"
 #include "mgr_at_cmd.h"
+#ifdef USE_USERDATA_JOURNAL
+#include "user_data_journal.h"
+#endif
+#ifdef USE_USERDATA_TX_PRIO
+#include "user_data.h"
+#include "mcu_tim_srv.h"
+#endif
 #include "kineis_sw_conf.h"
 #include KINEIS_SW_ASSERT_H
 #include "mgr_log.h"
@@ -100,6 +108,30 @@ static void MGR_LOG_array(__attribute__((unused)) uint8_t *data, uint16_t len)
 		MGR_LOG_DEBUG_RAW("%02X", data[i]);
 	MGR_LOG_DEBUG_RAW("\r\n");
 }
+#ifdef USE_USERDATA_TX_PRIO
+/** @brief Time base of the TX scheduling policy
+ *
+ * @return time in ms
+ */
+static uint32_t KNS_APP_getTimeMs(void)
+{
+	return (uint32_t)MCU_TIM_SRV_getTimeMs();
+}
+
+/**
+ * @brief TX scheduling policy driven by user data attribute (service and priority fields)
+ *
+ * Emergency messages go first, low priority ones (e.g. position fixes) are promoted after
+ * USERDATA_TX_AGING_MS and are the first dropped when TX fifo is full.
+ */
+static const struct sUserDataTxPolicy_t sTxPrioPolicy = {
+	.USERDATA_txPolicyGetClassCb = USERDATA_txFifoGetClassByAttr,
+	.USERDATA_txPolicyGetTimeMsCb = KNS_APP_getTimeMs,
+	.u32AgingMs = USERDATA_TX_AGING_MS,
+	.eDrop = USERDATA_TX_DROP_LOWEST
+};
+#endif
+
 /** @brief At end of standalone APP test, generate TEST status
  *
  * @return true if data is correctly processed, false otherwise
@@ -271,6 +303,11 @@ void KNS_APP_gui_init(void *context)
 
 	kns_assert(context != NULL); // context should contain pointer to UART handle
 
+#ifdef USE_USERDATA_TX_PRIO
+	/** Serve TX fifo by priority classes, also re-sorts messages recovered from journal */
+	USERDATA_txFifoSetPolicy(&sTxPrioPolicy);
+#endif
+
 	/** Initialize AT command manager */
 	MGR_AT_CMD_start(context);
 
@@ -302,6 +339,23 @@ void KNS_APP_gui_loop(void)
 	if (pu8_atcmd != NULL)
 		MGR_AT_CMD_decodeAt(pu8_atcmd);  // @todo: return code is not used ?
 	MGR_AT_CMD_macEvtProcess();
+	MGR_AT_CMD_txAggProcess();
+
+	/** One AT cmd is decoded per loop, come back for next ones */
+	if (MGR_AT_CMD_isPendingAt())
+		KNS_OS_setTaskReady(KNS_OS_TASK_APP);
+
+#ifdef USE_USERDATA_JOURNAL
+	/** Write staged TX journal records once their latency expired */
+	USERDATA_journalSyncProcess();
+
+	/** Compact TX journal in background, then write records waiting for room. Flash erase
+	 * stalls the CPU, do not do it while radio is on. Otherwise, it is retried at next loop,
+	 * i.e. at next AT cmd or MAC event.
+	 */
+	if (!KNS_MAC_getRsrcStatus().modemOn)
+		USERDATA_journalProcess();
+#endif
 }
 
 /**
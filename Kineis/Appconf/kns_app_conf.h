@@ -38,6 +38,15 @@
 
 #define INCLUDE_NOP_H		"stm32wlxx_hal.h"
 
+/**
+ * @brief NVIC line of the UART used by the AT console
+ *
+ * Console interrupts run above the critical section ceiling (cf KNS_CS_PRIO_CEILING). AT console
+ * masks this line priority, instead of entering a critical section, when its task context updates
+ * the TX state. UART DMA channels shall have the same priority (cf usart.c).
+ */
+#define AT_CONSOLE_UART_IRQn	LPUART1_IRQn
+
 #endif // end KNS_APP_CONF_H
 
 /**
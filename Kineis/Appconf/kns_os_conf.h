@@ -16,10 +16,12 @@
  *
  * For information, tasks are roder from lower priority to upper priority.
  *
- * \note In can you use the Kineis baremetal OS (USE_BAREMETAL compilation flag), there is actually
- * no notion of priorities on tasks. Priorities are rather handled at queue level. Before popping
- * an event from a queue the baremetal OS checks ther is no event present in higher-priority queues
- * before. Refer to \ref kns_q_page for extra details on this.
+ * \note In can you use the Kineis baremetal OS (USE_BAREMETAL compilation flag), priorities are
+ * mainly handled at queue level. Before popping an event from a queue the baremetal OS checks ther
+ * is no event present in higher-priority queues before, and the consumer task of the
+ * highest-priority non-empty queue is scheduled first. Refer to \ref kns_q_page for extra details
+ * on this. Task order is only used between tasks explicitly set ready (e.g. from ISR). IDLE task is
+ * scheduled when no other task is ready.
  */
 
 /**
@@ -34,6 +36,18 @@
 
 #pragma GCC visibility push(default)
 
+/* Defines ------------------------------------------------------------------------------------- */
+
+#ifdef USE_FREERTOS
+/** Stack depth (in words) of each RTOS task created by Kineis OS */
+#define KNS_OS_RTOS_STACK_DEPTH 1024
+
+/** RTOS priority of first task handler (KNS_OS_TASK_APP), next handlers get next priorities.
+ * @attention configMAX_PRIORITIES shall be higher than KNS_OS_RTOS_PRIO_BASE + KNS_OS_TASK_MAX
+ */
+#define KNS_OS_RTOS_PRIO_BASE (tskIDLE_PRIORITY + 1)
+#endif
+
 /* Enums --------------------------------------------------------------------------------------- */
 
 /**
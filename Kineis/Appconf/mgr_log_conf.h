@@ -33,12 +33,36 @@
 
 /* Defines -------------------------------------------------------------------*/
 
+/** Log backend selection, one of:
+ * * MGR_LOG_BACKEND_ATCONSOLE: logs are sent on the UART of the AT console (LPUART1). Logs are
+ *   mixed with AT cmd responses, thus are not compatible with a host driving the AT console.
+ * * MGR_LOG_BACKEND_ITM: logs are sent on ITM stimulus port 0 (SWO pin). Nothing is sent when no
+ *   debugger enabled the trace.
+ * * MGR_LOG_BACKEND_RTT: logs are written in a RAM ring buffer drained by a debugger (SEGGER RTT
+ *   layout). Logs are dropped when ring buffer is full.
+ */
+#if !defined(MGR_LOG_BACKEND_ATCONSOLE) && !defined(MGR_LOG_BACKEND_ITM) && \
+	!defined(MGR_LOG_BACKEND_RTT)
+#define MGR_LOG_BACKEND_ATCONSOLE
+#endif
+
+#if defined(MGR_LOG_BACKEND_ATCONSOLE)
+
 #define log_uart	hlpuart1
 
 /* Variables -----------------------------------------------------------------*/
 
 extern UART_HandleTypeDef hlpuart1;
 
+#elif defined(MGR_LOG_BACKEND_RTT)
+
+#include "mgr_log_rtt.h"
+
+/** Size of RAM ring buffer, in bytes */
+#define MGR_LOG_RTT_BUFFER_SIZE	1024
+
+#endif // end MGR_LOG_BACKEND_RTT
+
 #endif // end USE_LOCAL_PRINTF
 
 #endif // end MGR_LOG_CONF_H
@@ -23,37 +23,243 @@
 
 /* Includes ------------------------------------------------------------------------------------ */
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#ifdef USE_POSIX
+#include <pthread.h>
+#else
 #include "main.h"
+#endif
+#include "kns_cs.h"
+#include "kns_os_perf.h"
 
 #pragma GCC visibility push(default)
 
-/* Defines ------------------------------------------------------------------------------------- */
-#define PRIM_ARRAY_SIZE 8 // define the depth of inner critical sections. MUST be 4 at minimum
+/* Private variables --------------------------------------------------------------------------- */
 
+/** Nesting depth of KNS_CS_enter, only modified within critical section */
+static uint32_t u32_csDepth;
 
-/* Private variables --------------------------------------------------------------------------- */
+/** Interrupt mask saved by outermost KNS_CS_enter */
+static uint32_t u32_csOuterMask;
 
-static uint32_t prim[PRIM_ARRAY_SIZE];
-uint8_t idx = 0;
+#ifdef KNS_OS_PERF
+/** Start of current masked interval, in cycles */
+static uint32_t u32_csStartCycles;
+/** Caller of current masked interval */
+static uintptr_t csStartCaller;
+/** Longest masked interval, in cycles */
+static uint32_t u32_csMaxCycles;
+/** Caller of longest masked interval */
+static uintptr_t csMaxCaller;
+#endif
 
-/* Function ------------------------------------------------------------------------------------ */
+/* Local functions ----------------------------------------------------------------------------- */
+
+/**
+ * @brief Start measuring a masked interval (outermost entry only)
+ *
+ * @param[in] caller address of the code entering critical section
+ */
+static inline void KNS_CS_perfStart(__attribute__((unused)) uintptr_t caller)
+{
+#ifdef KNS_OS_PERF
+	u32_csStartCycles = KNS_OS_PERF_GET_CYCLES();
+	csStartCaller = caller;
+#endif
+}
+
+/**
+ * @brief Stop measuring a masked interval (outermost exit only), keep the longest one
+ */
+static inline void KNS_CS_perfStop(void)
+{
+#ifdef KNS_OS_PERF
+	uint32_t u32_cycles = KNS_OS_PERF_GET_CYCLES() - u32_csStartCycles;
+
+	if (u32_cycles > u32_csMaxCycles) {
+		u32_csMaxCycles = u32_cycles;
+		csMaxCaller = csStartCaller;
+	}
+#endif
+}
+
+#ifdef USE_POSIX
+
+/** Host threads run in parallel, masking signals would not exclude other threads. Critical
+ * sections are thus a single recursive mutex, as they may be nested.
+ */
+static pthread_mutex_t csMutex;
+static pthread_once_t csOnce = PTHREAD_ONCE_INIT;
+
+/** Number of times csMutex is locked, only modified by the thread owning it */
+static uint32_t u32_lockDepth;
+
+static void KNS_CS_init(void)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&csMutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+/**
+ * @brief Lock critical section. Mask returned is the lock depth before locking.
+ */
+static uint32_t KNS_CS_mask(uintptr_t caller)
+{
+	pthread_once(&csOnce, KNS_CS_init);
+	pthread_mutex_lock(&csMutex);
+	if (u32_lockDepth == 0)
+		KNS_CS_perfStart(caller);
+	return u32_lockDepth++;
+}
+
+/**
+ * @brief Unlock critical section once, lock depth is decremented while still owning the mutex
+ */
+static void KNS_CS_unlock(void)
+{
+	u32_lockDepth--;
+	pthread_mutex_unlock(&csMutex);
+}
+
+static void KNS_CS_unmask(uint32_t u32_mask)
+{
+	if (u32_mask == 0)
+		KNS_CS_perfStop();
+	KNS_CS_unlock();
+}
+
+static bool KNS_CS_isOuterMask(uint32_t u32_mask)
+{
+	return u32_mask == 0;
+}
 
-void KNS_CS_enter()
+#else // else of USE_POSIX
+
+#if (KNS_CS_PRIO_CEILING >= (1 << __NVIC_PRIO_BITS))
+#error KNS_CS_PRIO_CEILING exceeds NVIC priority range
+#endif
+
+/** BASEPRI value of the ceiling, priority being in upper bits */
+#define CS_BASEPRI_CEILING ((uint32_t)KNS_CS_PRIO_CEILING << (8U - __NVIC_PRIO_BITS))
+
+/**
+ * @brief Check a saved mask did not mask interrupts up to the ceiling, i.e. matching entry was the
+ * outermost one
+ */
+static bool KNS_CS_isOuterMask(uint32_t u32_mask)
+{
+#if (KNS_CS_PRIO_CEILING == 0)
+	return u32_mask == 0;
+#else
+	return (u32_mask == 0) || (u32_mask > CS_BASEPRI_CEILING);
+#endif
+}
+
+/**
+ * @brief Mask interrupts up to ceiling
+ *
+ * @return previous PRIMASK (ceiling 0) or BASEPRI
+ */
+static uint32_t KNS_CS_mask(uintptr_t caller)
 {
+	uint32_t u32_mask;
 
-	prim[idx % PRIM_ARRAY_SIZE] = __get_PRIMASK();
+#if (KNS_CS_PRIO_CEILING == 0)
+	u32_mask = __get_PRIMASK();
 	__disable_irq();
-	idx++; // make prim pointing on next empty plac in array
+#else
+	u32_mask = __get_BASEPRI();
+	/** BASEPRI_MAX only raises masking level, never lowers it */
+	__set_BASEPRI_MAX(CS_BASEPRI_CEILING);
+	__ISB();
+#endif
+	if (KNS_CS_isOuterMask(u32_mask))
+		KNS_CS_perfStart(caller);
+
+	return u32_mask;
 }
 
-void KNS_CS_exit()
+/**
+ * @brief Restore interrupt mask
+ */
+static void KNS_CS_unmask(uint32_t u32_mask)
 {
-	idx--; // decrement idx in a way to point on last valid data
-	if (!prim[idx % PRIM_ARRAY_SIZE]) {
+	if (KNS_CS_isOuterMask(u32_mask))
+		KNS_CS_perfStop();
+#if (KNS_CS_PRIO_CEILING == 0)
+	if (u32_mask == 0)
 		__enable_irq();
-	}
+#else
+	__set_BASEPRI(u32_mask);
+#endif
+}
+
+#endif // end of USE_POSIX
+
+/* Function ------------------------------------------------------------------------------------ */
+
+void KNS_CS_enter(void)
+{
+	uint32_t u32_mask = KNS_CS_mask((uintptr_t)__builtin_return_address(0));
+
+	if (u32_csDepth++ == 0)
+		u32_csOuterMask = u32_mask;
+}
+
+void KNS_CS_exit(void)
+{
+	if (--u32_csDepth == 0)
+		KNS_CS_unmask(u32_csOuterMask);
+#ifdef USE_POSIX
+	else
+		KNS_CS_unlock();
+#endif
+}
+
+uint32_t KNS_CS_enterSave(void)
+{
+	return KNS_CS_mask((uintptr_t)__builtin_return_address(0));
+}
+
+void KNS_CS_exitRestore(uint32_t u32_mask)
+{
+	KNS_CS_unmask(u32_mask);
+}
+
+uint32_t KNS_CS_getMaxMasked(uintptr_t *pCaller)
+{
+#ifdef KNS_OS_PERF
+	uint32_t u32_mask = KNS_CS_enterSave();
+	uint32_t u32_cycles = u32_csMaxCycles;
+
+	if (pCaller != NULL)
+		*pCaller = csMaxCaller;
+	KNS_CS_exitRestore(u32_mask);
+
+	return u32_cycles;
+#else
+	if (pCaller != NULL)
+		*pCaller = 0;
+	return 0;
+#endif
+}
+
+void KNS_CS_resetMaxMasked(void)
+{
+#ifdef KNS_OS_PERF
+	uint32_t u32_mask = KNS_CS_enterSave();
+
+	u32_csMaxCycles = 0;
+	csMaxCaller = 0;
+	KNS_CS_exitRestore(u32_mask);
+#endif
 }
 
 #pragma GCC visibility pop
@@ -24,9 +24,37 @@
 #ifndef KNS_CS_H
 #define KNS_CS_H
 
+/* Includes ----------------------------------------------------------------- */
+
+#include <stdint.h>
+
+/* Defines ------------------------------------------------------------------ */
+
+/**
+ * @brief Interrupt priority ceiling of critical sections (CS_PRIO_CEILING in Makefile)
+ *
+ * Critical sections mask interrupts whose NVIC priority is greater than or equal to this value,
+ * through BASEPRI. Interrupts of higher priority (lower value) are never masked, they shall thus
+ * not access any data protected by a critical section, nor call KNS_CS API. On STM32WL, only AT
+ * console interrupts are such ones (cf mcu_at_console_stm.c).
+ *
+ * @attention SUBGHZ radio processing is NOT kept live by the ceiling: radio callbacks (libknsrf)
+ * call KNS_CS API, so SUBGHZ_Radio_IRQHandler only pends RADIO_DEFERRED_IRQn, below the ceiling,
+ * which stays masked as long as a critical section is held (cf stm32wlxx_it.c). Keep critical
+ * sections short to bound radio IRQ latency.
+ *
+ * 0 masks all interrupts through PRIMASK.
+ */
+#ifndef KNS_CS_PRIO_CEILING
+#define KNS_CS_PRIO_CEILING 0
+#endif
+
 /* Exported functions ------------------------------------------------------- */
 
 /** @brief Enter critical section
+  *
+  * @note Nesting depth is kept in a static counter, as this API is called by Kineis library.
+  * Prefer KNS_CS_enterSave/KNS_CS_exitRestore in application code.
   */
 void KNS_CS_enter(void);
 
@@ -34,6 +62,32 @@ void KNS_CS_enter(void);
   */
 void KNS_CS_exit(void);
 
+/** @brief Enter critical section, caller keeps the previous interrupt mask
+  *
+  * @return interrupt mask before entering, to be given back to KNS_CS_exitRestore
+  */
+uint32_t KNS_CS_enterSave(void);
+
+/** @brief Exit critical section, restoring interrupt mask got from KNS_CS_enterSave
+  *
+  * @param[in] u32_mask interrupt mask returned by matching KNS_CS_enterSave
+  */
+void KNS_CS_exitRestore(uint32_t u32_mask);
+
+/** @brief Get longest time spent with interrupts masked by critical sections
+  *
+  * Only measured when built with KNS_OS_PERF (PERF=1 in Makefile), 0 is returned otherwise.
+  *
+  * @param[out] pCaller address of the code which entered the longest critical section
+  *
+  * @return duration in CPU cycles (nanoseconds on POSIX host)
+  */
+uint32_t KNS_CS_getMaxMasked(uintptr_t *pCaller);
+
+/** @brief Clear longest masked interval
+  */
+void KNS_CS_resetMaxMasked(void);
+
 #endif // end KNS_CS_H
 
 /**
@@ -25,44 +25,48 @@
 
 #ifdef USE_BAREMETAL
 
-static uint8_t qDataApp2Mac[KNS_Q_DL_APP2MAC_LEN][KNS_Q_DL_APP2MAC_ITEM_BYTESIZE];
+static uint32_t qDataApp2Mac[KNS_Q_DL_APP2MAC_LEN][KNS_Q_ELT_WORDSIZE(KNS_Q_DL_APP2MAC_ITEM_BYTESIZE)];
 static struct q_desc_t qApp2Mac = {
-	.mutex = false,
 	.rIdx = 0,
 	.wIdx = 0,
+	.wResvIdx = 0,
+	.wNest = 0,
 	.nbElt = KNS_Q_DL_APP2MAC_LEN,
 	.eltSize = KNS_Q_DL_APP2MAC_ITEM_BYTESIZE,
-	.data = (uint8_t *)qDataApp2Mac
+	.data = (uint32_t *)qDataApp2Mac
 };
 
-static uint8_t qDataMac2App[KNS_Q_UL_MAC2APP_LEN][KNS_Q_UL_MAC2APP_ITEM_BYTESIZE];
+static uint32_t qDataMac2App[KNS_Q_UL_MAC2APP_LEN][KNS_Q_ELT_WORDSIZE(KNS_Q_UL_MAC2APP_ITEM_BYTESIZE)];
 static struct q_desc_t qMac2App = {
-	.mutex = false,
 	.rIdx = 0,
 	.wIdx = 0,
+	.wResvIdx = 0,
+	.wNest = 0,
 	.nbElt = KNS_Q_UL_MAC2APP_LEN,
 	.eltSize = KNS_Q_UL_MAC2APP_ITEM_BYTESIZE,
-	.data = (uint8_t *)qDataMac2App
+	.data = (uint32_t *)qDataMac2App
 };
 
-static uint8_t qDataSrvc2Mac[KNS_Q_UL_SRVC2MAC_LEN][KNS_Q_UL_SRVC2MAC_ITEM_BYTESIZE];
+static uint32_t qDataSrvc2Mac[KNS_Q_UL_SRVC2MAC_LEN][KNS_Q_ELT_WORDSIZE(KNS_Q_UL_SRVC2MAC_ITEM_BYTESIZE)];
 static struct q_desc_t qSrvc2Mac = {
-	.mutex = false,
 	.rIdx = 0,
 	.wIdx = 0,
+	.wResvIdx = 0,
+	.wNest = 0,
 	.nbElt = KNS_Q_UL_SRVC2MAC_LEN,
 	.eltSize = KNS_Q_UL_SRVC2MAC_ITEM_BYTESIZE,
-	.data = (uint8_t *)qDataSrvc2Mac
+	.data = (uint32_t *)qDataSrvc2Mac
 };
 
-static uint8_t qDataInfra2Mac[KNS_Q_UL_INFRA2MAC_LEN][KNS_Q_UL_INFRA2MAC_ITEM_BYTESIZE];
+static uint32_t qDataInfra2Mac[KNS_Q_UL_INFRA2MAC_LEN][KNS_Q_ELT_WORDSIZE(KNS_Q_UL_INFRA2MAC_ITEM_BYTESIZE)];
 static struct q_desc_t qInfra2Mac = {
-	.mutex = false,
 	.rIdx = 0,
 	.wIdx = 0,
+	.wResvIdx = 0,
+	.wNest = 0,
 	.nbElt = KNS_Q_UL_INFRA2MAC_LEN,
 	.eltSize = KNS_Q_UL_INFRA2MAC_ITEM_BYTESIZE,
-	.data = (uint8_t *)qDataInfra2Mac
+	.data = (uint32_t *)qDataInfra2Mac
 };
 
 struct q_desc_t *qPool[KNS_Q_MAX] = {
@@ -93,6 +97,18 @@ const char *qIdx2Str[KNS_Q_MAX] = {
 
 #endif /* USE_BAREMETAL */
 
+const enum KNS_OS_taskHdlr_t qConsumerTask[KNS_Q_MAX] = {
+	/** @todo APP can add its own queues below */
+	// KNS_OS_TASK_APP, /**< example for adding one appplication queue here */
+	/** @attention keep below queue handlers for proper bahaviour of kineis stack
+	 * @attention align this enum wit hcontent of qPool declared in kns_q_conf.c
+	 */
+	KNS_OS_TASK_MAC,
+	KNS_OS_TASK_APP,
+	KNS_OS_TASK_MAC,
+	KNS_OS_TASK_MAC
+};
+
 #pragma GCC visibility pop
 
 #endif /* KNS_Q_CONF_C */
@@ -34,6 +34,7 @@
 #include <stdint.h>
 
 #include "kns_mac_evt.h"
+#include "kns_os_conf.h"
 /** @todo remove once SRVC2MAC event and kns queues dependencies are correctly clean-up */
 #include "kns_srvc_common.h"
 
@@ -76,6 +77,11 @@
 #endif // end of USE_BAREMETAL
 #define KNS_Q_UL_INFRA2MAC_ITEM_BYTESIZE sizeof(struct KNS_MAC_infraEvt_t)
 
+/**< Number of 32-bit words needed to store one element of given byte size. Baremetal queue slots
+ * are word-aligned so elements can be moved word by word.
+ */
+#define KNS_Q_ELT_WORDSIZE(eltByteSize) (((eltByteSize) + sizeof(uint32_t) - 1) / sizeof(uint32_t))
+
 /* Enums --------------------------------------------------------------------------------------- */
 
 /**
@@ -108,15 +114,19 @@ enum KNS_Q_handle_t {
  * @brief queue description queue
  * @attention keep below struct descriptio, as is, in case of Kineis's baremetal OS
  *
- * All useful parameters needed to use a queue
+ * All useful parameters needed to use a queue. Queue is a lock-free ring with a single consumer:
+ * * rIdx is only written by the consumer,
+ * * wIdx is only advanced once the element(s) before it are fully written,
+ * * wResvIdx and wNest let producers from nested ISR contexts claim slots without masking IRQs.
  */
 struct q_desc_t {
-	bool mutex;
-	uint8_t rIdx;
-	uint8_t wIdx;
-	uint8_t nbElt;
-	uint8_t eltSize;
-	uint8_t *data;
+	volatile uint8_t rIdx;     /**< next slot to read, owned by consumer */
+	volatile uint8_t wIdx;     /**< end of readable slots, published by producers */
+	volatile uint8_t wResvIdx; /**< next free slot, claimed by producers */
+	volatile uint8_t wNest;    /**< number of producers currently writing into the queue */
+	uint8_t nbElt;             /**< number of slots (one more than usable elements) */
+	uint16_t eltSize;          /**< element size in bytes */
+	uint32_t *data;            /**< slots storage, KNS_Q_ELT_WORDSIZE(eltSize) words each */
 };
 
 /* Extern -------------------------------------------------------------------------------------- */
@@ -129,6 +139,13 @@ extern const char *qIdx2Str[KNS_Q_MAX];
 
 #endif /* USE_BAREMETAL */
 
+/* Extern -------------------------------------------------------------------------------------- */
+
+/** Task consuming each queue. Kineis OS schedules (baremetal) or notifies (RTOS) this task as long
+ * as the queue holds some event (refer to \ref kns_os_page).
+ */
+extern const enum KNS_OS_taskHdlr_t qConsumerTask[KNS_Q_MAX];
+
 #pragma GCC visibility pop
 
 #endif /* KNS_Q_CONF_H */
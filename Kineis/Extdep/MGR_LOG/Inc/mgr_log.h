@@ -36,6 +36,10 @@
  * By defult, in most of the packages delivered by Kineis, this Log Manager is actually outpûting
  * the log to a dedicated console (via UART).
  *
+ * On this platform, the log output (backend) is selected in mgr_log_conf.h through one of the
+ * MGR_LOG_BACKEND_ATCONSOLE, MGR_LOG_BACKEND_ITM, MGR_LOG_BACKEND_RTT flags (LOG variable of the
+ * Makefile). Except ATCONSOLE, they all keep logs away from the AT cmd link.
+ *
  */
 
 /**
@@ -51,10 +55,38 @@
 #ifdef DEBUG
 #include "mgr_log_rtc.h"
 #endif
+#if defined(USE_LOCAL_PRINTF) && defined(MGR_LOG_DEFERRED)
+#include <stdint.h>
+#include <stdbool.h>
+#endif
 
 /* Defines -------------------------------------------------------------------*/
 
-#ifdef DEBUG
+/* Deferred binary records would be mixed with AT cmd responses on the AT console UART (which is
+ * also the backend selected by default in mgr_log_conf.h)
+ */
+#if defined(MGR_LOG_DEFERRED) && !defined(MGR_LOG_BACKEND_ITM) && !defined(MGR_LOG_BACKEND_RTT)
+#error "MGR_LOG_DEFERRED requires the ITM or RTT log backend (LOG_DEFERRED=1 needs LOG=ITM or RTT)"
+#endif
+
+#if defined(DEBUG) && defined(USE_LOCAL_PRINTF) && defined(MGR_LOG_DEFERRED)
+
+/* log with tick timestamp before */
+#define MGR_LOG_DEBUG(...)		MGR_LOG_DEFER(true, __VA_ARGS__)
+/* direct logging */
+#define MGR_LOG_DEBUG_RAW(...)		MGR_LOG_DEFER(false, __VA_ARGS__)
+
+#ifdef VERBOSE
+/* log with tick timestamp before */
+#define MGR_LOG_VERBOSE(...)		MGR_LOG_DEFER(true, __VA_ARGS__)
+/* direct logging without timestamp */
+#define MGR_LOG_VERBOSE_RAW(...)	MGR_LOG_DEFER(false, __VA_ARGS__)
+#else  // else VERBOSE
+#define MGR_LOG_VERBOSE(...)		do {} while (0)
+#define MGR_LOG_VERBOSE_RAW(...)	do {} while (0)
+#endif // end VERBOSE
+
+#elif defined(DEBUG)
 
 /* log with RTC timestamp before */
 #define MGR_LOG_DEBUG(...)		do {\
@@ -89,6 +121,36 @@
 
 #endif // end not DEBUG
 
+#if defined(USE_LOCAL_PRINTF) && defined(MGR_LOG_DEFERRED)
+
+/** Maximum number of arguments per deferred log */
+#define MGR_LOG_DEFERRED_MAX_ARGS	10
+
+/** Deferred log record: first byte, used by host decoder to resynchronize on records */
+#define MGR_LOG_DEFERRED_SYNC		0xA5U
+/** Deferred log record: flag set in second byte when a timestamp is present */
+#define MGR_LOG_DEFERRED_TS_FLAG	0x80U
+/** Deferred log record maximum size in 32-bit words: header, timestamp and arguments */
+#define MGR_LOG_DEFERRED_RECORD_MAX_WORDS	(2 + MGR_LOG_DEFERRED_MAX_ARGS)
+
+/** Section of format strings. It is not loaded on target, only kept in ELF file for host decoder
+ * (cf linker script). Address of a format string in this section is its ID.
+ */
+#define MGR_LOG_FMT_SECTION		__attribute__((section(".mgr_log_fmt"), used))
+
+/** Number of arguments given after format, up to 10 */
+#define MGR_LOG_NARGS(...)		MGR_LOG_NARGS_(0, ##__VA_ARGS__, 10, 9, 8, 7, 6, 5, 4, 3, \
+						2, 1, 0)
+#define MGR_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, N, ...)	N
+
+/** Store format string in format section and log a binary record */
+#define MGR_LOG_DEFER(bWithTimestamp, format, ...)	do {\
+	static const char MGR_LOG_FMT_SECTION ac_mgrLogFmt[] = format;\
+	vMGR_LOG_deferred(ac_mgrLogFmt, bWithTimestamp, MGR_LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__);\
+} while (0)
+
+#endif // end USE_LOCAL_PRINTF && MGR_LOG_DEFERRED
+
 /* Functions -----------------------------------------------------------------*/
 
 /**
@@ -103,6 +165,29 @@
 #ifdef USE_LOCAL_PRINTF
 void vMGR_LOG_printf(const char *format, ...);
 
+#ifdef MGR_LOG_DEFERRED
+/**
+ * @brief Log a binary record, decoded later by host tool (Tools/mgr_log_decoder)
+ *
+ * The record is made of 32-bit little endian words:
+ * * header: sync byte \ref MGR_LOG_DEFERRED_SYNC, then a byte with number of arguments and
+ *   \ref MGR_LOG_DEFERRED_TS_FLAG, then 16-bit format string ID
+ * * timestamp in ms (HAL tick), if requested
+ * * raw arguments
+ *
+ * @attention Arguments must be 32-bit long (no 64-bit integers nor floats). String arguments
+ * (%s) must point to constant strings in flash, as they are read back from ELF file by the host
+ * decoder.
+ *
+ * @note Use MGR_LOG_DEBUG/VERBOSE macros rather than calling this function directly.
+ *
+ * @param[in] format pointer to format string in format section
+ * @param[in] bWithTimestamp true to add a timestamp in the record
+ * @param[in] u8_nbArgs number of arguments following
+ */
+void vMGR_LOG_deferred(const char *format, bool bWithTimestamp, uint8_t u8_nbArgs, ...);
+#endif // end MGR_LOG_DEFERRED
+
 #else // not USE_LOCAL_PRINTF
 
 #define vMGR_LOG_printf			printf
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: no SPDX license */
+/**
+ * @file mgr_log_rtt.h
+ * @author Kinéis
+ * @brief logger RAM ring buffer backend, drained by a debugger (SEGGER RTT compatible)
+ */
+
+/**
+ * @addtogroup MGR_LOG
+ * @{
+ */
+
+#ifndef MGR_LOG_RTT_H
+#define MGR_LOG_RTT_H
+
+/* Includes ------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/* Functions -----------------------------------------------------------------*/
+
+/**
+ * @brief Write log characters into RAM ring buffer
+ *
+ * The ring buffer is described by a control block following SEGGER RTT layout (up-buffer 0), so
+ * that it can be drained by a debugger or any host tool reading target memory (J-Link RTT viewer,
+ * OpenOCD "rtt" commands, ...).
+ *
+ * This function never waits. When there is not enough room for the whole message in the ring
+ * buffer (e.g. no debugger attached), the message is dropped.
+ *
+ * @param[in] pu8_data pointer to characters to be logged
+ * @param[in] u16_len number of characters
+ */
+void MGR_LOG_RTT_write(const uint8_t *pu8_data, uint16_t u16_len);
+
+#endif // end MGR_LOG_RTT_H
+
+/**
+ * @}
+ */
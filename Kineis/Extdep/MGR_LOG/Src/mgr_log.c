@@ -15,6 +15,8 @@
 #include <stdarg.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include "mgr_log_conf.h"
 #include "mgr_log.h"
 
@@ -29,24 +31,79 @@
 
 static char au8_output[LOGGING_PURPOSE_STORAGE_MAX_MESSAGE_LEN];
 
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief Send log data to the selected backend (cf mgr_log_conf.h)
+ *
+ * @param[in] pu8_data pointer to data to be logged
+ * @param[in] u16_len number of bytes
+ */
+static void vMGR_LOG_write(const uint8_t *pu8_data, uint16_t u16_len)
+{
+#if defined(MGR_LOG_BACKEND_RTT)
+	/* Write log message in RAM ring buffer, drained by debugger */
+	MGR_LOG_RTT_write(pu8_data, u16_len);
+#elif defined(MGR_LOG_BACKEND_ITM)
+	/* Send log message via SWO, nothing is sent when trace is not enabled */
+	while (u16_len-- > 0)
+		ITM_SendChar(*pu8_data++);
+#else
+	uint32_t u32_tickStart;
+
+	/* Wait for end of any on-going transfer on the UART (e.g. AT console responses sent by DMA)
+	 * then send log message via UART
+	 */
+	u32_tickStart = HAL_GetTick();
+	while ((log_uart.gState != HAL_UART_STATE_READY) && ((HAL_GetTick() - u32_tickStart) < 500))
+		;
+	HAL_UART_Transmit(&log_uart, (uint8_t *)pu8_data, u16_len, 500);
+#endif
+}
+
 /* Functions -----------------------------------------------------------------*/
 
 void vMGR_LOG_printf(const char *format, ...)
 {
 	va_list args;
-
-	/* Reset output buffer */
-	memset(au8_output, 0x00, LOGGING_PURPOSE_STORAGE_MAX_MESSAGE_LEN);
+	int s32_len;
 
 	/* Log message formatting */
 	va_start(args, format);
-	vsprintf(au8_output, format, args);
+	s32_len = vsnprintf(au8_output, sizeof(au8_output), format, args);
+	va_end(args);
+	assert_param((s32_len >= 0) && ((uint32_t)s32_len < sizeof(au8_output)));
+
+	if (s32_len > 0)
+		vMGR_LOG_write((uint8_t *)au8_output, (uint16_t)s32_len);
+}
+
+#ifdef MGR_LOG_DEFERRED
+void vMGR_LOG_deferred(const char *format, bool bWithTimestamp, uint8_t u8_nbArgs, ...)
+{
+	va_list args;
+	uint32_t au32_record[MGR_LOG_DEFERRED_RECORD_MAX_WORDS];
+	uint8_t u8_nbWords = 0;
+
+	/** Arguments beyond the maximum are not logged, host decoder prints them as missing */
+	if (u8_nbArgs > MGR_LOG_DEFERRED_MAX_ARGS)
+		u8_nbArgs = MGR_LOG_DEFERRED_MAX_ARGS;
+
+	au32_record[u8_nbWords++] = MGR_LOG_DEFERRED_SYNC |
+		((uint32_t)((bWithTimestamp ? MGR_LOG_DEFERRED_TS_FLAG : 0) | u8_nbArgs) << 8) |
+		(((uint32_t)format & 0xFFFF) << 16);
+	if (bWithTimestamp)
+		au32_record[u8_nbWords++] = HAL_GetTick();
+
+	/** All arguments are 32-bit long on this target (int, long, pointers) */
+	va_start(args, u8_nbArgs);
+	while (u8_nbArgs-- > 0)
+		au32_record[u8_nbWords++] = va_arg(args, uint32_t);
 	va_end(args);
-	assert_param(strlen(au8_output) < sizeof(au8_output));
 
-	/* Send log message via UART */
-	HAL_UART_Transmit(&log_uart, (uint8_t *)au8_output, strlen(au8_output), 500);
+	vMGR_LOG_write((uint8_t *)au32_record, u8_nbWords * sizeof(uint32_t));
 }
+#endif // end MGR_LOG_DEFERRED
 #endif // end USE_LOCAL_PRINTF
 
 /**
@@ -27,45 +27,30 @@
 #include STM32_HAL_H
 #include STM32_HAL_RTC_H
 
-/*******************************************************************************
- * EXTERNS
- ******************************************************************************/
-extern RTC_HandleTypeDef hrtc;
-
 /*******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
 void MGR_LOG_RtcDateTime(void)
 {
-	RTC_DateTypeDef sdatestructureget;
-	RTC_TimeTypeDef stimestructureget;
+	/** RTC runs in binary mode (sub-second TX period timer), calendar is not running. Log time
+	 * since RTC init instead, which laps every 2^32 RTC ticks (~48 days).
+	 */
+	uint32_t tick = RTC_getBinTick();
+	uint32_t sec = tick / RTC_BIN_TICK_HZ;
+	uint32_t ms = ((tick % RTC_BIN_TICK_HZ) * 1000) / RTC_BIN_TICK_HZ;
 
 	/* Buffer used for displaying Time */
-	uint8_t aShowTime[15] = {0};
-	uint8_t aShowDate[15] = {0};
-
-	HAL_RTC_WaitForSynchro(&hrtc);
-	/* Get the RTC current Time */
-	HAL_RTC_GetTime(&hrtc, &stimestructureget, RTC_FORMAT_BIN);
-	/* Get the RTC current Date */
-	HAL_RTC_GetDate(&hrtc, &sdatestructureget, RTC_FORMAT_BIN);
-
-	/* Display date Format : mm-dd-yy */
-	sprintf((char *)aShowDate,
-			"%04d/%02d/%02d",
-			2000 + sdatestructureget.Year,
-			sdatestructureget.Month,
-			sdatestructureget.Date);
+	uint8_t aShowTime[24] = {0};
 
-	/* Display time Format : hh:mm:ss */
+	/* Display time Format : ddd hh:mm:ss.mmm */
 	sprintf((char *)aShowTime,
-			"%02d:%02d:%02d",
-			stimestructureget.Hours,
-			stimestructureget.Minutes,
-			stimestructureget.Seconds);
+			"%03lu %02lu:%02lu:%02lu.%03lu",
+			sec / 86400,
+			(sec / 3600) % 24,
+			(sec / 60) % 60,
+			sec % 60,
+			ms);
 
-	vMGR_LOG_printf((char *)aShowDate);
-	vMGR_LOG_printf(" ");
 	vMGR_LOG_printf((char *)aShowTime);
 }
 
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file mgr_log_rtt.c
+ * @author Kinéis
+ * @brief logger RAM ring buffer backend, drained by a debugger (SEGGER RTT compatible)
+ */
+
+/**
+ * @addtogroup MGR_LOG
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------*/
+
+#include <string.h>
+#include "mgr_log_conf.h"
+#include "mgr_log_rtt.h"
+
+#if defined(USE_LOCAL_PRINTF) && defined(MGR_LOG_BACKEND_RTT)
+
+/* Defines -------------------------------------------------------------------*/
+
+#define MGR_LOG_RTT_MODE_NO_BLOCK_SKIP 0U /**< drop message when ring buffer is full */
+
+/* Structures ----------------------------------------------------------------*/
+
+/** Ring buffer descriptor, as expected by RTT host tools */
+struct MGR_LOG_RTT_buf_t {
+	const char *sName;
+	uint8_t *pBuffer;
+	uint32_t u32_size;
+	volatile uint32_t u32_wrOff; /**< written by target only */
+	volatile uint32_t u32_rdOff; /**< written by host only */
+	uint32_t u32_flags;
+};
+
+/** Control block, looked for by RTT host tools in target RAM thanks to its ID */
+struct MGR_LOG_RTT_cb_t {
+	char acID[16];
+	int32_t s32_maxNumUpBuffers;
+	int32_t s32_maxNumDownBuffers;
+	struct MGR_LOG_RTT_buf_t up;
+	struct MGR_LOG_RTT_buf_t down;
+};
+
+/* Variables -----------------------------------------------------------------*/
+
+static uint8_t au8_rttUpBuf[MGR_LOG_RTT_BUFFER_SIZE];
+static uint8_t au8_rttDownBuf[16]; /**< unused, some host tools expect one down buffer */
+
+struct MGR_LOG_RTT_cb_t _SEGGER_RTT = {
+	.acID = "SEGGER RTT",
+	.s32_maxNumUpBuffers = 1,
+	.s32_maxNumDownBuffers = 1,
+	.up = {
+		.sName = "Terminal",
+		.pBuffer = au8_rttUpBuf,
+		.u32_size = sizeof(au8_rttUpBuf),
+		.u32_wrOff = 0,
+		.u32_rdOff = 0,
+		.u32_flags = MGR_LOG_RTT_MODE_NO_BLOCK_SKIP,
+	},
+	.down = {
+		.sName = "Terminal",
+		.pBuffer = au8_rttDownBuf,
+		.u32_size = sizeof(au8_rttDownBuf),
+		.u32_wrOff = 0,
+		.u32_rdOff = 0,
+		.u32_flags = MGR_LOG_RTT_MODE_NO_BLOCK_SKIP,
+	},
+};
+
+/* Functions -----------------------------------------------------------------*/
+
+void MGR_LOG_RTT_write(const uint8_t *pu8_data, uint16_t u16_len)
+{
+	struct MGR_LOG_RTT_buf_t *pBuf = &_SEGGER_RTT.up;
+	uint32_t u32_primask;
+	uint32_t u32_wrOff;
+	uint32_t u32_rdOff;
+	uint32_t u32_free;
+	uint32_t u32_firstPart;
+
+	/** Logs may be issued from interrupts, protect write offset */
+	u32_primask = __get_PRIMASK();
+	__disable_irq();
+
+	u32_wrOff = pBuf->u32_wrOff;
+	u32_rdOff = pBuf->u32_rdOff;
+	if (u32_rdOff > u32_wrOff)
+		u32_free = u32_rdOff - u32_wrOff - 1;
+	else
+		u32_free = pBuf->u32_size - (u32_wrOff - u32_rdOff) - 1;
+
+	if (u16_len <= u32_free) {
+		u32_firstPart = pBuf->u32_size - u32_wrOff;
+		if (u16_len < u32_firstPart)
+			u32_firstPart = u16_len;
+		memcpy(&pBuf->pBuffer[u32_wrOff], pu8_data, u32_firstPart);
+		memcpy(pBuf->pBuffer, &pu8_data[u32_firstPart], u16_len - u32_firstPart);
+		/** Data must be in RAM before host sees new write offset */
+		__DMB();
+		pBuf->u32_wrOff = (u32_wrOff + u16_len) % pBuf->u32_size;
+	}
+
+	__set_PRIMASK(u32_primask);
+}
+
+#endif // end USE_LOCAL_PRINTF && MGR_LOG_BACKEND_RTT
+
+/**
+ * @}
+ */
@@ -90,6 +90,28 @@ void MCU_MISC_turn_off_pa();
  */
 enum KNS_status_t MCU_MISC_getSettingsHwRf(int8_t rf_level_dBm, void* rfSettings);
 
+/**
+ * @brief Start free-running CPU cycle counter
+ *
+ * Used for runtime profiling (cf KNS_OS_PERF). On Cortex-M, this is the DWT cycle counter. It only
+ * counts while the core is clocked, so time spent in low power modes is not accounted.
+ */
+void MCU_MISC_cycleCntStart(void);
+
+/**
+ * @brief Get current value of the CPU cycle counter
+ *
+ * @return number of CPU cycles since @ref MCU_MISC_cycleCntStart, wraps around on 32 bits
+ */
+uint32_t MCU_MISC_getCycleCnt(void);
+
+/**
+ * @brief Get frequency of the CPU cycle counter
+ *
+ * @return counter frequency in Hz
+ */
+uint32_t MCU_MISC_getCycleCntFreq(void);
+
 #endif /* MCU_MISC_H_ */
 
 /**
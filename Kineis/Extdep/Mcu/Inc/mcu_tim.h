@@ -10,6 +10,11 @@
  * @page mcu_tim_page MCU wrappers: TIMers
  *
  * The Kineis SW library requires some timer for its protocols
+ *
+ * * MCU_TIM_HDLR_TX_TIMEOUT runs on the LPTIM1 timer service (\ref mcu_tim_srv_page)
+ * * MCU_TIM_HDLR_TX_PERIOD runs on RTC alarm A, RTC being in binary mode (32-bit sub-second
+ * counter, 1024 Hz). Period has ms resolution and no range limitation, long periods are split in
+ * chained alarms. It keeps on running in STANDBY mode.
  */
 
 /**
@@ -0,0 +1,153 @@
+/* SPDX-License-Identifier: no SPDX license */
+/**
+ * @file    mcu_tim_srv.h
+ * @brief   Software timer service multiplexed on one low-power hardware compare
+ * @author  Kineis
+ */
+
+/**
+ * @page mcu_tim_srv_page MCU wrappers: software TIMer SeRVice
+ *
+ * Hardware timers of mcu_tim (\ref mcu_tim_page) are statically assigned to one Kineis stack
+ * feature each. Any other timed activity (scheduled TX, sensor sampling, log flush, watchdog kick,
+ * ...) uses this service instead, which runs any number of one-shot and periodic software timers
+ * on top of one single hardware compare.
+ *
+ * @section mcu_tim_srv_hw Time base
+ *
+ * Time is read from the RTC binary counter (LSE divided by 32, 1024 Hz, ~1 ms tick), which keeps
+ * counting in all low power modes. Its 32-bit lap is counted on RTC SSRU interrupt, so the
+ * service gives a 64-bit monotonic time in ms (\ref MCU_TIM_SRV_getTimeMs).
+ *
+ * Deadlines are programmed on LPTIM1 compare, LPTIM1 being clocked by LSE divided by 32 too. It
+ * raises interrupts in SLEEP and STOP modes (STOP2 included), not in STANDBY/SHUTDOWN. Deadlines
+ * further than ~31 s are reached through intermediate compare matches. When no timer runs, LPTIM1
+ * interrupt is disabled: MCU is only woken up by the RTC SSRU interrupt, once every ~48 days.
+ *
+ * @section mcu_tim_srv_list Timers
+ *
+ * Running timers are kept in a list sorted by deadline. Only the earliest deadline is programmed
+ * into the compare register, which is updated when the list head changes. Deadlines are kept in
+ * ms, periodic timers are reloaded from their previous deadline so that they do not drift.
+ *
+ * Timer descriptors are allocated by the user (usually static) and stay owned by the service while
+ * running.
+ *
+ * @attention Callbacks run from LPTIM1 ISR. They shall be short: push an event into a queue or set
+ * a task ready (\ref KNS_OS_setTaskReady). Timers can be started or stopped from any context,
+ * callbacks included.
+ *
+ * @note While some timer runs, LPM client (lpm_cli_tim_srv.c) prevents STANDBY and SHUTDOWN.
+ */
+
+/**
+ * @addtogroup MCU_WRAPPERS
+ * @{
+ */
+
+#ifndef MCU_TIM_SRV_H_
+#define MCU_TIM_SRV_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+#include "mcu_tim.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+/** Tick frequency of the time base (LSE / 32) */
+#define MCU_TIM_SRV_TICK_HZ 1024
+
+/* Types ---------------------------------------------------------------------*/
+
+/**
+ * @struct MCU_TIM_SRV_timer_t
+ * @brief Software timer descriptor
+ *
+ * @attention Fields are private to the service, use @ref MCU_TIM_SRV_create to initialize it.
+ */
+struct MCU_TIM_SRV_timer_t {
+	struct MCU_TIM_SRV_timer_t *next; /**< next running timer, sorted by deadline */
+	uint64_t deadlineMs;              /**< absolute expiry time, in ms */
+	uint32_t periodMs;                /**< reload period in ms, 0 for one-shot timer */
+	void (*cb)(void *ctx);            /**< expiry callback, run from ISR */
+	void *ctx;                        /**< user context given to callback */
+	bool isRunning;                   /**< timer is in running list */
+};
+
+/* Function declaration ------------------------------------------------------*/
+
+/**
+ * @brief Initialize the service and start its time base
+ *
+ * Shall be called once at startup, after LSE is running (RTC init).
+ */
+void MCU_TIM_SRV_init(void);
+
+/**
+ * @brief Initialize a timer descriptor
+ *
+ * @param[out] tim timer descriptor
+ * @param[in] cb callback function called from ISR when timer expires
+ * @param[in] ctx user context given to callback
+ */
+void MCU_TIM_SRV_create(struct MCU_TIM_SRV_timer_t *tim, void (*cb)(void *ctx), void *ctx);
+
+/**
+ * @brief Start (or restart) a timer
+ *
+ * @param[in] tim timer descriptor
+ * @param[in] delayMs delay before first expiry in ms, 0 to expire as soon as possible
+ * @param[in] periodMs period of next expiries in ms, 0 for one-shot timer
+ *
+ * @return MCU_TIM_STATUS_OK if success. Error status otherwise.
+ */
+enum mcu_tim_status_t MCU_TIM_SRV_start(struct MCU_TIM_SRV_timer_t *tim, uint32_t delayMs,
+	uint32_t periodMs);
+
+/**
+ * @brief Stop a timer. Nothing is done if timer is not running.
+ *
+ * @param[in] tim timer descriptor
+ *
+ * @return MCU_TIM_STATUS_OK if success. Error status otherwise.
+ */
+enum mcu_tim_status_t MCU_TIM_SRV_stop(struct MCU_TIM_SRV_timer_t *tim);
+
+/**
+ * @brief Check a timer is running
+ *
+ * @param[in] tim timer descriptor
+ *
+ * @return true if timer is running
+ */
+bool MCU_TIM_SRV_isRunning(const struct MCU_TIM_SRV_timer_t *tim);
+
+/**
+ * @brief Get remaining time before next expiry of a timer
+ *
+ * @param[in] tim timer descriptor
+ *
+ * @return remaining time in ms, 0 if timer is not running or about to expire
+ */
+uint32_t MCU_TIM_SRV_getRemainingMs(const struct MCU_TIM_SRV_timer_t *tim);
+
+/**
+ * @brief Check some timer is running
+ *
+ * @return true if at least one timer is running
+ */
+bool MCU_TIM_SRV_isSomeRunning(void);
+
+/**
+ * @brief Get monotonic time of the service
+ *
+ * @return time in ms, from RTC counter origin
+ */
+uint64_t MCU_TIM_SRV_getTimeMs(void);
+
+#endif /* MCU_TIM_SRV_H_ */
+
+/**
+ * @}
+ */
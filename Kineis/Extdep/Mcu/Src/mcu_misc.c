@@ -125,6 +125,23 @@ enum KNS_status_t MCU_MISC_getSettingsHwRf(int8_t rf_level_dBm, void* rfSettings
 	return KNS_STATUS_OK;
 }
 
+void MCU_MISC_cycleCntStart(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t MCU_MISC_getCycleCnt(void)
+{
+	return DWT->CYCCNT;
+}
+
+uint32_t MCU_MISC_getCycleCntFreq(void)
+{
+	return SystemCoreClock;
+}
+
 /**
  * @}
  */
@@ -12,11 +12,12 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
 #include "kns_app_conf.h" // for STM32 HAL include
 #include  STM32_HAL_H
 
 #include "mcu_tim.h"
-#include "tim.h"
+#include "mcu_tim_srv.h"
 #include "rtc.h"
 
 //#undef VERBOSE // TIM verbose log disabled by default as too verbose.
@@ -27,8 +28,29 @@
 
 /* Defines ------------------------------------------------------------*/
 
+/** Longest RTC alarm step, in RTC ticks. Longer TX periods are split in chained alarms so that
+ * the 32-bit RTC counter never laps between two updates of the elapsed time.
+ */
+#define RTC_ALARM_STEP_MAX	(1UL << 31)
+
+/** Shortest delay between now and a programmed RTC alarm, in RTC ticks, so that counter cannot
+ * pass the compare value while it is being written
+ */
+#define RTC_ALARM_DELAY_MIN	2
+
 /* Types -----------------------------------------------------------*/
 
+/**
+ * @struct MCU_TIM_txPeriod_t
+ * @brief TX period context, run on RTC binary counter and alarm A
+ */
+struct MCU_TIM_txPeriod_t {
+	uint64_t elapsedTicks; /**< RTC ticks elapsed from start up to lastTick */
+	uint32_t lastTick;     /**< RTC tick at last update of elapsedTicks */
+	uint32_t periodMs;     /**< TX period in ms */
+	bool isRunning;        /**< TX period timer is running */
+};
+
 /* Macro -------------------------------------------------------------*/
 
 /* Variables ---------------------------------------------------------*/
@@ -44,42 +66,118 @@ typedef enum KNS_status_t (*timeout_isr_cb_t)(void);
 __attribute__((__section__(".lpmSection")))
 static timeout_isr_cb_t timeout_isr_cb[MCU_TIM_HDLR_MAX] = {NULL};
 
+/** TX timeout runs as a one-shot software timer on LPTIM1, thus keeps on running in STOP modes
+ * (TIM16 was only able to wakeup from SLEEP).
+ */
+static struct MCU_TIM_SRV_timer_t txTimeoutTim;
+
+/** Start time of TX timeout, in ms of timer service time base */
+static uint64_t txTimeoutStartMs;
+
+/** TX period context
+ * @attention TX period keeps on running in STANDBY mode, ensure it remains available at LPM wakeup
+ */
+__attribute__((__section__(".lpmSection")))
+static struct MCU_TIM_txPeriod_t txPeriod;
+
 /* Static function declaration -------------------------------------------------------------*/
 
 /* Functions -------------------------------------------------------------*/
 
 /**
- * @brief  Tx Timeout ISR override
+ * @brief  Tx Timeout software timer callback, called from LPTIM1 ISR
  *
- * Depending on timer concerned, call the callback of the corresponding handler
+ * @param[in] ctx unused
+ */
+static void MCU_TIM_txTimeoutCb(__attribute__((unused)) void *ctx)
+{
+	MGR_LOG_VERBOSE("%d: %s %d\r\n", MCU_TIM_HDLR_TX_TIMEOUT, __FUNCTION__, __LINE__);
+	if (timeout_isr_cb[MCU_TIM_HDLR_TX_TIMEOUT] != NULL)
+		timeout_isr_cb[MCU_TIM_HDLR_TX_TIMEOUT]();
+}
+
+/**
+ * @brief Convert ms into RTC ticks, rounded up so that TX period never expires early
+ */
+static uint64_t MCU_TIM_msToRtcTicks(uint32_t ms)
+{
+	return ((uint64_t)ms * RTC_BIN_TICK_HZ + 999) / 1000;
+}
+
+/**
+ * @brief Update TX period elapsed time with RTC counter
  *
- * @note So far in system, all used timers are from mcu_tim, thus the override function can be done
- * here.
+ * @attention Shall be called at least once per lap of the 32-bit RTC counter, which is ensured by
+ * alarm steps being shorter than RTC_ALARM_STEP_MAX.
  *
- * @param[in] htim TIM handle
+ * @return RTC tick of the update
  */
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+static uint32_t MCU_TIM_txPeriodUpdate(void)
 {
-	if (htim == &htim16) {
-		MGR_LOG_VERBOSE("%d: %s %d\r\n", MCU_TIM_HDLR_TX_TIMEOUT, __FUNCTION__,
-			__LINE__);
-		if (timeout_isr_cb[MCU_TIM_HDLR_TX_TIMEOUT] != NULL)
-			timeout_isr_cb[MCU_TIM_HDLR_TX_TIMEOUT]();
-	}
+	uint32_t now = RTC_getBinTick();
+
+	txPeriod.elapsedTicks += (uint32_t)(now - txPeriod.lastTick);
+	txPeriod.lastTick = now;
+
+	return now;
+}
+
+/**
+ * @brief Program RTC alarm A on next step of TX period
+ *
+ * Step ends on TX period expiry, or earlier for periods longer than RTC_ALARM_STEP_MAX (chained
+ * alarms). Alarm matches the whole 32-bit sub-second register, there is no rounding to seconds.
+ *
+ * If RTC counter went beyond compare value while it was written (preemption by higher priority
+ * IRQs), step is programmed again.
+ */
+static void MCU_TIM_txPeriodProgramAlarm(void)
+{
+	RTC_AlarmTypeDef sAlarm = {0};
+	uint64_t remainTicks;
+	uint32_t now, step;
+
+	do {
+		now = MCU_TIM_txPeriodUpdate();
+		remainTicks = MCU_TIM_msToRtcTicks(txPeriod.periodMs) - txPeriod.elapsedTicks;
+		if (remainTicks > RTC_ALARM_STEP_MAX)
+			step = RTC_ALARM_STEP_MAX;
+		else if (remainTicks < RTC_ALARM_DELAY_MIN)
+			step = RTC_ALARM_DELAY_MIN;
+		else
+			step = (uint32_t)remainTicks;
+
+		/** RTC_SSR is a down-counter, alarm compares it with ~tick */
+		sAlarm.AlarmTime.SubSeconds = ~(now + step);
+		sAlarm.AlarmSubSecondMask = RTC_ALARMSUBSECONDBINMASK_NONE;
+		sAlarm.BinaryAutoClr = RTC_ALARMSUBSECONDBIN_AUTOCLR_NO;
+		sAlarm.Alarm = RTC_ALARM_A;
+		if (HAL_RTC_SetAlarm_IT(&hrtc, &sAlarm, RTC_FORMAT_BIN) != HAL_OK)
+			Error_Handler();
+	} while ((uint32_t)(RTC_getBinTick() - now) >= step);
 }
 
 /**
-  * @brief  Wake Up Timer callback.
+  * @brief  RTC alarm A callback, end of a TX period step
   * @param[in] hrtc_local: RTC handle
   */
-void HAL_RTCEx_WakeUpTimerEventCallback(RTC_HandleTypeDef *hrtc_local)
+void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc_local)
 {
-	if (hrtc_local == &hrtc) {
-		MGR_LOG_VERBOSE("%d: %s %d\r\n", MCU_TIM_HDLR_TX_PERIOD, __FUNCTION__, __LINE__);
-		if (timeout_isr_cb[MCU_TIM_HDLR_TX_PERIOD] != NULL)
-			timeout_isr_cb[MCU_TIM_HDLR_TX_PERIOD]();
-
+	if ((hrtc_local != &hrtc) || !txPeriod.isRunning)
+		return;
+
+	MCU_TIM_txPeriodUpdate();
+	if (txPeriod.elapsedTicks < MCU_TIM_msToRtcTicks(txPeriod.periodMs)) {
+		/** Intermediate step of a long period, chain next alarm */
+		MCU_TIM_txPeriodProgramAlarm();
+		return;
 	}
+
+	txPeriod.isRunning = false;
+	HAL_RTC_DeactivateAlarm(&hrtc, RTC_ALARM_A);
+	MGR_LOG_VERBOSE("%d: %s %d\r\n", MCU_TIM_HDLR_TX_PERIOD, __FUNCTION__, __LINE__);
+	if (timeout_isr_cb[MCU_TIM_HDLR_TX_PERIOD] != NULL)
+		timeout_isr_cb[MCU_TIM_HDLR_TX_PERIOD]();
 }
 
 
@@ -97,8 +195,8 @@ enum mcu_tim_status_t MCU_TIM_init(enum mcu_tim_hdlr hdlr, enum KNS_status_t (*e
 	 */
 	switch (hdlr) {
 	case MCU_TIM_HDLR_TX_TIMEOUT:
-		/* uncomment below to handle real init of peripheral HW */
-		MX_TIM16_Init();
+		/** LPTIM1 itself is started once for all by MCU_TIM_SRV_init */
+		MCU_TIM_SRV_create(&txTimeoutTim, MCU_TIM_txTimeoutCb, NULL);
 		timeout_isr_cb[MCU_TIM_HDLR_TX_TIMEOUT] = eop_isr_cb;
 		return MCU_TIM_STATUS_OK;
 	break;
@@ -124,10 +222,7 @@ enum mcu_tim_status_t MCU_TIM_deinit(enum mcu_tim_hdlr hdlr)
 	 */
 	switch (hdlr) {
 	case MCU_TIM_HDLR_TX_TIMEOUT:
-		/* uncomment below to handle real de-init of peripheral HW */
-		if (HAL_TIM_Base_DeInit(&htim16) != HAL_OK)
-			return MCU_TIM_STATUS_ERROR;
-		return MCU_TIM_STATUS_OK;
+		return MCU_TIM_SRV_stop(&txTimeoutTim);
 	break;
 	case MCU_TIM_HDLR_TX_PERIOD:
 		/** @attention Init/DeInit of RTC in timer wrappers may conflict with RTC alarms and
@@ -135,7 +230,7 @@ enum mcu_tim_status_t MCU_TIM_deinit(enum mcu_tim_hdlr hdlr)
 		/* uncomment below to handle real de-init of peripheral HW */
 //		if (HAL_RTC_DeInit(&hrtc) != HAL_OK)
 //			return MCU_TIM_STATUS_ERROR;
-		return MCU_TIM_STATUS_OK;
+		return MCU_TIM_stop(MCU_TIM_HDLR_TX_PERIOD);
 	break;
 	default:
 		return MCU_TIM_STATUS_ERROR;
@@ -145,55 +240,27 @@ enum mcu_tim_status_t MCU_TIM_deinit(enum mcu_tim_hdlr hdlr)
 
 enum mcu_tim_status_t MCU_TIM_start(enum mcu_tim_hdlr hdlr, uint32_t timeout_ms)
 {
-	TIM_HandleTypeDef *htim = &htim16;
-	RTC_HandleTypeDef *hrtc_local;
-	uint32_t cnt_val, cnt_val_max;
-
 	MGR_LOG_VERBOSE("%d: %s %d\r\n", hdlr, __FUNCTION__, __LINE__);
 
-	/** Configure timer handler */
 	switch (hdlr) {
 	case MCU_TIM_HDLR_TX_TIMEOUT:
-		htim = &htim16;
+		/** Software timer has no range limitation (TIM16 was limited to 32767ms) */
+		MGR_LOG_VERBOSE("start timer %d for %d ms\r\n", hdlr, timeout_ms);
+		txTimeoutStartMs = MCU_TIM_SRV_getTimeMs();
+		return MCU_TIM_SRV_start(&txTimeoutTim, timeout_ms, 0);
 	break;
 	case MCU_TIM_HDLR_TX_PERIOD:
-		hrtc_local = &hrtc;
-	break;
-	default:
-		return MCU_TIM_STATUS_ERROR;
-	break;
-	}
-
-	/** Configure timer settings */
-	switch (hdlr) {
-	case MCU_TIM_HDLR_TX_TIMEOUT:
-		/** As htim16 ARR are 16 long, check delay is not too big.
+		/** RTC alarm on sub-second register: no rounding to seconds, no range limitation (the
+		 * 16-bit wakeup timer was limited to 65535s)
 		 */
-		cnt_val = timeout_ms * 2 - 1;
-		cnt_val_max = (1 << 16) - 1;
-		if (cnt_val > cnt_val_max)
-			return MCU_TIM_STATUS_ERROR;
-		MGR_LOG_VERBOSE("start timer %d for %d ms, cnt=%d, cnt_max=%d\r\n",
-				hdlr, timeout_ms, cnt_val, cnt_val_max);
-
-		__HAL_TIM_CLEAR_FLAG(htim, TIM_IT_UPDATE);
-		__HAL_TIM_SET_COUNTER(htim, 0);
-		__HAL_TIM_SET_AUTORELOAD(htim, cnt_val);
-		HAL_TIM_Base_Start_IT(htim);
-	break;
-	case MCU_TIM_HDLR_TX_PERIOD:
-		cnt_val = timeout_ms / 1000;
-		cnt_val--; /** With this config of RTC timer (1s tick), need to reduce count down
-			    * by one
-			    */
-		cnt_val_max = (1 << 16) - 1;
-		if (cnt_val > cnt_val_max)
-			return MCU_TIM_STATUS_ERROR;
-		MGR_LOG_VERBOSE("start timer %d for %d ms, cnt=%d, cnt_max=%d\r\n",
-				hdlr, timeout_ms, cnt_val, cnt_val_max);
-		if (HAL_RTCEx_SetWakeUpTimer_IT(hrtc_local, cnt_val,
-		    RTC_WAKEUPCLOCK_CK_SPRE_16BITS, 0) != HAL_OK)
-			Error_Handler();
+		MGR_LOG_VERBOSE("start timer %d for %d ms\r\n", hdlr, timeout_ms);
+		HAL_NVIC_DisableIRQ(RTC_Alarm_IRQn);
+		txPeriod.elapsedTicks = 0;
+		txPeriod.lastTick = RTC_getBinTick();
+		txPeriod.periodMs = timeout_ms;
+		txPeriod.isRunning = true;
+		MCU_TIM_txPeriodProgramAlarm();
+		HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
 	break;
 	default:
 		return MCU_TIM_STATUS_ERROR;
@@ -205,19 +272,22 @@ enum mcu_tim_status_t MCU_TIM_start(enum mcu_tim_hdlr hdlr, uint32_t timeout_ms)
 
 enum mcu_tim_status_t MCU_TIM_getCount(enum mcu_tim_hdlr hdlr, uint32_t *elapsed_time_ms)
 {
-	TIM_HandleTypeDef *htim;
-	RTC_HandleTypeDef *hrtc_local;
+	uint64_t elapsedTicks;
 
 	switch (hdlr) {
 	case MCU_TIM_HDLR_TX_TIMEOUT:
-		htim = &htim16;
-		/** Get counter value and divide it by 2 as it is currently a 500us-step counter */
-		*elapsed_time_ms = __HAL_TIM_GET_COUNTER(htim) / 2;
+		*elapsed_time_ms = (uint32_t)(MCU_TIM_SRV_getTimeMs() - txTimeoutStartMs);
 	break;
 	case MCU_TIM_HDLR_TX_PERIOD:
-		hrtc_local = &hrtc;
-		/** Get counter value and divide it by 2 as it is currently a 500us-step counter */
-		*elapsed_time_ms = 1000 * HAL_RTCEx_GetWakeUpTimer(hrtc_local);
+		/** Elapsed time from start, read from RTC counter (the wakeup timer only gave back its
+		 * reload value). It stops increasing once TX period expired.
+		 */
+		HAL_NVIC_DisableIRQ(RTC_Alarm_IRQn);
+		if (txPeriod.isRunning)
+			MCU_TIM_txPeriodUpdate();
+		elapsedTicks = txPeriod.elapsedTicks;
+		HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
+		*elapsed_time_ms = (uint32_t)((elapsedTicks * 1000) / RTC_BIN_TICK_HZ);
 	break;
 	default:
 		return MCU_TIM_STATUS_ERROR;
@@ -231,19 +301,17 @@ enum mcu_tim_status_t MCU_TIM_getCount(enum mcu_tim_hdlr hdlr, uint32_t *elapsed
 
 enum mcu_tim_status_t MCU_TIM_stop(enum mcu_tim_hdlr hdlr)
 {
-	TIM_HandleTypeDef *htim;
-	RTC_HandleTypeDef *hrtc_local;
-
 	MGR_LOG_VERBOSE("%d: %s %d\r\n", hdlr, __FUNCTION__, __LINE__);
 
 	switch (hdlr) {
 	case MCU_TIM_HDLR_TX_TIMEOUT:
-		htim = &htim16;
-		HAL_TIM_Base_Stop_IT(htim);
+		return MCU_TIM_SRV_stop(&txTimeoutTim);
 	break;
 	case MCU_TIM_HDLR_TX_PERIOD:
-		hrtc_local = &hrtc;
-		HAL_RTCEx_DeactivateWakeUpTimer(hrtc_local);
+		HAL_NVIC_DisableIRQ(RTC_Alarm_IRQn);
+		txPeriod.isRunning = false;
+		HAL_RTC_DeactivateAlarm(&hrtc, RTC_ALARM_A);
+		HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
 	break;
 	default:
 		return MCU_TIM_STATUS_ERROR;
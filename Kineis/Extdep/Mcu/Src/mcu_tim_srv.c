@@ -0,0 +1,453 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    mcu_tim_srv.c
+ * @brief   Software timer service multiplexed on LPTIM1 compare
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup MCU_WRAPPERS
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "kns_app_conf.h" // for STM32 HAL include
+#include  STM32_HAL_H
+
+#include "mcu_tim_srv.h"
+#include "rtc.h"
+#include "kineis_sw_conf.h"
+#include KINEIS_CS_H
+
+//#undef VERBOSE // TIM verbose log disabled by default as too verbose.
+#include "mgr_log.h"
+
+/* Defines ------------------------------------------------------------*/
+
+/** LPTIM1 auto-reload value, counter runs over its full 16-bit range */
+#define LPTIM_ARR_VAL		0xFFFFU
+
+/** Compare value programmed at init, before any timer runs.
+ * @note CMP shall be strictly lower than ARR.
+ */
+#define LPTIM_CMP_IDLE		(LPTIM_ARR_VAL - 1)
+
+/** Longest step programmed in LPTIM1 compare, in ticks. Later deadlines are reached through
+ * intermediate compare matches. It is kept below half a counter lap, so that a compare value
+ * already passed is told apart from a future one.
+ */
+#define LPTIM_CMP_STEP_MAX	0x7F00U
+
+/** LPTIM1 and RTC SSRU IRQ priority, same as other MCU timers */
+#define LPTIM_IRQ_PRIO		4
+
+/* Variables ---------------------------------------------------------*/
+
+/** Running timers, sorted by deadline */
+static struct MCU_TIM_SRV_timer_t *runList;
+
+/** Number of RTC binary counter underflows (upper bits of tick counter) */
+static uint32_t rtcLapCnt;
+
+/** Compare value currently programmed in LPTIM1 */
+static uint16_t hwCmp = LPTIM_CMP_IDLE;
+
+/** Offset from LPTIM1 counter to RTC tick counter (lower 16 bits), see MCU_TIM_SRV_init */
+static uint16_t hwCntOffset;
+
+/** LPTIM1 compare IRQ and wake-up are enabled, i.e. some timer runs */
+static bool hwIsArmed;
+
+/* Static functions ----------------------------------------------------------*/
+
+/**
+ * @brief Get 64-bit tick counter
+ *
+ * Time base is the RTC binary counter (LSE / 32 as well), which runs in all low power modes and
+ * needs no wake-up to be extended: its 32-bit lap is counted on RTC SSRU interrupt, once every
+ * ~48 days.
+ *
+ * Underflow may be pending (SSRUF flag set, IRQ not served yet), it is then accounted here. Flag
+ * is read after counter, a flag set while counter is still in its upper half means the counter was
+ * read just before the underflow.
+ *
+ * @return number of RTC ticks
+ */
+static uint64_t MCU_TIM_SRV_getTicks(void)
+{
+	uint64_t lap;
+	uint32_t tick;
+	uint32_t csMask;
+
+	csMask = KNS_CS_enterSave();
+	tick = RTC_getBinTick();
+	lap = rtcLapCnt;
+	if (((RTC->SR & RTC_SR_SSRUF) != 0) && (tick < 0x80000000UL))
+		lap++;
+	KNS_CS_exitRestore(csMask);
+
+	return (lap << 32) | tick;
+}
+
+/**
+ * @brief Read LPTIM1 counter
+ *
+ * @return counter value
+ */
+static uint16_t MCU_TIM_SRV_getCnt(void)
+{
+	uint32_t cnt;
+
+	/** LPTIM counter is asynchronous to APB clock, read it until two reads match */
+	do {
+		cnt = LPTIM1->CNT;
+	} while (cnt != LPTIM1->CNT);
+
+	return (uint16_t)cnt;
+}
+
+/**
+ * @brief Convert ticks into ms, rounded down
+ */
+static uint64_t MCU_TIM_SRV_ticksToMs(uint64_t ticks)
+{
+	return (ticks * 1000) / MCU_TIM_SRV_TICK_HZ;
+}
+
+/**
+ * @brief Convert ms into ticks, rounded up so that a deadline never fires early
+ */
+static uint64_t MCU_TIM_SRV_msToTicks(uint64_t ms)
+{
+	return (ms * MCU_TIM_SRV_TICK_HZ + 999) / 1000;
+}
+
+/**
+ * @brief Write LPTIM1 compare register
+ *
+ * Write is synchronized to LPTIM kernel clock (LSE), CMPOK tells when it is done. Next write shall
+ * not happen before, so wait for it here.
+ *
+ * @param[in] cmp compare value, lower than ARR
+ */
+static void MCU_TIM_SRV_setCmp(uint16_t cmp)
+{
+	if (cmp == hwCmp)
+		return;
+	LPTIM1->CMP = cmp;
+	while ((LPTIM1->ISR & LPTIM_ISR_CMPOK) == 0)
+		;
+	LPTIM1->ICR = LPTIM_ICR_CMPOKCF;
+	hwCmp = cmp;
+}
+
+/**
+ * @brief Program LPTIM1 compare with deadline of list head
+ *
+ * When no timer runs, LPTIM1 keeps counting but its IRQ and EXTI wake-up line are disabled, so
+ * that MCU is not woken up at all. They are enabled again, stale compare match dropped, when
+ * the list gets a head.
+ *
+ * Deadline is converted from RTC ticks into LPTIM1 counter through hwCntOffset. As offset is never
+ * above the actual one, compare never matches before deadline (up to 2 ticks, ~2 ms, after).
+ * Deadlines further than LPTIM_CMP_STEP_MAX are reached in several steps, the compare IRQ running
+ * again this function.
+ *
+ * If deadline is already reached (or compare got passed while it was being written), IRQ is set
+ * pending by SW.
+ *
+ * @attention Shall be called within critical section
+ */
+static void MCU_TIM_SRV_programHw(void)
+{
+	uint64_t nowTicks, dlTicks;
+	uint16_t cmp;
+
+	if (runList == NULL) {
+		if (hwIsArmed) {
+			LL_EXTI_DisableIT_0_31(LL_EXTI_LINE_29);
+			NVIC_DisableIRQ(LPTIM1_IRQn);
+			hwIsArmed = false;
+		}
+		return;
+	}
+
+	if (!hwIsArmed) {
+		LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+		NVIC_ClearPendingIRQ(LPTIM1_IRQn);
+		LL_EXTI_EnableIT_0_31(LL_EXTI_LINE_29);
+		NVIC_EnableIRQ(LPTIM1_IRQn);
+		hwIsArmed = true;
+	}
+
+	dlTicks = MCU_TIM_SRV_msToTicks(runList->deadlineMs);
+	nowTicks = MCU_TIM_SRV_getTicks();
+	if (dlTicks <= nowTicks) {
+		NVIC_SetPendingIRQ(LPTIM1_IRQn);
+		return;
+	}
+	if ((dlTicks - nowTicks) > LPTIM_CMP_STEP_MAX)
+		dlTicks = nowTicks + LPTIM_CMP_STEP_MAX;
+
+	/** CMP shall be strictly lower than ARR, next value matches one tick later */
+	cmp = (uint16_t)(dlTicks - hwCntOffset);
+	if (cmp == LPTIM_ARR_VAL)
+		cmp = 0;
+	MCU_TIM_SRV_setCmp(cmp);
+
+	/** Counter at or beyond compare (within half a lap) means the match may have been missed */
+	if ((uint16_t)(MCU_TIM_SRV_getCnt() - cmp) < 0x8000U)
+		NVIC_SetPendingIRQ(LPTIM1_IRQn);
+}
+
+/**
+ * @brief Insert a timer in running list, after timers having same deadline
+ *
+ * @attention Shall be called within critical section
+ *
+ * @param[in] tim timer descriptor, deadline already set
+ */
+static void MCU_TIM_SRV_insert(struct MCU_TIM_SRV_timer_t *tim)
+{
+	struct MCU_TIM_SRV_timer_t **pos = &runList;
+
+	while ((*pos != NULL) && ((*pos)->deadlineMs <= tim->deadlineMs))
+		pos = &(*pos)->next;
+	tim->next = *pos;
+	*pos = tim;
+	tim->isRunning = true;
+}
+
+/**
+ * @brief Remove a timer from running list
+ *
+ * @attention Shall be called within critical section
+ *
+ * @param[in] tim timer descriptor
+ */
+static void MCU_TIM_SRV_remove(struct MCU_TIM_SRV_timer_t *tim)
+{
+	struct MCU_TIM_SRV_timer_t **pos = &runList;
+
+	while ((*pos != NULL) && (*pos != tim))
+		pos = &(*pos)->next;
+	if (*pos != NULL)
+		*pos = tim->next;
+	tim->next = NULL;
+	tim->isRunning = false;
+}
+
+/**
+ * @brief Run expired timers and program next deadline
+ *
+ * Callbacks are called outside of critical section so that they can start/stop timers. A periodic
+ * timer is reloaded from its previous deadline. If MCU could not serve it for more than one
+ * period, missed expiries are skipped instead of being called in burst.
+ */
+static void MCU_TIM_SRV_process(void)
+{
+	struct MCU_TIM_SRV_timer_t *tim;
+	uint32_t csMask;
+	void (*cb)(void *ctx);
+	void *ctx;
+	uint64_t nowMs = MCU_TIM_SRV_getTimeMs();
+
+	while (1) {
+		csMask = KNS_CS_enterSave();
+		tim = runList;
+		if ((tim == NULL) || (tim->deadlineMs > nowMs)) {
+			MCU_TIM_SRV_programHw();
+			KNS_CS_exitRestore(csMask);
+			return;
+		}
+		runList = tim->next;
+		tim->next = NULL;
+		tim->isRunning = false;
+		if (tim->periodMs != 0) {
+			do {
+				tim->deadlineMs += tim->periodMs;
+			} while (tim->deadlineMs <= nowMs);
+			MCU_TIM_SRV_insert(tim);
+		}
+		cb = tim->cb;
+		ctx = tim->ctx;
+		KNS_CS_exitRestore(csMask);
+
+		MGR_LOG_VERBOSE("[TIM_SRV] %p expired at %lu ms\r\n", tim, (uint32_t)nowMs);
+		if (cb != NULL)
+			cb(ctx);
+	}
+}
+
+/* Functions -----------------------------------------------------------------*/
+
+/**
+ * @brief LPTIM1 global interrupt handler (compare match)
+ */
+void LPTIM1_IRQHandler(void)
+{
+	LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+
+	MCU_TIM_SRV_process();
+}
+
+/**
+ * @brief RTC SSRU interrupt handler (binary counter underflow), shared with tamper, timestamp and
+ * LSECSS interrupts which are not used
+ */
+void TAMP_STAMP_LSECSS_SSRU_IRQHandler(void)
+{
+	uint32_t csMask;
+
+	csMask = KNS_CS_enterSave();
+	if ((RTC->MISR & RTC_MISR_SSRUMF) != 0) {
+		RTC->SCR = RTC_SCR_CSSRUF;
+		rtcLapCnt++;
+	}
+	KNS_CS_exitRestore(csMask);
+}
+
+void MCU_TIM_SRV_init(void)
+{
+	runList = NULL;
+	rtcLapCnt = 0;
+	hwIsArmed = false;
+
+	/** RTC binary counter underflow extends the time base. Stale flag is dropped so that it is
+	 * not accounted as a lap.
+	 */
+	RTC->SCR = RTC_SCR_CSSRUF;
+	if (HAL_RTCEx_SetSSRU_IT(&hrtc) != HAL_OK)
+		Error_Handler();
+	HAL_NVIC_SetPriority(TAMP_STAMP_LSECSS_SSRU_IRQn, LPTIM_IRQ_PRIO, 0);
+	HAL_NVIC_EnableIRQ(TAMP_STAMP_LSECSS_SSRU_IRQn);
+
+	__HAL_RCC_LPTIM1_CONFIG(RCC_LPTIM1CLKSOURCE_LSE);
+	__HAL_RCC_LPTIM1_CLK_ENABLE();
+	__HAL_RCC_LPTIM1_FORCE_RESET();
+	__HAL_RCC_LPTIM1_RELEASE_RESET();
+
+	/** CFGR and IER can only be written while LPTIM is disabled: internal clock, prescaler /32,
+	 * compare IRQ enabled for good (it is masked in NVIC and EXTI while no timer runs).
+	 */
+	LPTIM1->CFGR = LPTIM_CFGR_PRESC_2 | LPTIM_CFGR_PRESC_0;
+	LPTIM1->IER = LPTIM_IER_CMPMIE;
+	LPTIM1->CR = LPTIM_CR_ENABLE;
+
+	LPTIM1->ARR = LPTIM_ARR_VAL;
+	while ((LPTIM1->ISR & LPTIM_ISR_ARROK) == 0)
+		;
+	LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+	LPTIM1->CMP = LPTIM_CMP_IDLE;
+	while ((LPTIM1->ISR & LPTIM_ISR_CMPOK) == 0)
+		;
+	LPTIM1->ICR = LPTIM_ICR_CMPOKCF;
+	hwCmp = LPTIM_CMP_IDLE;
+
+	/** LPTIM1 wakes-up MCU from STOP modes through EXTI line 29, enabled while some timer runs */
+	HAL_NVIC_SetPriority(LPTIM1_IRQn, LPTIM_IRQ_PRIO, 0);
+
+	LPTIM1->CR |= LPTIM_CR_CNTSTRT;
+
+	/** Measure offset to RTC counter once LPTIM1 counts. Both counters tick at the same rate but
+	 * with another phase, so RTC - LPTIM1 is o right after a LPTIM1 tick and o + 1 later on. A
+	 * LPTIM1 tick between both reads may lower the measure by one. One is removed so that offset
+	 * is never above o, the value seen by a compare match.
+	 */
+	while (MCU_TIM_SRV_getCnt() == 0)
+		;
+	hwCntOffset = (uint16_t)RTC_getBinTick();
+	hwCntOffset -= MCU_TIM_SRV_getCnt() + 1;
+}
+
+void MCU_TIM_SRV_create(struct MCU_TIM_SRV_timer_t *tim, void (*cb)(void *ctx), void *ctx)
+{
+	tim->next = NULL;
+	tim->deadlineMs = 0;
+	tim->periodMs = 0;
+	tim->cb = cb;
+	tim->ctx = ctx;
+	tim->isRunning = false;
+}
+
+enum mcu_tim_status_t MCU_TIM_SRV_start(struct MCU_TIM_SRV_timer_t *tim, uint32_t delayMs,
+	uint32_t periodMs)
+{
+	uint32_t csMask;
+
+	if (tim == NULL)
+		return MCU_TIM_STATUS_ERROR;
+
+	MGR_LOG_VERBOSE("[TIM_SRV] start %p, delay %lu ms, period %lu ms\r\n", tim, delayMs,
+		periodMs);
+
+	csMask = KNS_CS_enterSave();
+	if (tim->isRunning)
+		MCU_TIM_SRV_remove(tim);
+	tim->deadlineMs = MCU_TIM_SRV_getTimeMs() + delayMs;
+	tim->periodMs = periodMs;
+	MCU_TIM_SRV_insert(tim);
+	if (runList == tim)
+		MCU_TIM_SRV_programHw();
+	KNS_CS_exitRestore(csMask);
+
+	return MCU_TIM_STATUS_OK;
+}
+
+enum mcu_tim_status_t MCU_TIM_SRV_stop(struct MCU_TIM_SRV_timer_t *tim)
+{
+	bool wasHead;
+	uint32_t csMask;
+
+	if (tim == NULL)
+		return MCU_TIM_STATUS_ERROR;
+
+	MGR_LOG_VERBOSE("[TIM_SRV] stop %p\r\n", tim);
+
+	csMask = KNS_CS_enterSave();
+	if (tim->isRunning) {
+		wasHead = (runList == tim);
+		MCU_TIM_SRV_remove(tim);
+		if (wasHead)
+			MCU_TIM_SRV_programHw();
+	}
+	KNS_CS_exitRestore(csMask);
+
+	return MCU_TIM_STATUS_OK;
+}
+
+bool MCU_TIM_SRV_isRunning(const struct MCU_TIM_SRV_timer_t *tim)
+{
+	return (tim != NULL) && tim->isRunning;
+}
+
+uint32_t MCU_TIM_SRV_getRemainingMs(const struct MCU_TIM_SRV_timer_t *tim)
+{
+	uint64_t nowMs, remainingMs = 0;
+	uint32_t csMask;
+
+	csMask = KNS_CS_enterSave();
+	if (MCU_TIM_SRV_isRunning(tim)) {
+		nowMs = MCU_TIM_SRV_getTimeMs();
+		if (tim->deadlineMs > nowMs)
+			remainingMs = tim->deadlineMs - nowMs;
+	}
+	KNS_CS_exitRestore(csMask);
+
+	return (uint32_t)remainingMs;
+}
+
+bool MCU_TIM_SRV_isSomeRunning(void)
+{
+	return runList != NULL;
+}
+
+uint64_t MCU_TIM_SRV_getTimeMs(void)
+{
+	return MCU_TIM_SRV_ticksToMs(MCU_TIM_SRV_getTicks());
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: no SPDX license */
+/**
+ * @file    lpm_cli_at_console.h
+ * @brief   AT console's LPM client. It is implementing APIs needed to interface with the low
+ *          power manager (MGR_LPM)
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup MGR_LPM
+ * @{
+ */
+
+#ifndef LPM_CLI_AT_CONSOLE_H
+#define LPM_CLI_AT_CONSOLE_H
+
+/* Includes ------------------------------------------------------------------------------------ */
+#include <stdbool.h>
+#include "mgr_lpm.h"
+
+/* Enums --------------------------------------------------------------------------------------- */
+
+extern struct MgrLpmClientCb_t mgrLpmCliAtConsole;
+
+/* Functions ----------------------------------------------------------------------------------- */
+
+/**
+ * @brief Request deepest LPM allowed by the AT console client
+ *
+ * AT console transmission is drained by DMA in background. The UART and DMA keep on running in
+ * SLEEP mode only. Thus deepest LPM is:
+ * * SLEEP as long as some characters are not fully sent
+ * * SHUTDOWN otherwise (i.e. no constraint from this client)
+ *
+ * @return MgrLpm_LPM_t return the low power mode as per MGR_LPM definition
+ */
+enum MgrLpm_LPM_t AT_CONSOLE_lpmReq(void);
+
+/**
+ * @brief Notify the AT console client which LPM is going to enter
+ *
+ * @param[in] enteringLpm entering LPM as per MGR_LPM definition
+ *
+ * @return true is status is OK, false otherwise
+ */
+bool AT_CONSOLE_lpmNotifEnter(enum MgrLpm_LPM_t enteringLpm);
+
+/**
+ * @brief Notify the AT console client from which LPM UC just exited
+ *
+ * @param[in] exitingLpm exiting LPM as per MGR_LPM definition
+ *
+ * @return true is status is OK, false otherwise
+ */
+bool AT_CONSOLE_lpmNotifExit(enum MgrLpm_LPM_t exitingLpm);
+
+#endif /* LPM_CLI_AT_CONSOLE_H */
+
+/**
+ * @}
+ */
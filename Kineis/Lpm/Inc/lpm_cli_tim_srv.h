@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: no SPDX license */
+/**
+ * @file    lpm_cli_tim_srv.h
+ * @brief   Software timer service's LPM client. It is implementing APIs needed to interface with
+ *          the low power manager (MGR_LPM)
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup MGR_LPM
+ * @{
+ */
+
+#ifndef LPM_CLI_TIM_SRV_H
+#define LPM_CLI_TIM_SRV_H
+
+/* Includes ------------------------------------------------------------------------------------ */
+#include <stdbool.h>
+#include "mgr_lpm.h"
+
+/* Enums --------------------------------------------------------------------------------------- */
+
+extern struct MgrLpmClientCb_t mgrLpmCliTimSrv;
+
+/* Functions ----------------------------------------------------------------------------------- */
+
+/**
+ * @brief Request deepest LPM allowed by the software timer service client
+ *
+ * Software timers run on LPTIM1, which is clocked and can wake-up the MCU up to STOP modes. Thus
+ * deepest LPM is:
+ * * STOP as long as some timer is running
+ * * SHUTDOWN otherwise (i.e. no constraint from this client)
+ *
+ * @return MgrLpm_LPM_t return the low power mode as per MGR_LPM definition
+ */
+enum MgrLpm_LPM_t TIM_SRV_lpmReq(void);
+
+/**
+ * @brief Notify the software timer service client which LPM is going to enter
+ *
+ * @param[in] enteringLpm entering LPM as per MGR_LPM definition
+ *
+ * @return true is status is OK, false otherwise
+ */
+bool TIM_SRV_lpmNotifEnter(enum MgrLpm_LPM_t enteringLpm);
+
+/**
+ * @brief Notify the software timer service client from which LPM UC just exited
+ *
+ * @param[in] exitingLpm exiting LPM as per MGR_LPM definition
+ *
+ * @return true is status is OK, false otherwise
+ */
+bool TIM_SRV_lpmNotifExit(enum MgrLpm_LPM_t exitingLpm);
+
+#endif /* LPM_CLI_TIM_SRV_H */
+
+/**
+ * @}
+ */
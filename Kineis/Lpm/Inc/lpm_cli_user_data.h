@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: no SPDX license */
+/**
+ * @file    lpm_cli_user_data.h
+ * @brief   USERDATA TX journal's LPM client. It is implementing APIs needed to interface with the
+ *          low power manager (MGR_LPM)
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup MGR_LPM
+ * @{
+ */
+
+#ifndef LPM_CLI_USER_DATA_H
+#define LPM_CLI_USER_DATA_H
+
+/* Includes ------------------------------------------------------------------------------------ */
+#include <stdbool.h>
+#include "mgr_lpm.h"
+
+/* Enums --------------------------------------------------------------------------------------- */
+
+extern struct MgrLpmClientCb_t mgrLpmCliUserData;
+
+/* Functions ----------------------------------------------------------------------------------- */
+
+/**
+ * @brief Request deepest LPM allowed by the USERDATA TX journal client
+ *
+ * Journal has no constraint on LPM, thus deepest LPM is SHUTDOWN.
+ *
+ * @return MgrLpm_LPM_t return the low power mode as per MGR_LPM definition
+ */
+enum MgrLpm_LPM_t USERDATA_lpmReq(void);
+
+/**
+ * @brief Notify the USERDATA TX journal client which LPM is going to enter
+ *
+ * Records staged in RAM (cf \ref USERDATA_journalSetSyncBatch) are written in flash before
+ * entering STANDBY or SHUTDOWN modes, as the MCU may not wake-up from them before a power loss.
+ *
+ * @param[in] enteringLpm entering LPM as per MGR_LPM definition
+ *
+ * @return true is status is OK, false otherwise
+ */
+bool USERDATA_lpmNotifEnter(enum MgrLpm_LPM_t enteringLpm);
+
+/**
+ * @brief Notify the USERDATA TX journal client from which LPM UC just exited
+ *
+ * @param[in] exitingLpm exiting LPM as per MGR_LPM definition
+ *
+ * @return true is status is OK, false otherwise
+ */
+bool USERDATA_lpmNotifExit(enum MgrLpm_LPM_t exitingLpm);
+
+#endif /* LPM_CLI_USER_DATA_H */
+
+/**
+ * @}
+ */
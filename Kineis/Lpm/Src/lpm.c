@@ -24,6 +24,9 @@
 #include "lpm.h"
 #include "mgr_lpm.h"
 #include "lpm_cli_kstk.h"
+#include "lpm_cli_at_console.h"
+#include "lpm_cli_tim_srv.h"
+#include "lpm_cli_user_data.h"
 #include "mgr_log.h"
 
 #pragma GCC visibility push(default)
@@ -98,6 +101,9 @@ struct LPM_retentionReg_t lpm_ctxt = {
 	.low_power_mode = LOW_POWER_MODE_NONE
 };
 
+/** UART woke-up the MCU from STOP, set from LPUART1 IRQ */
+static volatile bool bLpmIsUartWakeUp;
+
 /* Private functions --------------------------------------------------------------------------- */
 
 static bool LPM_configWakeUpUart(void)
@@ -241,15 +247,29 @@ static void LPM_sleep_exit() {
 //	MGR_LOG_DEBUG("==== SLEEP exit ====\r\n");
 }
 
+/**
+ * @brief UART wake-up from STOP callback, invoked from LPUART1 IRQ
+ *
+ * This function overrides the generic defined one from STM32HAL_UART.
+ *
+ * @param huart UART handle.
+ */
+void HAL_UARTEx_WakeupCallback(UART_HandleTypeDef *huart)
+{
+	if (huart == &hlpuart1)
+		bLpmIsUartWakeUp = true;
+}
+
 /** @brief System callback invoked by MGR_LPM at STOP mode entering */
 static void LPM_stop_enter() {
 //	MGR_LOG_DEBUG("==== STOP enter ====\r\n");
+	bLpmIsUartWakeUp = false;
 	GPIO_DisableAllToAnalogInput();
 	/** Configure and renable interrupt as wakeup from UART is needed in case of GUI APP.
 	 *
 	 * @attention, This should not be done in case of standalone APP, as long as UART reception
-	 * is not is fully configured (need to call UART_Start_Receive_IT or KINEIS_UART_StartRx_IT
-	 * at init)
+	 * is not is fully configured (need to call HAL_UARTEx_ReceiveToIdle_DMA or
+	 * KINEIS_UART_StartRx_DMA at init)
 	 *
 	 * */
 	LPM_configWakeUpUart();
@@ -262,10 +282,13 @@ static void LPM_stop_exit() {
 	/* Wake Up on start bit detection successful */
 	LPM_SystemClock_Config_RestoreFromStop();
 	HAL_UARTEx_DisableStopMode(&hlpuart1);
-	HAL_Delay(100); /** So far need to add some delay at exit before being able to receive a new
-			 * AT command from UART link.
-			 * @note same delay used in STM32 examples
-			 */
+	/** So far need to add some delay at exit before being able to receive a new AT command from
+	 * UART link. It is only paid when UART woke-up the MCU, not on other wake-up sources (e.g.
+	 * SUBGHZ TX done, LPTIM1 timers).
+	 * @note same delay used in STM32 examples
+	 */
+	if (bLpmIsUartWakeUp)
+		HAL_Delay(100);
 //	MGR_LOG_DEBUG("==== STOP exit ====\r\n");
 }
 
@@ -333,8 +356,8 @@ void LPM_SystemClockConfig(void)
 	/* =================== SLEEP/STOP support ============================= */
 	/* Disable Prefetch Buffer */
 	__HAL_FLASH_PREFETCH_BUFFER_DISABLE();
-	/* Reset all RCC Clock-enable in Sleep and Stop modes but LPTIM1 and LPUART in a way to
-	 * improve current drain.
+	/* Reset all RCC Clock-enable in Sleep and Stop modes but LPTIM1, LPUART and its RX DMA in a
+	 * way to improve current drain.
 	 */
 	/* \note: sounds like no official HAL API exists to configure clock sleep */
 	RCC->AHB1SMENR  = 0x0;
@@ -343,8 +366,10 @@ void LPM_SystemClockConfig(void)
 	RCC->APB1SMENR1 = 0x0;
 	RCC->APB1SMENR2 = 0x0;
 	RCC->APB2SMENR  = 0x0;
-//	__HAL_RCC_LPTIM1_CLK_SLEEP_ENABLE();
+	__HAL_RCC_LPTIM1_CLK_SLEEP_ENABLE();
 	__HAL_RCC_LPUART1_CLK_SLEEP_ENABLE();
+	__HAL_RCC_DMAMUX1_CLK_SLEEP_ENABLE();
+	__HAL_RCC_DMA1_CLK_SLEEP_ENABLE();
 
 	/* =================== STOP support ============================= */
 	/* Configure the wake up from stop clock, back to full speed HSI. From System clock MUX,
@@ -376,6 +401,11 @@ void LPM_init(void)
 {
 	MGR_LPM_init(lpm_config);
 	MGR_LPM_registerClient(mgrLpmCliKstk);
+	MGR_LPM_registerClient(mgrLpmCliAtConsole);
+	MGR_LPM_registerClient(mgrLpmCliTimSrv);
+#ifdef USE_USERDATA_JOURNAL
+	MGR_LPM_registerClient(mgrLpmCliUserData);
+#endif
 }
 
 void LPM_enter(void)
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    lpm_cli_at_console.c
+ * @brief   AT console's LPM client. It is implementing APIs needed to interface with the low
+ *          power manager (MGR_LPM)
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup MGR_LPM
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------------------------ */
+#include <stdbool.h>
+#include "lpm_cli_at_console.h"
+#include "mgr_lpm.h"
+#include "mcu_at_console.h"
+
+/* Variables ----------------------------------------------------------------------------------- */
+
+struct MgrLpmClientCb_t mgrLpmCliAtConsole =
+{     .fpMGR_LPM_LpmReqCb        = AT_CONSOLE_lpmReq,
+      .fpMGR_LPM_LpmNotifEnterCb = AT_CONSOLE_lpmNotifEnter,
+      .fpMGR_LPM_LpmNotifExitCb  = AT_CONSOLE_lpmNotifExit
+};
+
+/* Functions ----------------------------------------------------------------------------------- */
+
+enum MgrLpm_LPM_t AT_CONSOLE_lpmReq(void)
+{
+	/** DMA is not clocked from STOP mode. Stay in SLEEP until last character left the UART,
+	 * otherwise response would be truncated.
+	 */
+	if (MCU_AT_CONSOLE_isTxBusy())
+		return LOW_POWER_MODE_SLEEP;
+	return LOW_POWER_MODE_SHUTDOWN;
+}
+
+bool AT_CONSOLE_lpmNotifEnter(__attribute__((unused)) enum MgrLpm_LPM_t enteringLpm)
+{
+	return true;
+}
+
+bool AT_CONSOLE_lpmNotifExit(__attribute__((unused)) enum MgrLpm_LPM_t exitingLpm)
+{
+	return true;
+}
+
+/**
+ * @}
+ */
@@ -37,20 +37,27 @@ enum MgrLpm_LPM_t KSTK_lpmReq(void)
 	 * * RUNTIME when woken-up to:
 	 *     * configure/start the SUBGHZ RF through SPI bus
 	 *     * start the TX- TIMEOUT timer
-	 * * LPSLEEP or STOP during SUBGHZ transmission, until TX DONE or until TX TIMEOUT
+	 * * SLEEP during SUBGHZ transmission, until TX DONE or until TX TIMEOUT. STOP when
+	 *   LPM_TX_STOP_ENABLED, as the TX timeout timer (LPTIM1, cf mcu_tim_srv) also wakes-up
+	 *   from STOP. It is not the default as long as energy per message is not measured: each
+	 *   STOP exit restores the system clock.
 	 * * STANDBY in any other situation (RTC timer is used for periodical transmission
 	 * * SHUTDOWN when there is no ressource to backup.
 	 *   @attention KNS-MAC-ressource status is an internal variable which acyually needs to
 	 *   remain over LPM, but when all is cleared, it is ok to enter a LPM (e.g. shutdown)
 	 *   which clears this variables (as it is already cleared!!)
 	 *
-	 * * @note SUBGHZ peripheral is able to wakeup the STM32WL55xx uC from STNDBY, but the timer
-	 * TIM16 is only able to wakeup from LPSLEEP
+	 * * @note SUBGHZ peripheral is able to wakeup the STM32WL55xx uC from STNDBY, but the TX
+	 * timeout timer (LPTIM1, cf mcu_tim_srv) is only able to wakeup from STOP
 	 * */
 	if (rsrc.raw == 0x0)
 		return LOW_POWER_MODE_SHUTDOWN;
-	if (rsrc.txTimeout == 1) // as TX timeout timer is htim16 (cf aks_l1_cfg.h)
+	if (rsrc.txTimeout == 1)
+#ifdef LPM_TX_STOP_ENABLED
+		return LOW_POWER_MODE_STOP;
+#else
 		return LOW_POWER_MODE_SLEEP;
+#endif
 	return LOW_POWER_MODE_STANDBY;
 }
 
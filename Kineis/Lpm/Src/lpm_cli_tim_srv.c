@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    lpm_cli_tim_srv.c
+ * @brief   Software timer service's LPM client. It is implementing APIs needed to interface with
+ *          the low power manager (MGR_LPM)
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup MGR_LPM
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------------------------ */
+#include <stdbool.h>
+#include "lpm_cli_tim_srv.h"
+#include "mgr_lpm.h"
+#include "mcu_tim_srv.h"
+
+/* Variables ----------------------------------------------------------------------------------- */
+
+struct MgrLpmClientCb_t mgrLpmCliTimSrv =
+{     .fpMGR_LPM_LpmReqCb        = TIM_SRV_lpmReq,
+      .fpMGR_LPM_LpmNotifEnterCb = TIM_SRV_lpmNotifEnter,
+      .fpMGR_LPM_LpmNotifExitCb  = TIM_SRV_lpmNotifExit
+};
+
+/* Functions ----------------------------------------------------------------------------------- */
+
+enum MgrLpm_LPM_t TIM_SRV_lpmReq(void)
+{
+	/** LPTIM1 keeps on counting in STOP modes, its content is lost in STANDBY */
+	if (MCU_TIM_SRV_isSomeRunning())
+		return LOW_POWER_MODE_STOP;
+	return LOW_POWER_MODE_SHUTDOWN;
+}
+
+bool TIM_SRV_lpmNotifEnter(__attribute__((unused)) enum MgrLpm_LPM_t enteringLpm)
+{
+	return true;
+}
+
+bool TIM_SRV_lpmNotifExit(__attribute__((unused)) enum MgrLpm_LPM_t exitingLpm)
+{
+	return true;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file    lpm_cli_user_data.c
+ * @brief   USERDATA TX journal's LPM client. It is implementing APIs needed to interface with the
+ *          low power manager (MGR_LPM)
+ * @author  Kineis
+ */
+
+/**
+ * @addtogroup MGR_LPM
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------------------------ */
+#include <stdbool.h>
+#include "lpm_cli_user_data.h"
+#include "mgr_lpm.h"
+#include "kns_mac.h"
+#include "user_data_journal.h"
+
+/* Variables ----------------------------------------------------------------------------------- */
+
+struct MgrLpmClientCb_t mgrLpmCliUserData =
+{     .fpMGR_LPM_LpmReqCb        = USERDATA_lpmReq,
+      .fpMGR_LPM_LpmNotifEnterCb = USERDATA_lpmNotifEnter,
+      .fpMGR_LPM_LpmNotifExitCb  = USERDATA_lpmNotifExit
+};
+
+/* Functions ----------------------------------------------------------------------------------- */
+
+enum MgrLpm_LPM_t USERDATA_lpmReq(void)
+{
+	return LOW_POWER_MODE_SHUTDOWN;
+}
+
+bool USERDATA_lpmNotifEnter(enum MgrLpm_LPM_t enteringLpm)
+{
+#ifdef USE_USERDATA_JOURNAL
+	/** Staged fifo operations are lost if power is lost while sleeping that deep */
+	if ((enteringLpm == LOW_POWER_MODE_STANDBY) || (enteringLpm == LOW_POWER_MODE_SHUTDOWN)) {
+		/** Make room first if needed, page erase is not allowed while radio is on */
+		if (!KNS_MAC_getRsrcStatus().modemOn)
+			USERDATA_journalProcess();
+		USERDATA_journalSync();
+	}
+#else
+	(void)enteringLpm;
+#endif
+	return true;
+}
+
+bool USERDATA_lpmNotifExit(__attribute__((unused)) enum MgrLpm_LPM_t exitingLpm)
+{
+	return true;
+}
+
+/**
+ * @}
+ */
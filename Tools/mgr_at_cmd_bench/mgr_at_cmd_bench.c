@@ -0,0 +1,401 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file mgr_at_cmd_bench.c
+ * @author Kinéis
+ * @brief Host benchmark of the AT cmd stream parser (MGR_AT_CMD)
+ *
+ * Compares the incremental state-machine parser of mgr_at_cmd.c with the former parser, which
+ * rescanned the RX buffer backward for "AT+" then forward for "\r\n" each time a '\n' was
+ * received (kept below as reference, legacyParseStreamCb).
+ *
+ * Each scenario is fed byte per byte to both parsers, as the former RX ISR did. Results are:
+ * * throughput, in MB/s of received stream, AT cmds being consumed as soon as extracted
+ * * worst-case cycles spent in one parser call (host TSC), i.e. the former ISR critical path
+ * * number of AT cmds extracted
+ *
+ * Worst-case cycles are measured in a second pass, so that throughput is not biased by timing
+ * each call. Parsers are reset before each repeat of the stream, thus the same call occurs once per
+ * repeat: its cost is the minimum over repeats, which filters out host preemption and cache
+ * misses. Worst case is the maximum of these costs over the stream.
+ *
+ * The current parser is also fed by chunks of 64 bytes, as done from APP task on DMA idle event.
+ *
+ * Build (from repository root):
+ @verbatim
+ gcc -std=gnu11 -O2 -DUSE_HDA4 -DUSE_BAREMETAL -IKineis/Extdep/Conf -IKineis/Lib -Ikineis_sw \
+     -IKineis/Appconf -IKineis/App/Kineis_os/KNS_OS/Inc -IKineis/App/Kineis_os/KNS_Q/Inc \
+     -IKineis/App/Managers/MGR_AT_CMD/Inc -IKineis/App/Mcu/Inc -IKineis/App/Libs/STRUTIL/Inc \
+     -IKineis/App/Libs/USERDATA/Inc -IKineis/Extdep/MGR_LOG/Inc -IKineis/Extdep/Mcu/Inc -ICore/Inc \
+     -o mgr_at_cmd_bench Tools/mgr_at_cmd_bench/mgr_at_cmd_bench.c \
+     Kineis/App/Managers/MGR_AT_CMD/Src/mgr_at_cmd.c
+ @endverbatim
+ *
+ * Usage:
+ @verbatim
+ mgr_at_cmd_bench [<repeat>]
+ @endverbatim
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "kns_types.h"
+#include "kns_os.h"
+#include "mgr_at_cmd.h"
+#include "mgr_at_cmd_common.h"
+#include "mgr_at_cmd_list.h"
+
+/* Defines ------------------------------------------------------------------------------------- */
+
+#define RXBUF_SIZE	2560 /**< console RX buffer size (USE_HDA4), cf mcu_at_console_stm.c */
+#define FIFO_MAX_SIZE	4    /**< AT cmd FIFO size, cf mgr_at_cmd.c */
+#define FRAME_MAX_LEN	1280 /**< AT cmd maximum length (USE_HDA4), cf mgr_at_cmd.c */
+#define DMA_CHUNK_SIZE	64   /**< characters handled per DMA idle event */
+#define DEFAULT_REPEAT	2000
+#define STREAM_MAX_LEN	(16 * RXBUF_SIZE)
+
+/* Host stubs of target dependencies of mgr_at_cmd.c ------------------------------------------- */
+
+const struct atcmd_desc_t cas_atcmd_list_array[ATCMD_MAX_COUNT];
+
+static void (*parseCb)(uint8_t *pu8_RxBuffer, uint16_t u16_rxBufSize, uint16_t u16_rxIdx,
+		       uint16_t u16_nbRxChar);
+static uint8_t au8_rxBuf[RXBUF_SIZE];
+static uint16_t u16_rxWrIdx;
+
+/** Cost of the parser call done at each stream position, minimum over repeats */
+static uint64_t au64_callCycles[STREAM_MAX_LEN];
+
+bool MCU_AT_CONSOLE_register(void *context,
+		void (*rx_evt_cb)(uint8_t *pu8_RxBuffer, uint16_t u16_rxBufSize,
+		uint16_t u16_rxIdx, uint16_t u16_nbRxChar),
+		void (*rx_ovf_cb)(void), void (*rx_err_cb)(void), void (*rx_notify_cb)(void))
+{
+	(void)context;
+	(void)rx_ovf_cb;
+	(void)rx_err_cb;
+	(void)rx_notify_cb;
+	parseCb = rx_evt_cb;
+	return true;
+}
+
+void MCU_AT_CONSOLE_rxPoll(void)
+{
+}
+
+void MCU_AT_CONSOLE_rxRelease(uint16_t u16_rxIdx)
+{
+	(void)u16_rxIdx;
+}
+
+void KNS_OS_setTaskReady(enum KNS_OS_taskHdlr_t tskHdlr)
+{
+	(void)tskHdlr;
+}
+
+bool bUTIL_strcmp(uint8_t *pu8_Str1, const uint8_t *pu8_Str2, uint8_t u8_strLength)
+{
+	return memcmp(pu8_Str1, pu8_Str2, u8_strLength) == 0;
+}
+
+bool bMGR_AT_CMD_logFailedMsg(enum ERROR_RETURN_T eErrorType)
+{
+	(void)eErrorType;
+	return true;
+}
+
+void kns_assert_failed(uint8_t *file, uint32_t line)
+{
+	fprintf(stderr, "assert failed %s:%u\n", file, line);
+	exit(1);
+}
+
+/* Former parser, reference ---------------------------------------------------------------------- */
+
+static struct {
+	uint8_t au8_fifo[FIFO_MAX_SIZE][FRAME_MAX_LEN];
+	uint8_t u8_widx;
+	uint8_t u8_ridx;
+} s_legacyFifo;
+
+/**
+ * @brief Former MGR_AT_CMD_parseStreamCb, run from RX ISR on linear RX buffer
+ */
+static bool legacyParseStreamCb(uint8_t *pu8_RxBuffer, int16_t *pi16_nbRxValidChar)
+{
+	int16_t idxEnd = 0;
+	int16_t idxStart = 0;
+	int16_t i16_atcmdLen = 0;
+	bool isEOLdetected = false;
+	bool isFirstCharDetected = false;
+
+	char C = (char)(pu8_RxBuffer[*pi16_nbRxValidChar - 1]);
+
+	if (C != '\n')
+		return false;
+	if (*pi16_nbRxValidChar < 5)
+		return false;
+
+	for (idxStart = *pi16_nbRxValidChar - 1; idxStart >= 0; idxStart--)
+		if (pu8_RxBuffer[idxStart] == 'A' &&
+		    pu8_RxBuffer[idxStart + 1] == 'T' &&
+		    pu8_RxBuffer[idxStart + 2] == '+') {
+			isFirstCharDetected = true;
+			break;
+		}
+	if (!isFirstCharDetected)
+		return false;
+
+	for (idxEnd = idxStart + 2; idxEnd <= *pi16_nbRxValidChar; idxEnd++) {
+		if (pu8_RxBuffer[idxEnd - 2] == '\r' && pu8_RxBuffer[idxEnd - 1] == '\n') {
+			isEOLdetected = true;
+			break;
+		}
+	}
+	if (!isEOLdetected)
+		return false;
+
+	*pi16_nbRxValidChar = idxStart;
+
+	if (((s_legacyFifo.u8_widx+1) % FIFO_MAX_SIZE) == (s_legacyFifo.u8_ridx % FIFO_MAX_SIZE))
+		return true;
+	i16_atcmdLen = idxEnd - idxStart;
+	if ((i16_atcmdLen + 1) > FRAME_MAX_LEN)
+		i16_atcmdLen = FRAME_MAX_LEN - 1;
+	memcpy(s_legacyFifo.au8_fifo[s_legacyFifo.u8_widx % FIFO_MAX_SIZE],
+		&pu8_RxBuffer[idxStart], i16_atcmdLen);
+	s_legacyFifo.au8_fifo[s_legacyFifo.u8_widx % FIFO_MAX_SIZE][i16_atcmdLen] = '\0';
+	s_legacyFifo.u8_widx++;
+
+	return true;
+}
+
+/* Benchmark ----------------------------------------------------------------------------------- */
+
+struct benchResult_t {
+	double f_bytesPerSec;
+	uint64_t u64_maxCycles;
+	uint32_t u32_cmdNb;
+};
+
+static inline uint64_t benchCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static inline double benchSeconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Keep cost of a call if lower than the one measured at same position in previous repeats
+ */
+static inline void benchCallCycles(uint32_t u32_rep, uint32_t u32_idx, uint64_t u64_dt)
+{
+	if ((u32_rep == 0) || (u64_dt < au64_callCycles[u32_idx]))
+		au64_callCycles[u32_idx] = u64_dt;
+}
+
+/**
+ * @brief Worst-case cost of a call over the stream
+ */
+static uint64_t benchMaxCycles(uint32_t u32_len)
+{
+	uint64_t u64_max = 0;
+	uint32_t u32_idx;
+
+	for (u32_idx = 0; u32_idx < u32_len; u32_idx++)
+		if (au64_callCycles[u32_idx] > u64_max)
+			u64_max = au64_callCycles[u32_idx];
+	return u64_max;
+}
+
+/**
+ * @brief Feed former parser byte per byte, as its RX ISR did on a linear RX buffer
+ *
+ * @param[in] b_perCall true to measure cycles of each call, false to measure throughput
+ */
+static void benchLegacy(const uint8_t *pu8_stream, uint32_t u32_len, uint32_t u32_repeat,
+	bool b_perCall, struct benchResult_t *ps_res)
+{
+	static uint8_t au8_linBuf[RXBUF_SIZE];
+	int16_t i16_nbValid = 0;
+	uint64_t u64_t0 = 0;
+	double f_t0;
+	uint32_t u32_rep;
+	uint32_t u32_idx;
+
+	ps_res->u32_cmdNb = 0;
+	f_t0 = benchSeconds();
+	memset(au64_callCycles, 0, sizeof(au64_callCycles));
+	for (u32_rep = 0; u32_rep < u32_repeat; u32_rep++) {
+		if (b_perCall)
+			i16_nbValid = 0;
+		for (u32_idx = 0; u32_idx < u32_len; u32_idx++) {
+			au8_linBuf[i16_nbValid++] = pu8_stream[u32_idx];
+			if (b_perCall)
+				u64_t0 = benchCycles();
+			while (legacyParseStreamCb(au8_linBuf, &i16_nbValid))
+				;
+			if (b_perCall)
+				benchCallCycles(u32_rep, u32_idx, benchCycles() - u64_t0);
+			/* buffer full: former ISR restarted writing from its beginning */
+			if (i16_nbValid >= RXBUF_SIZE)
+				i16_nbValid = 0;
+			/* APP task keeps up with incoming AT cmds */
+			while (s_legacyFifo.u8_ridx != s_legacyFifo.u8_widx) {
+				s_legacyFifo.u8_ridx++;
+				ps_res->u32_cmdNb++;
+			}
+		}
+	}
+	if (b_perCall)
+		ps_res->u64_maxCycles = benchMaxCycles(u32_len);
+	else
+		ps_res->f_bytesPerSec = (double)u32_len * u32_repeat / (benchSeconds() - f_t0);
+}
+
+/**
+ * @brief Feed current parser by chunks written in the console RX circular buffer
+ *
+ * @param[in] b_perCall true to measure cycles of each call, false to measure throughput
+ */
+static void benchCurrent(const uint8_t *pu8_stream, uint32_t u32_len, uint32_t u32_repeat,
+	uint16_t u16_chunk, bool b_perCall, struct benchResult_t *ps_res)
+{
+	uint8_t *pu8_atcmd;
+	uint16_t u16_nb;
+	uint16_t u16_part;
+	uint64_t u64_t0 = 0;
+	double f_t0;
+	uint32_t u32_rep;
+	uint32_t u32_idx;
+
+	ps_res->u32_cmdNb = 0;
+	f_t0 = benchSeconds();
+	memset(au64_callCycles, 0, sizeof(au64_callCycles));
+	for (u32_rep = 0; u32_rep < u32_repeat; u32_rep++) {
+		if (b_perCall) {
+			MGR_AT_CMD_start(NULL);
+			u16_rxWrIdx = 0;
+		}
+		for (u32_idx = 0; u32_idx < u32_len; u32_idx += u16_nb) {
+			u16_nb = (u32_len - u32_idx < u16_chunk) ? u32_len - u32_idx : u16_chunk;
+			u16_part = (RXBUF_SIZE - u16_rxWrIdx < u16_nb) ?
+				   RXBUF_SIZE - u16_rxWrIdx : u16_nb;
+			memcpy(&au8_rxBuf[u16_rxWrIdx], &pu8_stream[u32_idx], u16_part);
+			memcpy(au8_rxBuf, &pu8_stream[u32_idx + u16_part], u16_nb - u16_part);
+			if (b_perCall)
+				u64_t0 = benchCycles();
+			/* as console does, a chunk wrapping around the end of buffer is split */
+			parseCb(au8_rxBuf, RXBUF_SIZE, u16_rxWrIdx, u16_part);
+			if (u16_part < u16_nb)
+				parseCb(au8_rxBuf, RXBUF_SIZE, 0, u16_nb - u16_part);
+			if (b_perCall)
+				benchCallCycles(u32_rep, u32_idx, benchCycles() - u64_t0);
+			u16_rxWrIdx = (u16_rxWrIdx + u16_nb) % RXBUF_SIZE;
+			/* APP task keeps up with incoming AT cmds */
+			while ((pu8_atcmd = MGR_AT_CMD_popNextAt()) != NULL) {
+				MGR_AT_CMD_decodeAt(pu8_atcmd);
+				ps_res->u32_cmdNb++;
+			}
+		}
+	}
+	if (b_perCall)
+		ps_res->u64_maxCycles = benchMaxCycles(u32_len);
+	else
+		ps_res->f_bytesPerSec = (double)u32_len * u32_repeat / (benchSeconds() - f_t0);
+}
+
+/**
+ * @brief Append "AT+TX=<hex>\r\n" to stream
+ */
+static uint32_t benchAddTx(uint8_t *pu8_stream, uint32_t u32_len, uint16_t u16_cmdLen)
+{
+	static const char ac_hex[] = "0123456789ABCDEF";
+	uint16_t u16_idx;
+
+	u32_len += sprintf((char *)&pu8_stream[u32_len], "AT+TX=");
+	for (u16_idx = 0; u16_idx < u16_cmdLen - 8; u16_idx++)
+		pu8_stream[u32_len++] = ac_hex[u16_idx % 16];
+	pu8_stream[u32_len++] = '\r';
+	pu8_stream[u32_len++] = '\n';
+	return u32_len;
+}
+
+static void benchRun(const char *pc_name, const uint8_t *pu8_stream, uint32_t u32_len,
+	uint32_t u32_repeat)
+{
+	struct benchResult_t s_old = { 0 };
+	struct benchResult_t s_new = { 0 };
+	struct benchResult_t s_dma = { 0 };
+
+	benchLegacy(pu8_stream, u32_len, u32_repeat, false, &s_old);
+	benchLegacy(pu8_stream, u32_len, u32_repeat, true, &s_old);
+	benchCurrent(pu8_stream, u32_len, u32_repeat, 1, false, &s_new);
+	benchCurrent(pu8_stream, u32_len, u32_repeat, 1, true, &s_new);
+	benchCurrent(pu8_stream, u32_len, u32_repeat, DMA_CHUNK_SIZE, false, &s_dma);
+	benchCurrent(pu8_stream, u32_len, u32_repeat, DMA_CHUNK_SIZE, true, &s_dma);
+
+	printf("%-28s %9.1f %9.1f %9.1f   %7llu %7llu %7llu   %6u %6u %6u\n", pc_name,
+	       s_old.f_bytesPerSec / 1e6, s_new.f_bytesPerSec / 1e6, s_dma.f_bytesPerSec / 1e6,
+	       (unsigned long long)s_old.u64_maxCycles, (unsigned long long)s_new.u64_maxCycles,
+	       (unsigned long long)s_dma.u64_maxCycles,
+	       s_old.u32_cmdNb / u32_repeat, s_new.u32_cmdNb / u32_repeat,
+	       s_dma.u32_cmdNb / u32_repeat);
+}
+
+int main(int argc, char *argv[])
+{
+	static uint8_t au8_stream[STREAM_MAX_LEN];
+	uint32_t u32_repeat = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_REPEAT;
+	uint32_t u32_len;
+	uint16_t u16_idx;
+
+	MGR_AT_CMD_start(NULL);
+
+	printf("%-28s %29s   %23s   %20s\n", "", "throughput (MB/s)", "worst call (cycles)",
+	       "AT cmds per stream");
+	printf("%-28s %9s %9s %9s   %7s %7s %7s   %6s %6s %6s\n", "scenario", "old", "new",
+	       "new/64", "old", "new", "new/64", "old", "new", "new/64");
+
+	/* 8 AT+TX of 49 characters in a row */
+	for (u32_len = 0, u16_idx = 0; u16_idx < 8; u16_idx++)
+		u32_len = benchAddTx(au8_stream, u32_len, 49);
+	benchRun("8 x AT+TX (49 chars)", au8_stream, u32_len, u32_repeat);
+
+	/* 1 AT+TX of 1265 characters (HDA4 maximum payload) */
+	u32_len = benchAddTx(au8_stream, 0, 1265);
+	benchRun("1 x AT+TX (1265 chars)", au8_stream, u32_len, u32_repeat / 8);
+
+	/* Lines without AT cmd (e.g. echo, noise) between AT cmds, left in former RX buffer */
+	for (u32_len = 0, u16_idx = 0; u16_idx < 32; u16_idx++) {
+		memset(&au8_stream[u32_len], 'x', 78);
+		u32_len += 78;
+		au8_stream[u32_len++] = '\r';
+		au8_stream[u32_len++] = '\n';
+		if ((u16_idx % 8) == 7)
+			u32_len = benchAddTx(au8_stream, u32_len, 49);
+	}
+	benchRun("32 noise lines + 4 AT+TX", au8_stream, u32_len, u32_repeat / 8);
+
+	return 0;
+}
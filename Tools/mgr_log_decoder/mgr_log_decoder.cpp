@@ -0,0 +1,309 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file mgr_log_decoder.cpp
+ * @author Kinéis
+ * @brief Host decoder of deferred logs (MGR_LOG_DEFERRED)
+ *
+ * Firmware built with LOG_DEFERRED=1 emits binary records instead of text (cf vMGR_LOG_deferred).
+ * This tool rebuilds the text from the records and from the format strings kept in the
+ * .mgr_log_fmt section of the firmware ELF file.
+ *
+ * Build:
+ @verbatim
+ g++ -std=c++17 -O2 -o mgr_log_decoder mgr_log_decoder.cpp
+ @endverbatim
+ *
+ * Usage:
+ @verbatim
+ mgr_log_decoder <firmware.elf> [<records.bin>]
+ @endverbatim
+ * Records are read from stdin when no records file is given, e.g. from OpenOCD RTT server:
+ @verbatim
+ nc localhost 9090 | mgr_log_decoder build/argos-smd-at-kineis-firmware.elf
+ @endverbatim
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t RECORD_SYNC = 0xA5;     // MGR_LOG_DEFERRED_SYNC
+constexpr uint8_t RECORD_TS_FLAG = 0x80;  // MGR_LOG_DEFERRED_TS_FLAG
+constexpr uint8_t RECORD_MAX_ARGS = 10;   // MGR_LOG_DEFERRED_MAX_ARGS
+constexpr const char *FMT_SECTION = ".mgr_log_fmt";
+
+struct Section {
+	std::string name;
+	uint32_t type;
+	uint32_t flags;
+	uint32_t addr;
+	uint32_t offset;
+	uint32_t size;
+};
+
+/** Minimal reader of a 32-bit little endian ELF file: section headers only */
+class Elf {
+public:
+	bool load(const std::string &path)
+	{
+		std::ifstream file(path, std::ios::binary);
+
+		if (!file)
+			return false;
+		data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		if ((data_.size() < 52) || (std::memcmp(data_.data(), "\x7F" "ELF", 4) != 0) ||
+		    (data_[4] != 1) || (data_[5] != 1))
+			return false;
+
+		uint32_t shoff = read32(32);
+		uint16_t shentsize = read16(46);
+		uint16_t shnum = read16(48);
+		uint16_t shstrndx = read16(50);
+
+		if ((shoff == 0) || (shstrndx >= shnum) ||
+		    ((uint64_t)shoff + (uint64_t)shnum * shentsize > data_.size()))
+			return false;
+
+		for (uint16_t i = 0; i < shnum; i++) {
+			uint32_t hdr = shoff + i * shentsize;
+			Section sec;
+
+			sec.name = std::to_string(read32(hdr));  // resolved below
+			sec.type = read32(hdr + 4);
+			sec.flags = read32(hdr + 8);
+			sec.addr = read32(hdr + 12);
+			sec.offset = read32(hdr + 16);
+			sec.size = read32(hdr + 20);
+			sections_.push_back(sec);
+		}
+		const Section &strtab = sections_[shstrndx];
+		for (Section &sec : sections_)
+			sec.name = cstring(strtab.offset + std::stoul(sec.name),
+					   strtab.offset + strtab.size);
+		return true;
+	}
+
+	const Section *section(const std::string &name) const
+	{
+		for (const Section &sec : sections_)
+			if (sec.name == name)
+				return &sec;
+		return nullptr;
+	}
+
+	/** Constant string at given target address, looked for in initialized sections */
+	bool stringAt(uint32_t addr, std::string &str) const
+	{
+		constexpr uint32_t SHT_PROGBITS = 1;
+		constexpr uint32_t SHF_ALLOC = 2;
+
+		for (const Section &sec : sections_) {
+			if ((sec.type != SHT_PROGBITS) || !(sec.flags & SHF_ALLOC) ||
+			    (addr < sec.addr) || (addr >= sec.addr + sec.size))
+				continue;
+			str = cstring(sec.offset + (addr - sec.addr), sec.offset + sec.size);
+			return true;
+		}
+		return false;
+	}
+
+	std::string cstring(uint32_t offset, uint32_t end) const
+	{
+		std::string str;
+
+		for (; (offset < end) && (offset < data_.size()) && (data_[offset] != 0); offset++)
+			str += (char)data_[offset];
+		return str;
+	}
+
+private:
+	uint16_t read16(uint32_t off) const
+	{
+		return (uint16_t)(data_[off] | (data_[off + 1] << 8));
+	}
+
+	uint32_t read32(uint32_t off) const
+	{
+		return (uint32_t)read16(off) | ((uint32_t)read16(off + 2) << 16);
+	}
+
+	std::vector<uint8_t> data_;
+	std::vector<Section> sections_;
+};
+
+/** Render a printf-like format string with 32-bit raw arguments */
+std::string render(const Elf &elf, const std::string &fmt, const std::vector<uint32_t> &args)
+{
+	std::string out;
+	size_t argIdx = 0;
+	char buf[256];
+
+	for (size_t i = 0; i < fmt.size(); i++) {
+		if (fmt[i] != '%') {
+			out += fmt[i];
+			continue;
+		}
+		if ((i + 1 < fmt.size()) && (fmt[i + 1] == '%')) {
+			out += '%';
+			i++;
+			continue;
+		}
+
+		/* Keep flags, width and precision, drop length modifiers (all args are 32-bit) */
+		std::string spec = "%";
+		size_t j = i + 1;
+
+		while ((j < fmt.size()) && std::strchr("-+ #0123456789.", fmt[j]))
+			spec += fmt[j++];
+		while ((j < fmt.size()) && std::strchr("hlzjt", fmt[j]))
+			j++;
+		if (j >= fmt.size())
+			break;
+
+		char conv = fmt[j];
+		i = j;
+		if (argIdx >= args.size()) {
+			out += "<missing>";
+			continue;
+		}
+		uint32_t arg = args[argIdx++];
+
+		switch (conv) {
+		case 'd':
+		case 'i':
+			spec += 'd';
+			std::snprintf(buf, sizeof(buf), spec.c_str(), (int32_t)arg);
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			spec += conv;
+			std::snprintf(buf, sizeof(buf), spec.c_str(), arg);
+			break;
+		case 'c':
+			spec += 'c';
+			std::snprintf(buf, sizeof(buf), spec.c_str(), (int)arg);
+			break;
+		case 'p':
+			std::snprintf(buf, sizeof(buf), "0x%08x", arg);
+			break;
+		case 's': {
+			std::string str;
+
+			if (elf.stringAt(arg, str)) {
+				spec += 's';
+				std::snprintf(buf, sizeof(buf), spec.c_str(), str.c_str());
+			} else {
+				std::snprintf(buf, sizeof(buf), "<str@0x%08x>", arg);
+			}
+			break;
+		}
+		default:
+			std::snprintf(buf, sizeof(buf), "<%%%c:0x%08x>", conv, arg);
+			break;
+		}
+		out += buf;
+	}
+	return out;
+}
+
+uint32_t le32(const std::vector<uint8_t> &in, size_t off)
+{
+	return (uint32_t)in[off] | ((uint32_t)in[off + 1] << 8) | ((uint32_t)in[off + 2] << 16) |
+	       ((uint32_t)in[off + 3] << 24);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	Elf elf;
+
+	if ((argc < 2) || (argc > 3)) {
+		std::cerr << "usage: " << argv[0] << " <firmware.elf> [<records.bin>]\n";
+		return 1;
+	}
+	if (!elf.load(argv[1])) {
+		std::cerr << "cannot read ELF file " << argv[1] << "\n";
+		return 1;
+	}
+	const Section *fmtSec = elf.section(FMT_SECTION);
+	if (fmtSec == nullptr) {
+		std::cerr << "no " << FMT_SECTION << " section, was firmware built with "
+			     "LOG_DEFERRED=1 ?\n";
+		return 1;
+	}
+
+	std::ifstream file;
+	std::istream *in = &std::cin;
+	if (argc == 3) {
+		file.open(argv[2], std::ios::binary);
+		if (!file) {
+			std::cerr << "cannot read records file " << argv[2] << "\n";
+			return 1;
+		}
+		in = &file;
+	}
+
+	std::vector<uint8_t> stream;
+	size_t pos = 0;
+	char c;
+
+	while (in->get(c)) {
+		stream.push_back((uint8_t)c);
+
+		/* Decode as many complete records as possible */
+		while (stream.size() - pos >= 4) {
+			if (stream[pos] != RECORD_SYNC) {
+				pos++;
+				continue;
+			}
+			uint8_t info = stream[pos + 1];
+			uint8_t nbArgs = info & ~RECORD_TS_FLAG;
+			uint32_t fmtId = stream[pos + 2] | (stream[pos + 3] << 8);
+			bool hasTs = (info & RECORD_TS_FLAG) != 0;
+			size_t recLen = 4 * (1 + (hasTs ? 1 : 0) + nbArgs);
+
+			/* Format ID must point to the beginning of a format string */
+			if ((nbArgs > RECORD_MAX_ARGS) || (fmtId >= fmtSec->size) ||
+			    ((fmtId != 0) && (elf.cstring(fmtSec->offset + fmtId - 1,
+							  fmtSec->offset + fmtId) != ""))) {
+				pos++;
+				continue;
+			}
+			if (stream.size() - pos < recLen)
+				break;
+
+			size_t off = pos + 4;
+			std::vector<uint32_t> args;
+
+			if (hasTs) {
+				uint32_t ts = le32(stream, off);
+
+				std::printf("%6u.%03u ", ts / 1000, ts % 1000);
+				off += 4;
+			}
+			for (uint8_t i = 0; i < nbArgs; i++, off += 4)
+				args.push_back(le32(stream, off));
+
+			std::string fmt = elf.cstring(fmtSec->offset + fmtId,
+						      fmtSec->offset + fmtSec->size);
+			std::fputs(render(elf, fmt, args).c_str(), stdout);
+			std::fflush(stdout);
+			pos += recLen;
+		}
+		if (pos > 4096) {
+			stream.erase(stream.begin(), stream.begin() + pos);
+			pos = 0;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: no SPDX license
+/**
+ * @file strutil_bench.c
+ * @author Kinéis
+ * @brief Host micro-benchmark of the hexadecimal ASCII decoder (STRUTILS)
+ *
+ * Compares the decoding of AT+TX user data:
+ * * former path: sscanf with a "%1265[0-9A-Fa-f]" scanset copying the digits, then conversion of
+ *   each nibble through the former u8UTIL_convertCharToHex4bits (kept below as reference)
+ * * current path: u16UTIL_convertAsciiToHex, decoding in place from the AT cmd buffer
+ *
+ * Payloads of 49 and 1265 characters are decoded. Both paths are checked to produce the same
+ * data. Cost of one decoding is the minimum over repeats, in host TSC cycles (or ns on non-x86
+ * hosts), which filters out host preemption.
+ *
+ * Build (from repository root):
+ @verbatim
+ gcc -std=gnu11 -O2 -IKineis/App/Libs/STRUTIL/Inc -o strutil_bench \
+     Tools/strutil_bench/strutil_bench.c Kineis/App/Libs/STRUTIL/Src/strutil_lib.c
+ @endverbatim
+ *
+ * Usage:
+ @verbatim
+ strutil_bench [<repeat>]
+ @endverbatim
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "strutil_lib.h"
+
+/* Defines ------------------------------------------------------------------------------------- */
+
+#define PAYLOAD_MAX_CHAR_NB	1265 /**< MGR_AT_CMD_TX_MAX_CHAR_NB with HDA4 */
+#define DEFAULT_REPEAT		20000
+
+/* Former decoder, reference ------------------------------------------------------------------- */
+
+static uint8_t legacyConvertCharToHex4bits(uint8_t u8_num)
+{
+	if ((u8_num >= 'A') && (u8_num <= 'F'))
+		return u8_num - 'A' + 10;
+
+	if ((u8_num >= 'a') && (u8_num <= 'f'))
+		return u8_num - 'a' + 10;
+
+	if ((u8_num >= '0') && (u8_num <= '9'))
+		return u8_num - '0';
+
+	return HEX_DEC_4BIT_CONVERSION_FAILED_CODE;
+}
+
+/**
+ * @brief Former AT+TX user data decoding: sscanf copy, then per-nibble conversion
+ *
+ * @return data length in bits, 0 on error
+ */
+static uint16_t legacyDecode(uint8_t *pu8_out, const uint8_t *pu8_cmd)
+{
+	uint16_t u16_charNb;
+	uint16_t u16_index;
+	uint8_t u8_high;
+	uint8_t u8_low;
+
+	if (sscanf((const char *)pu8_cmd, "AT+TX=%1265[0-9A-Fa-f]", pu8_out) != 1)
+		return 0;
+	u16_charNb = strlen((const char *)pu8_out);
+
+	for (u16_index = 0; u16_index < (u16_charNb / 2); u16_index++) {
+		u8_high = legacyConvertCharToHex4bits(pu8_out[2 * u16_index]);
+		u8_low = legacyConvertCharToHex4bits(pu8_out[2 * u16_index + 1]);
+		if ((u8_high == 0xFF) || (u8_low == 0xFF))
+			return 0;
+		pu8_out[u16_index] = (u8_high << 4) | u8_low;
+	}
+	if (u16_charNb % 2 != 0) {
+		u8_high = legacyConvertCharToHex4bits(pu8_out[u16_charNb - 1]);
+		if (u8_high == 0xFF)
+			return 0;
+		pu8_out[u16_index] = u8_high << 4;
+	}
+
+	return u16_charNb * 4;
+}
+
+/**
+ * @brief Current AT+TX user data decoding, in place from the AT cmd buffer
+ *
+ * @return data length in bits
+ */
+static uint16_t currentDecode(uint8_t *pu8_cmd)
+{
+	return u16UTIL_convertAsciiToHex(&pu8_cmd[6], &pu8_cmd[6], PAYLOAD_MAX_CHAR_NB) * 4;
+}
+
+/* Benchmark ----------------------------------------------------------------------------------- */
+
+static inline uint64_t benchCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Build "AT+TX=<hex>\r\n" with random mixed-case digits
+ */
+static void benchBuildCmd(uint8_t *pu8_cmd, uint16_t u16_charNb)
+{
+	static const char ac_hex[] = "0123456789ABCDEFabcdef";
+	uint16_t u16_idx;
+
+	memcpy(pu8_cmd, "AT+TX=", 6);
+	for (u16_idx = 0; u16_idx < u16_charNb; u16_idx++)
+		pu8_cmd[6 + u16_idx] = ac_hex[rand() % (sizeof(ac_hex) - 1)];
+	memcpy(&pu8_cmd[6 + u16_charNb], "\r\n", 3);
+}
+
+static bool benchRun(uint16_t u16_charNb, uint32_t u32_repeat)
+{
+	static uint8_t au8_cmdRef[PAYLOAD_MAX_CHAR_NB + 16];
+	static uint8_t au8_cmd[PAYLOAD_MAX_CHAR_NB + 16];
+	static uint8_t au8_legacyOut[PAYLOAD_MAX_CHAR_NB + 1];
+	uint64_t u64_legacyMin = UINT64_MAX;
+	uint64_t u64_currentMin = UINT64_MAX;
+	uint64_t u64_t0;
+	uint64_t u64_dt;
+	uint16_t u16_legacyBits = 0;
+	uint16_t u16_currentBits = 0;
+	uint32_t u32_rep;
+
+	benchBuildCmd(au8_cmdRef, u16_charNb);
+
+	for (u32_rep = 0; u32_rep < u32_repeat; u32_rep++) {
+		u64_t0 = benchCycles();
+		u16_legacyBits = legacyDecode(au8_legacyOut, au8_cmdRef);
+		u64_dt = benchCycles() - u64_t0;
+		if (u64_dt < u64_legacyMin)
+			u64_legacyMin = u64_dt;
+
+		/* in-place decoding overwrites the command, restore it out of measurement */
+		memcpy(au8_cmd, au8_cmdRef, sizeof(au8_cmd));
+		u64_t0 = benchCycles();
+		u16_currentBits = currentDecode(au8_cmd);
+		u64_dt = benchCycles() - u64_t0;
+		if (u64_dt < u64_currentMin)
+			u64_currentMin = u64_dt;
+	}
+
+	printf("%5u chars   %8llu %8llu   x%.1f\n", u16_charNb,
+	       (unsigned long long)u64_legacyMin, (unsigned long long)u64_currentMin,
+	       (double)u64_legacyMin / u64_currentMin);
+
+	return (u16_legacyBits == u16_currentBits) &&
+	       (memcmp(au8_legacyOut, &au8_cmd[6], (u16_currentBits + 7) / 8) == 0);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t u32_repeat = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_REPEAT;
+	bool b_isOk = true;
+
+	srand(1);
+	printf("payload       former  current   speed-up  (cycles per decoding)\n");
+	b_isOk &= benchRun(49, u32_repeat);
+	b_isOk &= benchRun(PAYLOAD_MAX_CHAR_NB, u32_repeat);
+	if (!b_isOk)
+		printf("ERROR: decoded data mismatch\n");
+
+	return b_isOk ? 0 : 1;
+}